@@ -0,0 +1,116 @@
+/*
+ * MVKHash.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+#pragma mark -
+#pragma mark MVKHash128
+
+/** A 128-bit hash value. */
+typedef struct MVKHash128 {
+	uint64_t lo = 0;
+	uint64_t hi = 0;
+
+	bool operator==(const MVKHash128& rhs) const { return lo == rhs.lo && hi == rhs.hi; }
+	bool operator!=(const MVKHash128& rhs) const { return !(*this == rhs); }
+} MVKHash128;
+
+static constexpr uint64_t kMVKHashPrime1 = 0x9E3779B185EBCA87ULL;
+static constexpr uint64_t kMVKHashPrime2 = 0xC2B2AE3D27D4EB4FULL;
+static constexpr uint64_t kMVKHashPrime3 = 0x165667B19E3779F9ULL;
+
+static inline uint64_t mvkRotl64(uint64_t val, int bits) { return (val << bits) | (val >> (64 - bits)); }
+
+// Reads 8 bytes from memory that may not be aligned.
+static inline uint64_t mvkRead64(const uint8_t* pBytes) {
+	uint64_t val;
+	memcpy(&val, pBytes, sizeof(val));
+	return val;
+}
+
+static inline uint64_t mvkHashRound(uint64_t acc, uint64_t val) {
+	return mvkRotl64(acc + (val * kMVKHashPrime2), 31) * kMVKHashPrime1;
+}
+
+static inline uint64_t mvkHashAvalanche(uint64_t val) {
+	val ^= val >> 33;
+	val *= kMVKHashPrime2;
+	val ^= val >> 29;
+	val *= kMVKHashPrime3;
+	val ^= val >> 32;
+	return val;
+}
+
+/**
+ * Returns a 128-bit hash value calculated from the contents of the specified memory.
+ *
+ * Unlike mvkHash(), which processes one element per step, this function consumes 32 bytes
+ * per step across four independent 64-bit lanes, and avalanches the lanes into two 64-bit
+ * results. Each lane uses scalar 64-bit multiplies, but because the lanes do not depend on
+ * each other, the CPU can execute them in parallel, making this function considerably faster
+ * over large content, such as shader code. Its wider result also makes collisions unlikely,
+ * even across very large numbers of inputs. See MVKHashBenchmark in the Tests folder.
+ *
+ * To accumulate a single hash value over several blocks of memory, use the
+ * lo value returned by previous calls as the seed in subsequent calls.
+ *
+ * This function is defined in this header, which has no other dependencies, so that the
+ * same hash can be calculated by both MoltenVK and the shader converter.
+ */
+inline MVKHash128 mvkHash128(const void* pData, std::size_t byteCount, uint64_t seed = 0) {
+	const uint8_t* pBytes = (const uint8_t*)pData;
+	const uint8_t* pEnd = pBytes + byteCount;
+
+	// The four lanes have no dependencies on each other, allowing the CPU to overlap the
+	// multiplies of each 32-byte step, instead of waiting for the result of each multiply.
+	uint64_t lanes[4] = { seed + kMVKHashPrime1 + kMVKHashPrime2, seed + kMVKHashPrime2, seed, seed - kMVKHashPrime1 };
+	while (pEnd - pBytes >= 32) {
+		lanes[0] = mvkHashRound(lanes[0], mvkRead64(pBytes));
+		lanes[1] = mvkHashRound(lanes[1], mvkRead64(pBytes + 8));
+		lanes[2] = mvkHashRound(lanes[2], mvkRead64(pBytes + 16));
+		lanes[3] = mvkHashRound(lanes[3], mvkRead64(pBytes + 24));
+		pBytes += 32;
+	}
+
+	// Fold any remaining 8-byte words, and then any remaining bytes, into successive lanes.
+	uint32_t laneIdx = 0;
+	while (pEnd - pBytes >= 8) {
+		lanes[laneIdx] = mvkHashRound(lanes[laneIdx], mvkRead64(pBytes));
+		laneIdx = (laneIdx + 1) & 3;
+		pBytes += 8;
+	}
+	if (pBytes < pEnd) {
+		uint64_t tail = 0;
+		memcpy(&tail, pBytes, pEnd - pBytes);
+		lanes[laneIdx] = mvkHashRound(lanes[laneIdx], tail);
+	}
+
+	// Combine the lanes two different ways, and include the length to distinguish trailing zeros.
+	uint64_t len = byteCount;
+	MVKHash128 hash;
+	hash.lo = mvkHashAvalanche(mvkRotl64(lanes[0], 1) + mvkRotl64(lanes[1], 7) +
+							   mvkRotl64(lanes[2], 12) + mvkRotl64(lanes[3], 18) + len);
+	hash.hi = mvkHashAvalanche((lanes[0] ^ mvkRotl64(lanes[2], 29)) +
+							   (lanes[1] ^ mvkRotl64(lanes[3], 41)) + (len * kMVKHashPrime3) + hash.lo);
+	return hash;
+}
@@ -55,7 +55,7 @@ typedef unsigned long MTLLanguageVersion;
 #define MVK_MAKE_VERSION(major, minor, patch)    (((major) * 10000) + ((minor) * 100) + (patch))
 #define MVK_VERSION     MVK_MAKE_VERSION(MVK_VERSION_MAJOR, MVK_VERSION_MINOR, MVK_VERSION_PATCH)
 
-#define VK_MVK_MOLTENVK_SPEC_VERSION            33
+#define VK_MVK_MOLTENVK_SPEC_VERSION            34
 #define VK_MVK_MOLTENVK_EXTENSION_NAME          "VK_MVK_moltenvk"
 
 /** Identifies the level of logging MoltenVK should be limited to outputting. */
@@ -828,6 +828,207 @@ typedef struct {
 	 */
 	VkBool32 useMetalArgumentBuffers;
 
+	/**
+	 * The path to a directory in which MoltenVK should persist the results of converting SPIR-V
+	 * shader code to MSL, so that conversions can be reused across runs of the app, and by other
+	 * processes that use the same directory, without the app needing to save and restore the
+	 * contents of a VkPipelineCache. A path starting with '~' can be used to place the directory
+	 * in a user's home directory, as in the shell. The directory is created if it does not exist.
+	 *
+	 * Each conversion is held in a separate file, identified by the content of the SPIR-V code,
+	 * the shader conversion configuration, and the MoltenVK revision. Files are replaced atomically,
+	 * so multiple processes can safely share the same directory. MoltenVK does not remove files
+	 * from the directory, and the app may remove them at any time that no VkDevice is using it.
+	 *
+	 * If this parameter is NULL or an empty string, shader conversions are not persisted.
+	 *
+	 * The value of this parameter must be changed before creating a VkDevice,
+	 * for the change to take effect.
+	 *
+	 * The initial value or this parameter is set by the
+	 * MVK_CONFIG_SHADER_CONVERSION_CACHE_PATH
+	 * runtime environment variable or MoltenVK compile-time build setting.
+	 * If neither is set, shader conversions are not persisted.
+	 */
+	const char* shaderConversionCachePath;
+
+	/**
+	 * Controls whether MoltenVK should compress the content of each shader library it writes to
+	 * pipeline cache data, when the content of a VkPipelineCache is retrieved by the app using
+	 * vkGetPipelineCacheData(). Enabling this setting reduces the size of the pipeline cache data,
+	 * at the cost of additional time to retrieve the data. Compressed content is decompressed
+	 * only when a shader module using it is first used with the VkPipelineCache. Pipeline cache
+	 * data containing compressed content can be read regardless of the value of this setting.
+	 *
+	 * The value of this parameter may be changed at any time during application runtime,
+	 * and the changed value will affect the content of pipeline cache data subsequently
+	 * retrieved from each VkPipelineCache.
+	 *
+	 * The initial value or this parameter is set by the
+	 * MVK_CONFIG_COMPRESS_PIPELINE_CACHE_DATA
+	 * runtime environment variable or MoltenVK compile-time build setting.
+	 * If neither is set, pipeline cache data is not compressed.
+	 */
+	VkBool32 compressPipelineCacheData;
+
+	/**
+	 * Controls whether MoltenVK should allocate the commands recorded into each command buffer
+	 * from an arena of contiguous memory held by that command buffer, instead of acquiring each
+	 * command from a pool of commands of the same type, held by the command pool. Commands that
+	 * are recorded consecutively are then adjacent in memory, which improves memory locality when
+	 * recording and encoding large numbers of commands. The arena memory is reused each time the
+	 * command buffer is reset, and is released when the command buffer is reset with the
+	 * VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT flag, or is freed. When this setting is
+	 * enabled, the useCommandPooling setting has no effect on the commands recorded into
+	 * command buffers, but still affects other command resources.
+	 *
+	 * The value of this parameter may be changed at any time during application runtime,
+	 * and the changed value will immediately effect behavior of VkCommandPools created
+	 * after the setting is changed.
+	 *
+	 * The initial value or this parameter is set by the
+	 * MVK_CONFIG_USE_COMMAND_ARENAS
+	 * runtime environment variable or MoltenVK compile-time build setting.
+	 * If neither is set, commands are acquired from the command type pools.
+	 */
+	VkBool32 useCommandArenas;
+
+	/**
+	 * Controls whether MoltenVK should encode large primary command buffers concurrently, on
+	 * several threads, when they are submitted to a queue. If this value is not zero, a primary
+	 * command buffer that is not prefilled is divided into segments that each begin a render pass
+	 * or a compute dispatch, and contain at least this number of commands. Each segment is encoded
+	 * into a separate MTLCommandBuffer, on its own thread, and the MTLCommandBuffers are committed
+	 * in submission order. The encoding threads are created once, and reused across submissions.
+	 * Command buffers that cannot be divided into at least three such segments, or that contain
+	 * queries, events, debug marker regions, or secondary command buffers, are always encoded
+	 * on the submitting thread.
+	 *
+	 * The value of this parameter may be changed at any time during application runtime,
+	 * and the changed value will immediately effect command buffers subsequently submitted.
+	 *
+	 * The initial value or this parameter is set by the
+	 * MVK_CONFIG_PARALLEL_ENCODING_SEGMENT_SIZE
+	 * runtime environment variable or MoltenVK compile-time build setting.
+	 * If neither is set, the value of this parameter is zero, and each command
+	 * buffer is encoded on the thread that submits it.
+	 */
+	uint32_t parallelEncodingSegmentSize;
+
+	/**
+	 * Controls whether MoltenVK should remove redundant state commands from each reusable command
+	 * buffer, when recording into that command buffer ends. A command that sets viewports, scissors,
+	 * push constants, or descriptor sets without dynamic offsets, is removed if an earlier command
+	 * in the command buffer has already set that state to the same content. Consecutive commands of
+	 * one of these types, with no draw or dispatch between them, are merged into a single command.
+	 * Command buffers begun with VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT are not optimized,
+	 * because the time taken to optimize them is not recovered across repeated submissions.
+	 *
+	 * The value of this parameter may be changed at any time during application runtime,
+	 * and the changed value will immediately effect command buffers subsequently ended.
+	 *
+	 * The initial value or this parameter is set by the
+	 * MVK_CONFIG_COALESCE_STATE_COMMANDS
+	 * runtime environment variable or MoltenVK compile-time build setting.
+	 * If neither is set, recorded commands are not optimized.
+	 */
+	VkBool32 coalesceStateCommands;
+
+	/**
+	 * Controls whether MoltenVK should record a replay stream for each reusable command buffer, the
+	 * first time that command buffer is submitted, and encode the command buffer from that replay
+	 * stream on each later submission. The replay stream is a flattened list of the commands in the
+	 * command buffer, in which the commands of secondary command buffers, and of each pass of a multiview
+	 * render pass, are expanded in place, and descriptor set binding commands are replaced by the resource
+	 * bindings they resolved. The replay stream is recorded again if any descriptor set it binds has been
+	 * updated, or any secondary command buffer it executes has been recorded again, since it was recorded.
+	 * Command buffers begun with VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT or
+	 * VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT do not use a replay stream.
+	 *
+	 * The value of this parameter may be changed at any time during application runtime,
+	 * and the changed value will immediately effect command buffers subsequently submitted.
+	 *
+	 * The initial value or this parameter is set by the
+	 * MVK_CONFIG_REPLAY_REUSABLE_COMMAND_BUFFERS
+	 * runtime environment variable or MoltenVK compile-time build setting.
+	 * If neither is set, the commands in each command buffer are encoded each time it is submitted.
+	 */
+	VkBool32 replayReusableCommandBuffers;
+
+	/**
+	 * Controls whether MoltenVK should acquire and return the MTLBuffer regions used for transient
+	 * data, such as push constants and implicit buffers, through per-thread caches of each region
+	 * size, in front of a lock-free list of free regions, instead of taking a lock on each acquire
+	 * and return. A lock is only taken when a new region must be created. When this is enabled,
+	 * the MTLBuffers that hold these regions are not marked volatile while they are unused.
+	 *
+	 * The value of this parameter may be changed at any time during application runtime,
+	 * and the changed value will immediately effect command pools subsequently created.
+	 *
+	 * The initial value or this parameter is set by the
+	 * MVK_CONFIG_USE_LOCK_FREE_BUFFER_ALLOCATION
+	 * runtime environment variable or MoltenVK compile-time build setting.
+	 * If neither is set, a lock is taken each time a region is acquired or returned.
+	 */
+	VkBool32 useLockFreeBufferAllocation;
+
+	/**
+	 * Controls whether MoltenVK should stream the commands recorded into a command buffer that is begun
+	 * with VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, when the prefillMetalCommandBuffers parameter is
+	 * also enabled. Each streamed command is configured in temporary memory, and encoded to the Metal
+	 * command buffer immediately, without acquiring a command object from the command pool, or retaining
+	 * it in the command buffer. Commands recorded within a multiview render pass are not streamed.
+	 *
+	 * The value of this parameter may be changed at any time during application runtime,
+	 * and the changed value will immediately effect command buffers subsequently begun.
+	 *
+	 * The initial value or this parameter is set by the
+	 * MVK_CONFIG_STREAM_ONE_TIME_SUBMIT_COMMANDS
+	 * runtime environment variable or MoltenVK compile-time build setting.
+	 * If neither is set, each prefilled command is acquired from the command pool, and released once encoded.
+	 */
+	VkBool32 streamOneTimeSubmitCommands;
+
+	/**
+	 * The maximum size, in bytes, of the scratch buffer used to hold decompressed texels, when the content
+	 * of a 3D texture in a compressed format, which Metal does not support on 3D textures, is decompressed
+	 * and uploaded to the texture. The content of each mipmap level is decompressed and uploaded through
+	 * the scratch buffer a few depth slices, or rows of texel blocks, at a time. A scratch buffer always
+	 * holds at least four rows of texels. If this value is zero, the content of each mipmap level is
+	 * decompressed into a buffer large enough to hold it all, and uploaded at once.
+	 *
+	 * The value of this parameter may be changed at any time during application runtime,
+	 * and the changed value will immediately effect texture content subsequently uploaded.
+	 *
+	 * The initial value or this parameter is set by the
+	 * MVK_CONFIG_TEXTURE_DECOMPRESSION_SCRATCH_SIZE
+	 * runtime environment variable or MoltenVK compile-time build setting.
+	 * If neither is set, the value of this parameter is 4 MB.
+	 */
+	uint32_t textureDecompressionScratchSize;
+
+	/**
+	 * Controls whether MoltenVK tracks the content of host-visible device memory, in 4 KB pages,
+	 * so that when a memory range is flushed, only the pages whose content has changed since it was
+	 * last flushed to, or pulled from, the images and buffers bound to the memory, are copied to them.
+	 * Each page is compared using a hash of its content, which is recorded for each page that lies
+	 * entirely within a flushed or pulled range. Pages that lie only partly within the range are always
+	 * copied. This avoids re-uploading unchanged texture content when a large range is flushed, such as
+	 * when host-coherent memory is unmapped, at the cost of hashing the content of the flushed range.
+	 * Because the GPU may overwrite the content of an image or buffer that can be written to by the GPU,
+	 * once command buffers have been submitted to any queue, the pages bound to such an image or buffer
+	 * are copied on the next flush, even if their host content has not changed.
+	 *
+	 * The value of this parameter may be changed at any time during application runtime,
+	 * and the changed value will immediately effect memory ranges subsequently flushed.
+	 *
+	 * The initial value or this parameter is set by the
+	 * MVK_CONFIG_TRACK_DIRTY_HOST_MEMORY_PAGES
+	 * runtime environment variable or MoltenVK compile-time build setting.
+	 * If neither is set, the entire flushed range is copied to the images and buffers bound to the memory.
+	 */
+	VkBool32 trackDirtyHostMemoryPages;
+
 } MVKConfiguration;
 
 /** Identifies the type of rounding Metal uses for float to integer conversions in particular calculatons. */
@@ -958,6 +1159,7 @@ typedef struct {
 	MVKPerformanceTracker sizePipelineCache;			/** Calculate the size of cache data required to write MSL to pipeline cache data stream. */
 	MVKPerformanceTracker writePipelineCache;			/** Write MSL to pipeline cache data stream. */
 	MVKPerformanceTracker readPipelineCache;			/** Read MSL from pipeline cache data stream. */
+	MVKPerformanceTracker lockContention;				/** Wait for another thread to release a pipeline cache lock, or to finish converting the same shader code. */
 } MVKPipelineCachePerformance;
 
 /** MoltenVK performance of queue activities. */
@@ -968,6 +1170,58 @@ typedef struct {
 	MVKPerformanceTracker frameInterval;				/** Frame presentation interval (1000/FPS). */
 } MVKQueuePerformance;
 
+/** MoltenVK performance of command buffer activities. */
+typedef struct {
+	MVKPerformanceTracker recordCommands;				/** Record commands into a command buffer, from vkBeginCommandBuffer() to vkEndCommandBuffer(). */
+	MVKPerformanceTracker encodeCommands;				/** Encode the commands in a command buffer into a MTLCommandBuffer. */
+	MVKPerformanceTracker releaseCommands;				/** Release the commands in a command buffer when it is reset. */
+	MVKPerformanceTracker coalesceCommands;				/** Remove and merge redundant state commands when recording into a command buffer ends. */
+} MVKCommandBufferPerformance;
+
+/** MoltenVK counts of resource bindings encoded to Metal command encoders. */
+typedef struct {
+	uint64_t encodedBindings;							/** Number of buffer, texture, and sampler bindings encoded to a Metal command encoder. */
+	uint64_t elidedBindings;							/** Number of bindings not encoded, because identical content was already bound at the same index. */
+} MVKResourceBindingPerformance;
+
+/** MoltenVK counts of redundant state commands coalesced in reusable command buffers. */
+typedef struct {
+	uint64_t removedCommands;							/** Number of commands removed, because their state was already set, or was set again before it was used. */
+	uint64_t mergedCommands;							/** Number of commands merged into a later command that sets an adjacent or overlapping range of the same state. */
+} MVKCommandCoalescingPerformance;
+
+/** MoltenVK counts of replay streams recorded and replayed for reusable command buffers. */
+typedef struct {
+	uint64_t recordedStreams;							/** Number of replay streams recorded while encoding a command buffer. */
+	uint64_t replayedStreams;							/** Number of command buffer submissions encoded by replaying a replay stream. */
+	uint64_t invalidatedStreams;						/** Number of replay streams recorded again, because an object they depend on had changed. */
+} MVKCommandReplayPerformance;
+
+/** MoltenVK counts of transient data uploaded through the upload ring of each command encoder. */
+typedef struct {
+	uint64_t uploadedRegions;							/** Number of regions of push constant, implicit buffer, and buffer update data sub-allocated from an upload ring. */
+	uint64_t acquiredBlocks;							/** Number of MTLBuffer blocks acquired by upload rings to hold those regions. */
+} MVKUploadRingPerformance;
+
+/** MoltenVK counts of pipeline barriers recorded, and merged at record time. */
+typedef struct {
+	uint64_t recordedBarriers;							/** Number of memory, buffer, and image barriers recorded by vkCmdPipelineBarrier(). */
+	uint64_t mergedBarriers;							/** Number of barriers merged into another barrier recorded by the same command. */
+} MVKPipelineBarrierPerformance;
+
+/** MoltenVK counts of compressed 3D texture content decompressed and uploaded through a scratch buffer. */
+typedef struct {
+	uint64_t decompressedBytes;							/** Number of bytes of decompressed texels uploaded to 3D textures. */
+	uint64_t uploadedRegions;							/** Number of regions of decompressed texels uploaded, each through the scratch buffer. */
+	uint64_t peakScratchBytes;							/** Size of the largest scratch buffer used to hold decompressed texels. */
+} MVKTextureDecompressionPerformance;
+
+/** MoltenVK counts of bytes of host-visible memory flushed, and of content actually copied to images and buffers. */
+typedef struct {
+	uint64_t flushedBytes;								/** Number of bytes of host-visible memory flushed to the images and buffers bound to it. */
+	uint64_t transferredBytes;							/** Number of bytes of flushed content copied to images and buffers. */
+} MVKHostMemoryFlushPerformance;
+
 /**
  * MoltenVK performance. You can retrieve a copy of this structure using the vkGetPerformanceStatisticsMVK() function.
  *
@@ -985,6 +1239,14 @@ typedef struct {
 	MVKShaderCompilationPerformance shaderCompilation;	/** Shader compilations activities. */
 	MVKPipelineCachePerformance pipelineCache;			/** Pipeline cache activities. */
 	MVKQueuePerformance queue;          				/** Queue activities. */
+	MVKCommandBufferPerformance commandBuffer;			/** Command buffer activities. */
+	MVKResourceBindingPerformance resourceBinding;		/** Resource binding counts. */
+	MVKCommandCoalescingPerformance commandCoalescing;	/** Command coalescing counts. */
+	MVKCommandReplayPerformance commandReplay;			/** Command buffer replay stream counts. */
+	MVKUploadRingPerformance uploadRing;				/** Upload ring counts. */
+	MVKPipelineBarrierPerformance pipelineBarrier;		/** Pipeline barrier counts. */
+	MVKTextureDecompressionPerformance textureDecompression;	/** Compressed 3D texture decompression counts. */
+	MVKHostMemoryFlushPerformance hostMemoryFlush;		/** Host memory flush counts. */
 } MVKPerformanceStatistics;
 
 
@@ -0,0 +1,111 @@
+/*
+ * MVKBufferUploadRing.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// The contents of this file do not depend on Metal, or on the MoltenVK buffer allocation classes,
+// so that the sub-allocation of upload regions can be exercised with any block type.
+
+
+#pragma mark -
+#pragma mark MVKBufferUploadRing
+
+/**
+ * Sub-allocates transient regions, such as the constant data uploaded while encoding a command
+ * buffer, by advancing an offset through a small number of large blocks. Each region is aligned,
+ * within its block, to the alignment specified when this ring is created, which must be a power
+ * of two. A region larger than a block is given its own block, which does not replace the block
+ * that regions are currently sub-allocated from.
+ *
+ * Blocks are acquired using the function passed to the constructor. Regions are not returned
+ * individually. Instead, recycle() hands over all of the blocks acquired since the previous
+ * recycle, so that they can be returned together once they are no longer in use.
+ *
+ * The block type B is not accessed by this class, so it can be any type, such as MVKMTLBufferAllocation.
+ *
+ * This class is not thread-safe.
+ */
+template <class B>
+class MVKBufferUploadRing {
+
+public:
+
+	/** A region sub-allocated from a block. */
+	typedef struct Region {
+		B* block;			/**< The block containing the region. */
+		size_t offset;		/**< The offset of the region from the start of the block. */
+		size_t length;		/**< The length of the region. */
+	} Region;
+
+	/** Returns a region of the specified length. */
+	Region acquireRegion(size_t length) {
+		_regionCount++;
+
+		if (length > _blockLength) {
+			B* block = _acquireBlock(length);
+			_blocks.push_back(block);
+			return { block, 0, length };
+		}
+
+		size_t offset = (_nextOffset + _alignment - 1) & ~(_alignment - 1);
+		if ( !_currentBlock || offset + length > _blockLength ) {
+			_currentBlock = _acquireBlock(_blockLength);
+			_blocks.push_back(_currentBlock);
+			offset = 0;
+		}
+		_nextOffset = offset + length;
+		return { _currentBlock, offset, length };
+	}
+
+	/**
+	 * Appends all blocks acquired since the previous recycle to the vector, and returns the number of
+	 * regions sub-allocated from those blocks. Regions subsequently acquired are sub-allocated from new blocks.
+	 */
+	uint32_t recycle(std::vector<B*>& blocks) {
+		uint32_t regionCnt = _regionCount;
+		blocks.insert(blocks.end(), _blocks.begin(), _blocks.end());
+		_blocks.clear();
+		_currentBlock = nullptr;
+		_nextOffset = 0;
+		_regionCount = 0;
+		return regionCnt;
+	}
+
+	/** Returns the blocks acquired since the previous recycle. */
+	const std::vector<B*>& getBlocks() { return _blocks; }
+
+	/** Returns the number of blocks acquired since the previous recycle. */
+	uint32_t getBlockCount() { return (uint32_t)_blocks.size(); }
+
+	MVKBufferUploadRing(std::function<B*(size_t length)> acquireBlock, size_t alignment, size_t blockLength) :
+		_acquireBlock(std::move(acquireBlock)), _alignment(alignment ? alignment : 1), _blockLength(blockLength) {}
+
+protected:
+	std::function<B*(size_t length)> _acquireBlock;
+	std::vector<B*> _blocks;
+	B* _currentBlock = nullptr;
+	size_t _alignment;
+	size_t _blockLength;
+	size_t _nextOffset = 0;
+	uint32_t _regionCount = 0;
+};
@@ -47,6 +47,7 @@ class MVKCmdDebugMarkerBegin : public MVKCmdDebugMarker {
 
 public:
 	void encode(MVKCommandEncoder* cmdEncoder) override;
+	MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeCommandBuffer; }
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
@@ -64,6 +65,7 @@ public:
 	VkResult setContent(MVKCommandBuffer* cmdBuff);
 
 	void encode(MVKCommandEncoder* cmdEncoder) override;
+	MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeCommandBuffer; }
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
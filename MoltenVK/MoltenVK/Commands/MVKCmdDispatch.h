@@ -35,6 +35,7 @@ public:
 						uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
 
     void encode(MVKCommandEncoder* cmdEncoder) override;
+    MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeBoundary; }
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
@@ -58,6 +59,7 @@ public:
 	VkResult setContent(MVKCommandBuffer* cmdBuff, VkBuffer buffer, VkDeviceSize offset);
 
 	void encode(MVKCommandEncoder* cmdEncoder) override;
+	MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeBoundary; }
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
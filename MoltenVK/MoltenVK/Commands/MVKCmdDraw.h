@@ -43,6 +43,7 @@ public:
 						const VkDeviceSize* pOffsets);
 
     void encode(MVKCommandEncoder* cmdEncoder) override;
+    MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeState; }
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
@@ -69,6 +70,7 @@ public:
 						VkIndexType indexType);
 
 	void encode(MVKCommandEncoder* cmdEncoder) override;
+	MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeState; }
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
@@ -36,6 +36,10 @@ class MVKDescriptorUpdateTemplate;
 /**
  * Vulkan command to add a pipeline barrier.
  * Template class to balance vector pre-allocations between very common low counts and fewer larger counts.
+ *
+ * Barriers are merged as they are recorded. All memory barriers are merged into a single global
+ * memory barrier, and each buffer or image barrier is merged into the previous barrier, if it
+ * covers an adjacent or overlapping range of the same resource.
  */
 template <size_t N>
 class MVKCmdPipelineBarrier : public MVKCommand {
@@ -58,10 +62,13 @@ protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
 	bool coversTextures();
 
-	MVKSmallVector<MVKPipelineBarrier, N> _barriers;
+	MVKSmallVector<MVKPipelineBarrier, N> _barriers;	// Buffer barriers, followed by image barriers
+	MVKPipelineBarrier _memoryBarrier;					// All memory barriers, merged into one global barrier
 	VkPipelineStageFlags _srcStageMask;
 	VkPipelineStageFlags _dstStageMask;
 	VkDependencyFlags _dependencyFlags;
+	uint32_t _bufferBarrierCount;
+	bool _hasMemoryBarrier;
 };
 
 // Concrete template class implementations.
@@ -81,6 +88,8 @@ public:
 
 	virtual bool isTessellationPipeline() { return false; };
 
+	MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeState; }
+
 protected:
 	MVKPipeline* _pipeline;
 
@@ -138,6 +147,10 @@ public:
 						const VkDescriptorSet* pDescriptorSets);
 
 	void encode(MVKCommandEncoder* cmdEncoder) override;
+	MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeState; }
+	MVKCommandStateContent getStateContent() override;
+	bool mergeStateContent(const MVKCommandStateContent& prevContent) override;
+	MVKCommandReplayMode getReplayMode() override { return kMVKCommandReplayBindings; }
 
 	~MVKCmdBindDescriptorSetsStatic() override;
 
@@ -178,6 +191,7 @@ public:
 						const uint32_t* pDynamicOffsets);
 
 	void encode(MVKCommandEncoder* cmdEncoder) override;
+	MVKCommandStateContent getStateContent() override;
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
@@ -209,6 +223,9 @@ public:
 						const void* pValues);
 
 	void encode(MVKCommandEncoder* cmdEncoder) override;
+	MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeState; }
+	MVKCommandStateContent getStateContent() override;
+	bool mergeStateContent(const MVKCommandStateContent& prevContent) override;
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
@@ -239,6 +256,8 @@ public:
 						const VkWriteDescriptorSet* pDescriptorWrites);
 
 	void encode(MVKCommandEncoder* cmdEncoder) override;
+	MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeState; }
+	MVKCommandStateContent getStateContent() override { return { kMVKCommandStateAll }; }
 
 	~MVKCmdPushDescriptorSet() override;
 
@@ -267,6 +286,8 @@ public:
 						const void* pData);
 
 	void encode(MVKCommandEncoder* cmdEncoder) override;
+	MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeState; }
+	MVKCommandStateContent getStateContent() override { return { kMVKCommandStateAll }; }
 
 	~MVKCmdPushDescriptorSetWithTemplate() override;
 
@@ -291,6 +312,8 @@ public:
 						VkEvent event,
 						VkPipelineStageFlags stageMask);
 
+	MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeCommandBuffer; }
+
 protected:
 	MVKEvent* _mvkEvent;
 
@@ -352,6 +375,7 @@ public:
 						const VkImageMemoryBarrier* pImageMemoryBarriers);
 
 	void encode(MVKCommandEncoder* cmdEncoder) override;
+	MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeCommandBuffer; }
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
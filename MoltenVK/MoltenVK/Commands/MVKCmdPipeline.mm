@@ -46,18 +46,30 @@ VkResult MVKCmdPipelineBarrier<N>::setContent(MVKCommandBuffer* cmdBuff,
 	_dependencyFlags = dependencyFlags;
 
 	_barriers.clear();	// Clear for reuse
-	_barriers.reserve(memoryBarrierCount + bufferMemoryBarrierCount + imageMemoryBarrierCount);
+	_barriers.reserve(bufferMemoryBarrierCount + imageMemoryBarrierCount);
 
+	_memoryBarrier = MVKPipelineBarrier();
+	_hasMemoryBarrier = memoryBarrierCount > 0;
 	for (uint32_t i = 0; i < memoryBarrierCount; i++) {
-		_barriers.emplace_back(pMemoryBarriers[i]);
+		_memoryBarrier.mergeMemoryBarrier(pMemoryBarriers[i]);
 	}
 	for (uint32_t i = 0; i < bufferMemoryBarrierCount; i++) {
-		_barriers.emplace_back(pBufferMemoryBarriers[i]);
+		if (_barriers.empty() || !_barriers.back().mergeBufferBarrier(pBufferMemoryBarriers[i])) {
+			_barriers.emplace_back(pBufferMemoryBarriers[i]);
+		}
 	}
+	_bufferBarrierCount = (uint32_t)_barriers.size();
 	for (uint32_t i = 0; i < imageMemoryBarrierCount; i++) {
-		_barriers.emplace_back(pImageMemoryBarriers[i]);
+		if (_barriers.size() == _bufferBarrierCount || !_barriers.back().mergeImageBarrier(pImageMemoryBarriers[i])) {
+			_barriers.emplace_back(pImageMemoryBarriers[i]);
+		}
 	}
 
+	uint32_t barrierCnt = memoryBarrierCount + bufferMemoryBarrierCount + imageMemoryBarrierCount;
+	MVKDevice* mvkDev = cmdBuff->getDevice();
+	mvkDev->addCountPerformance(mvkDev->_performanceStatistics.pipelineBarrier.recordedBarriers, barrierCnt);
+	mvkDev->addCountPerformance(mvkDev->_performanceStatistics.pipelineBarrier.mergedBarriers, barrierCnt - (_hasMemoryBarrier + (uint32_t)_barriers.size()));
+
 	return VK_SUCCESS;
 }
 
@@ -71,32 +83,27 @@ void MVKCmdPipelineBarrier<N>::encode(MVKCommandEncoder* cmdEncoder) {
 		MTLRenderStages srcStages = mvkMTLRenderStagesFromVkPipelineStageFlags(_srcStageMask, false);
 		MTLRenderStages dstStages = mvkMTLRenderStagesFromVkPipelineStageFlags(_dstStageMask, true);
 
-		id<MTLResource> resources[_barriers.size()];
+		if (_hasMemoryBarrier) {
+			MTLBarrierScope scope = (mvkMTLBarrierScopeFromVkAccessFlags(_memoryBarrier.srcAccessMask) |
+									 mvkMTLBarrierScopeFromVkAccessFlags(_memoryBarrier.dstAccessMask));
+			[cmdEncoder->_mtlRenderEncoder memoryBarrierWithScope: scope
+													  afterStages: srcStages
+													 beforeStages: dstStages];
+		}
+
+		// Each image may have up to three planes.
+		id<MTLResource> resources[_bufferBarrierCount + (_barriers.size() - _bufferBarrierCount) * 3];
 		uint32_t rezCnt = 0;
 
-		for (auto& b : _barriers) {
-			switch (b.type) {
-				case MVKPipelineBarrier::Memory: {
-					MTLBarrierScope scope = (mvkMTLBarrierScopeFromVkAccessFlags(b.srcAccessMask) |
-											 mvkMTLBarrierScopeFromVkAccessFlags(b.dstAccessMask));
-					[cmdEncoder->_mtlRenderEncoder memoryBarrierWithScope: scope
-															  afterStages: srcStages
-															 beforeStages: dstStages];
-					break;
+		uint32_t barrierCnt = (uint32_t)_barriers.size();
+		for (uint32_t bIdx = 0; bIdx < barrierCnt; bIdx++) {
+			auto& b = _barriers[bIdx];
+			if (bIdx < _bufferBarrierCount) {
+				resources[rezCnt++] = b.mvkBuffer->getMTLBuffer();
+			} else {
+				for (uint8_t planeIndex = 0; planeIndex < b.mvkImage->getPlaneCount(); planeIndex++) {
+					resources[rezCnt++] = b.mvkImage->getMTLTexture(planeIndex);
 				}
-
-				case MVKPipelineBarrier::Buffer:
-					resources[rezCnt++] = b.mvkBuffer->getMTLBuffer();
-					break;
-
-				case MVKPipelineBarrier::Image:
-                    for (uint8_t planeIndex = 0; planeIndex < b.mvkImage->getPlaneCount(); planeIndex++) {
-                        resources[rezCnt++] = b.mvkImage->getMTLTexture(planeIndex);
-                    }
-					break;
-
-				default:
-					break;
 			}
 		}
 
@@ -121,8 +128,9 @@ void MVKCmdPipelineBarrier<N>::encode(MVKCommandEncoder* cmdEncoder) {
 	// by checking for a VK_IMAGE_LAYOUT_GENERAL layout.
 	if (cmdEncoder->_mtlRenderEncoder && cmdEncoder->getDevice()->_pMetalFeatures->tileBasedDeferredRendering) {
 		bool needsRenderpassRestart = false;
-		for (auto& b : _barriers) {
-			if (b.type == MVKPipelineBarrier::Image && b.newLayout == VK_IMAGE_LAYOUT_GENERAL) {
+		uint32_t barrierCnt = (uint32_t)_barriers.size();
+		for (uint32_t bIdx = _bufferBarrierCount; bIdx < barrierCnt; bIdx++) {
+			if (_barriers[bIdx].newLayout == VK_IMAGE_LAYOUT_GENERAL) {
 				needsRenderpassRestart = true;
 				break;
 			}
@@ -136,36 +144,24 @@ void MVKCmdPipelineBarrier<N>::encode(MVKCommandEncoder* cmdEncoder) {
 	MVKDevice* mvkDvc = cmdEncoder->getDevice();
 	MVKCommandUse cmdUse = kMVKCommandUsePipelineBarrier;
 
-	for (auto& b : _barriers) {
-		switch (b.type) {
-			case MVKPipelineBarrier::Memory:
-				mvkDvc->applyMemoryBarrier(_srcStageMask, _dstStageMask, b, cmdEncoder, cmdUse);
-				break;
-
-			case MVKPipelineBarrier::Buffer:
-				b.mvkBuffer->applyBufferMemoryBarrier(_srcStageMask, _dstStageMask, b, cmdEncoder, cmdUse);
-				break;
-
-			case MVKPipelineBarrier::Image:
-				b.mvkImage->applyImageMemoryBarrier(_srcStageMask, _dstStageMask, b, cmdEncoder, cmdUse);
-				break;
+	if (_hasMemoryBarrier) {
+		mvkDvc->applyMemoryBarrier(_srcStageMask, _dstStageMask, _memoryBarrier, cmdEncoder, cmdUse);
+	}
 
-			default:
-				break;
+	uint32_t barrierCnt = (uint32_t)_barriers.size();
+	for (uint32_t bIdx = 0; bIdx < barrierCnt; bIdx++) {
+		auto& b = _barriers[bIdx];
+		if (bIdx < _bufferBarrierCount) {
+			b.mvkBuffer->applyBufferMemoryBarrier(_srcStageMask, _dstStageMask, b, cmdEncoder, cmdUse);
+		} else {
+			b.mvkImage->applyImageMemoryBarrier(_srcStageMask, _dstStageMask, b, cmdEncoder, cmdUse);
 		}
 	}
 }
 
 template <size_t N>
 bool MVKCmdPipelineBarrier<N>::coversTextures() {
-	for (auto& b : _barriers) {
-		switch (b.type) {
-			case MVKPipelineBarrier::Memory:	return true;
-			case MVKPipelineBarrier::Image: 	return true;
-			default: 							break;
-		}
-	}
-	return false;
+	return _hasMemoryBarrier || _barriers.size() > _bufferBarrierCount;
 }
 
 template class MVKCmdPipelineBarrier<1>;
@@ -243,6 +239,26 @@ void MVKCmdBindDescriptorSetsStatic<N>::encode(MVKCommandEncoder* cmdEncoder, MV
 	_pipelineLayout->bindDescriptorSets(cmdEncoder, _pipelineBindPoint, _descriptorSets.contents(), _firstSet, dynamicOffsets);
 }
 
+template <size_t N>
+MVKCommandStateContent MVKCmdBindDescriptorSetsStatic<N>::getStateContent() {
+	MVKCommandStateContent content;
+	content.stateType = (_pipelineBindPoint == VK_PIPELINE_BIND_POINT_COMPUTE
+						 ? kMVKCommandStateComputeDescriptorSets
+						 : kMVKCommandStateGraphicsDescriptorSets);
+	content.layout = _pipelineLayout;
+	content.firstElement = _firstSet;
+	content.elementCount = (uint32_t)_descriptorSets.size();
+	content.elementSize = sizeof(MVKDescriptorSet*);
+	content.elements = _descriptorSets.data();
+	return content;
+}
+
+template <size_t N>
+bool MVKCmdBindDescriptorSetsStatic<N>::mergeStateContent(const MVKCommandStateContent& prevContent) {
+	mvkMergeCommandStateContent(_descriptorSets, _firstSet, prevContent);
+	return true;
+}
+
 template <size_t N>
 MVKCmdBindDescriptorSetsStatic<N>::~MVKCmdBindDescriptorSetsStatic() {
 	if (_pipelineLayout) { _pipelineLayout->release(); }
@@ -284,6 +300,15 @@ void MVKCmdBindDescriptorSetsDynamic<N>::encode(MVKCommandEncoder* cmdEncoder) {
 	MVKCmdBindDescriptorSetsStatic<N>::encode(cmdEncoder, _dynamicOffsets.contents());
 }
 
+// The descriptor sets are bound with dynamic offsets, which cannot be compared to those
+// of other commands, so this command binds descriptor sets without comparable content.
+template <size_t N>
+MVKCommandStateContent MVKCmdBindDescriptorSetsDynamic<N>::getStateContent() {
+	MVKCommandStateContent content = MVKCmdBindDescriptorSetsStatic<N>::getStateContent();
+	content.elements = nullptr;
+	return content;
+}
+
 template class MVKCmdBindDescriptorSetsDynamic<4>;
 template class MVKCmdBindDescriptorSetsDynamic<8>;
 
@@ -323,6 +348,24 @@ void MVKCmdPushConstants<N>::encode(MVKCommandEncoder* cmdEncoder) {
     }
 }
 
+template <size_t N>
+MVKCommandStateContent MVKCmdPushConstants<N>::getStateContent() {
+	MVKCommandStateContent content;
+	content.stateType = kMVKCommandStatePushConstants;
+	content.selector = _stageFlags;
+	content.firstElement = _offset;
+	content.elementCount = (uint32_t)_pushConstants.size();
+	content.elementSize = sizeof(char);
+	content.elements = _pushConstants.data();
+	return content;
+}
+
+template <size_t N>
+bool MVKCmdPushConstants<N>::mergeStateContent(const MVKCommandStateContent& prevContent) {
+	mvkMergeCommandStateContent(_pushConstants, _offset, prevContent);
+	return true;
+}
+
 template class MVKCmdPushConstants<64>;
 template class MVKCmdPushConstants<128>;
 template class MVKCmdPushConstants<512>;
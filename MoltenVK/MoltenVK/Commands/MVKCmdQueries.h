@@ -35,6 +35,8 @@ public:
 						VkQueryPool queryPool,
 						uint32_t query);
 
+	MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeCommandBuffer; }
+
 protected:
     MVKQueryPool* _queryPool;
     uint32_t _query;
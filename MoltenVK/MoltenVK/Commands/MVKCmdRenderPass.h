@@ -44,6 +44,11 @@ public:
 
 	inline MVKRenderPass* getRenderPass() { return _renderPass; }
 
+	/** The encoder references this command when it repeats the commands of each pass of a multiview render pass. */
+	static constexpr bool canStream() { return false; }
+
+	MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeBoundary; }
+
 protected:
 
 	MVKRenderPass* _renderPass;
@@ -153,6 +158,9 @@ public:
 						const VkCommandBuffer* pCommandBuffers);
 
 	void encode(MVKCommandEncoder* cmdEncoder) override;
+	MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeCommandBuffer; }
+	MVKCommandStateContent getStateContent() override { return { kMVKCommandStateAll }; }
+	MVKCommandReplayMode getReplayMode() override { return kMVKCommandReplayExpand; }
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
@@ -182,6 +190,9 @@ public:
 						const VkViewport* pViewports);
 
 	void encode(MVKCommandEncoder* cmdEncoder) override;
+	MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeState; }
+	MVKCommandStateContent getStateContent() override;
+	bool mergeStateContent(const MVKCommandStateContent& prevContent) override;
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
@@ -212,6 +223,9 @@ public:
 						const VkRect2D* pScissors);
 
 	void encode(MVKCommandEncoder* cmdEncoder) override;
+	MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeState; }
+	MVKCommandStateContent getStateContent() override;
+	bool mergeStateContent(const MVKCommandStateContent& prevContent) override;
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
@@ -236,6 +250,7 @@ public:
 					float lineWidth);
 
     void encode(MVKCommandEncoder* cmdEncoder) override;
+    MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeState; }
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
@@ -257,6 +272,7 @@ public:
 						float depthBiasSlopeFactor);
 
     void encode(MVKCommandEncoder* cmdEncoder) override;
+    MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeState; }
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
@@ -278,6 +294,7 @@ public:
 						const float blendConst[4]);
 
     void encode(MVKCommandEncoder* cmdEncoder) override;
+    MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeState; }
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
@@ -301,6 +318,7 @@ public:
 						float maxDepthBounds);
 
     void encode(MVKCommandEncoder* cmdEncoder) override;
+    MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeState; }
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
@@ -322,6 +340,7 @@ public:
 						uint32_t stencilCompareMask);
 
     void encode(MVKCommandEncoder* cmdEncoder) override;
+    MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeState; }
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
@@ -343,6 +362,7 @@ public:
 						uint32_t stencilWriteMask);
 
     void encode(MVKCommandEncoder* cmdEncoder) override;
+    MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeState; }
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
@@ -364,6 +384,7 @@ public:
 						uint32_t stencilReference);
 
     void encode(MVKCommandEncoder* cmdEncoder) override;
+    MVKCommandEncodingScope getEncodingScope() override { return kMVKCommandEncodingScopeState; }
 
 protected:
 	MVKCommandTypePool<MVKCommand>* getTypePool(MVKCommandPool* cmdPool) override;
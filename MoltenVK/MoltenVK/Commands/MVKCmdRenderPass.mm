@@ -181,6 +181,23 @@ void MVKCmdSetViewport<N>::encode(MVKCommandEncoder* cmdEncoder) {
 	cmdEncoder->_viewportState.setViewports(_viewports.contents(), _firstViewport, true);
 }
 
+template <size_t N>
+MVKCommandStateContent MVKCmdSetViewport<N>::getStateContent() {
+	MVKCommandStateContent content;
+	content.stateType = kMVKCommandStateViewports;
+	content.firstElement = _firstViewport;
+	content.elementCount = (uint32_t)_viewports.size();
+	content.elementSize = sizeof(VkViewport);
+	content.elements = _viewports.data();
+	return content;
+}
+
+template <size_t N>
+bool MVKCmdSetViewport<N>::mergeStateContent(const MVKCommandStateContent& prevContent) {
+	mvkMergeCommandStateContent(_viewports, _firstViewport, prevContent);
+	return true;
+}
+
 template class MVKCmdSetViewport<1>;
 template class MVKCmdSetViewport<kMVKCachedViewportScissorCount>;
 
@@ -208,6 +225,23 @@ void MVKCmdSetScissor<N>::encode(MVKCommandEncoder* cmdEncoder) {
     cmdEncoder->_scissorState.setScissors(_scissors.contents(), _firstScissor, true);
 }
 
+template <size_t N>
+MVKCommandStateContent MVKCmdSetScissor<N>::getStateContent() {
+	MVKCommandStateContent content;
+	content.stateType = kMVKCommandStateScissors;
+	content.firstElement = _firstScissor;
+	content.elementCount = (uint32_t)_scissors.size();
+	content.elementSize = sizeof(VkRect2D);
+	content.elements = _scissors.data();
+	return content;
+}
+
+template <size_t N>
+bool MVKCmdSetScissor<N>::mergeStateContent(const MVKCommandStateContent& prevContent) {
+	mvkMergeCommandStateContent(_scissors, _firstScissor, prevContent);
+	return true;
+}
+
 template class MVKCmdSetScissor<1>;
 template class MVKCmdSetScissor<kMVKCachedViewportScissorCount>;
 
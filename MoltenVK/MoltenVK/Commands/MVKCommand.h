@@ -20,6 +20,14 @@
 
 
 #include "MVKObjectPool.h"
+#include "MVKCommandArena.h"
+#include "MVKCommandEncodingPlan.h"
+#include "MVKCommandStateContent.h"
+#include "MVKCommandReplayStream.h"
+#include "MVKSmallVector.h"
+#include "MVKFoundation.h"
+#include <cstring>
+#include <new>
 
 class MVKCommandBuffer;
 class MVKCommandEncoder;
@@ -67,6 +75,39 @@ public:
 	/** Encodes this command on the specified command encoder. */
 	virtual void encode(MVKCommandEncoder* cmdEncoder) = 0;
 
+	/**
+	 * Returns how this command constrains the division of its command buffer into segments that are
+	 * encoded concurrently. Commands encode into the same segment as the commands before them by default.
+	 */
+	virtual MVKCommandEncodingScope getEncodingScope() { return kMVKCommandEncodingScopeSegment; }
+
+	/**
+	 * Returns the content of the encoder state set by this command, which is used to remove redundant
+	 * state commands from a command buffer when recording ends. Commands do not set any state by default.
+	 */
+	virtual MVKCommandStateContent getStateContent() { return {}; }
+
+	/**
+	 * Merges the content of the state set by an earlier command of the same type into the content of
+	 * the state set by this command, so that the earlier command can be removed. The ranges of elements
+	 * set by the two commands must overlap or abut. Returns whether the content was merged.
+	 * Returns false by default.
+	 */
+	virtual bool mergeStateContent(const MVKCommandStateContent& prevContent) { return false; }
+
+	/**
+	 * Returns how this command is represented in the replay stream of a reusable command buffer.
+	 * Commands are encoded again each time the stream is replayed by default.
+	 */
+	virtual MVKCommandReplayMode getReplayMode() { return kMVKCommandReplayEncode; }
+
+	/**
+	 * Returns whether commands of this type can be streamed, by encoding a temporary instance of the
+	 * command directly, without acquiring the command from its pool or retaining it in the command buffer.
+	 * Commands of a type that must be referenced after they are encoded hide this function to return false.
+	 */
+	static constexpr bool canStream() { return true; }
+
 protected:
 	friend MVKCommandBuffer;
 
@@ -0,0 +1,122 @@
+/*
+ * MVKCommandArena.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+
+// The contents of this file do not depend on Metal, or on the MoltenVK command classes,
+// so that the allocation of command memory can be exercised with any command type.
+
+
+#pragma mark -
+#pragma mark MVKCommandArena
+
+/** The size of each memory chunk allocated by a MVKCommandArena. */
+static constexpr size_t kMVKCommandArenaChunkSize = 64 * 1024;
+
+/**
+ * Allocates memory for the commands recorded into a command buffer, by advancing an offset
+ * through a list of contiguous memory chunks, so that consecutively recorded commands are
+ * adjacent in memory, regardless of their type.
+ *
+ * Memory is not returned to the arena for each command. Instead, once each command allocated
+ * from the arena has been destroyed, the arena is reset in constant time, and the same memory
+ * chunks are reused for the commands allocated next. Memory chunks are only released when the
+ * arena is trimmed or destroyed.
+ *
+ * This class is not thread-safe.
+ */
+class MVKCommandArena {
+
+public:
+
+	/** Constructs and returns a new instance of the command type, in memory allocated from this arena. */
+	template <class T>
+	T* newCommand() { return new (allocate(sizeof(T), alignof(T))) T(); }
+
+	/**
+	 * Allocates memory of the specified size and alignment, which must be a power of two.
+	 *
+	 * Like the operator new used by the command type pools, this function throws std::bad_alloc
+	 * if the memory cannot be allocated, so a null command is never returned to the caller.
+	 */
+	void* allocate(size_t size, size_t alignment) {
+		assert(alignment <= alignof(std::max_align_t) && "MVKCommandArena does not support over-aligned types.");
+		size_t chunkCnt = _chunks.size();
+		while (_chunkIndex < chunkCnt) {
+			auto& chunk = _chunks[_chunkIndex];
+			size_t offset = (_offset + alignment - 1) & ~(alignment - 1);
+			if (offset + size <= chunk.second) {
+				_offset = offset + size;
+				return chunk.first + offset;
+			}
+			_chunkIndex++;
+			_offset = 0;
+		}
+
+		// Objects larger than the standard chunk size are given their own chunk.
+		size_t chunkSize = std::max(size, kMVKCommandArenaChunkSize);
+		char* pChunk = (char*)malloc(chunkSize);
+		if ( !pChunk ) { throw std::bad_alloc(); }
+		_chunks.emplace_back(pChunk, chunkSize);
+		_chunkIndex = chunkCnt;
+		_offset = size;
+		return _chunks.back().first;
+	}
+
+	/** Makes all memory in this arena available for reuse. The objects in the memory must have been destroyed. */
+	void reset() {
+		_chunkIndex = 0;
+		_offset = 0;
+	}
+
+	/** Resets this arena, and releases all memory held by it. */
+	void trim() {
+		for (auto& chunk : _chunks) { free(chunk.first); }
+		_chunks.clear();
+		reset();
+	}
+
+	/**
+	 * Releases the memory chunks that follow the chunk currently being allocated from. Unlike trim(),
+	 * this can be called while objects allocated from this arena are still in use. If the arena
+	 * has been reset, all memory held by it is released.
+	 */
+	void trimUnused() {
+		size_t usedChunkCnt = _chunkIndex + (_offset ? 1 : 0);
+		for (size_t chunkIdx = usedChunkCnt; chunkIdx < _chunks.size(); chunkIdx++) { free(_chunks[chunkIdx].first); }
+		_chunks.resize(std::min(usedChunkCnt, _chunks.size()));
+	}
+
+	/** Returns the number of memory chunks held by this arena. */
+	size_t getChunkCount() { return _chunks.size(); }
+
+	~MVKCommandArena() { trim(); }
+
+protected:
+	std::vector<std::pair<char*, size_t>> _chunks;
+	size_t _chunkIndex = 0;
+	size_t _offset = 0;
+};
@@ -55,6 +55,16 @@ typedef struct MVKCommandEncodingContext {
 } MVKCommandEncodingContext;
 
 
+#pragma mark -
+#pragma mark MVKCommandReplayDependencyKind
+
+/** Identifies the type of an object on which the replay stream of a command buffer depends. */
+typedef enum : uint32_t {
+	kMVKCommandReplayDependencyDescriptorSet = 0,	/**< A descriptor set whose resources were resolved into bindings. */
+	kMVKCommandReplayDependencyCommandBuffer,		/**< A secondary command buffer whose commands were expanded in place. */
+} MVKCommandReplayDependencyKind;
+
+
 #pragma mark -
 #pragma mark MVKCommandBuffer
 
@@ -82,9 +92,38 @@ public:
 	/** Closes this buffer from receiving commands and prepares for submission to a queue. */
 	VkResult end();
 
+	/**
+	 * Returns a new command of the type, to be populated and then added to this command buffer using addCommand().
+	 * If the command pool uses command arenas, the command is allocated from the command arena of this command
+	 * buffer, otherwise it is acquired from the specified command type pool of the command pool.
+	 */
+	template <class T>
+	T* acquireCommand(MVKCommandTypePool<T>& cmdTypePool) {
+		return _usesCommandArena ? _commandArena.newCommand<T>() : cmdTypePool.acquireObject();
+	}
+
 	/** Adds the specified execution command at the end of this command buffer. */
 	void addCommand(MVKCommand* command);
 
+	/** Releases any memory held by the command arena of this command buffer that is not in use by recorded commands. */
+	void trimCommandArena() { _commandArena.trimUnused(); }
+
+	/** Releases a command that was acquired using acquireCommand(), but was not added to this command buffer. */
+	void releaseCommand(MVKCommand* command);
+
+	/**
+	 * Returns whether commands are currently being streamed into this command buffer. Streamed commands
+	 * are constructed temporarily by the caller, and passed to encodeStreamedCommand() instead of
+	 * being acquired with acquireCommand() and passed to addCommand().
+	 *
+	 * Commands are streamed into a command buffer that is prefilled, and begun with
+	 * VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, outside of a multiview render pass.
+	 */
+	inline bool isStreamingCommands() { return _isStreamingCommands && _canAcceptCommands && !getLastMultiviewSubpass(); }
+
+	/** Encodes a temporary command immediately, without retaining it in this command buffer. */
+	void encodeStreamedCommand(MVKCommand* command);
+
 	/** Returns the number of commands currently in this command buffer. */
 	inline uint32_t getCommandCount() { return _commandCount; }
 
@@ -97,6 +136,9 @@ public:
     /** Returns whether this command buffer can be submitted to a queue more than once. */
     inline bool getIsReusable() { return _isReusable; }
 
+	/** Returns the version of the commands recorded into this command buffer, which changes each time it is reset. */
+	inline uint64_t getRecordingVersion() { return _recordingVersion; }
+
     /**
      * Metal requires that a visibility buffer is established when a render pass is created, 
      * but Vulkan permits it to be set during a render pass. When the first occlusion query
@@ -110,11 +152,14 @@ public:
 
 #pragma mark Tessellation constituent command management
 
-	/** Update the last recorded pipeline with tessellation shaders */
+	/** Update whether the last recorded pipeline has tessellation shaders */
 	void recordBindPipeline(MVKCmdBindPipeline* mvkBindPipeline);
 
-	/** The most recent recorded tessellation pipeline */
-	MVKCmdBindPipeline* _lastTessellationPipeline;
+	/**
+	 * Whether the most recently recorded pipeline has tessellation shaders. The command that
+	 * bound it is not retained, because a streamed command does not outlive its recording.
+	 */
+	bool _hasTessellationPipeline;
 
 
 #pragma mark Multiview render pass command management
@@ -166,14 +211,21 @@ protected:
 	bool canPrefill();
 	void prefill();
 	void clearPrefilledMTLCommandBuffer();
+	bool encodeConcurrently(MVKQueueCommandBufferSubmission* cmdBuffSubmit, MVKCommandEncodingContext* pEncodingContext);
+	bool encodeReplayStream(MVKQueueCommandBufferSubmission* cmdBuffSubmit, MVKCommandEncodingContext* pEncodingContext);
     void releaseCommands(MVKCommand* command);
 	void releaseRecordedCommands();
+	void coalesceCommands();
     void flushImmediateCmdEncoder();
 
 	MVKCommand* _head = nullptr;
 	MVKCommand* _tail = nullptr;
 	uint32_t _commandCount;
 	MVKCommandPool* _commandPool;
+	MVKCommandArena _commandArena;
+	MVKCommandReplayStream<MVKCommand> _replayStream;
+	uint64_t _recordingVersion = 0;
+	uint64_t _recordingStartTime = 0;
 	std::atomic_flag _isExecutingNonConcurrently;
 	VkCommandBufferInheritanceInfo _secondaryInheritanceInfo;
 	id<MTLCommandBuffer> _prefilledMTLCmdBuffer = nil;
@@ -182,9 +234,11 @@ protected:
 	bool _isSecondary;
 	bool _doesContinueRenderPass;
 	bool _canAcceptCommands;
+	bool _isStreamingCommands = false;
 	bool _isReusable;
 	bool _supportsConcurrentExecution;
 	bool _wasExecuted;
+	bool _usesCommandArena = false;
 };
 
 
@@ -280,9 +334,59 @@ public:
 	void encode(id<MTLCommandBuffer> mtlCmdBuff, MVKCommandEncodingContext* pEncodingContext);
     
     void beginEncoding(id<MTLCommandBuffer> mtlCmdBuff, MVKCommandEncodingContext* pEncodingContext);
-    void encodeCommands(MVKCommand* command);
+    void encodeCommands(MVKCommand* command, MVKCommand* endCommand = nullptr);
+
+	/**
+	 * Encodes a temporary command that will not outlive this call, and ensures this encoder does not retain it.
+	 * Streamed commands are never encoded within a multiview render pass, whose passes repeat the commands
+	 * that follow the command that began the subpass.
+	 */
+	void encodeStreamedCommand(MVKCommand* command);
     void endEncoding();
 
+	/** Encodes the command, and records it in the replay stream, if one is being recorded. */
+	void encodeCommand(MVKCommand* command);
+
+	/**
+	 * Sets the replay stream into which subsequently encoded commands are recorded,
+	 * or stops recording, if the replay stream is null.
+	 */
+	void setReplayStreamRecorder(MVKCommandReplayStream<MVKCommand>* replayStream) { _replayStream = replayStream; }
+
+	/** Encodes the ops in the replay stream onto the Metal command buffer, in place of the commands in the command buffer. */
+	void replay(id<MTLCommandBuffer> mtlCmdBuff,
+				MVKCommandEncodingContext* pEncodingContext,
+				MVKCommandReplayStream<MVKCommand>& replayStream);
+
+	/** If the resource bindings resolved by the current command are being recorded, records the binding in the replay stream. */
+	void recordReplayBinding(MVKShaderStage stage, const MVKMTLBufferBinding& binding) {
+		if (_isRecordingReplayBindings) {
+			_replayStream->recordBinding(kMVKCommandReplayOpBindBuffer, stage, binding.index, binding.mtlBytes,
+										 binding.offset, binding.size, binding.isInline);
+		}
+	}
+
+	/** If the resource bindings resolved by the current command are being recorded, records the binding in the replay stream. */
+	void recordReplayBinding(MVKShaderStage stage, const MVKMTLTextureBinding& binding) {
+		if (_isRecordingReplayBindings) {
+			_replayStream->recordBinding(kMVKCommandReplayOpBindTexture, stage, binding.index, binding.mtlTexture, 0, binding.swizzle);
+		}
+	}
+
+	/** If the resource bindings resolved by the current command are being recorded, records the binding in the replay stream. */
+	void recordReplayBinding(MVKShaderStage stage, const MVKMTLSamplerStateBinding& binding) {
+		if (_isRecordingReplayBindings) {
+			_replayStream->recordBinding(kMVKCommandReplayOpBindSamplerState, stage, binding.index, binding.mtlSamplerState);
+		}
+	}
+
+	/**
+	 * Indicates that a resource resolved by the current command might be different the next time
+	 * the command is encoded, such as the drawable texture of a swapchain image, so the command
+	 * must be encoded again, instead of replaying the resource bindings it resolved.
+	 */
+	void markReplayBindingsVolatile() { _areReplayBindingsVolatile = _isRecordingReplayBindings; }
+
 	/** Encode commands from the specified secondary command buffer onto the Metal command buffer. */
 	void encodeSecondary(MVKCommandBuffer* secondaryCmdBuffer);
 
@@ -410,6 +514,12 @@ public:
 	/** Copy the bytes to a temporary MTLBuffer that will be returned to a pool after the command buffer is finished. */
 	const MVKMTLBufferAllocation* copyToTempMTLBufferAllocation(const void* bytes, NSUInteger length, bool isDedicated = false);
 
+	/**
+	 * Copy the bytes to a region sub-allocated from the upload ring of this encoder. All regions
+	 * are returned to a pool together, once the Metal command buffer is finished with them.
+	 */
+	MVKMTLBufferUploadRegion copyToUploadRegion(const void* bytes, NSUInteger length);
+
     /** Returns the command encoding pool. */
     MVKCommandEncodingPool* getCommandEncodingPool();
 
@@ -537,8 +647,12 @@ protected:
 	MVKPushConstantsCommandEncoderState _fragmentPushConstants;
 	MVKPushConstantsCommandEncoderState _computePushConstants;
     MVKOcclusionQueryCommandEncoderState _occlusionQueryState;
+	MVKMTLBufferUploadRing _uploadRing;
+	MVKCommandReplayStream<MVKCommand>* _replayStream = nullptr;
     uint32_t _flushCount = 0;
 	bool _isRenderingEntireAttachment;
+	bool _isRecordingReplayBindings = false;
+	bool _areReplayBindingsVolatile = false;
 };
 
 
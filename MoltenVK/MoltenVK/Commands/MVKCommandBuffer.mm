@@ -27,6 +27,7 @@
 #include "MVKCmdDraw.h"
 #include "MVKCmdRenderPass.h"
 #include <sys/mman.h>
+#include <thread>
 
 using namespace std;
 
@@ -40,6 +41,7 @@ VkResult MVKCommandBuffer::begin(const VkCommandBufferBeginInfo* pBeginInfo) {
 
 	clearConfigurationResult();
 	_canAcceptCommands = true;
+	_recordingStartTime = _device->getPerformanceTimestamp();
 
 	VkCommandBufferUsageFlags usage = pBeginInfo->flags;
 	_isReusable = !mvkAreAllFlagsEnabled(usage, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
@@ -61,6 +63,7 @@ VkResult MVKCommandBuffer::begin(const VkCommandBufferBeginInfo* pBeginInfo) {
             _immediateCmdEncoder = new MVKCommandEncoder(this);
             _immediateCmdEncoder->beginEncoding(_prefilledMTLCmdBuffer, _immediateCmdEncodingContext);
         }
+		_isStreamingCommands = !_isReusable && mvkConfig().streamOneTimeSubmitCommands;
     }
     
     return getConfigurationResult();
@@ -69,18 +72,32 @@ VkResult MVKCommandBuffer::begin(const VkCommandBufferBeginInfo* pBeginInfo) {
 void MVKCommandBuffer::releaseCommands(MVKCommand* command) {
     while(command) {
         MVKCommand* nextCommand = command->_next; // Establish next before returning current to pool.
-        (command->getTypePool(getCommandPool()))->returnObject(command);
+        releaseCommand(command);
         command = nextCommand;
     }
 }
 
+// If the command was allocated from the command arena, it is destroyed in place,
+// and its memory is reclaimed when the command arena is next reset.
+void MVKCommandBuffer::releaseCommand(MVKCommand* command) {
+	if (_usesCommandArena) {
+		command->~MVKCommand();
+	} else {
+		(command->getTypePool(getCommandPool()))->returnObject(command);
+	}
+}
+
 void MVKCommandBuffer::releaseRecordedCommands() {
+	uint64_t startTime = _device->getPerformanceTimestamp();
     releaseCommands(_head);
+	_commandArena.reset();
+	if (_head) { _device->addActivityPerformance(_device->_performanceStatistics.commandBuffer.releaseCommands, startTime); }
 	_head = nullptr;
 	_tail = nullptr;
 }
 
 void MVKCommandBuffer::flushImmediateCmdEncoder() {
+	_isStreamingCommands = false;
     if(_immediateCmdEncoder) {
         _immediateCmdEncoder->endEncoding();
         delete _immediateCmdEncoder;
@@ -101,14 +118,17 @@ VkResult MVKCommandBuffer::reset(VkCommandBufferResetFlags flags) {
 	_supportsConcurrentExecution = false;
 	_wasExecuted = false;
 	_isExecutingNonConcurrently.clear();
+	_replayStream.clear();
+	_recordingVersion = mvkNewCommandReplayVersion();
 	_commandCount = 0;
 	_needsVisibilityResultMTLBuffer = false;
-	_lastTessellationPipeline = nullptr;
+	_hasTessellationPipeline = false;
 	_lastMultiviewSubpass = nullptr;
 	setConfigurationResult(VK_NOT_READY);
 
 	if (mvkAreAllFlagsEnabled(flags, VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT)) {
-		// TODO: what are we releasing or returning here?
+		_commandArena.trim();
+		_replayStream.trim();
 	}
 
 	return VK_SUCCESS;
@@ -118,13 +138,50 @@ VkResult MVKCommandBuffer::end() {
 	_canAcceptCommands = false;
     
     flushImmediateCmdEncoder();
-    
+
+	_device->addActivityPerformance(_device->_performanceStatistics.commandBuffer.recordCommands, _recordingStartTime);
+
+	if (mvkConfig().coalesceStateCommands && _isReusable) { coalesceCommands(); }
+
 	return getConfigurationResult();
 }
 
+// Removes redundant state commands, so they are not encoded each time this command buffer is submitted.
+void MVKCommandBuffer::coalesceCommands() {
+	if ( !_head ) { return; }
+
+	uint64_t startTime = _device->getPerformanceTimestamp();
+
+	MVKSmallVector<MVKCommand*, 256> cmds;
+	cmds.reserve(_commandCount);
+	for (MVKCommand* cmd = _head; cmd; cmd = cmd->_next) { cmds.push_back(cmd); }
+
+	MVKCommandCoalescingCounts counts = mvkCoalesceStateCommands(cmds, [this](MVKCommand* cmd) { releaseCommand(cmd); });
+	uint32_t rmvCnt = counts.removedCount;
+	uint32_t mrgCnt = counts.mergedCount;
+
+	// Relink the remaining commands
+	if (rmvCnt || mrgCnt) {
+		_head = nullptr;
+		_tail = nullptr;
+		for (MVKCommand* cmd : cmds) {
+			if ( !cmd ) { continue; }
+			if (_tail) { _tail->_next = cmd; } else { _head = cmd; }
+			_tail = cmd;
+		}
+		if (_tail) { _tail->_next = nullptr; }
+		_commandCount -= rmvCnt + mrgCnt;
+	}
+
+	_device->addActivityPerformance(_device->_performanceStatistics.commandBuffer.coalesceCommands, startTime);
+	_device->addCountPerformance(_device->_performanceStatistics.commandCoalescing.removedCommands, rmvCnt);
+	_device->addCountPerformance(_device->_performanceStatistics.commandCoalescing.mergedCommands, mrgCnt);
+}
+
 void MVKCommandBuffer::addCommand(MVKCommand* command) {
     if ( !_canAcceptCommands ) {
         setConfigurationResult(reportError(VK_NOT_READY, "Command buffer cannot accept commands before vkBeginCommandBuffer() is called."));
+        releaseCommand(command);
         return;
     }
     
@@ -144,6 +201,11 @@ void MVKCommandBuffer::addCommand(MVKCommand* command) {
     _commandCount++;
 }
 
+// The command is owned by the caller, and is destroyed by the caller once it has been encoded.
+void MVKCommandBuffer::encodeStreamedCommand(MVKCommand* command) {
+	_immediateCmdEncoder->encodeStreamedCommand(command);
+}
+
 void MVKCommandBuffer::submit(MVKQueueCommandBufferSubmission* cmdBuffSubmit,
 							  MVKCommandEncodingContext* pEncodingContext) {
 	if ( !canExecute() ) { return; }
@@ -152,13 +214,110 @@ void MVKCommandBuffer::submit(MVKQueueCommandBufferSubmission* cmdBuffSubmit,
 		cmdBuffSubmit->setActiveMTLCommandBuffer(_prefilledMTLCmdBuffer);
 		clearPrefilledMTLCommandBuffer();
 	} else {
-		MVKCommandEncoder encoder(this);
-		encoder.encode(cmdBuffSubmit->getActiveMTLCommandBuffer(), pEncodingContext);
+		uint64_t startTime = _device->getPerformanceTimestamp();
+		if ( !encodeReplayStream(cmdBuffSubmit, pEncodingContext) &&
+			 !encodeConcurrently(cmdBuffSubmit, pEncodingContext) ) {
+			MVKCommandEncoder encoder(this);
+			encoder.encode(cmdBuffSubmit->getActiveMTLCommandBuffer(), pEncodingContext);
+		}
+		_device->addActivityPerformance(_device->_performanceStatistics.commandBuffer.encodeCommands, startTime);
 	}
 
 	if ( !_supportsConcurrentExecution ) { _isExecutingNonConcurrently.clear(); }
 }
 
+// If enabled, divides the commands into segments that each begin a render pass or compute dispatch,
+// and encodes the segments concurrently, on persistent worker threads, each into its own MTLCommandBuffer.
+// The first segment is encoded into the active MTLCommandBuffer of the submission. Once all segments have been encoded,
+// the MTLCommandBuffer of each later segment is made active in turn, which commits the MTLCommandBuffer
+// of the previous segment, so the segments execute in order. Returns whether the commands were encoded.
+// Descriptor sets that use Metal argument buffers share a Metal argument encoder, and track which of
+// their descriptors must be encoded, while they are bound, so their command buffers are not divided.
+// Each encoder is primed with the state commands that precede its segment on this thread, before any
+// segment is encoded, so that a state command is not encoded by more than one thread at once.
+bool MVKCommandBuffer::encodeConcurrently(MVKQueueCommandBufferSubmission* cmdBuffSubmit,
+										  MVKCommandEncodingContext* pEncodingContext) {
+	uint32_t minSegCmdCnt = mvkConfig().parallelEncodingSegmentSize;
+	if ( !minSegCmdCnt || _needsVisibilityResultMTLBuffer || isUsingMetalArgumentBuffers() ) { return false; }
+
+	size_t maxSegCnt = thread::hardware_concurrency();
+	MVKCommandEncodingPlan<MVKCommand> encodingPlan;
+	if ( !encodingPlan.divide(_head, _commandCount, minSegCmdCnt, maxSegCnt) ) { return false; }
+
+	size_t segCnt = encodingPlan.getSegmentCount();
+	MVKSmallVector<id<MTLCommandBuffer>, 8> mtlCmdBuffs;
+	mtlCmdBuffs.reserve(segCnt);
+	mtlCmdBuffs.push_back(cmdBuffSubmit->getActiveMTLCommandBuffer());
+	for (size_t segIdx = 1; segIdx < segCnt; segIdx++) {
+		mtlCmdBuffs.push_back(cmdBuffSubmit->_queue->getMTLCommandBuffer(cmdBuffSubmit->_commandUse));
+	}
+
+	MVKSmallVector<MVKCommandEncoder*, 8> encoders;
+	encoders.reserve(segCnt);
+	encodingPlan.encode(maxSegCnt,
+						[&](size_t segIdx) {
+							@autoreleasepool {
+								auto& seg = encodingPlan.getSegment(segIdx);
+								MVKCommandEncoder* encoder = new MVKCommandEncoder(this);
+								encoders.push_back(encoder);
+								encoder->beginEncoding(mtlCmdBuffs[segIdx], pEncodingContext);
+								for (size_t cmdIdx = 0; cmdIdx < seg.primingCommandCount; cmdIdx++) {
+									encodingPlan.getPrimingCommand(cmdIdx)->encode(encoder);
+								}
+							}
+						},
+						[&](size_t segIdx) {
+							@autoreleasepool {
+								auto& seg = encodingPlan.getSegment(segIdx);
+								encoders[segIdx]->encodeCommands(seg.firstCommand, seg.endCommand);
+								encoders[segIdx]->endEncoding();
+							}
+						},
+						[&](size_t segIdx) {
+							if (segIdx > 0) { cmdBuffSubmit->setActiveMTLCommandBuffer(mtlCmdBuffs[segIdx]); }
+						});
+	mvkDestroyContainerContents(encoders);
+	return true;
+}
+
+// If enabled, and this command buffer is reusable, encodes this command buffer from its replay stream.
+// If the replay stream has not been recorded, or an object it depends on has changed since it was
+// recorded, the commands are encoded normally, and the replay stream is recorded while they are
+// encoded, so it can be replayed the next time this command buffer is submitted. A command buffer
+// that supports simultaneous use might be encoded on more than one thread at once, so it does not
+// use a replay stream. Returns whether the commands were encoded.
+bool MVKCommandBuffer::encodeReplayStream(MVKQueueCommandBufferSubmission* cmdBuffSubmit,
+										  MVKCommandEncodingContext* pEncodingContext) {
+	if ( !(mvkConfig().replayReusableCommandBuffers && _isReusable && !_supportsConcurrentExecution) ) { return false; }
+
+	MVKCommandEncoder encoder(this);
+	id<MTLCommandBuffer> mtlCmdBuff = cmdBuffSubmit->getActiveMTLCommandBuffer();
+
+	bool wasRecorded = _replayStream.isRecorded();
+	if (wasRecorded && _replayStream.isCurrent([](const MVKCommandReplayDependency& dep) -> uint64_t {
+		switch (dep.kind) {
+			case kMVKCommandReplayDependencyDescriptorSet:
+				return ((MVKDescriptorSet*)dep.object)->getContentVersion();
+			case kMVKCommandReplayDependencyCommandBuffer:
+				return ((MVKCommandBuffer*)dep.object)->getRecordingVersion();
+			default:
+				return 0;
+		}
+	})) {
+		encoder.replay(mtlCmdBuff, pEncodingContext, _replayStream);
+		_device->addCountPerformance(_device->_performanceStatistics.commandReplay.replayedStreams, 1);
+		return true;
+	}
+
+	_replayStream.beginRecording();
+	encoder.setReplayStreamRecorder(&_replayStream);
+	encoder.encode(mtlCmdBuff, pEncodingContext);
+	_replayStream.endRecording(wasConfigurationSuccessful());
+	_device->addCountPerformance(_device->_performanceStatistics.commandReplay.recordedStreams, 1);
+	if (wasRecorded) { _device->addCountPerformance(_device->_performanceStatistics.commandReplay.invalidatedStreams, 1); }
+	return true;
+}
+
 bool MVKCommandBuffer::canExecute() {
 	if (_isSecondary) {
 		setConfigurationResult(reportError(VK_NOT_READY, "Secondary command buffers may not be submitted directly to a queue."));
@@ -205,6 +364,7 @@ void MVKCommandBuffer::clearPrefilledMTLCommandBuffer() {
 // Initializes this instance after it has been created or retrieved from a pool.
 void MVKCommandBuffer::init(const VkCommandBufferAllocateInfo* pAllocateInfo) {
 	_commandPool = (MVKCommandPool*)pAllocateInfo->commandPool;
+	_usesCommandArena = _commandPool->usesCommandArenas();
 	_isSecondary = (pAllocateInfo->level == VK_COMMAND_BUFFER_LEVEL_SECONDARY);
 
 	reset(0);
@@ -232,7 +392,7 @@ void MVKCommandBuffer::recordExecuteCommands(const MVKArrayRef<MVKCommandBuffer*
 #pragma mark Tessellation constituent command management
 
 void MVKCommandBuffer::recordBindPipeline(MVKCmdBindPipeline* mvkBindPipeline) {
-	_lastTessellationPipeline = mvkBindPipeline->isTessellationPipeline() ? mvkBindPipeline : nullptr;
+	_hasTessellationPipeline = mvkBindPipeline->isTessellationPipeline();
 }
 
 
@@ -279,6 +439,7 @@ void MVKCommandEncoder::beginEncoding(id<MTLCommandBuffer> mtlCmdBuff, MVKComman
     _subpassContents = VK_SUBPASS_CONTENTS_INLINE;
     _renderSubpassIndex = 0;
     _multiviewPassIndex = 0;
+    _lastMultiviewPassCmd = nullptr;
     _canUseLayeredRendering = false;
 
     _pEncodingContext = pEncodingContext;
@@ -287,10 +448,10 @@ void MVKCommandEncoder::beginEncoding(id<MTLCommandBuffer> mtlCmdBuff, MVKComman
     setLabelIfNotNil(_mtlCmdBuffer, _cmdBuffer->_debugName);
 }
 
-void MVKCommandEncoder::encodeCommands(MVKCommand* command) {
-    while(command) {
+void MVKCommandEncoder::encodeCommands(MVKCommand* command, MVKCommand* endCommand) {
+    while(command && command != endCommand) {
         uint32_t prevMVPassIdx = _multiviewPassIndex;
-        command->encode(this);
+        encodeCommand(command);
         
         if(_multiviewPassIndex > prevMVPassIdx) {
             // This means we're in a multiview render pass, and we moved on to the
@@ -303,19 +464,128 @@ void MVKCommandEncoder::encodeCommands(MVKCommand* command) {
     }
 }
 
+void MVKCommandEncoder::encodeStreamedCommand(MVKCommand* command) {
+	command->_next = nullptr;
+	encodeCommands(command);
+
+	MVKAssert(_multiviewPassIndex == 0, "Commands cannot be streamed within a multiview render pass.");
+	if (_lastMultiviewPassCmd == command) { _lastMultiviewPassCmd = nullptr; }
+}
+
 void MVKCommandEncoder::endEncoding() {
     endCurrentMetalEncoding();
     finishQueries();
+	uint32_t blockCnt = _uploadRing.getBlockCount();
+	uint32_t regionCnt = _uploadRing.recycleOnCompletion(_mtlCmdBuffer);
+	_device->addCountPerformance(_device->_performanceStatistics.uploadRing.uploadedRegions, regionCnt);
+	_device->addCountPerformance(_device->_performanceStatistics.uploadRing.acquiredBlocks, blockCnt);
+	_graphicsResourcesState.addBindingPerformance();
+	_computeResourcesState.addBindingPerformance();
 }
 
+// The commands of secondary command buffers are expanded in place in the replay stream of the primary command buffer.
 void MVKCommandEncoder::encodeSecondary(MVKCommandBuffer* secondaryCmdBuffer) {
+	if (_replayStream) {
+		_replayStream->addDependency(secondaryCmdBuffer, secondaryCmdBuffer->getRecordingVersion(),
+									 kMVKCommandReplayDependencyCommandBuffer);
+	}
 	MVKCommand* cmd = secondaryCmdBuffer->_head;
 	while (cmd) {
-		cmd->encode(this);
+		encodeCommand(cmd);
 		cmd = cmd->_next;
 	}
 }
 
+// If a replay stream is being recorded, records the command according to its replay mode.
+// A command that binds descriptor sets is recorded as the resource bindings it resolves while it
+// is encoded. If any of those bindings might resolve to a different resource the next time the
+// command is encoded, the bindings are replaced by the command itself. When using Metal argument
+// buffers, the descriptors are encoded into the argument buffer when each draw or dispatch is
+// encoded, so those commands are recorded to be encoded again.
+void MVKCommandEncoder::encodeCommand(MVKCommand* command) {
+	if ( !_replayStream ) {
+		command->encode(this);
+		return;
+	}
+
+	switch (command->getReplayMode()) {
+		case kMVKCommandReplayBindings:
+			if ( !isUsingMetalArgumentBuffers() ) {
+				size_t opIdx = _replayStream->getOpCount();
+				_isRecordingReplayBindings = true;
+				_areReplayBindingsVolatile = false;
+				command->encode(this);
+				_isRecordingReplayBindings = false;
+				if (_areReplayBindingsVolatile) { _replayStream->replaceOpsWithCommand(opIdx, command); }
+				break;
+			}
+			_replayStream->recordCommand(command);
+			command->encode(this);
+			break;
+		case kMVKCommandReplayExpand:
+			command->encode(this);
+			break;
+		default:
+			_replayStream->recordCommand(command);
+			command->encode(this);
+			break;
+	}
+}
+
+// The ops are encoded in order. The commands of each multiview pass are already repeated in the
+// replay stream, so the encoder does not return to the start of the subpass for each pass.
+void MVKCommandEncoder::replay(id<MTLCommandBuffer> mtlCmdBuff,
+							   MVKCommandEncodingContext* pEncodingContext,
+							   MVKCommandReplayStream<MVKCommand>& replayStream) {
+	beginEncoding(mtlCmdBuff, pEncodingContext);
+	replayStream.replay([&](const MVKCommandReplayStream<MVKCommand>::Op& op) {
+		MVKShaderStage stage = MVKShaderStage(op.stage);
+		switch (op.type) {
+			case kMVKCommandReplayOpEncodeCommand:
+				op.command->encode(this);
+				break;
+			case kMVKCommandReplayOpBindBuffer: {
+				MVKMTLBufferBinding bb;
+				bb.mtlBytes = op.resource;
+				bb.offset = op.offset;
+				bb.size = op.sizeOrSwizzle;
+				bb.index = op.index;
+				bb.isInline = op.isInline;
+				if (stage == kMVKShaderStageCompute) {
+					_computeResourcesState.bindBuffer(bb);
+				} else {
+					_graphicsResourcesState.bindBuffer(stage, bb);
+				}
+				break;
+			}
+			case kMVKCommandReplayOpBindTexture: {
+				MVKMTLTextureBinding tb;
+				tb.mtlTexture = (id<MTLTexture>)op.resource;
+				tb.swizzle = op.sizeOrSwizzle;
+				tb.index = op.index;
+				if (stage == kMVKShaderStageCompute) {
+					_computeResourcesState.bindTexture(tb);
+				} else {
+					_graphicsResourcesState.bindTexture(stage, tb);
+				}
+				break;
+			}
+			case kMVKCommandReplayOpBindSamplerState: {
+				MVKMTLSamplerStateBinding sb;
+				sb.mtlSamplerState = (id<MTLSamplerState>)op.resource;
+				sb.index = op.index;
+				if (stage == kMVKShaderStageCompute) {
+					_computeResourcesState.bindSamplerState(sb);
+				} else {
+					_graphicsResourcesState.bindSamplerState(stage, sb);
+				}
+				break;
+			}
+		}
+	});
+	endEncoding();
+}
+
 void MVKCommandEncoder::beginRenderpass(MVKCommand* passCmd,
 										VkSubpassContents subpassContents,
 										MVKRenderPass* renderPass,
@@ -486,6 +756,10 @@ void MVKCommandEncoder::bindDescriptorSet(VkPipelineBindPoint pipelineBindPoint,
 										  MVKShaderResourceBinding& dslMTLRezIdxOffsets,
 										  MVKArrayRef<uint32_t> dynamicOffsets,
 										  uint32_t& dynamicOffsetIndex) {
+	if (_isRecordingReplayBindings) {
+		_replayStream->addDependency(descSet, descSet->getContentVersion(), kMVKCommandReplayDependencyDescriptorSet);
+	}
+
 	switch (pipelineBindPoint) {
 		case VK_PIPELINE_BIND_POINT_GRAPHICS:
 			_graphicsResourcesState.bindDescriptorSet(descSetIndex, descSet, dslMTLRezIdxOffsets,
@@ -709,8 +983,8 @@ void MVKCommandEncoder::setVertexBytes(id<MTLRenderCommandEncoder> mtlEncoder,
     if (_pDeviceMetalFeatures->dynamicMTLBufferSize && length <= _pDeviceMetalFeatures->dynamicMTLBufferSize) {
         [mtlEncoder setVertexBytes: bytes length: length atIndex: mtlBuffIndex];
     } else {
-        const MVKMTLBufferAllocation* mtlBuffAlloc = copyToTempMTLBufferAllocation(bytes, length);
-        [mtlEncoder setVertexBuffer: mtlBuffAlloc->_mtlBuffer offset: mtlBuffAlloc->_offset atIndex: mtlBuffIndex];
+        MVKMTLBufferUploadRegion mtlBuffRgn = copyToUploadRegion(bytes, length);
+        [mtlEncoder setVertexBuffer: mtlBuffRgn._mtlBuffer offset: mtlBuffRgn._offset atIndex: mtlBuffIndex];
     }
 }
 
@@ -721,8 +995,8 @@ void MVKCommandEncoder::setFragmentBytes(id<MTLRenderCommandEncoder> mtlEncoder,
     if (_pDeviceMetalFeatures->dynamicMTLBufferSize && length <= _pDeviceMetalFeatures->dynamicMTLBufferSize) {
         [mtlEncoder setFragmentBytes: bytes length: length atIndex: mtlBuffIndex];
     } else {
-        const MVKMTLBufferAllocation* mtlBuffAlloc = copyToTempMTLBufferAllocation(bytes, length);
-        [mtlEncoder setFragmentBuffer: mtlBuffAlloc->_mtlBuffer offset: mtlBuffAlloc->_offset atIndex: mtlBuffIndex];
+        MVKMTLBufferUploadRegion mtlBuffRgn = copyToUploadRegion(bytes, length);
+        [mtlEncoder setFragmentBuffer: mtlBuffRgn._mtlBuffer offset: mtlBuffRgn._offset atIndex: mtlBuffIndex];
     }
 }
 
@@ -733,8 +1007,8 @@ void MVKCommandEncoder::setComputeBytes(id<MTLComputeCommandEncoder> mtlEncoder,
     if (_pDeviceMetalFeatures->dynamicMTLBufferSize && length <= _pDeviceMetalFeatures->dynamicMTLBufferSize) {
         [mtlEncoder setBytes: bytes length: length atIndex: mtlBuffIndex];
     } else {
-        const MVKMTLBufferAllocation* mtlBuffAlloc = copyToTempMTLBufferAllocation(bytes, length);
-        [mtlEncoder setBuffer: mtlBuffAlloc->_mtlBuffer offset: mtlBuffAlloc->_offset atIndex: mtlBuffIndex];
+        MVKMTLBufferUploadRegion mtlBuffRgn = copyToUploadRegion(bytes, length);
+        [mtlEncoder setBuffer: mtlBuffRgn._mtlBuffer offset: mtlBuffRgn._offset atIndex: mtlBuffIndex];
     }
 }
 
@@ -758,6 +1032,10 @@ const MVKMTLBufferAllocation* MVKCommandEncoder::copyToTempMTLBufferAllocation(c
     return mtlBuffAlloc;
 }
 
+MVKMTLBufferUploadRegion MVKCommandEncoder::copyToUploadRegion(const void* bytes, NSUInteger length) {
+	return _uploadRing.copyBytes(bytes, length);
+}
+
 
 #pragma mark Queries
 
@@ -917,7 +1195,9 @@ MVKCommandEncoder::MVKCommandEncoder(MVKCommandBuffer* cmdBuffer) : MVKBaseDevic
         _stencilReferenceValueState(this),
         _graphicsResourcesState(this),
         _computeResourcesState(this),
-        _occlusionQueryState(this) {
+        _occlusionQueryState(this),
+        _uploadRing(cmdBuffer->getCommandPool()->getCommandEncodingPool()->getMTLBufferAllocator(),
+                    cmdBuffer->getDevice()->_pMetalFeatures->mtlBufferAlignment) {
 
             _pDeviceFeatures = &_device->_enabledFeatures;
             _pDeviceMetalFeatures = _device->_pMetalFeatures;
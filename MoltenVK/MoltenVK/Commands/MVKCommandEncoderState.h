@@ -19,6 +19,7 @@
 #pragma once
 
 #include "MVKMTLResourceBindings.h"
+#include "MVKResourceBindingTable.h"
 #include "MVKCommandResourceFactory.h"
 #include "MVKDevice.h"
 #include "MVKDescriptor.h"
@@ -363,62 +364,66 @@ public:
 												   MTLResourceUsage mtlUsage,
 												   MTLRenderStages mtlStages) = 0;
 
+	/**
+	 * If performance is being tracked, adds the number of resource bindings that have been encoded,
+	 * and that have been elided, by this instance, to the performance statistics, and resets them.
+	 */
+	void addBindingPerformance();
+
     MVKResourcesCommandEncoderState(MVKCommandEncoder* cmdEncoder) :
 		MVKCommandEncoderState(cmdEncoder), _boundDescriptorSets{} {}
 
 protected:
 	void markDirty() override;
 
-    // Template function that marks both the vector and all binding elements in the vector as dirty.
-    template<class T>
-    void markDirty(T& bindings, bool& bindingsDirtyFlag) {
-        for (auto& b : bindings) { b.isDirty = true; }
-        bindingsDirtyFlag = true;
-    }
+	// The capacities of the binding tables, covering the per-stage resource limits of all Metal devices.
+	static constexpr size_t kMaxBufferBindingCount = 32;
+	static constexpr size_t kMaxTextureBindingCount = 128;
+	static constexpr size_t kMaxSamplerStateBindingCount = 16;
+
+	typedef MVKResourceBindingTable<MVKMTLBufferBinding, kMaxBufferBindingCount> BufferBindingTable;
+	typedef MVKResourceBindingTable<MVKMTLTextureBinding, kMaxTextureBindingCount> TextureBindingTable;
+	typedef MVKResourceBindingTable<MVKMTLSamplerStateBinding, kMaxSamplerStateBindingCount> SamplerStateBindingTable;
+
+	// The command encoder, which holds a table of each type for each shader stage, is created on the stack
+	// when a command buffer is submitted. The tables allocate their bindings on the heap to keep it small.
+	static_assert(sizeof(BufferBindingTable) <= 64 && sizeof(TextureBindingTable) <= 64 && sizeof(SamplerStateBindingTable) <= 64,
+				  "Resource binding tables must not hold their bindings inline.");
 
-    // Template function that updates an existing binding or adds a new binding to a vector
-    // of bindings, and marks the binding, the vector, and this instance as dirty
-    template<class T, class V>
-    void bind(const T& b, V& bindings, bool& bindingsDirtyFlag) {
+    // Template function that updates the binding in a table of bindings, and if the binding
+    // changed, marks the binding and this instance as dirty. Counts bindings that are elided.
+    template<class T, class B>
+    void bind(const T& b, B& bindings) {
 
         if ( !b.mtlResource ) { return; }
 
-        T db = b;   // Copy that can be marked dirty
-        MVKCommandEncoderState::markDirty();
-        bindingsDirtyFlag = true;
-        db.isDirty = true;
+        if (b.index >= B::kCapacity) {
+            reportError(VK_ERROR_FEATURE_NOT_PRESENT, "Metal resource index %u exceeds the maximum of %zu Metal resources of that type that can be bound to a shader stage.", b.index, B::kCapacity);
+            return;
+        }
 
-        for (auto iter = bindings.begin(), end = bindings.end(); iter != end; ++iter) {
-            if( iter->index == db.index ) {
-                *iter = db;
-                return;
-            }
+        if (bindings.bind(b)) {
+            MVKCommandEncoderState::markDirty();
+        } else {
+            _elidedBindingCount++;
         }
-        bindings.push_back(db);
     }
 
 	// For texture bindings, we also keep track of whether any bindings need a texture swizzle
-	template<class V>
-	void bind(const MVKMTLTextureBinding& tb, V& texBindings, bool& bindingsDirtyFlag, bool& needsSwizzleFlag) {
-		bind(tb, texBindings, bindingsDirtyFlag);
+	void bind(const MVKMTLTextureBinding& tb, TextureBindingTable& texBindings, bool& needsSwizzleFlag) {
+		bind(tb, texBindings);
 		if (tb.swizzle != 0) { needsSwizzleFlag = true; }
 	}
 
     // Template function that executes a lambda expression on each dirty element of
-    // a vector of bindings, and marks the bindings and the vector as no longer dirty.
-	template<class T, class V>
-	void encodeBinding(V& bindings,
-					   bool& bindingsDirtyFlag,
+    // a table of bindings, and marks the bindings as no longer dirty.
+	template<class T, class B>
+	void encodeBinding(B& bindings,
 					   std::function<void(MVKCommandEncoder* cmdEncoder, T& b)> mtlOperation) {
-		if (bindingsDirtyFlag) {
-			bindingsDirtyFlag = false;
-			for (auto& b : bindings) {
-				if (b.isDirty) {
-					mtlOperation(_cmdEncoder, b);
-					b.isDirty = false;
-				}
-			}
-		}
+		bindings.encodeDirtyBindings([&](T& b) {
+			mtlOperation(_cmdEncoder, b);
+			_encodedBindingCount++;
+		});
 	}
 
 	// Updates a value at the given index in the given vector, resizing if needed.
@@ -428,34 +433,38 @@ protected:
 		contents[index] = value;
 	}
 
-	void assertMissingSwizzles(bool needsSwizzle, const char* stageName, const MVKArrayRef<MVKMTLTextureBinding> texBindings);
+	void assertMissingSwizzles(bool needsSwizzle, const char* stageName, TextureBindingTable& texBindings);
 	void encodeMetalArgumentBuffer(MVKShaderStage stage);
 	virtual void bindMetalArgumentBuffer(MVKShaderStage stage, MVKMTLBufferBinding& buffBind) = 0;
 
 	template<size_t N>
 	struct ResourceBindings {
-		MVKSmallVector<MVKMTLBufferBinding, N> bufferBindings;
-		MVKSmallVector<MVKMTLTextureBinding, N> textureBindings;
-		MVKSmallVector<MVKMTLSamplerStateBinding, N> samplerStateBindings;
+		BufferBindingTable bufferBindings;
+		TextureBindingTable textureBindings;
+		SamplerStateBindingTable samplerStateBindings;
 		MVKSmallVector<uint32_t, N> swizzleConstants;
 		MVKSmallVector<uint32_t, N> bufferSizes;
 
-		MVKMTLBufferBinding swizzleBufferBinding;
-		MVKMTLBufferBinding bufferSizeBufferBinding;
-		MVKMTLBufferBinding dynamicOffsetBufferBinding;
-		MVKMTLBufferBinding viewRangeBufferBinding;
-
-		bool areBufferBindingsDirty = false;
-		bool areTextureBindingsDirty = false;
-		bool areSamplerStateBindingsDirty = false;
+		MVKMTLImplicitBufferBinding swizzleBufferBinding;
+		MVKMTLImplicitBufferBinding bufferSizeBufferBinding;
+		MVKMTLImplicitBufferBinding dynamicOffsetBufferBinding;
+		MVKMTLImplicitBufferBinding viewRangeBufferBinding;
 
 		bool needsSwizzle = false;
+
+		void markDirty() {
+			bufferBindings.markDirty();
+			textureBindings.markDirty();
+			samplerStateBindings.markDirty();
+		}
 	};
 
 	MVKDescriptorSet* _boundDescriptorSets[kMVKMaxDescriptorSetCount];
 	MVKBitArray _metalUsageDirtyDescriptors[kMVKMaxDescriptorSetCount];
 
 	MVKSmallVector<uint32_t, 8> _dynamicOffsets;
+	uint32_t _encodedBindingCount = 0;
+	uint32_t _elidedBindingCount = 0;
 
 };
 
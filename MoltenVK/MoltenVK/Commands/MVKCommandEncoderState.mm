@@ -517,6 +517,7 @@ void MVKResourcesCommandEncoderState::encodeMetalArgumentBuffer(MVKShaderStage s
 			auto* dslBind = dsLayout->getBindingAt(dslBindIdx);
 			if (dslBind->getApplyToStage(stage) && shaderBindingUsage.getBit(dslBindIdx)) {
 				shouldBindArgBuffToStage = true;
+				auto& descRange = descSet->getDescriptorRangeAt(dslBindIdx);
 				uint32_t elemCnt = dslBind->getDescriptorCount(descSet);
 				for (uint32_t elemIdx = 0; elemIdx < elemCnt; elemIdx++) {
 					uint32_t descIdx = dslBind->getDescriptorIndex(elemIdx);
@@ -529,7 +530,7 @@ void MVKResourcesCommandEncoderState::encodeMetalArgumentBuffer(MVKShaderStage s
 							[mtlArgEncoder setArgumentBuffer: mtlArgBuffer offset: metalArgBufferOffset];
 							mtlArgEncAttached = true;
 						}
-						auto* mvkDesc = descSet->getDescriptorAt(descIdx);
+						auto* mvkDesc = descRange.getDescriptor(elemIdx);
 						mvkDesc->encodeToMetalArgumentBuffer(this, mtlArgEncoder,
 															 dsIdx, dslBind, elemIdx,
 															 stage, argBuffDirty, true);
@@ -569,9 +570,9 @@ void MVKResourcesCommandEncoderState::markDirty() {
 }
 
 // If a swizzle is needed for this stage, iterates all the bindings and logs errors for those that need texture swizzling.
-void MVKResourcesCommandEncoderState::assertMissingSwizzles(bool needsSwizzle, const char* stageName, const MVKArrayRef<MVKMTLTextureBinding> texBindings) {
+void MVKResourcesCommandEncoderState::assertMissingSwizzles(bool needsSwizzle, const char* stageName, TextureBindingTable& texBindings) {
 	if (needsSwizzle) {
-		for (auto& tb : texBindings) {
+		texBindings.forEachBinding([&](MVKMTLTextureBinding& tb) {
 			VkComponentMapping vkcm = mvkUnpackSwizzle(tb.swizzle);
 			if (!mvkVkComponentMappingsMatch(vkcm, {VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A})) {
 				MVKLogError("Pipeline does not support component swizzle (%s, %s, %s, %s) required by a VkImageView used in the %s shader."
@@ -581,24 +582,35 @@ void MVKResourcesCommandEncoderState::assertMissingSwizzles(bool needsSwizzle, c
 							mvkVkComponentSwizzleName(vkcm.b), mvkVkComponentSwizzleName(vkcm.a), stageName);
 				MVKAssert(false, "See previous logged error.");
 			}
-		}
+		});
 	}
 }
 
+void MVKResourcesCommandEncoderState::addBindingPerformance() {
+	MVKDevice* mvkDev = getDevice();
+	mvkDev->addCountPerformance(mvkDev->_performanceStatistics.resourceBinding.encodedBindings, _encodedBindingCount);
+	mvkDev->addCountPerformance(mvkDev->_performanceStatistics.resourceBinding.elidedBindings, _elidedBindingCount);
+	_encodedBindingCount = 0;
+	_elidedBindingCount = 0;
+}
+
 
 #pragma mark -
 #pragma mark MVKGraphicsResourcesCommandEncoderState
 
 void MVKGraphicsResourcesCommandEncoderState::bindBuffer(MVKShaderStage stage, const MVKMTLBufferBinding& binding) {
-    bind(binding, _shaderStageResourceBindings[stage].bufferBindings, _shaderStageResourceBindings[stage].areBufferBindingsDirty);
+    bind(binding, _shaderStageResourceBindings[stage].bufferBindings);
+	_cmdEncoder->recordReplayBinding(stage, binding);
 }
 
 void MVKGraphicsResourcesCommandEncoderState::bindTexture(MVKShaderStage stage, const MVKMTLTextureBinding& binding) {
-    bind(binding, _shaderStageResourceBindings[stage].textureBindings, _shaderStageResourceBindings[stage].areTextureBindingsDirty, _shaderStageResourceBindings[stage].needsSwizzle);
+    bind(binding, _shaderStageResourceBindings[stage].textureBindings, _shaderStageResourceBindings[stage].needsSwizzle);
+	_cmdEncoder->recordReplayBinding(stage, binding);
 }
 
 void MVKGraphicsResourcesCommandEncoderState::bindSamplerState(MVKShaderStage stage, const MVKMTLSamplerStateBinding& binding) {
-    bind(binding, _shaderStageResourceBindings[stage].samplerStateBindings, _shaderStageResourceBindings[stage].areSamplerStateBindingsDirty);
+    bind(binding, _shaderStageResourceBindings[stage].samplerStateBindings);
+	_cmdEncoder->recordReplayBinding(stage, binding);
 }
 
 void MVKGraphicsResourcesCommandEncoderState::bindSwizzleBuffer(const MVKShaderImplicitRezBinding& binding,
@@ -609,10 +621,10 @@ void MVKGraphicsResourcesCommandEncoderState::bindSwizzleBuffer(const MVKShaderI
     for (uint32_t i = kMVKShaderStageVertex; i <= kMVKShaderStageFragment; i++) {
         _shaderStageResourceBindings[i].swizzleBufferBinding.index = binding.stages[i];
     }
-    _shaderStageResourceBindings[kMVKShaderStageVertex].swizzleBufferBinding.isDirty = needVertexSwizzleBuffer;
-    _shaderStageResourceBindings[kMVKShaderStageTessCtl].swizzleBufferBinding.isDirty = needTessCtlSwizzleBuffer;
-    _shaderStageResourceBindings[kMVKShaderStageTessEval].swizzleBufferBinding.isDirty = needTessEvalSwizzleBuffer;
-    _shaderStageResourceBindings[kMVKShaderStageFragment].swizzleBufferBinding.isDirty = needFragmentSwizzleBuffer;
+    _shaderStageResourceBindings[kMVKShaderStageVertex].swizzleBufferBinding.isNeeded = needVertexSwizzleBuffer;
+    _shaderStageResourceBindings[kMVKShaderStageTessCtl].swizzleBufferBinding.isNeeded = needTessCtlSwizzleBuffer;
+    _shaderStageResourceBindings[kMVKShaderStageTessEval].swizzleBufferBinding.isNeeded = needTessEvalSwizzleBuffer;
+    _shaderStageResourceBindings[kMVKShaderStageFragment].swizzleBufferBinding.isNeeded = needFragmentSwizzleBuffer;
 }
 
 void MVKGraphicsResourcesCommandEncoderState::bindBufferSizeBuffer(const MVKShaderImplicitRezBinding& binding,
@@ -623,10 +635,10 @@ void MVKGraphicsResourcesCommandEncoderState::bindBufferSizeBuffer(const MVKShad
     for (uint32_t i = kMVKShaderStageVertex; i <= kMVKShaderStageFragment; i++) {
         _shaderStageResourceBindings[i].bufferSizeBufferBinding.index = binding.stages[i];
     }
-    _shaderStageResourceBindings[kMVKShaderStageVertex].bufferSizeBufferBinding.isDirty = needVertexSizeBuffer;
-    _shaderStageResourceBindings[kMVKShaderStageTessCtl].bufferSizeBufferBinding.isDirty = needTessCtlSizeBuffer;
-    _shaderStageResourceBindings[kMVKShaderStageTessEval].bufferSizeBufferBinding.isDirty = needTessEvalSizeBuffer;
-    _shaderStageResourceBindings[kMVKShaderStageFragment].bufferSizeBufferBinding.isDirty = needFragmentSizeBuffer;
+    _shaderStageResourceBindings[kMVKShaderStageVertex].bufferSizeBufferBinding.isNeeded = needVertexSizeBuffer;
+    _shaderStageResourceBindings[kMVKShaderStageTessCtl].bufferSizeBufferBinding.isNeeded = needTessCtlSizeBuffer;
+    _shaderStageResourceBindings[kMVKShaderStageTessEval].bufferSizeBufferBinding.isNeeded = needTessEvalSizeBuffer;
+    _shaderStageResourceBindings[kMVKShaderStageFragment].bufferSizeBufferBinding.isNeeded = needFragmentSizeBuffer;
 }
 
 void MVKGraphicsResourcesCommandEncoderState::bindDynamicOffsetBuffer(const MVKShaderImplicitRezBinding& binding,
@@ -637,10 +649,10 @@ void MVKGraphicsResourcesCommandEncoderState::bindDynamicOffsetBuffer(const MVKS
 	for (uint32_t i = kMVKShaderStageVertex; i <= kMVKShaderStageFragment; i++) {
 		_shaderStageResourceBindings[i].dynamicOffsetBufferBinding.index = binding.stages[i];
 	}
-	_shaderStageResourceBindings[kMVKShaderStageVertex].dynamicOffsetBufferBinding.isDirty = needVertexDynamicOffsetBuffer;
-	_shaderStageResourceBindings[kMVKShaderStageTessCtl].dynamicOffsetBufferBinding.isDirty = needTessCtlDynamicOffsetBuffer;
-	_shaderStageResourceBindings[kMVKShaderStageTessEval].dynamicOffsetBufferBinding.isDirty = needTessEvalDynamicOffsetBuffer;
-	_shaderStageResourceBindings[kMVKShaderStageFragment].dynamicOffsetBufferBinding.isDirty = needFragmentDynamicOffsetBuffer;
+	_shaderStageResourceBindings[kMVKShaderStageVertex].dynamicOffsetBufferBinding.isNeeded = needVertexDynamicOffsetBuffer;
+	_shaderStageResourceBindings[kMVKShaderStageTessCtl].dynamicOffsetBufferBinding.isNeeded = needTessCtlDynamicOffsetBuffer;
+	_shaderStageResourceBindings[kMVKShaderStageTessEval].dynamicOffsetBufferBinding.isNeeded = needTessEvalDynamicOffsetBuffer;
+	_shaderStageResourceBindings[kMVKShaderStageFragment].dynamicOffsetBufferBinding.isNeeded = needFragmentDynamicOffsetBuffer;
 }
 
 void MVKGraphicsResourcesCommandEncoderState::bindViewRangeBuffer(const MVKShaderImplicitRezBinding& binding,
@@ -649,10 +661,10 @@ void MVKGraphicsResourcesCommandEncoderState::bindViewRangeBuffer(const MVKShade
     for (uint32_t i = kMVKShaderStageVertex; i <= kMVKShaderStageFragment; i++) {
         _shaderStageResourceBindings[i].viewRangeBufferBinding.index = binding.stages[i];
     }
-    _shaderStageResourceBindings[kMVKShaderStageVertex].viewRangeBufferBinding.isDirty = needVertexViewBuffer;
-    _shaderStageResourceBindings[kMVKShaderStageTessCtl].viewRangeBufferBinding.isDirty = false;
-    _shaderStageResourceBindings[kMVKShaderStageTessEval].viewRangeBufferBinding.isDirty = false;
-    _shaderStageResourceBindings[kMVKShaderStageFragment].viewRangeBufferBinding.isDirty = needFragmentViewBuffer;
+    _shaderStageResourceBindings[kMVKShaderStageVertex].viewRangeBufferBinding.isNeeded = needVertexViewBuffer;
+    _shaderStageResourceBindings[kMVKShaderStageTessCtl].viewRangeBufferBinding.isNeeded = false;
+    _shaderStageResourceBindings[kMVKShaderStageTessEval].viewRangeBufferBinding.isNeeded = false;
+    _shaderStageResourceBindings[kMVKShaderStageFragment].viewRangeBufferBinding.isNeeded = needFragmentViewBuffer;
 }
 
 void MVKGraphicsResourcesCommandEncoderState::encodeBindings(MVKShaderStage stage,
@@ -667,40 +679,40 @@ void MVKGraphicsResourcesCommandEncoderState::encodeBindings(MVKShaderStage stag
 
     auto& shaderStage = _shaderStageResourceBindings[stage];
 
-    if (shaderStage.swizzleBufferBinding.isDirty) {
+    if (shaderStage.swizzleBufferBinding.isNeeded) {
 
-        for (auto& b : shaderStage.textureBindings) {
-            if (b.isDirty) { updateImplicitBuffer(shaderStage.swizzleConstants, b.index, b.swizzle); }
-        }
+        shaderStage.textureBindings.forEachDirtyBinding([&](MVKMTLTextureBinding& b) {
+            updateImplicitBuffer(shaderStage.swizzleConstants, b.index, b.swizzle);
+        });
 
         bindImplicitBuffer(_cmdEncoder, shaderStage.swizzleBufferBinding, shaderStage.swizzleConstants.contents());
 
     } else {
-        assertMissingSwizzles(shaderStage.needsSwizzle && !fullImageViewSwizzle, pStageName, shaderStage.textureBindings.contents());
+        assertMissingSwizzles(shaderStage.needsSwizzle && !fullImageViewSwizzle, pStageName, shaderStage.textureBindings);
     }
 
-    if (shaderStage.bufferSizeBufferBinding.isDirty) {
-        for (auto& b : shaderStage.bufferBindings) {
-            if (b.isDirty) { updateImplicitBuffer(shaderStage.bufferSizes, b.index, b.size); }
-        }
+    if (shaderStage.bufferSizeBufferBinding.isNeeded) {
+        shaderStage.bufferBindings.forEachDirtyBinding([&](MVKMTLBufferBinding& b) {
+            updateImplicitBuffer(shaderStage.bufferSizes, b.index, b.size);
+        });
 
         bindImplicitBuffer(_cmdEncoder, shaderStage.bufferSizeBufferBinding, shaderStage.bufferSizes.contents());
     }
 
-	if (shaderStage.dynamicOffsetBufferBinding.isDirty) {
+	if (shaderStage.dynamicOffsetBufferBinding.isNeeded) {
 		bindImplicitBuffer(_cmdEncoder, shaderStage.dynamicOffsetBufferBinding, _dynamicOffsets.contents());
 	}
 
-    if (shaderStage.viewRangeBufferBinding.isDirty) {
+    if (shaderStage.viewRangeBufferBinding.isNeeded) {
         MVKSmallVector<uint32_t, 2> viewRange;
         viewRange.push_back(_cmdEncoder->getSubpass()->getFirstViewIndexInMetalPass(_cmdEncoder->getMultiviewPassIndex()));
         viewRange.push_back(_cmdEncoder->getSubpass()->getViewCountInMetalPass(_cmdEncoder->getMultiviewPassIndex()));
         bindImplicitBuffer(_cmdEncoder, shaderStage.viewRangeBufferBinding, viewRange.contents());
     }
 
-    encodeBinding<MVKMTLBufferBinding>(shaderStage.bufferBindings, shaderStage.areBufferBindingsDirty, bindBuffer);
-    encodeBinding<MVKMTLTextureBinding>(shaderStage.textureBindings, shaderStage.areTextureBindingsDirty, bindTexture);
-    encodeBinding<MVKMTLSamplerStateBinding>(shaderStage.samplerStateBindings, shaderStage.areSamplerStateBindingsDirty, bindSampler);
+    encodeBinding<MVKMTLBufferBinding>(shaderStage.bufferBindings, bindBuffer);
+    encodeBinding<MVKMTLTextureBinding>(shaderStage.textureBindings, bindTexture);
+    encodeBinding<MVKMTLSamplerStateBinding>(shaderStage.samplerStateBindings, bindSampler);
 }
 
 void MVKGraphicsResourcesCommandEncoderState::offsetZeroDivisorVertexBuffers(MVKGraphicsStage stage,
@@ -709,8 +721,13 @@ void MVKGraphicsResourcesCommandEncoderState::offsetZeroDivisorVertexBuffers(MVK
     auto& shaderStage = _shaderStageResourceBindings[kMVKShaderStageVertex];
     for (auto& binding : pipeline->getZeroDivisorVertexBindings()) {
         uint32_t mtlBuffIdx = pipeline->getMetalBufferIndexForVertexAttributeBinding(binding.first);
-        auto iter = std::find_if(shaderStage.bufferBindings.begin(), shaderStage.bufferBindings.end(), [mtlBuffIdx](const MVKMTLBufferBinding& b) { return b.index == mtlBuffIdx; });
+        auto* iter = shaderStage.bufferBindings.getBinding(mtlBuffIdx);
 		if (!iter) { continue; }
+
+		// The offset set here differs from the offset in the binding, so ensure the binding is encoded again
+		// before the next draw, even if identical content is bound again in the meantime.
+		shaderStage.bufferBindings.markDirty(mtlBuffIdx);
+		MVKCommandEncoderState::markDirty();
         switch (stage) {
             case kMVKGraphicsStageVertex:
                 [_cmdEncoder->getMTLComputeEncoder(kMVKCommandUseTessellationVertexTessCtl) setBufferOffset: iter->offset + firstInstance * binding.second
@@ -731,9 +748,7 @@ void MVKGraphicsResourcesCommandEncoderState::offsetZeroDivisorVertexBuffers(MVK
 void MVKGraphicsResourcesCommandEncoderState::markDirty() {
 	MVKResourcesCommandEncoderState::markDirty();
     for (uint32_t i = kMVKShaderStageVertex; i <= kMVKShaderStageFragment; i++) {
-        MVKResourcesCommandEncoderState::markDirty(_shaderStageResourceBindings[i].bufferBindings, _shaderStageResourceBindings[i].areBufferBindingsDirty);
-        MVKResourcesCommandEncoderState::markDirty(_shaderStageResourceBindings[i].textureBindings, _shaderStageResourceBindings[i].areTextureBindingsDirty);
-        MVKResourcesCommandEncoderState::markDirty(_shaderStageResourceBindings[i].samplerStateBindings, _shaderStageResourceBindings[i].areSamplerStateBindingsDirty);
+        _shaderStageResourceBindings[i].markDirty();
     }
 }
 
@@ -934,41 +949,42 @@ void MVKGraphicsResourcesCommandEncoderState::encodeArgumentBufferResourceUsage(
 #pragma mark MVKComputeResourcesCommandEncoderState
 
 void MVKComputeResourcesCommandEncoderState::bindBuffer(const MVKMTLBufferBinding& binding) {
-	bind(binding, _resourceBindings.bufferBindings, _resourceBindings.areBufferBindingsDirty);
+	bind(binding, _resourceBindings.bufferBindings);
+	_cmdEncoder->recordReplayBinding(kMVKShaderStageCompute, binding);
 }
 
 void MVKComputeResourcesCommandEncoderState::bindTexture(const MVKMTLTextureBinding& binding) {
-    bind(binding, _resourceBindings.textureBindings, _resourceBindings.areTextureBindingsDirty, _resourceBindings.needsSwizzle);
+    bind(binding, _resourceBindings.textureBindings, _resourceBindings.needsSwizzle);
+	_cmdEncoder->recordReplayBinding(kMVKShaderStageCompute, binding);
 }
 
 void MVKComputeResourcesCommandEncoderState::bindSamplerState(const MVKMTLSamplerStateBinding& binding) {
-    bind(binding, _resourceBindings.samplerStateBindings, _resourceBindings.areSamplerStateBindingsDirty);
+    bind(binding, _resourceBindings.samplerStateBindings);
+	_cmdEncoder->recordReplayBinding(kMVKShaderStageCompute, binding);
 }
 
 void MVKComputeResourcesCommandEncoderState::bindSwizzleBuffer(const MVKShaderImplicitRezBinding& binding,
 															   bool needSwizzleBuffer) {
     _resourceBindings.swizzleBufferBinding.index = binding.stages[kMVKShaderStageCompute];
-    _resourceBindings.swizzleBufferBinding.isDirty = needSwizzleBuffer;
+    _resourceBindings.swizzleBufferBinding.isNeeded = needSwizzleBuffer;
 }
 
 void MVKComputeResourcesCommandEncoderState::bindBufferSizeBuffer(const MVKShaderImplicitRezBinding& binding,
 																  bool needBufferSizeBuffer) {
     _resourceBindings.bufferSizeBufferBinding.index = binding.stages[kMVKShaderStageCompute];
-    _resourceBindings.bufferSizeBufferBinding.isDirty = needBufferSizeBuffer;
+    _resourceBindings.bufferSizeBufferBinding.isNeeded = needBufferSizeBuffer;
 }
 
 void MVKComputeResourcesCommandEncoderState::bindDynamicOffsetBuffer(const MVKShaderImplicitRezBinding& binding,
 																	 bool needDynamicOffsetBuffer) {
 	_resourceBindings.dynamicOffsetBufferBinding.index = binding.stages[kMVKShaderStageCompute];
-	_resourceBindings.dynamicOffsetBufferBinding.isDirty = needDynamicOffsetBuffer;
+	_resourceBindings.dynamicOffsetBufferBinding.isNeeded = needDynamicOffsetBuffer;
 }
 
 // Mark everything as dirty
 void MVKComputeResourcesCommandEncoderState::markDirty() {
     MVKResourcesCommandEncoderState::markDirty();
-    MVKResourcesCommandEncoderState::markDirty(_resourceBindings.bufferBindings, _resourceBindings.areBufferBindingsDirty);
-    MVKResourcesCommandEncoderState::markDirty(_resourceBindings.textureBindings, _resourceBindings.areTextureBindingsDirty);
-    MVKResourcesCommandEncoderState::markDirty(_resourceBindings.samplerStateBindings, _resourceBindings.areSamplerStateBindingsDirty);
+    _resourceBindings.markDirty();
 }
 
 void MVKComputeResourcesCommandEncoderState::encodeImpl(uint32_t) {
@@ -978,10 +994,10 @@ void MVKComputeResourcesCommandEncoderState::encodeImpl(uint32_t) {
     MVKPipeline* pipeline = _cmdEncoder->_computePipelineState.getPipeline();
 	bool fullImageViewSwizzle = pipeline ? pipeline->fullImageViewSwizzle() : false;
 
-    if (_resourceBindings.swizzleBufferBinding.isDirty) {
-		for (auto& b : _resourceBindings.textureBindings) {
-			if (b.isDirty) { updateImplicitBuffer(_resourceBindings.swizzleConstants, b.index, b.swizzle); }
-		}
+    if (_resourceBindings.swizzleBufferBinding.isNeeded) {
+		_resourceBindings.textureBindings.forEachDirtyBinding([&](MVKMTLTextureBinding& b) {
+			updateImplicitBuffer(_resourceBindings.swizzleConstants, b.index, b.swizzle);
+		});
 
 		_cmdEncoder->setComputeBytes(_cmdEncoder->getMTLComputeEncoder(kMVKCommandUseDispatch),
                                      _resourceBindings.swizzleConstants.data(),
@@ -989,13 +1005,13 @@ void MVKComputeResourcesCommandEncoderState::encodeImpl(uint32_t) {
                                      _resourceBindings.swizzleBufferBinding.index);
 
 	} else {
-		assertMissingSwizzles(_resourceBindings.needsSwizzle && !fullImageViewSwizzle, "compute", _resourceBindings.textureBindings.contents());
+		assertMissingSwizzles(_resourceBindings.needsSwizzle && !fullImageViewSwizzle, "compute", _resourceBindings.textureBindings);
     }
 
-    if (_resourceBindings.bufferSizeBufferBinding.isDirty) {
-		for (auto& b : _resourceBindings.bufferBindings) {
-			if (b.isDirty) { updateImplicitBuffer(_resourceBindings.bufferSizes, b.index, b.size); }
-		}
+    if (_resourceBindings.bufferSizeBufferBinding.isNeeded) {
+		_resourceBindings.bufferBindings.forEachDirtyBinding([&](MVKMTLBufferBinding& b) {
+			updateImplicitBuffer(_resourceBindings.bufferSizes, b.index, b.size);
+		});
 
 		_cmdEncoder->setComputeBytes(_cmdEncoder->getMTLComputeEncoder(kMVKCommandUseDispatch),
                                      _resourceBindings.bufferSizes.data(),
@@ -1004,7 +1020,7 @@ void MVKComputeResourcesCommandEncoderState::encodeImpl(uint32_t) {
 
     }
 
-	if (_resourceBindings.dynamicOffsetBufferBinding.isDirty) {
+	if (_resourceBindings.dynamicOffsetBufferBinding.isNeeded) {
 		_cmdEncoder->setComputeBytes(_cmdEncoder->getMTLComputeEncoder(kMVKCommandUseDispatch),
 									 _dynamicOffsets.data(),
 									 _dynamicOffsets.size() * sizeof(uint32_t),
@@ -1012,7 +1028,7 @@ void MVKComputeResourcesCommandEncoderState::encodeImpl(uint32_t) {
 
 	}
 
-	encodeBinding<MVKMTLBufferBinding>(_resourceBindings.bufferBindings, _resourceBindings.areBufferBindingsDirty,
+	encodeBinding<MVKMTLBufferBinding>(_resourceBindings.bufferBindings,
 									   [](MVKCommandEncoder* cmdEncoder, MVKMTLBufferBinding& b)->void {
 		if (b.isInline) {
 			cmdEncoder->setComputeBytes(cmdEncoder->getMTLComputeEncoder(kMVKCommandUseDispatch),
@@ -1026,13 +1042,13 @@ void MVKComputeResourcesCommandEncoderState::encodeImpl(uint32_t) {
 		}
 	});
 
-    encodeBinding<MVKMTLTextureBinding>(_resourceBindings.textureBindings, _resourceBindings.areTextureBindingsDirty,
+    encodeBinding<MVKMTLTextureBinding>(_resourceBindings.textureBindings,
                                         [](MVKCommandEncoder* cmdEncoder, MVKMTLTextureBinding& b)->void {
                                             [cmdEncoder->getMTLComputeEncoder(kMVKCommandUseDispatch) setTexture: b.mtlTexture
 																										 atIndex: b.index];
                                         });
 
-    encodeBinding<MVKMTLSamplerStateBinding>(_resourceBindings.samplerStateBindings, _resourceBindings.areSamplerStateBindingsDirty,
+    encodeBinding<MVKMTLSamplerStateBinding>(_resourceBindings.samplerStateBindings,
                                              [](MVKCommandEncoder* cmdEncoder, MVKMTLSamplerStateBinding& b)->void {
                                                  [cmdEncoder->getMTLComputeEncoder(kMVKCommandUseDispatch) setSamplerState: b.mtlSamplerState
 																												   atIndex: b.index];
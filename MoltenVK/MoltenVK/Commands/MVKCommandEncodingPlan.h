@@ -0,0 +1,283 @@
+/*
+ * MVKCommandEncodingPlan.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The contents of this file do not depend on Metal, or on the MoltenVK command and encoder
+// classes, so that the division and scheduling of concurrent encoding can be exercised
+// with any command type and encoder.
+
+
+#pragma mark -
+#pragma mark MVKCommandEncodingScope
+
+/** Indicates how a command constrains the division of a command buffer into segments that are encoded concurrently. */
+typedef enum : uint8_t {
+	kMVKCommandEncodingScopeSegment = 0,	/**< Encodes work that must be encoded in the same segment as the commands before it. */
+	kMVKCommandEncodingScopeState,			/**< Only sets encoder state, and is encoded again to prime the encoder of each later segment. */
+	kMVKCommandEncodingScopeBoundary,		/**< Encodes work that can begin a new segment, such as beginning a render pass, or dispatching compute work. */
+	kMVKCommandEncodingScopeCommandBuffer,	/**< Depends on encoding state that spans segments. The command buffer must be encoded as a single segment. */
+} MVKCommandEncodingScope;
+
+
+#pragma mark -
+#pragma mark MVKCommandEncodingWorkerPool
+
+/**
+ * A pool of persistent worker threads that run a task concurrently with the calling thread, so that
+ * encoding a command buffer concurrently does not create and join threads each time it is submitted.
+ *
+ * Worker threads are created as they are first needed, and live until the pool is destroyed.
+ * Only one task runs in the pool at a time. A task that is run while the pool is running another
+ * task, such as when command buffers are submitted to several queues at once, runs only on its
+ * calling thread, so the task must not depend on being run on more than one thread.
+ */
+class MVKCommandEncodingWorkerPool {
+
+public:
+
+	/**
+	 * Runs the task on the calling thread, and on up to (threadCount - 1) worker threads,
+	 * and returns once the task has returned on all of them.
+	 */
+	void run(size_t threadCount, const std::function<void()>& task) {
+		std::unique_lock<std::mutex> runLock(_runLock, std::try_to_lock);
+		size_t wkrCnt = (runLock.owns_lock() && threadCount > 1) ? threadCount - 1 : 0;
+		if ( !wkrCnt ) {
+			task();
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			while (_workers.size() < wkrCnt) { _workers.emplace_back(&MVKCommandEncodingWorkerPool::work, this, _workers.size()); }
+			_pTask = &task;
+			_taskWorkerCount = wkrCnt;
+			_runningWorkerCount = wkrCnt;
+			_taskID++;
+		}
+		_taskCondition.notify_all();
+
+		task();
+
+		std::unique_lock<std::mutex> lock(_lock);
+		_doneCondition.wait(lock, [this]() { return _runningWorkerCount == 0; });
+		_pTask = nullptr;
+	}
+
+	/** Returns the number of worker threads that have been created by this pool. */
+	size_t getWorkerCount() {
+		std::lock_guard<std::mutex> lock(_lock);
+		return _workers.size();
+	}
+
+	/** Returns a pool shared by all command buffers, whose worker threads live as long as the process. */
+	static MVKCommandEncodingWorkerPool& getSharedPool() {
+		static MVKCommandEncodingWorkerPool* pSharedPool = new MVKCommandEncodingWorkerPool();
+		return *pSharedPool;
+	}
+
+	~MVKCommandEncodingWorkerPool() {
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			_isStopping = true;
+		}
+		_taskCondition.notify_all();
+		for (auto& wkr : _workers) { wkr.join(); }
+	}
+
+protected:
+
+	// Runs each task that includes this worker, until the pool is destroyed.
+	void work(size_t wkrIdx) {
+		uint64_t lastTaskID = 0;
+		std::unique_lock<std::mutex> lock(_lock);
+		while (true) {
+			_taskCondition.wait(lock, [&]() { return _isStopping || (_taskID != lastTaskID && wkrIdx < _taskWorkerCount); });
+			if (_isStopping) { return; }
+
+			lastTaskID = _taskID;
+			const std::function<void()>* pTask = _pTask;
+			lock.unlock();
+			(*pTask)();
+			lock.lock();
+			if (--_runningWorkerCount == 0) { _doneCondition.notify_one(); }
+		}
+	}
+
+	std::mutex _runLock;
+	std::mutex _lock;
+	std::condition_variable _taskCondition;
+	std::condition_variable _doneCondition;
+	std::vector<std::thread> _workers;
+	const std::function<void()>* _pTask = nullptr;
+	size_t _taskWorkerCount = 0;
+	size_t _runningWorkerCount = 0;
+	uint64_t _taskID = 0;
+	bool _isStopping = false;
+};
+
+
+#pragma mark -
+#pragma mark MVKCommandEncodingPlan
+
+/**
+ * Divides a linked list of commands into segments that can be encoded concurrently,
+ * each by its own encoder, and schedules the encoding and ordered commitment of those segments.
+ *
+ * Each segment after the first begins with a command whose scope is kMVKCommandEncodingScopeBoundary.
+ * Encoder state set by the commands of earlier segments is not visible to the encoder of a later
+ * segment, so before encoding the commands of a segment, its encoder must be primed by encoding each
+ * of the commands with scope kMVKCommandEncodingScopeState that precede the segment in the list.
+ * Because the same priming command is encoded into the encoders of several segments, encoders are
+ * primed one at a time, before any segment is encoded, so that no command is ever encoded by more
+ * than one thread at a time.
+ *
+ * The command type C must contain a _next member that points to the next command in the list, and
+ * a getEncodingScope() member function that returns the MVKCommandEncodingScope of the command.
+ *
+ * This class is not thread-safe, but the functions passed to encode() are called concurrently.
+ */
+template <class C>
+class MVKCommandEncodingPlan {
+
+public:
+
+	/**
+	 * The minimum number of segments that a list of commands is divided into. Encoding fewer segments
+	 * concurrently gains too little to cover the cost of encoding into several MTLCommandBuffers.
+	 */
+	static constexpr size_t kMinSegmentCount = 3;
+
+	/** A contiguous range of the commands in the list. */
+	typedef struct Segment {
+		C* firstCommand;				/**< The first command in this segment. */
+		C* endCommand;					/**< The first command of the next segment, or null if this is the last segment. */
+		size_t commandCount;			/**< The number of commands in this segment. */
+		size_t primingCommandCount;		/**< The number of priming commands that precede this segment. */
+	} Segment;
+
+	/**
+	 * Divides the list of commands that begins with the head command into segments. Each segment contains
+	 * at least the minimum number of commands, and the list is not divided into more than the maximum number
+	 * of segments. The number of commands in the list is used to divide the list into segments of similar size.
+	 *
+	 * Returns whether the list was divided into at least kMinSegmentCount segments. Returns false, and leaves
+	 * this plan empty, if the list is too short to be divided into that many segments, or if it contains a
+	 * command that requires the command buffer to be encoded as a single segment.
+	 */
+	bool divide(C* headCommand, size_t commandCount, size_t minSegmentCommandCount, size_t maxSegmentCount) {
+		clear();
+
+		minSegmentCommandCount = std::max<size_t>(minSegmentCommandCount, 1);
+		if (maxSegmentCount < kMinSegmentCount || commandCount < minSegmentCommandCount * kMinSegmentCount) { return false; }
+
+		size_t segCmdCnt = std::max(minSegmentCommandCount, (commandCount + maxSegmentCount - 1) / maxSegmentCount);
+
+		_segments.push_back({headCommand, nullptr, 0, 0});
+		for (C* cmd = headCommand; cmd; cmd = cmd->_next) {
+			switch (cmd->getEncodingScope()) {
+				case kMVKCommandEncodingScopeState:
+					_primingCommands.push_back(cmd);
+					break;
+				case kMVKCommandEncodingScopeBoundary:
+					if (_segments.back().commandCount >= segCmdCnt && _segments.size() < maxSegmentCount) {
+						_segments.back().endCommand = cmd;
+						_segments.push_back({cmd, nullptr, 0, _primingCommands.size()});
+					}
+					break;
+				case kMVKCommandEncodingScopeCommandBuffer:
+					clear();
+					return false;
+				default:
+					break;
+			}
+			_segments.back().commandCount++;
+		}
+
+		// A short last segment is not worth priming another encoder for, so fold it into the previous segment.
+		size_t segCnt = _segments.size();
+		if (segCnt > 1 && _segments.back().commandCount < minSegmentCommandCount) {
+			Segment& prevSeg = _segments[segCnt - 2];
+			prevSeg.endCommand = nullptr;
+			prevSeg.commandCount += _segments.back().commandCount;
+			_segments.pop_back();
+		}
+
+		if (_segments.size() < kMinSegmentCount) {
+			clear();
+			return false;
+		}
+		return true;
+	}
+
+	/** Returns the number of segments in this plan. */
+	size_t getSegmentCount() { return _segments.size(); }
+
+	/** Returns the segment at the index. */
+	const Segment& getSegment(size_t segIdx) { return _segments[segIdx]; }
+
+	/**
+	 * Returns the priming command at the index. The priming commands that must be encoded before
+	 * the commands of a segment are those with an index less than the primingCommandCount of the segment.
+	 */
+	C* getPrimingCommand(size_t cmdIdx) { return _primingCommands[cmdIdx]; }
+
+	/**
+	 * Calls the primeSegment(segIdx) function for each segment, in order, on the calling thread. Then calls
+	 * the encodeSegment(segIdx) function once for each segment, on the calling thread and on up to
+	 * (threadCount - 1) persistent worker threads of the shared MVKCommandEncodingWorkerPool, with segments
+	 * claimed by each thread in order. Once all segments have been encoded, calls the commitSegment(segIdx)
+	 * function for each segment, in order, on the calling thread.
+	 */
+	template <class P, class E, class S>
+	void encode(size_t threadCount, P primeSegment, E encodeSegment, S commitSegment) {
+		size_t segCnt = _segments.size();
+		for (size_t segIdx = 0; segIdx < segCnt; segIdx++) { primeSegment(segIdx); }
+
+		std::atomic<size_t> nextSegIdx(0);
+		auto encodeSegments = [&]() {
+			size_t segIdx;
+			while ((segIdx = nextSegIdx++) < segCnt) { encodeSegment(segIdx); }
+		};
+
+		MVKCommandEncodingWorkerPool::getSharedPool().run(std::min(threadCount, segCnt), encodeSegments);
+
+		for (size_t segIdx = 0; segIdx < segCnt; segIdx++) { commitSegment(segIdx); }
+	}
+
+	/** Empties this plan. */
+	void clear() {
+		_segments.clear();
+		_primingCommands.clear();
+	}
+
+protected:
+	std::vector<Segment> _segments;
+	std::vector<C*> _primingCommands;
+};
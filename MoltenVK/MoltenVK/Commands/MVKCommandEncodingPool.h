@@ -68,6 +68,9 @@ public:
      */
     MVKMTLBufferAllocation* acquireMTLBufferAllocation(NSUInteger length, bool isPrivate = false, bool isDedicated = false);
 
+	/** Returns the allocator of host-shared MTLBuffer regions, from which transient upload data is sub-allocated. */
+	MVKMTLBufferAllocator* getMTLBufferAllocator() { return &_mtlBufferAllocator; }
+
 	/**
 	 * Returns a MTLRenderPipelineState dedicated to rendering to several attachments
 	 * to support clearing regions of those attachments.
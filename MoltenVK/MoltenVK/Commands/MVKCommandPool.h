@@ -87,6 +87,9 @@ public:
 	/** Release any held but unused memory back to the system. */
 	void trim();
 
+	/** Returns whether the commands in the command buffers of this pool are allocated from command arenas. */
+	bool usesCommandArenas() { return _usesCommandArenas; }
+
 
 #pragma mark Construction
 
@@ -95,7 +98,8 @@ public:
 
 	MVKCommandPool(MVKDevice* device,
 				   const VkCommandPoolCreateInfo* pCreateInfo,
-				   bool usePooling);
+				   bool usePooling,
+				   bool useCommandArenas = false);
 
 	~MVKCommandPool() override;
 
@@ -105,5 +109,6 @@ protected:
 	std::unordered_set<MVKCommandBuffer*> _allocatedCommandBuffers;
 	MVKCommandEncodingPool _commandEncodingPool;
 	uint32_t _queueFamilyIndex;
+	bool _usesCommandArenas;
 };
 
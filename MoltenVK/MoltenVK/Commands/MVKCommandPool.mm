@@ -81,10 +81,15 @@ id<MTLCommandBuffer> MVKCommandPool::newMTLCommandBuffer(uint32_t queueIndex) {
 	return [_device->getQueue(_queueFamilyIndex, queueIndex)->getMTLCommandBuffer(kMVKCommandUseEndCommandBuffer, true) retain];
 }
 
-// Clear the command type pool member variables.
+// Clear the command type pool member variables, and release the unused
+// command arena memory held by the command buffers allocated from this pool.
 void MVKCommandPool::trim() {
 #	define MVK_CMD_TYPE_POOL(cmdType)  _cmd ##cmdType ##Pool.clear();
 #	include "MVKCommandTypePools.def"
+
+	if (_usesCommandArenas) {
+		for (auto& cb : _allocatedCommandBuffers) { cb->trimCommandArena(); }
+	}
 }
 
 
@@ -92,9 +97,11 @@ void MVKCommandPool::trim() {
 
 MVKCommandPool::MVKCommandPool(MVKDevice* device,
 							   const VkCommandPoolCreateInfo* pCreateInfo,
-							   bool usePooling) :
+							   bool usePooling,
+							   bool useCommandArenas) :
 	MVKVulkanAPIDeviceObject(device),
 	_queueFamilyIndex(pCreateInfo->queueFamilyIndex),
+	_usesCommandArenas(useCommandArenas),
 	_commandBufferPool(device, usePooling),
 	_commandEncodingPool(this),
 
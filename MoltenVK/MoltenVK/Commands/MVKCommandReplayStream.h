@@ -0,0 +1,231 @@
+/*
+ * MVKCommandReplayStream.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// The contents of this file do not depend on Metal, or on the MoltenVK command and encoder
+// classes, so that the recording, validation, and replay of an op stream can be exercised
+// with any command type.
+
+
+#pragma mark -
+#pragma mark MVKCommandReplayMode
+
+/** Indicates how a command is represented in the replay stream of a reusable command buffer. */
+typedef enum : uint8_t {
+	kMVKCommandReplayEncode = 0,	/**< The command is encoded again each time the stream is replayed. */
+	kMVKCommandReplayBindings,		/**< The command is replaced by the resource bindings it resolved when it was first encoded. */
+	kMVKCommandReplayExpand,		/**< The command is replaced by the commands it encodes, such as those of a secondary command buffer. */
+} MVKCommandReplayMode;
+
+
+#pragma mark -
+#pragma mark MVKCommandReplayOp
+
+/** Identifies the operation performed by an op in a replay stream. */
+typedef enum : uint8_t {
+	kMVKCommandReplayOpEncodeCommand = 0,	/**< Encode the command. */
+	kMVKCommandReplayOpBindBuffer,			/**< Bind a resolved buffer, or inline bytes, to a shader stage. */
+	kMVKCommandReplayOpBindTexture,			/**< Bind a resolved texture to a shader stage. */
+	kMVKCommandReplayOpBindSamplerState,	/**< Bind a resolved sampler state to a shader stage. */
+} MVKCommandReplayOpType;
+
+/**
+ * A single operation in a replay stream. The op is plain data. Resources are held as
+ * opaque pointers, and are not retained, so the op is only valid while the objects
+ * on which its stream depends have not changed.
+ */
+template <class C>
+struct MVKCommandReplayOp {
+	union {
+		C* command;					/**< The command to encode, for an encode op. */
+		const void* resource;		/**< The resolved resource or inline bytes, for a bind op. */
+	};
+	uint64_t offset;				/**< The offset into a resolved buffer. */
+	uint32_t sizeOrSwizzle;			/**< The size of a resolved buffer, or the swizzle of a resolved texture. */
+	uint16_t index;					/**< The binding index of the resolved resource. */
+	uint8_t stage;					/**< The shader stage of the resolved resource. */
+	MVKCommandReplayOpType type;	/**< The type of this op. */
+	bool isInline;					/**< Whether the resolved resource is inline bytes. */
+};
+
+
+#pragma mark -
+#pragma mark MVKCommandReplayDependency
+
+/** An object on which a replay stream depends, and the version of its content when the stream was recorded. */
+typedef struct MVKCommandReplayDependency {
+	const void* object;			/**< The object. */
+	uint64_t version;			/**< The version of the content of the object when the stream was recorded. */
+	uint32_t kind;				/**< Identifies the type of the object, so its current version can be retrieved. */
+} MVKCommandReplayDependency;
+
+/**
+ * Returns a new content version. Content versions are unique across all objects on which a replay
+ * stream can depend, so a content version is never repeated, even if an object is reused.
+ */
+inline uint64_t mvkNewCommandReplayVersion() {
+	static std::atomic<uint64_t> nextVersion(1);
+	return nextVersion++;
+}
+
+
+#pragma mark -
+#pragma mark MVKCommandReplayStream
+
+/**
+ * A flattened stream of ops, recorded when a reusable command buffer is first encoded, and
+ * replayed in place of walking its commands when the command buffer is encoded again.
+ *
+ * The stream lists the commands in the order they were encoded, with the commands of secondary
+ * command buffers, and the commands repeated for each pass of a multiview render pass, already
+ * expanded in place. Commands that bind descriptor sets are replaced by the resource bindings
+ * they resolved, so replaying them does not walk the descriptors again.
+ *
+ * The stream records the objects whose content it depends on, and the version of that content.
+ * The stream can only be replayed while the current version of each of those objects is unchanged.
+ *
+ * The command type C is opaque to this class. This class is not thread-safe.
+ */
+template <class C>
+class MVKCommandReplayStream {
+
+public:
+
+	typedef MVKCommandReplayOp<C> Op;
+	static_assert(std::is_trivially_copyable<Op>::value, "MVKCommandReplayOp must be plain data.");
+
+	/** Empties this stream, and prepares it to record ops. */
+	void beginRecording() {
+		clear();
+		_isRecording = true;
+	}
+
+	/** Ends recording. If the recording was successful, this stream can subsequently be replayed. */
+	void endRecording(bool wasSuccessful = true) {
+		_isRecording = false;
+		_isRecorded = wasSuccessful;
+		if ( !wasSuccessful ) { clear(); }
+	}
+
+	/** Returns whether ops are currently being recorded into this stream. */
+	bool isRecording() { return _isRecording; }
+
+	/** Returns whether this stream contains a complete recording. */
+	bool isRecorded() { return _isRecorded; }
+
+	/** Appends an op that encodes the command. */
+	void recordCommand(C* command) {
+		Op op = {};
+		op.command = command;
+		op.type = kMVKCommandReplayOpEncodeCommand;
+		_ops.push_back(op);
+	}
+
+	/** Appends an op that binds a resolved resource. */
+	void recordBinding(MVKCommandReplayOpType type, uint8_t stage, uint16_t index, const void* resource,
+					   uint64_t offset = 0, uint32_t sizeOrSwizzle = 0, bool isInline = false) {
+		Op op = {};
+		op.resource = resource;
+		op.offset = offset;
+		op.sizeOrSwizzle = sizeOrSwizzle;
+		op.index = index;
+		op.stage = stage;
+		op.type = type;
+		op.isInline = isInline;
+		_ops.push_back(op);
+	}
+
+	/** Returns the number of ops in this stream. */
+	size_t getOpCount() { return _ops.size(); }
+
+	/**
+	 * Replaces the ops at and after the op index with a single op that encodes the command.
+	 * This is used when the bindings resolved by a command cannot be replayed, because a
+	 * resource they resolved might be different when the command is encoded again.
+	 */
+	void replaceOpsWithCommand(size_t opIndex, C* command) {
+		if (opIndex < _ops.size()) { _ops.resize(opIndex); }
+		recordCommand(command);
+	}
+
+	/** Records that this stream depends on the content of the object, at the version. */
+	void addDependency(const void* object, uint64_t version, uint32_t kind) {
+		for (auto& dep : _dependencies) {
+			if (dep.object == object && dep.kind == kind) {
+				// The same object with different content means the stream cannot be reused.
+				if (dep.version != version) { _isConsistent = false; }
+				return;
+			}
+		}
+		_dependencies.push_back({object, version, kind});
+	}
+
+	/**
+	 * Returns whether this stream contains a complete recording, and the current version of every
+	 * object it depends on, as returned by the getVersion(const MVKCommandReplayDependency&) function,
+	 * is the version recorded with the stream.
+	 */
+	template <class V>
+	bool isCurrent(V getVersion) {
+		if ( !(_isRecorded && _isConsistent) ) { return false; }
+		return std::all_of(_dependencies.begin(), _dependencies.end(),
+						   [&](const MVKCommandReplayDependency& dep) { return getVersion(dep) == dep.version; });
+	}
+
+	/** Calls the replayOp(const Op&) function for each op in this stream, in order. */
+	template <class R>
+	void replay(R replayOp) {
+		for (auto& op : _ops) { replayOp(op); }
+	}
+
+	/** Returns the ops in this stream. */
+	const std::vector<Op>& getOps() { return _ops; }
+
+	/** Returns the objects on which this stream depends. */
+	const std::vector<MVKCommandReplayDependency>& getDependencies() { return _dependencies; }
+
+	/** Empties this stream. */
+	void clear() {
+		_ops.clear();
+		_dependencies.clear();
+		_isRecording = false;
+		_isRecorded = false;
+		_isConsistent = true;
+	}
+
+	/** Empties this stream, and releases the memory it holds. */
+	void trim() {
+		clear();
+		_ops.shrink_to_fit();
+		_dependencies.shrink_to_fit();
+	}
+
+protected:
+	std::vector<Op> _ops;
+	std::vector<MVKCommandReplayDependency> _dependencies;
+	bool _isRecording = false;
+	bool _isRecorded = false;
+	bool _isConsistent = true;
+};
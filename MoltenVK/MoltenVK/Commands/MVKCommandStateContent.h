@@ -0,0 +1,199 @@
+/*
+ * MVKCommandStateContent.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "MVKCommandEncodingPlan.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+// The contents of this file do not depend on Metal, or on the MoltenVK command and encoder
+// classes, so that the coalescing of redundant state commands can be exercised with any
+// command type.
+
+
+#pragma mark -
+#pragma mark MVKCommandStateContent
+
+/** Identifies the encoder state set by a command, so that redundant commands that set the same state can be coalesced. */
+typedef enum : uint8_t {
+	kMVKCommandStateNone = 0,				/**< The command does not set any state that can be coalesced. */
+	kMVKCommandStateViewports,				/**< The command sets dynamic viewports. */
+	kMVKCommandStateScissors,				/**< The command sets dynamic scissors. */
+	kMVKCommandStatePushConstants,			/**< The command sets push constants. */
+	kMVKCommandStateGraphicsDescriptorSets,	/**< The command binds descriptor sets to the graphics pipeline bind point. */
+	kMVKCommandStateComputeDescriptorSets,	/**< The command binds descriptor sets to the compute pipeline bind point. */
+	kMVKCommandStateCount,					/**< The number of types of state that can be coalesced. */
+	kMVKCommandStateAll = kMVKCommandStateCount,	/**< The command may set any state, such as by executing secondary command buffers. */
+} MVKCommandStateType;
+
+/**
+ * Describes the encoder state set by a command, as a contiguous range of elements of one type of state.
+ *
+ * The content of two commands can be compared, element by element, if they set the same type of state,
+ * with the same layout and selector. If the elements are null, the content set by the command cannot be
+ * compared, and the command is never coalesced with another command.
+ */
+typedef struct MVKCommandStateContent {
+	MVKCommandStateType stateType = kMVKCommandStateNone;	/**< The type of state set by the command. */
+	const void* layout = nullptr;							/**< The pipeline layout used to set the state, if the content depends on it. */
+	uint32_t selector = 0;									/**< Distinguishes separate instances of the same type of state, such as the shader stages of push constants. */
+	uint32_t firstElement = 0;								/**< The index of the first element of state set by the command. */
+	uint32_t elementCount = 0;								/**< The number of elements of state set by the command. */
+	uint32_t elementSize = 0;								/**< The size of each element, in bytes. */
+	const void* elements = nullptr;							/**< The elements of state set by the command. */
+
+	/** Returns the index of the element that follows the elements set by the command. */
+	uint32_t getEndElement() const { return firstElement + elementCount; }
+
+	/** Returns whether the content of this command and the other command can be compared. */
+	bool isComparableWith(const MVKCommandStateContent& other) const {
+		return (elements && other.elements &&
+				stateType == other.stateType &&
+				layout == other.layout &&
+				selector == other.selector &&
+				elementSize == other.elementSize);
+	}
+
+	/** Returns whether the elements set by this command are also set, to identical content, by the other command. */
+	bool isRedundantWith(const MVKCommandStateContent& other) const {
+		if ( !isComparableWith(other) ) { return false; }
+		if (firstElement < other.firstElement || getEndElement() > other.getEndElement()) { return false; }
+		auto* otherElems = (const char*)other.elements + (firstElement - other.firstElement) * elementSize;
+		return memcmp(elements, otherElems, elementCount * elementSize) == 0;
+	}
+
+	/** Returns whether this command sets all of the elements that are set by the other command. */
+	bool contains(const MVKCommandStateContent& other) const {
+		return (isComparableWith(other) &&
+				firstElement <= other.firstElement &&
+				getEndElement() >= other.getEndElement());
+	}
+
+	/** Returns whether the range of elements set by this command overlaps or abuts the range set by the other command. */
+	bool canMergeWith(const MVKCommandStateContent& other) const {
+		return (isComparableWith(other) &&
+				firstElement <= other.getEndElement() &&
+				other.firstElement <= getEndElement());
+	}
+
+} MVKCommandStateContent;
+
+/**
+ * Merges the content of the state set by an earlier command, which must overlap or abut the range of elements
+ * beginning at firstElement, into the elements, as if the earlier command had set its state immediately before
+ * the elements were set. The elements and firstElement are updated to cover the range of both commands.
+ */
+template<class V>
+void mvkMergeCommandStateContent(V& elements,
+								 uint32_t& firstElement,
+								 const MVKCommandStateContent& prevContent) {
+	typedef typename std::remove_reference<decltype(elements[0])>::type T;
+
+	uint32_t mrgFirst = std::min(firstElement, prevContent.firstElement);
+	uint32_t mrgEnd = std::max<uint32_t>(firstElement + (uint32_t)elements.size(), prevContent.getEndElement());
+	uint32_t elemShift = firstElement - mrgFirst;
+	uint32_t elemCnt = (uint32_t)elements.size();
+
+	// Shift the elements of this command to their position in the merged range,
+	// then add the elements of the earlier command that this command does not overwrite.
+	elements.resize(mrgEnd - mrgFirst);
+	for (uint32_t elemIdx = elemCnt; elemIdx-- > 0; ) { elements[elemIdx + elemShift] = elements[elemIdx]; }
+
+	auto* prevElems = (const T*)prevContent.elements;
+	for (uint32_t prevIdx = 0; prevIdx < prevContent.elementCount; prevIdx++) {
+		uint32_t mrgIdx = prevContent.firstElement - mrgFirst + prevIdx;
+		if (mrgIdx < elemShift || mrgIdx >= elemShift + elemCnt) { elements[mrgIdx] = prevElems[prevIdx]; }
+	}
+	firstElement = mrgFirst;
+}
+
+
+#pragma mark -
+#pragma mark Coalescing state commands
+
+/** The numbers of state commands removed by mvkCoalesceStateCommands(). */
+typedef struct MVKCommandCoalescingCounts {
+	uint32_t removedCount = 0;		/**< The number of commands removed because their state was redundant. */
+	uint32_t mergedCount = 0;		/**< The number of commands removed because their state was merged into a later command. */
+} MVKCommandCoalescingCounts;
+
+/**
+ * Removes redundant state commands from the commands, by replacing them with null, and passing them to the
+ * releaseCommand function. Each state command is compared only with the most recent earlier command that sets
+ * the same type of state. If the state set by the command is already set to the same content by the earlier
+ * command, the command is removed. Otherwise, if no draw, dispatch, or other command that might use the state
+ * lies between the two commands, the content of the earlier command is merged into the command, and the
+ * earlier command is removed. A command that might set any state, such as one that executes secondary
+ * command buffers, ends all comparisons with the commands before it.
+ *
+ * The commands are held in an indexable container of pointers to the command type C, which must contain
+ * getStateContent(), mergeStateContent(), and getEncodingScope() member functions, like those of MVKCommand.
+ */
+template <class V, class R>
+MVKCommandCoalescingCounts mvkCoalesceStateCommands(V& cmds, R releaseCommand) {
+	static constexpr size_t kNoCmdIdx = std::numeric_limits<size_t>::max();
+	size_t prevCmdIndices[kMVKCommandStateCount];
+	std::fill_n(prevCmdIndices, kMVKCommandStateCount, kNoCmdIdx);
+	size_t lastUseIdx = kNoCmdIdx;		// Index of the most recent command that might use state
+	MVKCommandCoalescingCounts counts;
+
+	size_t cmdCnt = cmds.size();
+	for (size_t cmdIdx = 0; cmdIdx < cmdCnt; cmdIdx++) {
+		auto* cmd = cmds[cmdIdx];
+		MVKCommandStateContent content = cmd->getStateContent();
+		switch (content.stateType) {
+			case kMVKCommandStateNone:
+				if (cmd->getEncodingScope() != kMVKCommandEncodingScopeState) { lastUseIdx = cmdIdx; }
+				continue;
+			case kMVKCommandStateAll:
+				std::fill_n(prevCmdIndices, kMVKCommandStateCount, kNoCmdIdx);
+				lastUseIdx = cmdIdx;
+				continue;
+			default:
+				break;
+		}
+
+		size_t& prevCmdIdx = prevCmdIndices[content.stateType];
+		if (prevCmdIdx != kNoCmdIdx) {
+			auto*& prevCmd = cmds[prevCmdIdx];
+			MVKCommandStateContent prevContent = prevCmd->getStateContent();
+			if (content.isRedundantWith(prevContent)) {
+				releaseCommand(cmd);
+				cmds[cmdIdx] = nullptr;
+				counts.removedCount++;
+				continue;
+			}
+			bool isPrevUnused = (lastUseIdx == kNoCmdIdx || lastUseIdx < prevCmdIdx);
+			if (isPrevUnused && content.contains(prevContent)) {
+				releaseCommand(prevCmd);
+				prevCmd = nullptr;
+				counts.removedCount++;
+			} else if (isPrevUnused && content.canMergeWith(prevContent) && cmd->mergeStateContent(prevContent)) {
+				releaseCommand(prevCmd);
+				prevCmd = nullptr;
+				counts.mergedCount++;
+			}
+		}
+		prevCmdIdx = cmdIdx;
+	}
+	return counts;
+}
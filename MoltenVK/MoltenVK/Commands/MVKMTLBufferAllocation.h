@@ -23,6 +23,7 @@
 #include "MVKObjectPool.h"
 #include "MVKDevice.h"
 #include "MVKSmallVector.h"
+#include "MVKBufferUploadRing.h"
 
 class MVKMTLBufferAllocationPool;
 
@@ -77,6 +78,11 @@ protected:
  *
  * To return a MVKMTLBufferAllocation retrieved from this pool, back to this pool, 
  * call the returnToPool() function on the MVKMTLBufferAllocation instance.
+ *
+ * If this pool is lock-free, allocations are acquired and returned through the lock-free
+ * object pool, and a lock is only taken when a new allocation must be created.
+ * The purgeable state of the MTLBuffers of a lock-free pool is not changed as allocations are
+ * acquired and returned, because the allocation count of each MTLBuffer is not tracked.
  */
 class MVKMTLBufferAllocationPool : public MVKObjectPool<MVKMTLBufferAllocation>, public MVKDeviceTrackingMixin {
 
@@ -92,7 +98,7 @@ public:
 
     /** Configures this instance to dispense MVKMTLBufferAllocation instances of the specified size. */
     MVKMTLBufferAllocationPool(MVKDevice* device, NSUInteger allocationLength, bool makeThreadSafe,
-							   bool isDedicated, MTLStorageMode mtlStorageMode);
+							   bool isDedicated, MTLStorageMode mtlStorageMode, bool isLockFree = false);
 
     ~MVKMTLBufferAllocationPool() override;
 
@@ -149,7 +155,10 @@ public:
      * maximum size. Because MVKMTLBufferRegions are created with a power-of-two size,
      * the largest size of a MVKMTLBufferAllocation dispensed by this instance will be the
      * next power-of-two value that is at least as big as the specified maximum size.
-	 * If makeThreadSafe is true, a lock will be applied when an allocation is acquired.
+	 * If makeThreadSafe is true, a lock will be applied when an allocation is acquired, unless the
+	 * MVKConfiguration::useLockFreeBufferAllocation setting is enabled, in which case allocations
+	 * are acquired and returned through per-thread caches, and a lock is only applied when a new
+	 * allocation must be created.
      */
     MVKMTLBufferAllocator(MVKDevice* device, NSUInteger maxRegionLength, bool makeThreadSafe = false,
 						  bool isDedicated = false, MTLStorageMode mtlStorageMode = MTLStorageModeShared);
@@ -163,3 +172,64 @@ protected:
 
 };
 
+
+#pragma mark -
+#pragma mark MVKMTLBufferUploadRing
+
+/** The length of each MTLBuffer block from which a MVKMTLBufferUploadRing sub-allocates regions. */
+static constexpr NSUInteger kMVKMTLBufferUploadRingBlockLength = 256 * KIBI;
+
+/** Defines a contiguous region of bytes within a MTLBuffer, sub-allocated from a MVKMTLBufferUploadRing. */
+typedef struct MVKMTLBufferUploadRegion {
+	id<MTLBuffer> _mtlBuffer = nil;
+	NSUInteger _offset = 0;
+	NSUInteger _length = 0;
+
+	/**
+	 * Returns a pointer to the begining of this region memory, taking into
+	 * consideration this region's offset into the underlying MTLBuffer.
+	 */
+	inline void* getContents() const { return (void*)((uintptr_t)_mtlBuffer.contents + _offset); }
+} MVKMTLBufferUploadRegion;
+
+/**
+ * Sub-allocates transient regions, such as the constant data uploaded while encoding a command
+ * buffer, from a MVKBufferUploadRing of large blocks acquired from a MVKMTLBufferAllocator.
+ * Each region is aligned to the alignment specified when this ring is created. A region larger
+ * than a block is given its own block.
+ *
+ * Regions are not returned individually. Once the GPU has finished with all regions sub-allocated
+ * since the previous recycle, recycleOnCompletion() returns all of the blocks to the allocator at once,
+ * from a single MTLCommandBuffer completion handler.
+ *
+ * This class is not thread-safe.
+ */
+class MVKMTLBufferUploadRing {
+
+public:
+
+	/** Returns a region of the specified length. */
+	MVKMTLBufferUploadRegion acquireRegion(NSUInteger length);
+
+	/** Returns a region of the specified length, containing a copy of the bytes. */
+	MVKMTLBufferUploadRegion copyBytes(const void* bytes, NSUInteger length);
+
+	/**
+	 * Returns all blocks acquired since the previous recycle to the allocator, once the MTLCommandBuffer
+	 * completes, and returns the number of regions sub-allocated from those blocks. Regions subsequently
+	 * acquired from this ring are sub-allocated from new blocks.
+	 */
+	uint32_t recycleOnCompletion(id<MTLCommandBuffer> mtlCmdBuff);
+
+	/** Returns the number of blocks acquired since the previous recycle. */
+	uint32_t getBlockCount() { return _ring.getBlockCount(); }
+
+	MVKMTLBufferUploadRing(MVKMTLBufferAllocator* allocator, NSUInteger alignment,
+						   NSUInteger blockLength = kMVKMTLBufferUploadRingBlockLength);
+
+	~MVKMTLBufferUploadRing();
+
+protected:
+	MVKBufferUploadRing<MVKMTLBufferAllocation> _ring;
+};
+
@@ -58,7 +58,9 @@ MVKMTLBufferAllocation* MVKMTLBufferAllocationPool::acquireAllocationUnlocked()
 }
 
 MVKMTLBufferAllocation* MVKMTLBufferAllocationPool::acquireAllocation() {
-    if (_isThreadSafe) {
+	if (isLockFree()) {
+		return acquireObjectSafely();
+	} else if (_isThreadSafe) {
         std::lock_guard<std::mutex> lock(_lock);
         return acquireAllocationUnlocked();
     } else {
@@ -74,7 +76,9 @@ void MVKMTLBufferAllocationPool::returnAllocationUnlocked(MVKMTLBufferAllocation
 }
 
 void MVKMTLBufferAllocationPool::returnAllocation(MVKMTLBufferAllocation* ba) {
-    if (_isThreadSafe) {
+	if (isLockFree()) {
+		returnObjectSafely(ba);
+	} else if (_isThreadSafe) {
         std::lock_guard<std::mutex> lock(_lock);
         returnAllocationUnlocked(ba);
     } else {
@@ -84,8 +88,8 @@ void MVKMTLBufferAllocationPool::returnAllocation(MVKMTLBufferAllocation* ba) {
 
 
 MVKMTLBufferAllocationPool::MVKMTLBufferAllocationPool(MVKDevice* device, NSUInteger allocationLength, bool makeThreadSafe,
-													   bool isDedicated, MTLStorageMode mtlStorageMode) :
-	MVKObjectPool<MVKMTLBufferAllocation>(true),
+													   bool isDedicated, MTLStorageMode mtlStorageMode, bool isLockFree) :
+	MVKObjectPool<MVKMTLBufferAllocation>(true, isLockFree),
 	MVKDeviceTrackingMixin(device) {
 
     _allocationLength = allocationLength;
@@ -130,6 +134,7 @@ MVKMTLBufferAllocation* MVKMTLBufferAllocator::acquireMTLBufferRegion(NSUInteger
 MVKMTLBufferAllocator::MVKMTLBufferAllocator(MVKDevice* device, NSUInteger maxRegionLength, bool makeThreadSafe, bool isDedicated, MTLStorageMode mtlStorageMode) : MVKBaseDeviceObject(device) {
 	_maxAllocationLength = std::max<NSUInteger>(maxRegionLength, _device->_pMetalFeatures->mtlBufferAlignment);
 	_isThreadSafe = makeThreadSafe;
+	bool isLockFree = makeThreadSafe && mvkConfig().useLockFreeBufferAllocation;
 
     // Convert max length to the next power-of-two exponent
     NSUInteger maxP2Exp = mvkPowerOfTwoExponent(_maxAllocationLength);
@@ -138,7 +143,7 @@ MVKMTLBufferAllocator::MVKMTLBufferAllocator(MVKDevice* device, NSUInteger maxRe
     _regionPools.reserve(maxP2Exp + 1);
     NSUInteger allocLen = 1;
     for (uint32_t p2Exp = 0; p2Exp <= maxP2Exp; p2Exp++) {
-        _regionPools.push_back(new MVKMTLBufferAllocationPool(device, allocLen, makeThreadSafe, isDedicated, mtlStorageMode));
+        _regionPools.push_back(new MVKMTLBufferAllocationPool(device, allocLen, makeThreadSafe, isDedicated, mtlStorageMode, isLockFree));
         allocLen <<= 1;
     }
 }
@@ -147,3 +152,38 @@ MVKMTLBufferAllocator::~MVKMTLBufferAllocator() {
     mvkDestroyContainerContents(_regionPools);
 }
 
+
+#pragma mark -
+#pragma mark MVKMTLBufferUploadRing
+
+MVKMTLBufferUploadRegion MVKMTLBufferUploadRing::acquireRegion(NSUInteger length) {
+	auto region = _ring.acquireRegion(length);
+	return { region.block->_mtlBuffer, region.block->_offset + region.offset, length };
+}
+
+MVKMTLBufferUploadRegion MVKMTLBufferUploadRing::copyBytes(const void* bytes, NSUInteger length) {
+	MVKMTLBufferUploadRegion region = acquireRegion(length);
+	memcpy(region.getContents(), bytes, length);
+	return region;
+}
+
+uint32_t MVKMTLBufferUploadRing::recycleOnCompletion(id<MTLCommandBuffer> mtlCmdBuff) {
+	std::vector<MVKMTLBufferAllocation*> blocks;
+	uint32_t regionCnt = _ring.recycle(blocks);
+	if ( !blocks.empty() ) {
+		auto* pBlocks = new std::vector<MVKMTLBufferAllocation*>(std::move(blocks));
+		[mtlCmdBuff addCompletedHandler: ^(id<MTLCommandBuffer> mcb) {
+			for (auto* block : *pBlocks) { block->returnToPool(); }
+			delete pBlocks;
+		}];
+	}
+	return regionCnt;
+}
+
+MVKMTLBufferUploadRing::MVKMTLBufferUploadRing(MVKMTLBufferAllocator* allocator, NSUInteger alignment, NSUInteger blockLength) :
+	_ring([allocator](size_t length) { return allocator->acquireMTLBufferRegion(length); }, alignment, blockLength) {}
+
+// Blocks that were never handed to a MTLCommandBuffer were not used by the GPU, and can be returned immediately.
+MVKMTLBufferUploadRing::~MVKMTLBufferUploadRing() {
+	for (auto* block : _ring.getBlocks()) { block->returnToPool(); }
+}
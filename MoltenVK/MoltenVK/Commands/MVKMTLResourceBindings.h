@@ -19,28 +19,32 @@
 #pragma once
 
 #include "mvk_vulkan.h"
+#include "MVKPipelineBarrier.h"
 
 #import <Metal/Metal.h>
 
 
-class MVKResource;
-class MVKBuffer;
-class MVKImage;
-
-
 /** Describes a MTLTexture resource binding. */
 typedef struct MVKMTLTextureBinding {
     union { id<MTLTexture> mtlTexture = nil; id<MTLTexture> mtlResource; }; // aliases
     uint32_t swizzle = 0;
 	uint16_t index = 0;
-    bool isDirty = true;
+
+	/** Returns whether this binding would bind the same content as the other binding. */
+	bool isRedundantWith(const MVKMTLTextureBinding& other) const {
+		return mtlTexture == other.mtlTexture && swizzle == other.swizzle;
+	}
 } MVKMTLTextureBinding;
 
 /** Describes a MTLSamplerState resource binding. */
 typedef struct MVKMTLSamplerStateBinding {
     union { id<MTLSamplerState> mtlSamplerState = nil; id<MTLSamplerState> mtlResource; }; // aliases
     uint16_t index = 0;
-    bool isDirty = true;
+
+	/** Returns whether this binding would bind the same content as the other binding. */
+	bool isRedundantWith(const MVKMTLSamplerStateBinding& other) const {
+		return mtlSamplerState == other.mtlSamplerState;
+	}
 } MVKMTLSamplerStateBinding;
 
 /** Describes a MTLBuffer resource binding. */
@@ -49,10 +53,26 @@ typedef struct MVKMTLBufferBinding {
     VkDeviceSize offset = 0;
     uint32_t size = 0;
 	uint16_t index = 0;
-    bool isDirty = true;
     bool isInline = false;
+
+	/**
+	 * Returns whether this binding would bind the same content as the other binding.
+	 * The content of inline bytes may have changed, so inline bindings are never redundant.
+	 */
+	bool isRedundantWith(const MVKMTLBufferBinding& other) const {
+		return !isInline && !other.isInline && mtlBuffer == other.mtlBuffer && offset == other.offset && size == other.size;
+	}
 } MVKMTLBufferBinding;
 
+/**
+ * Describes the MTLBuffer binding of an implicit buffer, whose content is provided by MoltenVK,
+ * such as the swizzle constants of the bound textures, and which is only bound if the bound
+ * pipeline needs it.
+ */
+typedef struct MVKMTLImplicitBufferBinding : MVKMTLBufferBinding {
+	bool isNeeded = false;
+} MVKMTLImplicitBufferBinding;
+
 /** Describes a MTLBuffer resource binding as used for an index buffer. */
 typedef struct MVKIndexMTLBufferBinding {
     union { id<MTLBuffer> mtlBuffer = nil; id<MTLBuffer> mtlResource; }; // aliases
@@ -61,73 +81,4 @@ typedef struct MVKIndexMTLBufferBinding {
     bool isDirty = true;
 } MVKIndexMTLBufferBinding;
 
-/** Concise and consistent structure for holding pipeline barrier info. */
-typedef struct MVKPipelineBarrier {
-
-	typedef enum : uint8_t {
-		None,
-		Memory,
-		Buffer,
-		Image,
-	} MVKPipelineBarrierType;
-
-	union { MVKBuffer* mvkBuffer = nullptr; MVKImage* mvkImage; MVKResource* mvkResource; };
-	union {
-		struct {
-			VkDeviceSize offset = 0;
-			VkDeviceSize size = 0;
-		};
-		struct {
-			VkImageLayout newLayout;
-			VkImageAspectFlags aspectMask;
-			uint16_t baseArrayLayer;
-			uint16_t layerCount;
-			uint8_t baseMipLevel;
-			uint8_t levelCount;
-		};
-	};
-	VkAccessFlags srcAccessMask = 0;
-	VkAccessFlags dstAccessMask = 0;
-	uint8_t srcQueueFamilyIndex = 0;
-	uint8_t dstQueueFamilyIndex = 0;
-
-	MVKPipelineBarrierType type = None;
-
-	bool isMemoryBarrier() { return type == Memory; }
-	bool isBufferBarrier() { return type == Buffer; }
-	bool isImageBarrier() { return type == Image; }
-
-	MVKPipelineBarrier(const VkMemoryBarrier& vkBarrier) :
-		type(Memory),
-		srcAccessMask(vkBarrier.srcAccessMask),
-		dstAccessMask(vkBarrier.dstAccessMask)
-		{}
-
-	MVKPipelineBarrier(const VkBufferMemoryBarrier& vkBarrier) :
-		type(Buffer),
-		srcAccessMask(vkBarrier.srcAccessMask),
-		dstAccessMask(vkBarrier.dstAccessMask),
-		srcQueueFamilyIndex(vkBarrier.srcQueueFamilyIndex),
-		dstQueueFamilyIndex(vkBarrier.dstQueueFamilyIndex),
-		mvkBuffer((MVKBuffer*)vkBarrier.buffer),
-		offset(vkBarrier.offset),
-		size(vkBarrier.size)
-		{}
-
-	MVKPipelineBarrier(const VkImageMemoryBarrier& vkBarrier) :
-		type(Image),
-		srcAccessMask(vkBarrier.srcAccessMask),
-		dstAccessMask(vkBarrier.dstAccessMask),
-		newLayout(vkBarrier.newLayout),
-		srcQueueFamilyIndex(vkBarrier.srcQueueFamilyIndex),
-		dstQueueFamilyIndex(vkBarrier.dstQueueFamilyIndex),
-		mvkImage((MVKImage*)vkBarrier.image),
-		aspectMask(vkBarrier.subresourceRange.aspectMask),
-		baseMipLevel(vkBarrier.subresourceRange.baseMipLevel),
-		levelCount(vkBarrier.subresourceRange.levelCount),
-		baseArrayLayer(vkBarrier.subresourceRange.baseArrayLayer),
-		layerCount(vkBarrier.subresourceRange.layerCount)
-		{}
-
-} MVKPipelineBarrier;
 
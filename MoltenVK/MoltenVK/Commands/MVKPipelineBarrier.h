@@ -0,0 +1,150 @@
+/*
+ * MVKPipelineBarrier.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "mvk_vulkan.h"
+
+#include <algorithm>
+
+// The contents of this file do not depend on Metal, so that the merging
+// of pipeline barriers can be exercised on any platform.
+
+
+class MVKResource;
+class MVKBuffer;
+class MVKImage;
+
+
+/**
+ * Concise and consistent structure for holding pipeline barrier info.
+ *
+ * The structure does not identify the type of barrier it holds. The resource is null for a memory
+ * barrier, and the buffer or image fields are used for a buffer or image barrier, respectively.
+ * Queue family ownership transfers are not tracked, because Metal does not distinguish queue families.
+ */
+typedef struct MVKPipelineBarrier {
+
+	union { MVKBuffer* mvkBuffer = nullptr; MVKImage* mvkImage; MVKResource* mvkResource; };
+	union {
+		struct {
+			VkDeviceSize offset = 0;
+			VkDeviceSize size = 0;
+		};
+		struct {
+			VkImageLayout newLayout;
+			VkImageAspectFlags aspectMask;
+			uint16_t baseArrayLayer;
+			uint16_t layerCount;
+			uint8_t baseMipLevel;
+			uint8_t levelCount;
+		};
+	};
+	VkAccessFlags srcAccessMask = 0;
+	VkAccessFlags dstAccessMask = 0;
+
+	/** Merges the memory barrier into this memory barrier. */
+	void mergeMemoryBarrier(const VkMemoryBarrier& vkBarrier) {
+		srcAccessMask |= vkBarrier.srcAccessMask;
+		dstAccessMask |= vkBarrier.dstAccessMask;
+	}
+
+	/**
+	 * If the buffer barrier covers a range of the same buffer that overlaps, or is adjacent
+	 * to, the range covered by this buffer barrier, extends this barrier to cover both ranges,
+	 * and the access of both barriers, and returns true. Otherwise, returns false.
+	 */
+	bool mergeBufferBarrier(const VkBufferMemoryBarrier& vkBarrier) {
+		if (mvkBuffer != (MVKBuffer*)vkBarrier.buffer) { return false; }
+
+		bool isWhole = (size == VK_WHOLE_SIZE);
+		bool isOtherWhole = (vkBarrier.size == VK_WHOLE_SIZE);
+		VkDeviceSize end = isWhole ? VK_WHOLE_SIZE : offset + size;
+		VkDeviceSize otherEnd = isOtherWhole ? VK_WHOLE_SIZE : vkBarrier.offset + vkBarrier.size;
+		if (vkBarrier.offset > end || offset > otherEnd) { return false; }
+
+		VkDeviceSize mrgOffset = std::min(offset, vkBarrier.offset);
+		size = (isWhole || isOtherWhole) ? VK_WHOLE_SIZE : std::max(end, otherEnd) - mrgOffset;
+		offset = mrgOffset;
+		srcAccessMask |= vkBarrier.srcAccessMask;
+		dstAccessMask |= vkBarrier.dstAccessMask;
+		return true;
+	}
+
+	/**
+	 * If the image barrier transitions the same aspects of the same image, with the same access,
+	 * to the same layout, and covers the same mip levels and adjacent array layers, or the same
+	 * array layers and adjacent mip levels, as this image barrier, extends this barrier to cover
+	 * both subresource ranges, and returns true. Otherwise, returns false.
+	 */
+	bool mergeImageBarrier(const VkImageMemoryBarrier& vkBarrier) {
+		const VkImageSubresourceRange& vkRange = vkBarrier.subresourceRange;
+		if (mvkImage != (MVKImage*)vkBarrier.image ||
+			newLayout != vkBarrier.newLayout ||
+			aspectMask != vkRange.aspectMask ||
+			srcAccessMask != vkBarrier.srcAccessMask ||
+			dstAccessMask != vkBarrier.dstAccessMask) { return false; }
+
+		bool isSameLevels = (baseMipLevel == (uint8_t)vkRange.baseMipLevel && levelCount == (uint8_t)vkRange.levelCount);
+		bool isSameLayers = (baseArrayLayer == (uint16_t)vkRange.baseArrayLayer && layerCount == (uint16_t)vkRange.layerCount);
+		if (isSameLevels && isSameLayers) { return true; }
+
+		// Remaining levels or layers cannot be extended. The merged count must not look like a remaining count.
+		if (isSameLevels && layerCount != (uint16_t)VK_REMAINING_ARRAY_LAYERS &&
+			vkRange.layerCount != VK_REMAINING_ARRAY_LAYERS && baseArrayLayer + layerCount == vkRange.baseArrayLayer &&
+			uint32_t(layerCount) + vkRange.layerCount < (uint16_t)VK_REMAINING_ARRAY_LAYERS) {
+			layerCount += vkRange.layerCount;
+			return true;
+		}
+		if (isSameLayers && levelCount != (uint8_t)VK_REMAINING_MIP_LEVELS &&
+			vkRange.levelCount != VK_REMAINING_MIP_LEVELS && baseMipLevel + levelCount == vkRange.baseMipLevel &&
+			uint32_t(levelCount) + vkRange.levelCount < (uint8_t)VK_REMAINING_MIP_LEVELS) {
+			levelCount += vkRange.levelCount;
+			return true;
+		}
+		return false;
+	}
+
+	MVKPipelineBarrier() {}
+
+	MVKPipelineBarrier(const VkMemoryBarrier& vkBarrier) :
+		srcAccessMask(vkBarrier.srcAccessMask),
+		dstAccessMask(vkBarrier.dstAccessMask)
+		{}
+
+	MVKPipelineBarrier(const VkBufferMemoryBarrier& vkBarrier) :
+		mvkBuffer((MVKBuffer*)vkBarrier.buffer),
+		offset(vkBarrier.offset),
+		size(vkBarrier.size),
+		srcAccessMask(vkBarrier.srcAccessMask),
+		dstAccessMask(vkBarrier.dstAccessMask)
+		{}
+
+	MVKPipelineBarrier(const VkImageMemoryBarrier& vkBarrier) :
+		mvkImage((MVKImage*)vkBarrier.image),
+		newLayout(vkBarrier.newLayout),
+		aspectMask(vkBarrier.subresourceRange.aspectMask),
+		baseArrayLayer(vkBarrier.subresourceRange.baseArrayLayer),
+		layerCount(vkBarrier.subresourceRange.layerCount),
+		baseMipLevel(vkBarrier.subresourceRange.baseMipLevel),
+		levelCount(vkBarrier.subresourceRange.levelCount),
+		srcAccessMask(vkBarrier.srcAccessMask),
+		dstAccessMask(vkBarrier.dstAccessMask)
+		{}
+
+} MVKPipelineBarrier;
@@ -0,0 +1,122 @@
+/*
+ * MVKResourceBindingTable.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// The contents of this file do not depend on Metal, or on the MoltenVK binding types,
+// so that the tracking of bound and dirty resource bindings can be exercised with
+// any binding type.
+
+
+#pragma mark -
+#pragma mark MVKResourceBindingTable
+
+/**
+ * A fixed-capacity table of Metal resource bindings of a single type, addressed by Metal resource index.
+ *
+ * Bitmasks track which indexes are bound, and which bound indexes need to be encoded to the Metal
+ * command encoder, so that only the dirty bindings are visited when encoding. Binding content that
+ * is identical to the content already bound at the same index is elided.
+ *
+ * The bindings are allocated on the heap when the first binding is bound, so that a table is small
+ * when embedded in a command encoder, and a table that is never bound does not allocate bindings.
+ */
+template<class T, size_t N>
+class MVKResourceBindingTable {
+
+public:
+
+	/** The number of Metal resource indexes that can be bound in this table. */
+	static constexpr size_t kCapacity = N;
+
+	/**
+	 * Binds the content at the index of the binding, and marks it as needing to be encoded.
+	 * Returns false, and does nothing, if identical content is already bound at that index,
+	 * or if the index is not less than kCapacity, which the caller is expected to report.
+	 */
+	bool bind(const T& b) {
+		size_t idx = b.index;
+		if (idx >= N) { return false; }
+		if (isBound(idx) && b.isRedundantWith(_bindings[idx])) { return false; }
+		if ( !_bindings ) { _bindings.reset(new T[N]); }
+
+		_bindings[idx] = b;
+		setBit(_boundBits, idx);
+		setBit(_dirtyBits, idx);
+		return true;
+	}
+
+	/** Returns the binding at the index, or null if nothing is bound at that index. */
+	T* getBinding(size_t idx) { return (idx < N && isBound(idx)) ? &_bindings[idx] : nullptr; }
+
+	/** Returns whether any binding needs to be encoded. */
+	bool isDirty() const {
+		for (size_t wordIdx = 0; wordIdx < kWordCount; wordIdx++) {
+			if (_dirtyBits[wordIdx]) { return true; }
+		}
+		return false;
+	}
+
+	/** Marks all bindings as needing to be encoded. */
+	void markDirty() {
+		for (size_t wordIdx = 0; wordIdx < kWordCount; wordIdx++) { _dirtyBits[wordIdx] = _boundBits[wordIdx]; }
+	}
+
+	/** Marks the binding at the index as needing to be encoded, if something is bound at that index. */
+	void markDirty(size_t idx) { if (idx < N && isBound(idx)) { setBit(_dirtyBits, idx); } }
+
+	/** Calls the function on each binding. */
+	template<class F>
+	void forEachBinding(F func) { forEachSetBit(_boundBits, func); }
+
+	/** Calls the function on each binding that needs to be encoded. */
+	template<class F>
+	void forEachDirtyBinding(F func) { forEachSetBit(_dirtyBits, func); }
+
+	/** Calls the function on each binding that needs to be encoded, and marks all bindings as encoded. */
+	template<class F>
+	void encodeDirtyBindings(F func) {
+		forEachSetBit(_dirtyBits, func);
+		for (size_t wordIdx = 0; wordIdx < kWordCount; wordIdx++) { _dirtyBits[wordIdx] = 0; }
+	}
+
+protected:
+	static constexpr size_t kWordCount = (N + 63) / 64;
+
+	bool isBound(size_t idx) const { return _boundBits[idx >> 6] & (1ULL << (idx & 63)); }
+	static void setBit(uint64_t* bits, size_t idx) { bits[idx >> 6] |= 1ULL << (idx & 63); }
+
+	template<class F>
+	void forEachSetBit(const uint64_t* bits, F func) {
+		for (size_t wordIdx = 0; wordIdx < kWordCount; wordIdx++) {
+			uint64_t word = bits[wordIdx];
+			while (word) {
+				func(_bindings[(wordIdx << 6) + __builtin_ctzll(word)]);
+				word &= word - 1;
+			}
+		}
+	}
+
+	std::unique_ptr<T[]> _bindings;
+	uint64_t _boundBits[kWordCount] = {};
+	uint64_t _dirtyBits[kWordCount] = {};
+};
@@ -159,6 +159,7 @@ VkResult MVKBuffer::flushToDevice(VkDeviceSize offset, VkDeviceSize size) {
 		       reinterpret_cast<const char *>(_deviceMemory->getHostMemoryAddress()) + flushOffset,
 		       flushSize);
 		[_mtlBufferCache didModifyRange: NSMakeRange(flushOffset - _deviceMemoryOffset, flushSize)];
+		_device->addCountPerformance(_device->_performanceStatistics.hostMemoryFlush.transferredBytes, flushSize);
 	}
 #endif
 	return VK_SUCCESS;
@@ -207,13 +207,11 @@ void MVKDescriptorSetLayoutBinding::bind(MVKCommandEncoder* cmdEncoder,
 	// Establish the resource indices to use, by combining the offsets of the DSL and this DSL binding.
     MVKShaderResourceBinding mtlIdxs = _mtlResourceIndexOffsets + dslMTLRezIdxOffsets;
 
-	VkDescriptorType descType = getDescriptorType();
+	// The descriptors of this binding are held contiguously, and are all of the type of this binding.
+	auto& descRange = descSet->getDescriptorRange(getBinding());
     uint32_t descCnt = getDescriptorCount(descSet);
     for (uint32_t descIdx = 0; descIdx < descCnt; descIdx++) {
-		MVKDescriptor* mvkDesc = descSet->getDescriptor(getBinding(), descIdx);
-		if (mvkDesc->getDescriptorType() == descType) {
-			mvkDesc->bind(cmdEncoder, this, descIdx, _applyToStage, mtlIdxs, dynamicOffsets, dynamicOffsetIndex);
-		}
+		descRange.getDescriptor(descIdx)->bind(cmdEncoder, this, descIdx, _applyToStage, mtlIdxs, dynamicOffsets, dynamicOffsetIndex);
     }
 }
 
@@ -946,6 +944,7 @@ void MVKImageDescriptor::bind(MVKCommandEncoder* cmdEncoder,
         
         if (_mvkImageView) {
             tb.mtlTexture = _mvkImageView->getMTLTexture(planeIndex);
+            if (cmdEncoder && _mvkImageView->hasVolatileMTLTexture()) { cmdEncoder->markReplayBindingsVolatile(); }
         }
         tb.swizzle = ((descType == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE ||
                        descType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) &&
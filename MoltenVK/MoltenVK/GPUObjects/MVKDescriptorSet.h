@@ -21,6 +21,7 @@
 #include "MVKDescriptor.h"
 #include "MVKSmallVector.h"
 #include "MVKBitArray.h"
+#include <atomic>
 #include <unordered_set>
 #include <unordered_map>
 #include <vector>
@@ -132,7 +133,8 @@ protected:
 	void propagateDebugName() override {}
 	uint32_t getDescriptorCount() { return _descriptorCount; }
 	uint32_t getDescriptorIndex(uint32_t binding, uint32_t elementIndex = 0) { return getBinding(binding)->getDescriptorIndex(elementIndex); }
-	MVKDescriptorSetLayoutBinding* getBinding(uint32_t binding) { return &_bindings[_bindingToIndex[binding]]; }
+	uint32_t getBindingIndex(uint32_t binding) { return _bindingToIndex[binding]; }
+	MVKDescriptorSetLayoutBinding* getBinding(uint32_t binding) { return &_bindings[getBindingIndex(binding)]; }
 	const VkDescriptorBindingFlags* getBindingFlags(const VkDescriptorSetLayoutCreateInfo* pCreateInfo);
 	void initMTLArgumentEncoder();
 
@@ -145,6 +147,29 @@ protected:
 };
 
 
+#pragma mark -
+#pragma mark MVKDescriptorRange
+
+/**
+ * Identifies the descriptors holding the elements of a single binding of a descriptor set.
+ *
+ * The descriptors are instances of a single concrete descriptor class, held in contiguous
+ * memory, and are reserved from the descriptor pool together. Each element is located by
+ * its offset from the first descriptor, without chasing a pointer per element.
+ */
+typedef struct MVKDescriptorRange {
+	MVKDescriptor* pFirstDescriptor = nullptr;	/**< The descriptor of the first element, or null if there are no elements. */
+	uint32_t descriptorStride = 0;				/**< The number of bytes between the descriptors of consecutive elements. */
+	uint32_t descriptorCount = 0;				/**< The number of elements. */
+
+	/** Returns the descriptor of the element at the index. */
+	MVKDescriptor* getDescriptor(uint32_t elementIndex) {
+		return (MVKDescriptor*)((uint8_t*)pFirstDescriptor + (size_t)descriptorStride * elementIndex);
+	}
+
+} MVKDescriptorRange;
+
+
 #pragma mark -
 #pragma mark MVKDescriptorSet
 
@@ -193,15 +218,21 @@ public:
 	/** Returns an array indicating the descriptors that have changed since the Metal argument buffer was last updated. */
 	MVKBitArray& getMetalArgumentBufferDirtyDescriptors() { return _metalArgumentBufferDirtyDescriptors; }
 
-	/** Returns the descriptor at an index. */
-	MVKDescriptor* getDescriptorAt(uint32_t descIndex) { return _descriptors[descIndex]; }
+	/** Returns the descriptors of the binding at the index in the layout of this descriptor set. */
+	MVKDescriptorRange& getDescriptorRangeAt(uint32_t bindingIndex) { return _descriptorRanges[bindingIndex]; }
 
 	/** Returns the number of descriptors in this descriptor set. */
-	uint32_t getDescriptorCount() { return (uint32_t)_descriptors.size(); }
+	uint32_t getDescriptorCount() { return _descriptorCount; }
 
 	/** Returns the number of descriptors in this descriptor set that use dynamic offsets. */
 	uint32_t getDynamicOffsetDescriptorCount() { return _dynamicOffsetDescriptorCount; }
 
+	/**
+	 * Returns the version of the content of this descriptor set. The version changes
+	 * each time this descriptor set is allocated, or any of its descriptors are written.
+	 */
+	uint64_t getContentVersion() { return _contentVersion; }
+
 	MVKDescriptorSet(MVKDescriptorPool* pool);
 
 protected:
@@ -209,7 +240,7 @@ protected:
 	friend class MVKDescriptorPool;
 
 	void propagateDebugName() override {}
-	MVKDescriptor* getDescriptor(uint32_t binding, uint32_t elementIndex = 0);
+	MVKDescriptorRange& getDescriptorRange(uint32_t binding);
 	VkResult allocate(MVKDescriptorSetLayout* layout,
 					  uint32_t variableDescriptorCount,
 					  NSUInteger mtlArgBufferOffset);
@@ -217,9 +248,11 @@ protected:
 
 	MVKDescriptorPool* _pool;
 	MVKDescriptorSetLayout* _layout;
-	MVKSmallVector<MVKDescriptor*> _descriptors;
+	MVKSmallVector<MVKDescriptorRange> _descriptorRanges;
 	MVKBitArray _metalArgumentBufferDirtyDescriptors;
 	NSUInteger _metalArgumentBufferOffset;
+	std::atomic<uint64_t> _contentVersion;
+	uint32_t _descriptorCount;
 	uint32_t _dynamicOffsetDescriptorCount;
 	uint32_t _variableDescriptorCount;
 };
@@ -228,7 +261,10 @@ protected:
 #pragma mark -
 #pragma mark MVKDescriptorTypePool
 
-/** Support class for MVKDescriptorPool that holds a pool of instances of a single concrete descriptor class. */
+/**
+ * Support class for MVKDescriptorPool that holds a pool of instances of a single concrete descriptor class.
+ * Descriptors are reserved and returned in contiguous ranges, one range per descriptor set binding.
+ */
 template<class DescriptorClass>
 class MVKDescriptorTypePool : public MVKBaseObject {
 
@@ -241,12 +277,13 @@ public:
 protected:
 	friend class MVKDescriptorPool;
 
-	VkResult allocateDescriptor(MVKDescriptor** pMVKDesc, MVKDescriptorPool* pool);
-	void freeDescriptor(MVKDescriptor* mvkDesc, MVKDescriptorPool* pool);
+	VkResult allocateDescriptors(uint32_t count, MVKDescriptorRange& descRange, MVKDescriptorPool* pool);
+	void freeDescriptors(MVKDescriptorRange& descRange, MVKDescriptorPool* pool);
 	void reset();
 
 	MVKSmallVector<DescriptorClass> _descriptors;
 	MVKBitArray _availability;
+	size_t _availableCount;
 };
 
 
@@ -286,8 +323,8 @@ protected:
 	const uint32_t* getVariableDecriptorCounts(const VkDescriptorSetAllocateInfo* pAllocateInfo);
 	VkResult allocateDescriptorSet(MVKDescriptorSetLayout* mvkDSL, uint32_t variableDescriptorCount, VkDescriptorSet* pVKDS);
 	void freeDescriptorSet(MVKDescriptorSet* mvkDS, bool isPoolReset);
-	VkResult allocateDescriptor(VkDescriptorType descriptorType, MVKDescriptor** pMVKDesc);
-	void freeDescriptor(MVKDescriptor* mvkDesc);
+	VkResult allocateDescriptors(VkDescriptorType descriptorType, uint32_t count, MVKDescriptorRange& descRange);
+	void freeDescriptors(MVKDescriptorRange& descRange);
 	void initMetalArgumentBuffer(const VkDescriptorPoolCreateInfo* pCreateInfo);
 	NSUInteger getMetalArgumentBufferResourceStorageSize(NSUInteger bufferCount, NSUInteger textureCount, NSUInteger samplerCount);
 	MTLArgumentDescriptor* getMTLArgumentDescriptor(MTLDataType resourceType, NSUInteger argIndex, NSUInteger count);
@@ -278,39 +278,53 @@ VkDescriptorType MVKDescriptorSet::getDescriptorType(uint32_t binding) {
 	return _layout->getBinding(binding)->getDescriptorType();
 }
 
-MVKDescriptor* MVKDescriptorSet::getDescriptor(uint32_t binding, uint32_t elementIndex) {
-	return _descriptors[_layout->getDescriptorIndex(binding, elementIndex)];
+MVKDescriptorRange& MVKDescriptorSet::getDescriptorRange(uint32_t binding) {
+	return _descriptorRanges[_layout->getBindingIndex(binding)];
 }
 
 id<MTLBuffer> MVKDescriptorSet::getMetalArgumentBuffer() { return _pool->_metalArgumentBuffer; }
 
+// Descriptors are held in contiguous ranges, one per binding, so the descriptors of consecutive
+// elements are found by offset from the first, and only the descriptor type of each binding is checked.
+// As permitted by Vulkan, an update that extends beyond the last element of a binding continues
+// into the elements of the next binding. Elements of bindings of a different type are skipped.
 template<typename DescriptorAction>
 void MVKDescriptorSet::write(const DescriptorAction* pDescriptorAction,
 							 size_t stride,
 							 const void* pData) {
-#define writeDescriptorAt(IDX)                                    \
-	do {                                                          \
-		MVKDescriptor* mvkDesc = _descriptors[descIdx];           \
-		if (mvkDesc->getDescriptorType() == descType) {           \
-			mvkDesc->write(mvkDSLBind, this, IDX, stride, pData); \
-			_metalArgumentBufferDirtyDescriptors.setBit(descIdx); \
-		}                                                         \
-	} while(false)
 
 	MVKDescriptorSetLayoutBinding* mvkDSLBind = _layout->getBinding(pDescriptorAction->dstBinding);
 	VkDescriptorType descType = mvkDSLBind->getDescriptorType();
 	if (descType == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT) {
 		// For inline buffers dstArrayElement is a byte offset
-		uint32_t descIdx = _layout->getDescriptorIndex(pDescriptorAction->dstBinding);
-		writeDescriptorAt(pDescriptorAction->dstArrayElement);
+		auto& descRange = getDescriptorRange(pDescriptorAction->dstBinding);
+		descRange.getDescriptor(0)->write(mvkDSLBind, this, pDescriptorAction->dstArrayElement, stride, pData);
+		_metalArgumentBufferDirtyDescriptors.setBit(mvkDSLBind->getDescriptorIndex());
 	} else {
-		uint32_t descStartIdx = _layout->getDescriptorIndex(pDescriptorAction->dstBinding, pDescriptorAction->dstArrayElement);
+		uint32_t bindCnt = (uint32_t)_descriptorRanges.size();
+		uint32_t bindIdx = _layout->getBindingIndex(pDescriptorAction->dstBinding);
+		uint32_t dstElemIdx = pDescriptorAction->dstArrayElement;
 		uint32_t elemCnt = pDescriptorAction->descriptorCount;
-		for (uint32_t elemIdx = 0; elemIdx < elemCnt; elemIdx++) {
-			uint32_t descIdx = descStartIdx + elemIdx;
-			writeDescriptorAt(elemIdx);
+		uint32_t srcElemIdx = 0;
+		while (srcElemIdx < elemCnt && bindIdx < bindCnt) {
+			auto& descRange = _descriptorRanges[bindIdx];
+			MVKDescriptorSetLayoutBinding* mvkDSLBindAt = _layout->getBindingAt(bindIdx++);
+			if (dstElemIdx >= descRange.descriptorCount) {
+				dstElemIdx -= descRange.descriptorCount;
+				continue;
+			}
+			uint32_t rangeElemCnt = std::min(elemCnt - srcElemIdx, descRange.descriptorCount - dstElemIdx);
+			if (mvkDSLBindAt->getDescriptorType() == descType) {
+				for (uint32_t elemIdx = 0; elemIdx < rangeElemCnt; elemIdx++) {
+					descRange.getDescriptor(dstElemIdx + elemIdx)->write(mvkDSLBindAt, this, srcElemIdx + elemIdx, stride, pData);
+				}
+				_metalArgumentBufferDirtyDescriptors.setBits(mvkDSLBindAt->getDescriptorIndex(dstElemIdx), rangeElemCnt);
+			}
+			srcElemIdx += rangeElemCnt;
+			dstElemIdx = 0;
 		}
 	}
+	_contentVersion = mvkNewCommandReplayVersion();
 }
 
 void MVKDescriptorSet::read(const VkCopyDescriptorSet* pDescriptorCopy,
@@ -321,21 +335,32 @@ void MVKDescriptorSet::read(const VkCopyDescriptorSet* pDescriptorCopy,
 
 	MVKDescriptorSetLayoutBinding* mvkDSLBind = _layout->getBinding(pDescriptorCopy->srcBinding);
 	VkDescriptorType descType = mvkDSLBind->getDescriptorType();
-	uint32_t descCnt = pDescriptorCopy->descriptorCount;
     if (descType == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT) {
 		// For inline buffers srcArrayElement is a byte offset
-		MVKDescriptor* mvkDesc = getDescriptor(pDescriptorCopy->srcBinding);
-		if (mvkDesc->getDescriptorType() == descType) {
-			mvkDesc->read(mvkDSLBind, this, pDescriptorCopy->srcArrayElement, pImageInfo, pBufferInfo, pTexelBufferView, pInlineUniformBlock);
-		}
+		auto& descRange = getDescriptorRange(pDescriptorCopy->srcBinding);
+		descRange.getDescriptor(0)->read(mvkDSLBind, this, pDescriptorCopy->srcArrayElement, pImageInfo, pBufferInfo, pTexelBufferView, pInlineUniformBlock);
     } else {
-        uint32_t srcStartIdx = _layout->getDescriptorIndex(pDescriptorCopy->srcBinding, pDescriptorCopy->srcArrayElement);
-        for (uint32_t descIdx = 0; descIdx < descCnt; descIdx++) {
-			MVKDescriptor* mvkDesc = _descriptors[srcStartIdx + descIdx];
-			if (mvkDesc->getDescriptorType() == descType) {
-				mvkDesc->read(mvkDSLBind, this, descIdx, pImageInfo, pBufferInfo, pTexelBufferView, pInlineUniformBlock);
+		uint32_t bindCnt = (uint32_t)_descriptorRanges.size();
+		uint32_t bindIdx = _layout->getBindingIndex(pDescriptorCopy->srcBinding);
+		uint32_t srcElemIdx = pDescriptorCopy->srcArrayElement;
+		uint32_t descCnt = pDescriptorCopy->descriptorCount;
+		uint32_t dstElemIdx = 0;
+		while (dstElemIdx < descCnt && bindIdx < bindCnt) {
+			auto& descRange = _descriptorRanges[bindIdx];
+			MVKDescriptorSetLayoutBinding* mvkDSLBindAt = _layout->getBindingAt(bindIdx++);
+			if (srcElemIdx >= descRange.descriptorCount) {
+				srcElemIdx -= descRange.descriptorCount;
+				continue;
 			}
-        }
+			uint32_t rangeElemCnt = std::min(descCnt - dstElemIdx, descRange.descriptorCount - srcElemIdx);
+			if (mvkDSLBindAt->getDescriptorType() == descType) {
+				for (uint32_t elemIdx = 0; elemIdx < rangeElemCnt; elemIdx++) {
+					descRange.getDescriptor(srcElemIdx + elemIdx)->read(mvkDSLBindAt, this, dstElemIdx + elemIdx, pImageInfo, pBufferInfo, pTexelBufferView, pInlineUniformBlock);
+				}
+			}
+			dstElemIdx += rangeElemCnt;
+			srcElemIdx = 0;
+		}
     }
 }
 
@@ -343,51 +368,49 @@ MVKMTLBufferAllocation* MVKDescriptorSet::acquireMTLBufferRegion(NSUInteger leng
 	return _pool->_inlineBlockMTLBufferAllocator.acquireMTLBufferRegion(length);
 }
 
+// Reserves the descriptors of each binding from the pool as a single contiguous range.
 VkResult MVKDescriptorSet::allocate(MVKDescriptorSetLayout* layout,
 									uint32_t variableDescriptorCount,
 									NSUInteger mtlArgBufferOffset) {
 	_layout = layout;
 	_variableDescriptorCount = variableDescriptorCount;
+	_contentVersion = mvkNewCommandReplayVersion();
 
 	// If the Metal argument buffer offset has not been set yet, set it now.
 	if ( !_metalArgumentBufferOffset ) { _metalArgumentBufferOffset = mtlArgBufferOffset; }
 
-	uint32_t descCnt = layout->getDescriptorCount();
-	_descriptors.reserve(descCnt);
-	_metalArgumentBufferDirtyDescriptors.resize(descCnt);
-
 	uint32_t bindCnt = (uint32_t)layout->_bindings.size();
+	_descriptorRanges.reserve(bindCnt);
+	_metalArgumentBufferDirtyDescriptors.resize(layout->getDescriptorCount());
+
 	for (uint32_t bindIdx = 0; bindIdx < bindCnt; bindIdx++) {
 		MVKDescriptorSetLayoutBinding* mvkDSLBind = &layout->_bindings[bindIdx];
 		uint32_t elemCnt = mvkDSLBind->getDescriptorCount(this);
-		for (uint32_t elemIdx = 0; elemIdx < elemCnt; elemIdx++) {
-			VkDescriptorType descType = mvkDSLBind->getDescriptorType();
-			uint32_t descIdx = (uint32_t)_descriptors.size();
-			MVKDescriptor* mvkDesc = nullptr;
-			setConfigurationResult(_pool->allocateDescriptor(descType, &mvkDesc));
-			if ( !wasConfigurationSuccessful() ) { return getConfigurationResult(); }
-			if (mvkDesc->usesDynamicBufferOffsets()) { _dynamicOffsetDescriptorCount++; }
-			if (mvkDSLBind->usesImmutableSamplers()) { _metalArgumentBufferDirtyDescriptors.setBit(descIdx); }
-			_descriptors.push_back(mvkDesc);
-		}
+		MVKDescriptorRange descRange;
+		setConfigurationResult(_pool->allocateDescriptors(mvkDSLBind->getDescriptorType(), elemCnt, descRange));
+		if ( !wasConfigurationSuccessful() ) { return getConfigurationResult(); }
+		_descriptorRanges.push_back(descRange);
+		if (elemCnt && descRange.getDescriptor(0)->usesDynamicBufferOffsets()) { _dynamicOffsetDescriptorCount += elemCnt; }
+		if (mvkDSLBind->usesImmutableSamplers()) { _metalArgumentBufferDirtyDescriptors.setBits(_descriptorCount, elemCnt); }
+		_descriptorCount += elemCnt;
 	}
 	return getConfigurationResult();
 }
 
 void MVKDescriptorSet::free(bool isPoolReset) {
 	_layout = nullptr;
+	_contentVersion = mvkNewCommandReplayVersion();
 	_dynamicOffsetDescriptorCount = 0;
 	_variableDescriptorCount = 0;
+	_descriptorCount = 0;
 
 	// Only reset the Metal arg buffer offset if the entire pool is being reset
 	if (isPoolReset) { _metalArgumentBufferOffset = 0; }
 
-	// Pooled descriptors don't need to be individually freed under pool resets.
-	if ( !(_pool->_hasPooledDescriptors && isPoolReset) ) {
-		for (auto mvkDesc : _descriptors) { _pool->freeDescriptor(mvkDesc); }
-	}
-	_descriptors.clear();
-	_descriptors.shrink_to_fit();
+	// Ranges are freed even under pool resets, because a fragmented pool may have allocated some outside the pool.
+	for (auto& descRange : _descriptorRanges) { _pool->freeDescriptors(descRange); }
+	_descriptorRanges.clear();
+	_descriptorRanges.shrink_to_fit();
 	_metalArgumentBufferDirtyDescriptors.resize(0);
 
 	clearConfigurationResult();
@@ -401,49 +424,74 @@ MVKDescriptorSet::MVKDescriptorSet(MVKDescriptorPool* pool) : MVKVulkanAPIDevice
 #pragma mark -
 #pragma mark MVKDescriptorTypePool
 
-// If preallocated, find the next availalble descriptor.
-// If not preallocated, create one on the fly.
+// If preallocated, find the first run of available descriptors that is long enough to hold all
+// of the elements of a binding, and reserve the entire run. Descriptor sets are not individually
+// freed before a pool reset, so the available descriptors form a single run until a set is freed.
+// If enough descriptors are available, but freeing sets has fragmented them so that no run is long
+// enough, create an array of descriptors on the fly, which still counts against the pool capacity.
+// If not preallocated, create an array of descriptors on the fly.
 template<class DescriptorClass>
-VkResult MVKDescriptorTypePool<DescriptorClass>::allocateDescriptor(MVKDescriptor** pMVKDesc,
-																	MVKDescriptorPool* pool) {
-	DescriptorClass* mvkDesc;
+VkResult MVKDescriptorTypePool<DescriptorClass>::allocateDescriptors(uint32_t count,
+																	 MVKDescriptorRange& descRange,
+																	 MVKDescriptorPool* pool) {
+	descRange.pFirstDescriptor = nullptr;
+	descRange.descriptorStride = sizeof(DescriptorClass);
+	descRange.descriptorCount = count;
+	if ( !count ) { return VK_SUCCESS; }
+
+	DescriptorClass* pDescs = nullptr;
 	if (pool->_hasPooledDescriptors) {
-		size_t availDescIdx = _availability.getIndexOfFirstSetBit(true);
-		if (availDescIdx >= _availability.size()) { return VK_ERROR_OUT_OF_POOL_MEMORY; }
-		mvkDesc = &_descriptors[availDescIdx];
-		mvkDesc->reset();		// Clear before reusing.
-	} else {
-		mvkDesc = new DescriptorClass();
+		if (count > _availableCount) { return VK_ERROR_OUT_OF_POOL_MEMORY; }
+		_availableCount -= count;
+
+		size_t runStartIdx = _availability.getIndexOfFirstSetBitRun(count, true);
+		if (runStartIdx < _availability.size()) {
+			pDescs = &_descriptors[runStartIdx];
+			for (uint32_t descIdx = 0; descIdx < count; descIdx++) {
+				pDescs[descIdx].reset();		// Clear before reusing.
+			}
+		}
 	}
-	*pMVKDesc = mvkDesc;
+	if ( !pDescs ) { pDescs = new DescriptorClass[count]; }
+	descRange.pFirstDescriptor = pDescs;
 	return VK_SUCCESS;
 }
 
 // If preallocated, descriptors are held in contiguous memory, so the index of the returning
-// descriptor can be calculated by pointer differences, and it can be marked as available.
-// The descriptor will be reset when it is re-allocated. This streamlines the reset() of this pool.
-// If not preallocated, simply destroy returning descriptor.
+// descriptors can be calculated by pointer differences, and they can be marked as available.
+// The descriptors will be reset when they are re-allocated. This streamlines the reset() of this pool.
+// If not preallocated, or created on the fly because the pool was fragmented,
+// simply destroy the returning array of descriptors.
 template<typename DescriptorClass>
-void MVKDescriptorTypePool<DescriptorClass>::freeDescriptor(MVKDescriptor* mvkDesc,
-															MVKDescriptorPool* pool) {
-	if (pool->_hasPooledDescriptors) {
-		size_t descIdx = (DescriptorClass*)mvkDesc - _descriptors.data();
-		_availability.setBit(descIdx);
+void MVKDescriptorTypePool<DescriptorClass>::freeDescriptors(MVKDescriptorRange& descRange,
+															 MVKDescriptorPool* pool) {
+	auto* pDescs = (DescriptorClass*)descRange.pFirstDescriptor;
+	if ( !pDescs ) { return; }
+
+	if (pool->_hasPooledDescriptors) { _availableCount += descRange.descriptorCount; }
+
+	DescriptorClass* pPoolDescs = _descriptors.data();
+	if (pDescs >= pPoolDescs && pDescs < pPoolDescs + _descriptors.size()) {
+		_availability.setBits(pDescs - pPoolDescs, descRange.descriptorCount);
 	} else {
-		mvkDesc->destroy();
+		delete[] pDescs;
 	}
+	descRange.pFirstDescriptor = nullptr;
+	descRange.descriptorCount = 0;
 }
 
 // Preallocated descriptors will be reset when they are reused
 template<typename DescriptorClass>
 void MVKDescriptorTypePool<DescriptorClass>::reset() {
 	_availability.setAllBits();
+	_availableCount = _descriptors.size();
 }
 
 template<typename DescriptorClass>
 MVKDescriptorTypePool<DescriptorClass>::MVKDescriptorTypePool(size_t poolSize) :
 	_descriptors(poolSize),
-	_availability(poolSize, true) {}
+	_availability(poolSize, true),
+	_availableCount(poolSize) {}
 
 
 #pragma mark -
@@ -578,89 +626,92 @@ VkResult MVKDescriptorPool::reset(VkDescriptorPoolResetFlags flags) {
 	return VK_SUCCESS;
 }
 
-// Allocate a descriptor of the specified type
-VkResult MVKDescriptorPool::allocateDescriptor(VkDescriptorType descriptorType,
-											   MVKDescriptor** pMVKDesc) {
+// Allocate a contiguous range of descriptors of the specified type
+VkResult MVKDescriptorPool::allocateDescriptors(VkDescriptorType descriptorType,
+												uint32_t count,
+												MVKDescriptorRange& descRange) {
 	switch (descriptorType) {
 		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-			return _uniformBufferDescriptors.allocateDescriptor(pMVKDesc, this);
+			return _uniformBufferDescriptors.allocateDescriptors(count, descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-			return _storageBufferDescriptors.allocateDescriptor(pMVKDesc, this);
+			return _storageBufferDescriptors.allocateDescriptors(count, descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
-			return _uniformBufferDynamicDescriptors.allocateDescriptor(pMVKDesc, this);
+			return _uniformBufferDynamicDescriptors.allocateDescriptors(count, descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
-			return _storageBufferDynamicDescriptors.allocateDescriptor(pMVKDesc, this);
+			return _storageBufferDynamicDescriptors.allocateDescriptors(count, descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT:
-			return _inlineUniformBlockDescriptors.allocateDescriptor(pMVKDesc, this);
+			return _inlineUniformBlockDescriptors.allocateDescriptors(count, descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-			return _sampledImageDescriptors.allocateDescriptor(pMVKDesc, this);
+			return _sampledImageDescriptors.allocateDescriptors(count, descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-			return _storageImageDescriptors.allocateDescriptor(pMVKDesc, this);
+			return _storageImageDescriptors.allocateDescriptors(count, descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
-			return _inputAttachmentDescriptors.allocateDescriptor(pMVKDesc, this);
+			return _inputAttachmentDescriptors.allocateDescriptors(count, descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_SAMPLER:
-			return _samplerDescriptors.allocateDescriptor(pMVKDesc, this);
+			return _samplerDescriptors.allocateDescriptors(count, descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-			return _combinedImageSamplerDescriptors.allocateDescriptor(pMVKDesc, this);
+			return _combinedImageSamplerDescriptors.allocateDescriptors(count, descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
-			return _uniformTexelBufferDescriptors.allocateDescriptor(pMVKDesc, this);
+			return _uniformTexelBufferDescriptors.allocateDescriptors(count, descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
-			return _storageTexelBufferDescriptors.allocateDescriptor(pMVKDesc, this);
+			return _storageTexelBufferDescriptors.allocateDescriptors(count, descRange, this);
 
 		default:
 			return reportError(VK_ERROR_INITIALIZATION_FAILED, "Unrecognized VkDescriptorType %d.", descriptorType);
 	}
 }
 
-void MVKDescriptorPool::freeDescriptor(MVKDescriptor* mvkDesc) {
-	VkDescriptorType descriptorType = mvkDesc->getDescriptorType();
+void MVKDescriptorPool::freeDescriptors(MVKDescriptorRange& descRange) {
+	if ( !descRange.pFirstDescriptor ) { return; }
+
+	VkDescriptorType descriptorType = descRange.pFirstDescriptor->getDescriptorType();
 	switch (descriptorType) {
 		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-			return _uniformBufferDescriptors.freeDescriptor(mvkDesc, this);
+			return _uniformBufferDescriptors.freeDescriptors(descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-			return _storageBufferDescriptors.freeDescriptor(mvkDesc, this);
+			return _storageBufferDescriptors.freeDescriptors(descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
-			return _uniformBufferDynamicDescriptors.freeDescriptor(mvkDesc, this);
+			return _uniformBufferDynamicDescriptors.freeDescriptors(descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
-			return _storageBufferDynamicDescriptors.freeDescriptor(mvkDesc, this);
+			return _storageBufferDynamicDescriptors.freeDescriptors(descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK_EXT:
-			return _inlineUniformBlockDescriptors.freeDescriptor(mvkDesc, this);
+			return _inlineUniformBlockDescriptors.freeDescriptors(descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-			return _sampledImageDescriptors.freeDescriptor(mvkDesc, this);
+			return _sampledImageDescriptors.freeDescriptors(descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-			return _storageImageDescriptors.freeDescriptor(mvkDesc, this);
+			return _storageImageDescriptors.freeDescriptors(descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
-			return _inputAttachmentDescriptors.freeDescriptor(mvkDesc, this);
+			return _inputAttachmentDescriptors.freeDescriptors(descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_SAMPLER:
-			return _samplerDescriptors.freeDescriptor(mvkDesc, this);
+			return _samplerDescriptors.freeDescriptors(descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-			return _combinedImageSamplerDescriptors.freeDescriptor(mvkDesc, this);
+			return _combinedImageSamplerDescriptors.freeDescriptors(descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
-			return _uniformTexelBufferDescriptors.freeDescriptor(mvkDesc, this);
+			return _uniformTexelBufferDescriptors.freeDescriptors(descRange, this);
 
 		case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
-			return _storageTexelBufferDescriptors.freeDescriptor(mvkDesc, this);
+			return _storageTexelBufferDescriptors.freeDescriptors(descRange, this);
 
 		default:
 			reportError(VK_ERROR_INITIALIZATION_FAILED, "Unrecognized VkDescriptorType %d.", descriptorType);
@@ -30,6 +30,7 @@
 #include "mvk_datatypes.hpp"
 #include <string>
 #include <mutex>
+#include <atomic>
 
 #import <Metal/Metal.h>
 #import <QuartzCore/CAMetalLayer.h>
@@ -70,6 +71,8 @@ class MVKCommandEncoder;
 class MVKCommandResourceFactory;
 class MVKPrivateDataSlot;
 
+namespace mvk { class SPIRVToMSLConversionCache; }
+
 
 /** The buffer index to use for vertex content. */
 const static uint32_t kMVKVertexContentBufferIndex = 0;
@@ -451,6 +454,12 @@ public:
     /** Returns the common resource factory for creating command resources. */
     inline MVKCommandResourceFactory* getCommandResourceFactory() { return _commandResourceFactory; }
 
+	/**
+	 * Returns the persistent cache of SPIR-V to MSL shader conversions,
+	 * or nullptr if the shaderConversionCachePath configuration setting is not set.
+	 */
+	inline mvk::SPIRVToMSLConversionCache* getShaderConversionCache() { return _shaderConversionCache; }
+
 	/** Returns the function pointer corresponding to the specified named entry point. */
 	PFN_vkVoidFunction getProcAddr(const char* pName);
 
@@ -469,6 +478,15 @@ public:
 	/** Mark this device (and optionally the physical device) as lost. Releases all waits for this device. */
 	VkResult markLost(bool alsoMarkPhysicalDevice = false);
 
+	/**
+	 * Returns a value that changes each time command buffers are submitted to, or complete on,
+	 * any queue of this device, and so each time the GPU may have written to a resource.
+	 */
+	uint64_t getGPUWriteEpoch() { return _gpuWriteEpoch.load(std::memory_order_acquire); }
+
+	/** Changes the value returned by getGPUWriteEpoch(). */
+	void advanceGPUWriteEpoch() { _gpuWriteEpoch.fetch_add(1, std::memory_order_acq_rel); }
+
 	/** Returns whether or not the given descriptor set layout is supported. */
 	void getDescriptorSetLayoutSupport(const VkDescriptorSetLayoutCreateInfo* pCreateInfo,
 									   VkDescriptorSetLayoutSupport* pSupport);
@@ -658,6 +676,22 @@ public:
 		}
 	};
 
+	/**
+	 * If performance is being tracked, adds the count to the given performance counter,
+	 * such as one of the counters within _performanceStatistics.resourceBinding.
+	 */
+	inline void addCountPerformance(uint64_t& counter, uint64_t count) {
+		if (_isPerformanceTracking && count) { updateCountPerformance(counter, count, false); }
+	}
+
+	/**
+	 * If performance is being tracked, raises the given performance counter to the count,
+	 * if the count is larger, such as _performanceStatistics.textureDecompression.peakScratchBytes.
+	 */
+	inline void addPeakCountPerformance(uint64_t& counter, uint64_t count) {
+		if (_isPerformanceTracking && count) { updateCountPerformance(counter, count, true); }
+	}
+
     /** Populates the specified statistics structure from the current activity performance statistics. */
     void getPerformanceStatistics(MVKPerformanceStatistics* pPerf);
 
@@ -822,6 +856,7 @@ protected:
     void initPerformanceTracking();
 	void initPhysicalDevice(MVKPhysicalDevice* physicalDevice, const VkDeviceCreateInfo* pCreateInfo);
 	void initQueues(const VkDeviceCreateInfo* pCreateInfo);
+	void initShaderConversionCache();
 	void reservePrivateData(const VkDeviceCreateInfo* pCreateInfo);
 	void enableFeatures(const VkDeviceCreateInfo* pCreateInfo);
 	void enableFeatures(const VkBool32* pEnable, const VkBool32* pRequested, const VkBool32* pAvailable, uint32_t count);
@@ -829,12 +864,16 @@ protected:
     const char* getActivityPerformanceDescription(MVKPerformanceTracker& activity, MVKPerformanceStatistics& perfStats);
 	void logActivityPerformance(MVKPerformanceTracker& activity, MVKPerformanceStatistics& perfStats, bool isInline = false);
 	void updateActivityPerformance(MVKPerformanceTracker& activity, uint64_t startTime, uint64_t endTime);
+	const char* getCountPerformanceDescription(uint64_t& counter, MVKPerformanceStatistics& perfStats);
+	void logCountPerformance(uint64_t& counter, MVKPerformanceStatistics& perfStats);
+	void updateCountPerformance(uint64_t& counter, uint64_t count, bool isPeak);
 	void getDescriptorVariableDescriptorCountLayoutSupport(const VkDescriptorSetLayoutCreateInfo* pCreateInfo,
 														   VkDescriptorSetLayoutSupport* pSupport,
 														   VkDescriptorSetVariableDescriptorCountLayoutSupportEXT* pVarDescSetCountSupport);
 
 	MVKPhysicalDevice* _physicalDevice;
     MVKCommandResourceFactory* _commandResourceFactory;
+	mvk::SPIRVToMSLConversionCache* _shaderConversionCache;
 	MVKSmallVector<MVKSmallVector<MVKQueue*, kMVKQueueCountPerQueueFamily>, kMVKQueueFamilyCount> _queuesByQueueFamilyIndex;
 	MVKSmallVector<MVKResource*, 256> _resources;
 	MVKSmallVector<MVKPrivateDataSlot*> _privateDataSlots;
@@ -849,6 +888,7 @@ protected:
 	id<MTLBuffer> _dummyBlitMTLBuffer;
     uint32_t _globalVisibilityQueryCount;
     std::mutex _vizLock;
+	std::atomic<uint64_t> _gpuWriteEpoch = {0};
 	bool _logActivityPerformanceInline;
 	bool _isPerformanceTracking;
 	bool _isCurrentlyAutoGPUCapturing;
@@ -3499,7 +3499,7 @@ void MVKDevice::destroyRenderPass(MVKRenderPass* mvkRP,
 
 MVKCommandPool* MVKDevice::createCommandPool(const VkCommandPoolCreateInfo* pCreateInfo,
 											const VkAllocationCallbacks* pAllocator) {
-	return new MVKCommandPool(this, pCreateInfo, mvkConfig().useCommandPooling);
+	return new MVKCommandPool(this, pCreateInfo, mvkConfig().useCommandPooling, mvkConfig().useCommandArenas);
 }
 
 void MVKDevice::destroyCommandPool(MVKCommandPool* mvkCmdPool,
@@ -3627,6 +3627,12 @@ void MVKDevice::updateActivityPerformance(MVKPerformanceTracker& activity,
 	activity.averageDuration = totalInterval / activity.count;
 }
 
+void MVKDevice::updateCountPerformance(uint64_t& counter, uint64_t count, bool isPeak) {
+	lock_guard<mutex> lock(_perfLock);
+
+	counter = isPeak ? max(counter, count) : counter + count;
+}
+
 void MVKDevice::logActivityPerformance(MVKPerformanceTracker& activity, MVKPerformanceStatistics& perfStats, bool isInline) {
 	MVKLogInfo("%s%s%s avg: %.3f ms, latest: %.3f ms, min: %.3f ms, max: %.3f ms, count: %d",
 			   (isInline ? "" : "  "),
@@ -3639,6 +3645,10 @@ void MVKDevice::logActivityPerformance(MVKPerformanceTracker& activity, MVKPerfo
 			   activity.count);
 }
 
+void MVKDevice::logCountPerformance(uint64_t& counter, MVKPerformanceStatistics& perfStats) {
+	MVKLogInfo("  %s: %llu", getCountPerformanceDescription(counter, perfStats), (unsigned long long)counter);
+}
+
 void MVKDevice::logPerformanceSummary() {
 	if (_logActivityPerformanceInline) { return; }
 
@@ -3650,6 +3660,10 @@ void MVKDevice::logPerformanceSummary() {
 	logActivityPerformance(perfStats.queue.nextCAMetalDrawable, perfStats);
 	logActivityPerformance(perfStats.queue.mtlCommandBufferCompletion, perfStats);
 	logActivityPerformance(perfStats.queue.mtlQueueAccess, perfStats);
+	logActivityPerformance(perfStats.commandBuffer.recordCommands, perfStats);
+	logActivityPerformance(perfStats.commandBuffer.encodeCommands, perfStats);
+	logActivityPerformance(perfStats.commandBuffer.releaseCommands, perfStats);
+	logActivityPerformance(perfStats.commandBuffer.coalesceCommands, perfStats);
 	logActivityPerformance(perfStats.shaderCompilation.hashShaderCode, perfStats);
 	logActivityPerformance(perfStats.shaderCompilation.spirvToMSL, perfStats);
 	logActivityPerformance(perfStats.shaderCompilation.mslCompile, perfStats);
@@ -3661,6 +3675,23 @@ void MVKDevice::logPerformanceSummary() {
 	logActivityPerformance(perfStats.pipelineCache.sizePipelineCache, perfStats);
 	logActivityPerformance(perfStats.pipelineCache.readPipelineCache, perfStats);
 	logActivityPerformance(perfStats.pipelineCache.writePipelineCache, perfStats);
+	logActivityPerformance(perfStats.pipelineCache.lockContention, perfStats);
+	logCountPerformance(perfStats.resourceBinding.encodedBindings, perfStats);
+	logCountPerformance(perfStats.resourceBinding.elidedBindings, perfStats);
+	logCountPerformance(perfStats.commandCoalescing.removedCommands, perfStats);
+	logCountPerformance(perfStats.commandCoalescing.mergedCommands, perfStats);
+	logCountPerformance(perfStats.commandReplay.recordedStreams, perfStats);
+	logCountPerformance(perfStats.commandReplay.replayedStreams, perfStats);
+	logCountPerformance(perfStats.commandReplay.invalidatedStreams, perfStats);
+	logCountPerformance(perfStats.uploadRing.uploadedRegions, perfStats);
+	logCountPerformance(perfStats.uploadRing.acquiredBlocks, perfStats);
+	logCountPerformance(perfStats.pipelineBarrier.recordedBarriers, perfStats);
+	logCountPerformance(perfStats.pipelineBarrier.mergedBarriers, perfStats);
+	logCountPerformance(perfStats.textureDecompression.decompressedBytes, perfStats);
+	logCountPerformance(perfStats.textureDecompression.uploadedRegions, perfStats);
+	logCountPerformance(perfStats.textureDecompression.peakScratchBytes, perfStats);
+	logCountPerformance(perfStats.hostMemoryFlush.flushedBytes, perfStats);
+	logCountPerformance(perfStats.hostMemoryFlush.transferredBytes, perfStats);
 }
 
 const char* MVKDevice::getActivityPerformanceDescription(MVKPerformanceTracker& activity, MVKPerformanceStatistics& perfStats) {
@@ -3675,13 +3706,38 @@ const char* MVKDevice::getActivityPerformanceDescription(MVKPerformanceTracker&
 	if (&activity == &perfStats.pipelineCache.sizePipelineCache) { return "Calculate cache size required to write MSL to pipeline cache"; }
 	if (&activity == &perfStats.pipelineCache.readPipelineCache) { return "Read MSL from pipeline cache"; }
 	if (&activity == &perfStats.pipelineCache.writePipelineCache) { return "Write MSL to pipeline cache"; }
+	if (&activity == &perfStats.pipelineCache.lockContention) { return "Wait for contended pipeline cache access"; }
 	if (&activity == &perfStats.queue.mtlQueueAccess) { return "Access MTLCommandQueue"; }
 	if (&activity == &perfStats.queue.mtlCommandBufferCompletion) { return "Complete MTLCommandBuffer"; }
 	if (&activity == &perfStats.queue.nextCAMetalDrawable) { return "Retrieve a CAMetalDrawable from CAMetalLayer"; }
 	if (&activity == &perfStats.queue.frameInterval) { return "Frame interval"; }
+	if (&activity == &perfStats.commandBuffer.recordCommands) { return "Record commands into a command buffer"; }
+	if (&activity == &perfStats.commandBuffer.encodeCommands) { return "Encode command buffer commands into a MTLCommandBuffer"; }
+	if (&activity == &perfStats.commandBuffer.releaseCommands) { return "Release command buffer commands"; }
+	if (&activity == &perfStats.commandBuffer.coalesceCommands) { return "Coalesce command buffer state commands"; }
 	return "Unknown performance activity";
 }
 
+const char* MVKDevice::getCountPerformanceDescription(uint64_t& counter, MVKPerformanceStatistics& perfStats) {
+	if (&counter == &perfStats.resourceBinding.encodedBindings) { return "Resource bindings encoded"; }
+	if (&counter == &perfStats.resourceBinding.elidedBindings) { return "Resource bindings elided as redundant"; }
+	if (&counter == &perfStats.commandCoalescing.removedCommands) { return "State commands removed"; }
+	if (&counter == &perfStats.commandCoalescing.mergedCommands) { return "State commands merged"; }
+	if (&counter == &perfStats.commandReplay.recordedStreams) { return "Command buffer replay streams recorded"; }
+	if (&counter == &perfStats.commandReplay.replayedStreams) { return "Command buffer replay streams replayed"; }
+	if (&counter == &perfStats.commandReplay.invalidatedStreams) { return "Command buffer replay streams invalidated"; }
+	if (&counter == &perfStats.uploadRing.uploadedRegions) { return "Upload ring regions uploaded"; }
+	if (&counter == &perfStats.uploadRing.acquiredBlocks) { return "Upload ring blocks acquired"; }
+	if (&counter == &perfStats.pipelineBarrier.recordedBarriers) { return "Pipeline barriers recorded"; }
+	if (&counter == &perfStats.pipelineBarrier.mergedBarriers) { return "Pipeline barriers merged"; }
+	if (&counter == &perfStats.textureDecompression.decompressedBytes) { return "3D texture bytes decompressed"; }
+	if (&counter == &perfStats.textureDecompression.uploadedRegions) { return "3D texture decompressed regions uploaded"; }
+	if (&counter == &perfStats.textureDecompression.peakScratchBytes) { return "3D texture decompression peak scratch bytes"; }
+	if (&counter == &perfStats.hostMemoryFlush.flushedBytes) { return "Host memory bytes flushed"; }
+	if (&counter == &perfStats.hostMemoryFlush.transferredBytes) { return "Host memory bytes transferred"; }
+	return "Unknown performance count";
+}
+
 void MVKDevice::getPerformanceStatistics(MVKPerformanceStatistics* pPerf) {
     lock_guard<mutex> lock(_perfLock);
 
@@ -3912,6 +3968,8 @@ MVKDevice::MVKDevice(MVKPhysicalDevice* physicalDevice, const VkDeviceCreateInfo
 
 	_commandResourceFactory = new MVKCommandResourceFactory(this);
 
+	initShaderConversionCache();
+
 	startAutoGPUCapture(MVK_CONFIG_AUTO_GPU_CAPTURE_SCOPE_DEVICE, getMTLDevice());
 
 	MVKLogInfo("Created VkDevice to run on GPU %s with the following %d Vulkan extensions enabled:%s",
@@ -3920,6 +3978,36 @@ MVKDevice::MVKDevice(MVKPhysicalDevice* physicalDevice, const VkDeviceCreateInfo
 			   _enabledExtensions.enabledNamesString("\n\t\t", true).c_str());
 }
 
+// The pipeline cache UUID identifies the MoltenVK revision, which in turn identifies the
+// SPIRV-Cross revision, and the device capabilities, so use it to identify conversions
+// that can be reused, just as it is used to validate the content of a VkPipelineCache.
+void MVKDevice::initShaderConversionCache() {
+	_shaderConversionCache = nullptr;
+
+	const char* cachePath = mvkConfig().shaderConversionCachePath;
+	if ( !cachePath || !strlen(cachePath) ) { return; }
+
+	@autoreleasepool {
+		NSString* expandedPath = [[NSString stringWithUTF8String: cachePath] stringByExpandingTildeInPath];
+
+		string revision;
+		for (uint8_t uuidByte : _pProperties->pipelineCacheUUID) {
+			char hexByte[4];
+			snprintf(hexByte, sizeof(hexByte), "%02X", uuidByte);
+			revision += hexByte;
+		}
+
+		_shaderConversionCache = new SPIRVToMSLConversionCache(expandedPath.UTF8String, revision);
+		if (_shaderConversionCache->isValid()) {
+			MVKLogInfo("Using shader conversion cache in directory %s.", expandedPath.UTF8String);
+		} else {
+			reportMessage(MVK_CONFIG_LOG_LEVEL_WARNING, "Shader conversion cache directory %s could not be created. Shader conversions will not be persisted.", expandedPath.UTF8String);
+			delete _shaderConversionCache;
+			_shaderConversionCache = nullptr;
+		}
+	}
+}
+
 void MVKDevice::initPerformanceTracking() {
 
 	_isPerformanceTracking = mvkConfig().performanceTracking;
@@ -3946,6 +4034,18 @@ void MVKDevice::initPerformanceTracking() {
 	_performanceStatistics.queue.mtlCommandBufferCompletion = initPerf;
 	_performanceStatistics.queue.nextCAMetalDrawable = initPerf;
 	_performanceStatistics.queue.frameInterval = initPerf;
+	_performanceStatistics.pipelineCache.lockContention = initPerf;
+	_performanceStatistics.commandBuffer.recordCommands = initPerf;
+	_performanceStatistics.commandBuffer.encodeCommands = initPerf;
+	_performanceStatistics.commandBuffer.releaseCommands = initPerf;
+	_performanceStatistics.commandBuffer.coalesceCommands = initPerf;
+	_performanceStatistics.resourceBinding = {};
+	_performanceStatistics.commandCoalescing = {};
+	_performanceStatistics.commandReplay = {};
+	_performanceStatistics.uploadRing = {};
+	_performanceStatistics.pipelineBarrier = {};
+	_performanceStatistics.textureDecompression = {};
+	_performanceStatistics.hostMemoryFlush = {};
 }
 
 void MVKDevice::initPhysicalDevice(MVKPhysicalDevice* physicalDevice, const VkDeviceCreateInfo* pCreateInfo) {
@@ -4289,6 +4389,7 @@ MVKDevice::~MVKDevice() {
 		mvkDestroyContainerContents(queues);
 	}
 	_commandResourceFactory->destroy();
+	delete _shaderConversionCache;
 
     [_globalVisibilityResultMTLBuffer release];
 	[_defaultMTLSamplerState release];
@@ -20,6 +20,8 @@
 
 #include "MVKDevice.h"
 #include "MVKSmallVector.h"
+#include "MVKIntervalIndex.h"
+#include "MVKHostMemoryPageTracker.h"
 #include <mutex>
 
 #import <Metal/Metal.h>
@@ -145,6 +147,7 @@ protected:
 
 	void propagateDebugName() override;
 	VkDeviceSize adjustMemorySize(VkDeviceSize size, VkDeviceSize offset);
+	void flushResourcesToDevice(VkDeviceSize offset, VkDeviceSize size);
 	VkResult addBuffer(MVKBuffer* mvkBuff);
 	void removeBuffer(MVKBuffer* mvkBuff);
 	VkResult addImageMemoryBinding(MVKImageMemoryBinding* mvkImg);
@@ -155,12 +158,16 @@ protected:
 	void freeHostMemory();
 	MVKResource* getDedicatedResource();
 	void initExternalMemory(VkExternalMemoryHandleTypeFlags handleTypes);
+	MVKHostMemoryPageTracker* getHostMemoryPageTracker();
+	void markGPUWritableResourcesChanged(MVKHostMemoryPageTracker* pageTracker);
 
-	MVKSmallVector<MVKBuffer*, 4> _buffers;
-	MVKSmallVector<MVKImageMemoryBinding*, 4> _imageMemoryBindings;
+	MVKIntervalIndex<MVKBuffer*> _buffers;
+	MVKIntervalIndex<MVKImageMemoryBinding*> _imageMemoryBindings;
 	std::mutex _rezLock;
     VkDeviceSize _allocationSize = 0;
 	MVKMappedMemoryRange _mappedRange;
+	std::unique_ptr<MVKHostMemoryPageTracker> _hostMemoryPageTracker;
+	uint64_t _hostMemoryPageTrackerGPUWriteEpoch = 0;
 	id<MTLBuffer> _mtlBuffer = nil;
 	id<MTLHeap> _mtlHeap = nil;
 	void* _pMemory = nullptr;
@@ -92,10 +92,21 @@ VkResult MVKDeviceMemory::flushToDevice(VkDeviceSize offset, VkDeviceSize size)
 #endif
 
 	// If we have an MTLHeap object, there's no need to sync memory manually between resources and the buffer.
+	// If tracking changed pages, only flush the ranges of pages whose content has changed since last synchronized.
+	// Otherwise, discard any page tracking, because the resources may no longer match the recorded page content.
 	if ( !_mtlHeap ) {
 		lock_guard<mutex> lock(_rezLock);
-		for (auto& img : _imageMemoryBindings) { img->flushToDevice(offset, memSize); }
-		for (auto& buf : _buffers) { buf->flushToDevice(offset, memSize); }
+		if (mvkConfig().trackDirtyHostMemoryPages && _pMemory && !_imageMemoryBindings.empty()) {
+			MVKHostMemoryPageTracker* pageTracker = getHostMemoryPageTracker();
+			markGPUWritableResourcesChanged(pageTracker);
+			pageTracker->forEachChangedRange(_pMemory, offset, memSize, [this](VkDeviceSize rngOffset, VkDeviceSize rngSize) {
+				flushResourcesToDevice(rngOffset, rngSize);
+			});
+		} else {
+			_hostMemoryPageTracker.reset();
+			flushResourcesToDevice(offset, memSize);
+		}
+		_device->addCountPerformance(_device->_performanceStatistics.hostMemoryFlush.flushedBytes, memSize);
 	}
 
 	return VK_SUCCESS;
@@ -118,13 +129,20 @@ VkResult MVKDeviceMemory::pullFromDevice(VkDeviceSize offset,
 	// If we have an MTLHeap object, there's no need to sync memory manually between resources and the buffer.
 	if ( !_mtlHeap ) {
 		lock_guard<mutex> lock(_rezLock);
-        for (auto& img : _imageMemoryBindings) { img->pullFromDevice(offset, memSize); }
-        for (auto& buf : _buffers) { buf->pullFromDevice(offset, memSize); }
+		_imageMemoryBindings.forEachOverlapping(offset, memSize, [=](MVKImageMemoryBinding* img) { img->pullFromDevice(offset, memSize); });
+		_buffers.forEachOverlapping(offset, memSize, [=](MVKBuffer* buf) { buf->pullFromDevice(offset, memSize); });
+		if (_hostMemoryPageTracker && _pMemory) { _hostMemoryPageTracker->markSynchronized(_pMemory, offset, memSize); }
 	}
 
 	return VK_SUCCESS;
 }
 
+// Flushes the memory range to the images and buffers whose memory overlaps it. Must be called under _rezLock.
+void MVKDeviceMemory::flushResourcesToDevice(VkDeviceSize offset, VkDeviceSize size) {
+	_imageMemoryBindings.forEachOverlapping(offset, size, [=](MVKImageMemoryBinding* img) { img->flushToDevice(offset, size); });
+	_buffers.forEachOverlapping(offset, size, [=](MVKBuffer* buf) { buf->flushToDevice(offset, size); });
+}
+
 // If the size parameter is the special constant VK_WHOLE_SIZE, returns the size of memory
 // between offset and the end of the buffer, otherwise simply returns size.
 VkDeviceSize MVKDeviceMemory::adjustMemorySize(VkDeviceSize size, VkDeviceSize offset) {
@@ -136,7 +154,7 @@ VkResult MVKDeviceMemory::addBuffer(MVKBuffer* mvkBuff) {
 
 	// If a dedicated alloc, ensure this buffer is the one and only buffer
 	// I am dedicated to.
-	if (_isDedicated && (_buffers.empty() || _buffers[0] != mvkBuff) ) {
+	if (_isDedicated && !_buffers.contains(mvkBuff) ) {
 		return reportError(VK_ERROR_OUT_OF_DEVICE_MEMORY, "Could not bind VkBuffer %p to a VkDeviceMemory dedicated to resource %p. A dedicated allocation may only be used with the resource it was dedicated to.", mvkBuff, getDedicatedResource() );
 	}
 
@@ -145,14 +163,14 @@ VkResult MVKDeviceMemory::addBuffer(MVKBuffer* mvkBuff) {
 	}
 
 	// In the dedicated case, we already saved the buffer we're going to use.
-	if (!_isDedicated) { _buffers.push_back(mvkBuff); }
+	if (!_isDedicated) { _buffers.add(mvkBuff, mvkBuff->getDeviceMemoryOffset(), mvkBuff->getByteCount()); }
 
 	return VK_SUCCESS;
 }
 
 void MVKDeviceMemory::removeBuffer(MVKBuffer* mvkBuff) {
 	lock_guard<mutex> lock(_rezLock);
-	mvkRemoveAllOccurances(_buffers, mvkBuff);
+	_buffers.remove(mvkBuff);
 }
 
 VkResult MVKDeviceMemory::addImageMemoryBinding(MVKImageMemoryBinding* mvkImg) {
@@ -161,18 +179,18 @@ VkResult MVKDeviceMemory::addImageMemoryBinding(MVKImageMemoryBinding* mvkImg) {
 	// If a dedicated alloc, ensure this image is the one and only image
 	// I am dedicated to. If my image is aliasable, though, allow other aliasable
 	// images to bind to me.
-	if (_isDedicated && (_imageMemoryBindings.empty() || !(contains(_imageMemoryBindings, mvkImg) || (_imageMemoryBindings[0]->_image->getIsAliasable() && mvkImg->_image->getIsAliasable()))) ) {
+	if (_isDedicated && (_imageMemoryBindings.empty() || !(_imageMemoryBindings.contains(mvkImg) || (_imageMemoryBindings.any()->_image->getIsAliasable() && mvkImg->_image->getIsAliasable()))) ) {
 		return reportError(VK_ERROR_OUT_OF_DEVICE_MEMORY, "Could not bind VkImage %p to a VkDeviceMemory dedicated to resource %p. A dedicated allocation may only be used with the resource it was dedicated to.", mvkImg, getDedicatedResource() );
 	}
 
-	if (!_isDedicated) { _imageMemoryBindings.push_back(mvkImg); }
+	if (!_isDedicated) { _imageMemoryBindings.add(mvkImg, mvkImg->getDeviceMemoryOffset(), mvkImg->getContentByteCount()); }
 
 	return VK_SUCCESS;
 }
 
 void MVKDeviceMemory::removeImageMemoryBinding(MVKImageMemoryBinding* mvkImg) {
 	lock_guard<mutex> lock(_rezLock);
-	mvkRemoveAllOccurances(_imageMemoryBindings, mvkImg);
+	_imageMemoryBindings.remove(mvkImg);
 }
 
 // Ensures that this instance is backed by a MTLHeap object,
@@ -268,9 +286,35 @@ void MVKDeviceMemory::freeHostMemory() {
 	_pHostMemory = nullptr;
 }
 
+// Lazily creates the page tracker, so memory that is never flushed does not hold page hashes.
+// If the GPU may have written to the resources bound to this memory since this was last checked, the content
+// of any resource the GPU can write to may no longer match the host content recorded as synchronized, and the
+// host content of that resource must be flushed, even if it has not changed.
+void MVKDeviceMemory::markGPUWritableResourcesChanged(MVKHostMemoryPageTracker* pageTracker) {
+	uint64_t gpuWriteEpoch = _device->getGPUWriteEpoch();
+	if (gpuWriteEpoch == _hostMemoryPageTrackerGPUWriteEpoch) { return; }
+
+	_hostMemoryPageTrackerGPUWriteEpoch = gpuWriteEpoch;
+	_imageMemoryBindings.forEach([=](MVKImageMemoryBinding* img) {
+		if (img->isWritableByGPU()) { pageTracker->markChanged(img->getDeviceMemoryOffset(), img->getContentByteCount()); }
+	});
+	_buffers.forEach([=](MVKBuffer* buf) {
+		if (mvkIsAnyFlagEnabled(buf->getUsage(), (VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+												  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+												  VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT))) {
+			pageTracker->markChanged(buf->getDeviceMemoryOffset(), buf->getByteCount());
+		}
+	});
+}
+
+MVKHostMemoryPageTracker* MVKDeviceMemory::getHostMemoryPageTracker() {
+	if ( !_hostMemoryPageTracker ) { _hostMemoryPageTracker.reset(new MVKHostMemoryPageTracker(_allocationSize)); }
+	return _hostMemoryPageTracker.get();
+}
+
 MVKResource* MVKDeviceMemory::getDedicatedResource() {
 	MVKAssert(_isDedicated, "This method should only be called on dedicated allocations!");
-	return _buffers.empty() ? (MVKResource*)_imageMemoryBindings[0] : (MVKResource*)_buffers[0];
+	return _buffers.empty() ? (MVKResource*)_imageMemoryBindings.any() : (MVKResource*)_buffers.any();
 }
 
 MVKDeviceMemory::MVKDeviceMemory(MVKDevice* device,
@@ -326,13 +370,13 @@ MVKDeviceMemory::MVKDeviceMemory(MVKDevice* device,
 		}
 #endif
         for (auto& memoryBinding : ((MVKImage*)dedicatedImage)->_memoryBindings) {
-            _imageMemoryBindings.push_back(memoryBinding);
+            _imageMemoryBindings.add(memoryBinding, 0, memoryBinding->getContentByteCount());
         }
 		return;
 	}
 
 	if (dedicatedBuffer) {
-		_buffers.push_back((MVKBuffer*)dedicatedBuffer);
+		_buffers.add((MVKBuffer*)dedicatedBuffer, 0, ((MVKBuffer*)dedicatedBuffer)->getByteCount());
 	}
 
 	// If we can, create a MTLHeap. This should happen before creating the buffer, allowing us to map its contents.
@@ -373,9 +417,11 @@ void MVKDeviceMemory::initExternalMemory(VkExternalMemoryHandleTypeFlags handleT
 MVKDeviceMemory::~MVKDeviceMemory() {
     // Unbind any resources that are using me. Iterate a copy of the collection,
     // to allow the resource to callback to remove itself from the collection.
-    auto buffCopies = _buffers;
+    MVKSmallVector<MVKBuffer*, 4> buffCopies;
+    _buffers.forEach([&](MVKBuffer* buf) { buffCopies.push_back(buf); });
     for (auto& buf : buffCopies) { buf->bindDeviceMemory(nullptr, 0); }
-	auto imgCopies = _imageMemoryBindings;
+	MVKSmallVector<MVKImageMemoryBinding*, 4> imgCopies;
+	_imageMemoryBindings.forEach([&](MVKImageMemoryBinding* img) { imgCopies.push_back(img); });
 	for (auto& img : imgCopies) { img->bindDeviceMemory(nullptr, 0); }
 
 	[_mtlBuffer release];
@@ -69,6 +69,14 @@ protected:
     void initSubresources(const VkImageCreateInfo* pCreateInfo);
     MVKImageSubresource* getSubresource(uint32_t mipLevel, uint32_t arrayLayer);
     void updateMTLTextureContent(MVKImageSubresource& subresource, VkDeviceSize offset, VkDeviceSize size);
+	void updateMTLTextureContentFromCompressedContent(const VkImageSubresource& imgSubRez,
+													  const VkSubresourceLayout& imgLayout,
+													  const void* pImgBytes,
+													  VkExtent3D mipExtent,
+													  MTLRegion mtlRegion);
+	MTLRegion getOverlappingRegion(const VkSubresourceLayout& imgLayout, VkExtent3D mipExtent,
+								   VkDeviceSize offset, VkDeviceSize size);
+	uint32_t getBlockRowHeight();
     void getMTLTextureContent(MVKImageSubresource& subresource, VkDeviceSize offset, VkDeviceSize size);
 	bool overlaps(VkSubresourceLayout& imgLayout, VkDeviceSize offset, VkDeviceSize size);
     void propagateDebugName();
@@ -136,8 +144,10 @@ protected:
                            VkPipelineStageFlags dstStageMask,
                            MVKPipelineBarrier& barrier);
     bool shouldFlushHostMemory();
+    bool isWritableByGPU();
     VkResult flushToDevice(VkDeviceSize offset, VkDeviceSize size);
     VkResult pullFromDevice(VkDeviceSize offset, VkDeviceSize size);
+    VkDeviceSize getContentByteCount();
     uint8_t beginPlaneIndex() const;
     uint8_t endPlaneIndex() const;
 
@@ -264,6 +274,12 @@ public:
 	/** Returns a Metal texture that interprets the pixels in the specified format. */
 	id<MTLTexture> getMTLTexture(uint8_t planeIndex, MTLPixelFormat mtlPixFmt);
 
+	/**
+	 * Returns whether the Metal texture underlying this image can change each time it is retrieved.
+	 * Resource bindings that resolve such a texture cannot be replayed from a reusable command buffer.
+	 */
+	virtual bool hasVolatileMTLTexture() { return false; }
+
     /**
      * Sets this image to use the specified MTLTexture.
      *
@@ -388,6 +404,9 @@ public:
 	/** Returns the Metal texture used by the CAMetalDrawable underlying this image. */
 	id<MTLTexture> getMTLTexture(uint8_t planeIndex) override;
 
+	/** The CAMetalDrawable underlying this image, and its texture, change each time the image is presented. */
+	bool hasVolatileMTLTexture() override { return true; }
+
 
 #pragma mark Construction
 
@@ -580,6 +599,9 @@ public:
 	/** Returns the Metal texture type of this image view. */
 	MTLTextureType getMTLTextureType() { return _mtlTextureType; }
 
+	/** Returns whether the Metal texture underlying this image view can change each time it is retrieved. */
+	bool hasVolatileMTLTexture() { return _image->hasVolatileMTLTexture(); }
+
 	/**
 	 * Populates the texture of the specified render pass descriptor
 	 * with the Metal texture underlying this image.
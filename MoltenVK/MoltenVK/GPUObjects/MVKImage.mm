@@ -25,6 +25,7 @@
 #include "MVKFoundation.h"
 #include "MVKOSExtensions.h"
 #include "MVKCodec.h"
+#include "MVKCodecRegionDivider.h"
 #import "MTLTextureDescriptor+MoltenVK.h"
 #import "MTLSamplerDescriptor+MoltenVK.h"
 
@@ -63,12 +64,12 @@ id<MTLTexture> MVKImagePlane::getMTLTexture() {
                            offset: memoryBinding->getDeviceMemoryOffset() + _subresources[0].layout.offset];
             if (_image->_isAliasable) { [_mtlTexture makeAliasable]; }
         } else if (_image->_isAliasable && dvcMem && dvcMem->isDedicatedAllocation() &&
-            !contains(dvcMem->_imageMemoryBindings, memoryBinding)) {
+            !dvcMem->_imageMemoryBindings.contains(memoryBinding)) {
             // This is a dedicated allocation, but it belongs to another aliasable image.
             // In this case, use the MTLTexture from the memory's dedicated image.
             // We know the other image must be aliasable, or I couldn't have been bound
             // to its memory: the memory object wouldn't allow it.
-            _mtlTexture = [dvcMem->_imageMemoryBindings[0]->_image->getMTLTexture(_planeIndex, mtlTexDesc.pixelFormat) retain];
+            _mtlTexture = [dvcMem->_imageMemoryBindings.any()->_image->getMTLTexture(_planeIndex, mtlTexDesc.pixelFormat) retain];
         } else {
             _mtlTexture = [_image->getMTLDevice() newTextureWithDescriptor: mtlTexDesc];
         }
@@ -192,8 +193,9 @@ MVKImageSubresource* MVKImagePlane::getSubresource(uint32_t mipLevel, uint32_t a
     return (srIdx < _subresources.size()) ? &_subresources[srIdx] : NULL;
 }
 
-// Updates the contents of the underlying MTLTexture, corresponding to the
-// specified subresource definition, from the underlying memory buffer.
+// Updates the contents of the underlying MTLTexture, corresponding to the specified subresource
+// definition, from the underlying memory buffer. Only the rows of texel blocks, or for a 3D texture
+// spanning several depth slices, only the depth slices, that overlap the memory range are updated.
 void MVKImagePlane::updateMTLTextureContent(MVKImageSubresource& subresource,
                                             VkDeviceSize offset, VkDeviceSize size) {
 
@@ -210,28 +212,17 @@ void MVKImagePlane::updateMTLTextureContent(MVKImageSubresource& subresource,
     VkExtent3D mipExtent = _image->getExtent3D(_planeIndex, imgSubRez.mipLevel);
     void* pImgBytes = (void*)((uintptr_t)pHostMem + imgLayout.offset);
 
-    MTLRegion mtlRegion;
-    mtlRegion.origin = MTLOriginMake(0, 0, 0);
-    mtlRegion.size = mvkMTLSizeFromVkExtent3D(mipExtent);
+    id<MTLTexture> mtlTex = getMTLTexture();
+    bool isPVRTC = _image->getPixelFormats()->isPVRTCFormat(mtlTex.pixelFormat);
+    MTLRegion mtlRegion = isPVRTC ? MTLRegionMake3D(0, 0, 0, mipExtent.width, mipExtent.height, mipExtent.depth)
+                                  : getOverlappingRegion(imgLayout, mipExtent, offset, size);
 
 #if MVK_MACOS
-    std::unique_ptr<char[]> decompBuffer;
     if (_image->_is3DCompressed) {
         // We cannot upload the texture data directly in this case. But we
         // can upload the decompressed image data.
-        std::unique_ptr<MVKCodec> codec = mvkCreateCodec(_image->getVkFormat());
-        if (!codec) {
-            _image->reportError(VK_ERROR_FORMAT_NOT_SUPPORTED, "A 3D texture used a compressed format that MoltenVK does not yet support.");
-            return;
-        }
-        VkSubresourceLayout destLayout;
-        destLayout.rowPitch = 4 * mipExtent.width;
-        destLayout.depthPitch = destLayout.rowPitch * mipExtent.height;
-        destLayout.size = destLayout.depthPitch * mipExtent.depth;
-        decompBuffer = std::unique_ptr<char[]>(new char[destLayout.size]);
-        codec->decompress(decompBuffer.get(), pImgBytes, destLayout, imgLayout, mipExtent);
-        pImgBytes = decompBuffer.get();
-        imgLayout = destLayout;
+        updateMTLTextureContentFromCompressedContent(imgSubRez, imgLayout, pImgBytes, mipExtent, mtlRegion);
+        return;
     }
 #endif
 
@@ -239,18 +230,109 @@ void MVKImagePlane::updateMTLTextureContent(MVKImageSubresource& subresource,
     VkDeviceSize bytesPerRow = (imgType != VK_IMAGE_TYPE_1D) ? imgLayout.rowPitch : 0;
     VkDeviceSize bytesPerImage = (imgType == VK_IMAGE_TYPE_3D) ? imgLayout.depthPitch : 0;
 
-    id<MTLTexture> mtlTex = getMTLTexture();
-    if (_image->getPixelFormats()->isPVRTCFormat(mtlTex.pixelFormat)) {
+    if (isPVRTC) {
         bytesPerRow = 0;
         bytesPerImage = 0;
     }
 
+    uint32_t blockHeight = getBlockRowHeight();
+    uint32_t blockRowCount = (uint32_t)mvkCeilingDivide(mtlRegion.size.height, blockHeight);
+    VkDeviceSize regionOffset = (mtlRegion.origin.z * bytesPerImage) + ((mtlRegion.origin.y / blockHeight) * bytesPerRow);
+    VkDeviceSize regionSize = bytesPerRow ? (mtlRegion.size.depth * blockRowCount * bytesPerRow) : imgLayout.size;
+
     [mtlTex replaceRegion: mtlRegion
               mipmapLevel: imgSubRez.mipLevel
                     slice: imgSubRez.arrayLayer
-                withBytes: pImgBytes
+                withBytes: (void*)((uintptr_t)pImgBytes + regionOffset)
               bytesPerRow: bytesPerRow
             bytesPerImage: bytesPerImage];
+
+    MVKDevice* mvkDev = _image->getDevice();
+    mvkDev->addCountPerformance(mvkDev->_performanceStatistics.hostMemoryFlush.transferredBytes, regionSize);
+}
+
+// Returns the region of the specified subresource whose content lies within the memory range,
+// rounded out to whole rows of texel blocks. If the memory range spans more than one depth slice
+// of a 3D texture, the region is rounded out to whole depth slices. The memory range must overlap
+// the subresource. The content of a 1D texture is always returned as a whole.
+MTLRegion MVKImagePlane::getOverlappingRegion(const VkSubresourceLayout& imgLayout, VkExtent3D mipExtent,
+											  VkDeviceSize offset, VkDeviceSize size) {
+	MTLRegion mtlRegion = MTLRegionMake3D(0, 0, 0, mipExtent.width, mipExtent.height, mipExtent.depth);
+
+	VkImageType imgType = _image->getImageType();
+	if (imgType == VK_IMAGE_TYPE_1D || !imgLayout.rowPitch) { return mtlRegion; }
+
+	// The overlapping range, relative to the start of the subresource content.
+	VkDeviceSize imgStart = getMemoryBinding()->_deviceMemoryOffset + imgLayout.offset;
+	VkDeviceSize rngStart = max(offset, imgStart) - imgStart;
+	VkDeviceSize rngEnd = min(offset + size - imgStart, imgLayout.size);
+
+	if (imgType == VK_IMAGE_TYPE_3D && imgLayout.depthPitch) {
+		uint32_t firstSlice = (uint32_t)min<VkDeviceSize>(rngStart / imgLayout.depthPitch, mipExtent.depth - 1);
+		uint32_t lastSlice = (uint32_t)min<VkDeviceSize>((rngEnd - 1) / imgLayout.depthPitch, mipExtent.depth - 1);
+		mtlRegion.origin.z = firstSlice;
+		mtlRegion.size.depth = lastSlice - firstSlice + 1;
+		if (firstSlice != lastSlice) { return mtlRegion; }
+
+		rngStart -= firstSlice * imgLayout.depthPitch;
+		rngEnd -= firstSlice * imgLayout.depthPitch;
+	}
+
+	uint32_t blockHeight = getBlockRowHeight();
+	uint32_t blockRowCount = mvkCeilingDivide(mipExtent.height, blockHeight);
+	uint32_t firstBlockRow = (uint32_t)min<VkDeviceSize>(rngStart / imgLayout.rowPitch, blockRowCount - 1);
+	uint32_t lastBlockRow = (uint32_t)min<VkDeviceSize>((rngEnd - 1) / imgLayout.rowPitch, blockRowCount - 1);
+	mtlRegion.origin.y = firstBlockRow * blockHeight;
+	mtlRegion.size.height = min((lastBlockRow + 1) * blockHeight, mipExtent.height) - mtlRegion.origin.y;
+	return mtlRegion;
+}
+
+// Returns the number of rows of texels held in each row of the content of this plane in memory.
+// The extent of each plane of a chroma-subsampled image is already reduced by the subsampling.
+uint32_t MVKImagePlane::getBlockRowHeight() {
+	return _image->_hasChromaSubsampling ? 1 : _blockTexelSize.height;
+}
+
+// Decompresses the compressed content of the specified region of a subresource of a 3D texture, whose
+// format Metal does not support on 3D textures, and uploads the decompressed texels to the underlying
+// MTLTexture. To bound the memory used, the content is decompressed and uploaded in regions of several
+// depth slices, or if a single slice is too large, of several rows of texel blocks, as divided by a
+// MVKCodecRegionDivider, through a scratch buffer that is reused for each region.
+void MVKImagePlane::updateMTLTextureContentFromCompressedContent(const VkImageSubresource& imgSubRez,
+																 const VkSubresourceLayout& imgLayout,
+																 const void* pImgBytes,
+																 VkExtent3D mipExtent,
+																 MTLRegion mtlRegion) {
+	std::unique_ptr<MVKCodec> codec = mvkCreateCodec(_image->getVkFormat());
+	if (!codec) {
+		_image->reportError(VK_ERROR_FORMAT_NOT_SUPPORTED, "A 3D texture used a compressed format that MoltenVK does not yet support.");
+		return;
+	}
+
+	VkOffset3D origin = { 0, (int32_t)mtlRegion.origin.y, (int32_t)mtlRegion.origin.z };
+	VkExtent3D areaExtent = { mipExtent.width, (uint32_t)mtlRegion.size.height, (uint32_t)mtlRegion.size.depth };
+	MVKCodecRegionDivider regionDivider(origin, areaExtent, _blockTexelSize.height,
+										codec->getDecompressedBytesPerTexel(),
+										mvkConfig().textureDecompressionScratchSize);
+	const VkSubresourceLayout& scratchLayout = regionDivider.getScratchLayout();
+	std::unique_ptr<char[]> scratch(new char[scratchLayout.size]);
+
+	id<MTLTexture> mtlTex = getMTLTexture();
+	uint32_t regionCount = regionDivider.forEachRegion([&](VkOffset3D offset, VkExtent3D extent) {
+		codec->decompress(scratch.get(), pImgBytes, scratchLayout, imgLayout, offset, extent);
+		[mtlTex replaceRegion: MTLRegionMake3D(offset.x, offset.y, offset.z, extent.width, extent.height, extent.depth)
+				  mipmapLevel: imgSubRez.mipLevel
+						slice: imgSubRez.arrayLayer
+					withBytes: scratch.get()
+				  bytesPerRow: scratchLayout.rowPitch
+				bytesPerImage: scratchLayout.depthPitch];
+	});
+	MVKDevice* mvkDev = _image->getDevice();
+	auto& perfStats = mvkDev->_performanceStatistics;
+	mvkDev->addCountPerformance(perfStats.textureDecompression.decompressedBytes, regionDivider.getContentSize());
+	mvkDev->addCountPerformance(perfStats.textureDecompression.uploadedRegions, regionCount);
+	mvkDev->addPeakCountPerformance(perfStats.textureDecompression.peakScratchBytes, scratchLayout.size);
+	mvkDev->addCountPerformance(perfStats.hostMemoryFlush.transferredBytes, mvkCeilingDivide(mtlRegion.size.height, _blockTexelSize.height) * imgLayout.rowPitch * mtlRegion.size.depth);
 }
 
 // Updates the contents of the underlying memory buffer from the contents of
@@ -526,6 +608,27 @@ VkResult MVKImageMemoryBinding::pullFromDevice(VkDeviceSize offset, VkDeviceSize
     return VK_SUCCESS;
 }
 
+// Returns whether the GPU can write to the content of this binding, such as with a copy,
+// a render, or a storage image write.
+bool MVKImageMemoryBinding::isWritableByGPU() {
+    return mvkIsAnyFlagEnabled(_image->_usage, (VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                                                VK_IMAGE_USAGE_STORAGE_BIT |
+                                                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                                                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT));
+}
+
+// Returns the number of bytes of memory spanned by this binding, including the content of all of its
+// subresources, which, for an image whose size is determined by a MTLHeap, may exceed its byte count.
+VkDeviceSize MVKImageMemoryBinding::getContentByteCount() {
+    VkDeviceSize byteCount = _byteCount;
+    for(uint8_t planeIndex = beginPlaneIndex(); planeIndex < endPlaneIndex(); planeIndex++) {
+        for (auto& subRez : _image->_planes[planeIndex]->_subresources) {
+            byteCount = std::max(byteCount, subRez.layout.offset + subRez.layout.size);
+        }
+    }
+    return byteCount;
+}
+
 uint8_t MVKImageMemoryBinding::beginPlaneIndex() const {
     return (_image->_memoryBindings.size() > 1) ? _planeIndex : 0;
 }
@@ -944,6 +1047,8 @@ MVKImage::MVKImage(MVKDevice* device, const VkImageCreateInfo* pCreateInfo) : MV
             _planes[planeIndex]->_bytesPerBlock = bytesPerBlockOfPlane[planeIndex];
             _planes[planeIndex]->_mtlPixFmt = mtlPixFmtOfPlane[planeIndex];
         } else {
+            _planes[planeIndex]->_blockTexelSize = pixFmts->getBlockTexelSize(_vkFormat);
+            _planes[planeIndex]->_bytesPerBlock = pixFmts->getBytesPerBlock(_vkFormat);
             _planes[planeIndex]->_mtlPixFmt = getPixelFormats()->getMTLPixelFormat(_vkFormat);
         }
         _planes[planeIndex]->initSubresources(pCreateInfo);
@@ -29,6 +29,8 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <ostream>
+#include <memory>
+#include <future>
 
 #import <Metal/Metal.h>
 
@@ -422,6 +424,64 @@ protected:
 #pragma mark -
 #pragma mark MVKPipelineCache
 
+/**
+ * The serialized content of a shader library in a pipeline cache. The content is either held
+ * within the data used to create the pipeline cache, or was serialized when the shader library
+ * was added to the pipeline cache, and is retained so it does not need to be serialized again.
+ */
+typedef struct MVKPipelineCacheEntry {
+	MVKShaderModuleKey smKey;
+	uint64_t optionsHash = 0;	/**< The hash of the options of the shader conversion configuration, used to skip entries that cannot match. */
+	size_t offset = 0;			/**< The offset of the content within the initial data, if content is empty. */
+	size_t size = 0;
+	size_t rawSize = 0;			/**< The size of the content once decompressed, or zero if the content is not compressed. */
+	std::string content;
+} MVKPipelineCacheEntry;
+
+/** Identifies a shader library that has been added to a pipeline cache, but has not yet been serialized. */
+typedef struct MVKPipelineCacheNewEntry {
+	MVKShaderModuleKey smKey;
+	MVKShaderLibraryCache* slCache;
+	uint32_t slIndex;
+} MVKPipelineCacheNewEntry;
+
+/**
+ * Identifies a shader conversion that is in flight, by the key of the shader module being
+ * converted, and the digest of the shader conversion configuration it is being converted with.
+ */
+typedef struct MVKPipelineCacheConversionKey {
+	MVKShaderModuleKey smKey;
+	std::size_t configDigest;
+
+	bool operator==(const MVKPipelineCacheConversionKey& rhs) const {
+		return ((smKey == rhs.smKey) && (configDigest == rhs.configDigest));
+	}
+} MVKPipelineCacheConversionKey;
+
+/**
+ * Hash structure implementation for MVKPipelineCacheConversionKey in std namespace,
+ * so MVKPipelineCacheConversionKey can be used as a key in a std::unordered_map.
+ */
+namespace std {
+	template <>
+	struct hash<MVKPipelineCacheConversionKey> {
+		std::size_t operator()(const MVKPipelineCacheConversionKey& k) const { return k.smKey.codeHash.lo ^ k.configDigest; }
+	};
+}
+
+/**
+ * Guards the shader library caches of the shader module keys that map to this stripe, and tracks
+ * the shader conversions that are in flight for those keys. Each in-flight conversion is represented
+ * by a future that becomes ready when the conversion completes, whether or not it succeeded.
+ */
+typedef struct MVKPipelineCacheStripe {
+	std::unordered_map<MVKPipelineCacheConversionKey, std::shared_future<void>> conversionsInFlight;
+	std::mutex lock;
+} MVKPipelineCacheStripe;
+
+/** The number of stripes guarding the shader library caches of a pipeline cache. */
+static constexpr uint32_t kMVKPipelineCacheStripeCount = 16;
+
 /** Represents a Vulkan pipeline cache. */
 class MVKPipelineCache : public MVKVulkanAPIDeviceObject {
 
@@ -440,7 +500,13 @@ public:
 	 */
 	VkResult writeData(size_t* pDataSize, void* pData);
 
-	/** Return a shader library from the shader conversion configuration and sourced from the specified shader module. */
+	/**
+	 * Return a shader library from the shader conversion configuration and sourced from the specified shader module.
+	 *
+	 * This function may be called from multiple threads concurrently. Shader code with different keys may be converted
+	 * concurrently, and if shader code with the same key is already being converted, this function waits for that
+	 * conversion to complete, and returns the resulting shader library if it matches the shader conversion configuration.
+	 */
 	MVKShaderLibrary* getShaderLibrary(SPIRVToMSLConversionConfiguration* pContext, MVKShaderModule* shaderModule);
 
 	/** Merges the contents of the specified number of pipeline caches into this cache. */
@@ -456,13 +522,26 @@ public:
 protected:
 	void propagateDebugName() override {}
 	MVKShaderLibraryCache* getShaderLibraryCache(MVKShaderModuleKey smKey);
+	MVKPipelineCacheStripe& getStripe(const MVKShaderModuleKey& smKey) { return _stripes[std::hash<MVKShaderModuleKey>()(smKey) % kMVKPipelineCacheStripeCount]; }
+	void acquireLock(std::unique_lock<std::mutex>& lock);
 	void readData(const VkPipelineCacheCreateInfo* pCreateInfo);
-	void writeData(std::ostream& outstream, bool isCounting = false);
-	void markDirty();
+	MVKShaderLibrary* readPendingEntries(MVKShaderModuleKey smKey, MVKShaderLibraryCache* slCache, SPIRVToMSLConversionConfiguration* pContext);
+	bool readEntry(MVKPipelineCacheEntry& entry, MVKShaderLibraryCache* slCache);
+	void writeData(std::ostream& outstream);
+	void serializeNewEntries();
+	void addNewEntries(MVKShaderModuleKey smKey, MVKShaderLibraryCache* slCache, uint32_t firstSLIndex);
+	void addEntry(MVKPipelineCacheEntry&& entry);
+	const char* getEntryContent(MVKPipelineCacheEntry& entry) { return entry.content.empty() ? &_initialData[entry.offset] : entry.content.data(); }
 
 	std::unordered_map<MVKShaderModuleKey, MVKShaderLibraryCache*> _shaderCache;
+	std::unordered_map<MVKShaderModuleKey, MVKSmallVector<MVKPipelineCacheEntry, 1>> _pendingEntries;
+	MVKSmallVector<MVKPipelineCacheEntry> _entries;
+	MVKSmallVector<MVKPipelineCacheNewEntry> _newEntries;
+	std::unique_ptr<char[]> _initialData;
 	size_t _dataSize = 0;
+	MVKPipelineCacheStripe _stripes[kMVKPipelineCacheStripeCount];
 	std::mutex _shaderCacheLock;
+	std::mutex _newEntriesLock;
 };
 
 
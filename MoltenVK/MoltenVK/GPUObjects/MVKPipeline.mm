@@ -20,6 +20,7 @@
 #include "MVKRenderPass.h"
 #include "MVKCommandBuffer.h"
 #include "MVKFoundation.h"
+#include "MVKCompression.h"
 #include "MVKOSExtensions.h"
 #include "MVKStrings.h"
 #include "MTLRenderPipelineDescriptor+MoltenVK.h"
@@ -104,6 +105,9 @@ void MVKPipelineLayout::populateShaderConversionConfig(SPIRVToMSLConversionConfi
 																	  _dslMTLResourceIndexOffsets[dslIdx],
 																	  dslIdx);
 	}
+
+	// Allow the shader conversion config to be matched against cached configs in linear time.
+	shaderConfig.canonicalize();
 }
 
 bool MVKPipelineLayout::stageUsesPushConstants(MVKShaderStage mvkStage) {
@@ -1652,6 +1656,7 @@ void MVKGraphicsPipeline::addVertexInputToShaderConversionConfig(SPIRVToMSLConve
 
         shaderConfig.shaderInputs.push_back(si);
     }
+    shaderConfig.canonicalize();
 }
 
 // Initializes the shader inputs in a shader conversion config from the previous stage output.
@@ -1695,6 +1700,7 @@ void MVKGraphicsPipeline::addPrevStageOutputToShaderConversionConfig(SPIRVToMSLC
 
         shaderConfig.shaderInputs.push_back(si);
     }
+    shaderConfig.canonicalize();
 }
 
 // We render points if either the topology or polygon fill mode dictate it
@@ -1868,18 +1874,99 @@ MVKComputePipeline::~MVKComputePipeline() {
 #pragma mark -
 #pragma mark MVKPipelineCache
 
+// Registers a shader conversion as in flight in a pipeline cache stripe, for as long as this instance is in scope.
+// Must be constructed while holding the stripe lock. When destroyed, reacquires the stripe lock if it is not held,
+// removes the conversion from the stripe, and releases any threads waiting for the conversion to complete.
+class MVKPipelineCacheConversionInFlight {
+
+public:
+	MVKPipelineCacheConversionInFlight(MVKPipelineCacheStripe& stripe,
+									   unique_lock<mutex>& stripeLock,
+									   const MVKPipelineCacheConversionKey& convKey) :
+		_stripe(stripe), _stripeLock(stripeLock), _convKey(convKey) {
+		_stripe.conversionsInFlight[_convKey] = _conversionDone.get_future().share();
+	}
+
+	~MVKPipelineCacheConversionInFlight() {
+		if ( !_stripeLock.owns_lock() ) { _stripeLock.lock(); }
+		_stripe.conversionsInFlight.erase(_convKey);
+		_conversionDone.set_value();
+	}
+
+protected:
+	MVKPipelineCacheStripe& _stripe;
+	unique_lock<mutex>& _stripeLock;
+	MVKPipelineCacheConversionKey _convKey;
+	promise<void> _conversionDone;
+};
+
 // Return a shader library from the specified shader conversion configuration sourced from the specified shader module.
+// The pipeline cache lock is held only while locating the shader library cache of the shader module key. The shader
+// library cache is then accessed under the lock of the stripe for that key, and the shader code is converted without
+// holding any lock, so shader code with different keys can be converted concurrently. If no matching shader library has
+// been deserialized from the initial pipeline cache data, the pending entries for the key are deserialized, one at a time,
+// until a matching shader library is found, skipping any entry whose conversion options differ. If a conversion of shader code
+// with the same key and shader conversion configuration is in flight on another thread, wait for it to complete, and
+// look for a matching shader library again, rather than converting the same shader code concurrently. If the other
+// conversion does not produce a matching shader library, convert the shader code here. The MSL is also compiled before
+// reacquiring the lock. The in-flight conversion is removed, and any threads waiting for it are released, even if the
+// conversion throws an exception.
 MVKShaderLibrary* MVKPipelineCache::getShaderLibrary(SPIRVToMSLConversionConfiguration* pContext, MVKShaderModule* shaderModule) {
-	lock_guard<mutex> lock(_shaderCacheLock);
+	MVKShaderModuleKey smKey = shaderModule->getKey();
+	MVKPipelineCacheConversionKey convKey = { smKey, pContext->getDigest() };
+	MVKShaderLibraryCache* slCache;
+	{
+		unique_lock<mutex> plcLock(_shaderCacheLock, defer_lock);
+		acquireLock(plcLock);
+		slCache = getShaderLibraryCache(smKey);
+	}
+
+	MVKPipelineCacheStripe& stripe = getStripe(smKey);
+	unique_lock<mutex> stripeLock(stripe.lock, defer_lock);
+	acquireLock(stripeLock);
+	while (true) {
+		MVKShaderLibrary* shLib = slCache->findShaderLibrary(pContext);
+		if ( !shLib ) { shLib = readPendingEntries(smKey, slCache, pContext); }
+		if (shLib) { return shLib; }
+
+		auto cifIter = stripe.conversionsInFlight.find(convKey);
+		if (cifIter == stripe.conversionsInFlight.end()) { break; }
+
+		shared_future<void> conversion = cifIter->second;
+		stripeLock.unlock();
+		uint64_t startTime = _device->getPerformanceTimestamp();
+		conversion.wait();
+		_device->addActivityPerformance(_device->_performanceStatistics.pipelineCache.lockContention, startTime);
+		acquireLock(stripeLock);
+	}
 
-	bool wasAdded = false;
-	MVKShaderLibraryCache* slCache = getShaderLibraryCache(shaderModule->getKey());
-	MVKShaderLibrary* shLib = slCache->getShaderLibrary(pContext, shaderModule, &wasAdded);
-	if (wasAdded) { markDirty(); }
+	MVKPipelineCacheConversionInFlight conversionInFlight(stripe, stripeLock, convKey);
+	stripeLock.unlock();
+
+	MVKShaderLibrary* shLib = nullptr;
+	if (shaderModule->convert(pContext)) {
+		shLib = new MVKShaderLibrary(this, shaderModule->getMSL(), shaderModule->getConversionResults());
+	}
+
+	acquireLock(stripeLock);
+	if (shLib) {
+		slCache->addShaderLibrary(pContext, shLib);
+		addNewEntries(smKey, slCache, uint32_t(slCache->_shaderLibraries.size() - 1));
+	}
 	return shLib;
 }
 
+// Locks the unlocked lock, and if the mutex is held by another thread, tracks the time spent waiting for it.
+void MVKPipelineCache::acquireLock(unique_lock<mutex>& lock) {
+	if (lock.try_lock()) { return; }
+
+	uint64_t startTime = _device->getPerformanceTimestamp();
+	lock.lock();
+	_device->addActivityPerformance(_device->_performanceStatistics.pipelineCache.lockContention, startTime);
+}
+
 // Returns a shader library cache for the specified shader module key, creating it if necessary.
+// Must be called while holding the pipeline cache lock.
 MVKShaderLibraryCache* MVKPipelineCache::getShaderLibraryCache(MVKShaderModuleKey smKey) {
 	MVKShaderLibraryCache* slCache = _shaderCache[smKey];
 	if ( !slCache ) {
@@ -1892,38 +1979,108 @@ MVKShaderLibraryCache* MVKPipelineCache::getShaderLibraryCache(MVKShaderModuleKe
 
 #pragma mark Streaming pipeline cache to and from offline memory
 
-static uint32_t kDataHeaderSize = (sizeof(uint32_t) * 4) + VK_UUID_SIZE;
-
-// Entry type markers to be inserted into data stream
-typedef enum {
-	MVKPipelineCacheEntryTypeEOF = 0,
-	MVKPipelineCacheEntryTypeShaderLibrary = 1,
-} MVKPipelineCacheEntryType;
-
-// Helper class to iterate through the shader libraries in a shader library cache in order to serialize them.
-// Needs to support input of null shader library cache.
-class MVKShaderCacheIterator : public MVKBaseObject {
-
-	/** Returns the Vulkan API opaque object controlling this object. */
-	MVKVulkanAPIObject* getVulkanAPIObject() override { return _pSLCache->getVulkanAPIObject(); };
-
-protected:
-	friend MVKPipelineCache;
-
-	bool next() { return (++_index < (_pSLCache ? _pSLCache->_shaderLibraries.size() : 0)); }
-	SPIRVToMSLConversionConfiguration& getShaderConversionConfig() { return _pSLCache->_shaderLibraries[_index].first; }
-	std::string& getMSL() { return _pSLCache->_shaderLibraries[_index].second->_msl; }
-	SPIRVToMSLConversionResults& getShaderConversionResults() { return _pSLCache->_shaderLibraries[_index].second->_shaderConversionResults; }
-	MVKShaderCacheIterator(MVKShaderLibraryCache* pSLCache) : _pSLCache(pSLCache) {}
-
-	MVKShaderLibraryCache* _pSLCache;
-	size_t _count = 0;
-	int32_t _index = -1;
-};
+static constexpr uint32_t kDataHeaderSize = (sizeof(uint32_t) * 4) + VK_UUID_SIZE;
+
+// Identifies the layout of the content that follows the data header.
+static const uint32_t kMVKPipelineCacheContentMagic = 0x4B50564D;		// "MVPK"
+static const uint32_t kMVKPipelineCacheContentVersion = 4;
+static const size_t kMVKPipelineCacheEntryAlignment = 8;
+
+// Content header flags.
+static const uint32_t kMVKPipelineCacheFlagCompressedEntries = 1 << 0;	// Entries may be compressed using kMVKPipelineCacheDictionary
+static const uint32_t kMVKPipelineCacheSupportedFlags = kMVKPipelineCacheFlagCompressedEntries;
+
+// Dictionary content referenced by compressed entries. Most of the serialized content of a shader library is
+// the MSL source code, and the MSL generated by SPIRV-Cross shares a large amount of boilerplate text across
+// shaders, which is too small a part of each shader to compress well on its own. Text that occurs most often
+// is placed towards the end, where it can be referenced using the smallest offsets. This content must not be
+// changed without also changing kMVKPipelineCacheContentVersion, or existing compressed entries become unreadable.
+static const char kMVKPipelineCacheDictionary[] =
+	"#pragma clang diagnostic ignored \"-Wmissing-prototypes\"\n"
+	"#pragma clang diagnostic ignored \"-Wmissing-braces\"\n"
+	"#pragma clang diagnostic ignored \"-Wunused-variable\"\n"
+	"#include <metal_atomic>\n"
+	"template<typename T, size_t Num>\nstruct spvUnsafeArray\n{\n    T elements[Num ? Num : 1];\n    \n"
+	"    thread T& operator [] (size_t pos) thread\n    {\n        return elements[pos];\n    }\n"
+	"    constexpr const thread T& operator [] (size_t pos) const thread\n    {\n        return elements[pos];\n    }\n"
+	"    device T& operator [] (size_t pos) device\n    {\n        return elements[pos];\n    }\n"
+	"    threadgroup T& operator [] (size_t pos) threadgroup\n    {\n        return elements[pos];\n    }\n};\n\n"
+	"// Returns 2D texture coords corresponding to 1D texel buffer coords\n"
+	"static inline __attribute__((always_inline))\nuint2 spvTexelBufferCoord(uint tc)\n{\n"
+	"    return uint2(tc % 4096, tc / 4096);\n}\n\n"
+	"template<typename T> struct spvRemoveReference { typedef T type; };\n"
+	"template<typename T> inline constexpr thread T&& spvForward(thread typename spvRemoveReference<T>::type& x)\n"
+	"enum class spvSwizzle : uint\n{\n    none = 0,\n    zero,\n    one,\n    red,\n    green,\n    blue,\n    alpha\n};\n\n"
+	"template<typename T>\ninline T spvGetSwizzle(vec<T, 4> x, T c, spvSwizzle s)\n{\n    switch (s)\n    {\n"
+	"template<typename T, typename Tex, typename... Ts>\ninline vec<T, 4> spvTextureSwizzle(vec<T, 4> x, uint s)\n"
+	"constant uint* spvSwizzleConstants [[buffer(30)]]"
+	"constant uint* spvBufferSizeConstants [[buffer(25)]]"
+	"constant uint* spvIndirectParams [[buffer(29)]]"
+	"struct spvDescriptorSetBuffer0\n{\n"
+	"[[id(0)]];\n    [[id(1)]];\n    [[id(2)]];\n"
+	"constant spvDescriptorSetBuffer0& spvDescriptorSet0 [[buffer(0)]]"
+	"kernel void main0(uint3 gl_GlobalInvocationID [[thread_position_in_grid]], "
+	"uint3 gl_LocalInvocationID [[thread_position_in_threadgroup]], "
+	"uint3 gl_WorkGroupID [[threadgroup_position_in_grid]]"
+	"uint gl_VertexIndex [[vertex_id]]uint gl_InstanceIndex [[instance_id]]"
+	"uint gl_BaseVertex [[base_vertex]]uint gl_BaseInstance [[base_instance]]"
+	"float4 gl_FragCoord [[position]]bool gl_FrontFacing [[front_facing]]"
+	"float gl_PointSize [[point_size]]float gl_ClipDistance [[clip_distance]] [1];\n"
+	"float4 gl_Position [[position]];\n"
+	"struct main0_in\n{\n"
+	"    float4 m_0 [[user(locn0)]];\n    float2 m_1 [[user(locn1)]];\n    float4 m_2 [[user(locn2)]];\n"
+	"    float4 m_0 [[attribute(0)]];\n    float2 m_1 [[attribute(1)]];\n    float4 m_2 [[attribute(2)]];\n"
+	"    float4 out_var_SV_Target0 [[color(0)]];\n"
+	"    float4 out_var_TEXCOORD0 [[user(locn0)]];\n"
+	"    float4 in_var_TEXCOORD0 [[user(locn0)]];\n"
+	"vertex main0_out main0(main0_in in [[stage_in]], "
+	"fragment main0_out main0(main0_in in [[stage_in]], "
+	"texture2d<float> [[texture(0)]], sampler [[sampler(0)]], "
+	"constant type_Globals& _Globals [[buffer(0)]]"
+	"    main0_out out = {};\n"
+	".sample("
+	"    return out;\n}\n\n"
+	"#include <metal_stdlib>\n#include <simd/simd.h>\n\nusing namespace metal;\n\n"
+	"struct main0_out\n{\n    float4 ";
+
+// The content that follows the data header consists of a content header, followed by a table of
+// contents, holding a fixed-size entry for each shader library, followed by the serialized content of
+// each shader library, aligned to kMVKPipelineCacheEntryAlignment. All offsets are from the start of
+// the data, and all values in the content header and table of contents are stored in little-endian
+// byte order. Because each shader library can be located using only the table of contents, the data
+// can be indexed in place, such as from a memory-mapped file, and each shader library is deserialized
+// only when a shader module with a matching key is first used with the pipeline cache.
+// If the content header indicates that entries may be compressed, a table of contents entry with a
+// non-zero raw size identifies content compressed by mvkCompressLZ(), using kMVKPipelineCacheDictionary.
+// Compressed content is decompressed only when the shader libraries are deserialized.
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t flags;
+} MVKPipelineCacheContentHeader;
+
+typedef struct {
+	uint64_t codeSize;
+	uint64_t codeHashLo;
+	uint64_t codeHashHi;
+	uint64_t optionsHash;
+	uint64_t offset;
+	uint64_t size;
+	uint64_t rawSize;
+} MVKPipelineCacheTOCEntry;
+
+// The size of the data headers, which is also the offset to the table of contents.
+static constexpr size_t kMVKPipelineCacheTOCOffset = kDataHeaderSize + sizeof(MVKPipelineCacheContentHeader);
+
+static_assert(kMVKPipelineCacheTOCOffset % kMVKPipelineCacheEntryAlignment == 0, "Pipeline cache entries must follow the table of contents without padding.");
+static_assert(sizeof(MVKPipelineCacheTOCEntry) % kMVKPipelineCacheEntryAlignment == 0, "Pipeline cache entries must follow the table of contents without padding.");
 
 // If pData is not null, serializes at most pDataSize bytes of the contents of the cache into that
 // memory location, and returns the number of bytes serialized in pDataSize. If pData is null,
 // returns the number of bytes required to serialize the contents of this pipeline cache.
+// The serialized content of each shader library is retained, so only shader libraries
+// that have been added since the previous call need to be serialized.
 // This is the compliment of the readData() function. The two must be kept aligned.
 VkResult MVKPipelineCache::writeData(size_t* pDataSize, void* pData) {
 	lock_guard<mutex> lock(_shaderCacheLock);
@@ -1932,6 +2089,8 @@ VkResult MVKPipelineCache::writeData(size_t* pDataSize, void* pData) {
 
 		if ( !pDataSize ) { return VK_SUCCESS; }
 
+		serializeNewEntries();
+
 		if (pData) {
 			if (*pDataSize >= _dataSize) {
 				mvk::membuf mb((char*)pData, _dataSize);
@@ -1944,12 +2103,6 @@ VkResult MVKPipelineCache::writeData(size_t* pDataSize, void* pData) {
 				return VK_INCOMPLETE;
 			}
 		} else {
-			if (_dataSize == 0) {
-				mvk::countbuf cb;
-				ostream outStream(&cb);
-				writeData(outStream, true);
-				_dataSize = cb.buffSize;
-			}
 			*pDataSize = _dataSize;
 			return VK_SUCCESS;
 		}
@@ -1960,14 +2113,11 @@ VkResult MVKPipelineCache::writeData(size_t* pDataSize, void* pData) {
 	}
 }
 
-// Serializes the data in this cache to a stream
-void MVKPipelineCache::writeData(ostream& outstream, bool isCounting) {
+// Writes the data in this cache to a stream, by concatenating the headers, the table of contents,
+// and the retained serialized content of each shader library.
+void MVKPipelineCache::writeData(ostream& outstream) {
+	uint64_t startTime = _device->getPerformanceTimestamp();
 
-	MVKPerformanceTracker& activityTracker = isCounting
-		? _device->_performanceStatistics.pipelineCache.sizePipelineCache
-		: _device->_performanceStatistics.pipelineCache.writePipelineCache;
-
-	uint32_t cacheEntryType;
 	cereal::BinaryOutputArchive writer(outstream);
 
 	// Write the data header...after ensuring correct byte-order.
@@ -1978,120 +2128,288 @@ void MVKPipelineCache::writeData(ostream& outstream, bool isCounting) {
 	writer(NSSwapHostIntToLittle(pDevProps->deviceID));
 	writer(pDevProps->pipelineCacheUUID);
 
-	// Shader libraries
-	// Output a cache entry for each shader library, including the shader module key in each entry.
-	cacheEntryType = MVKPipelineCacheEntryTypeShaderLibrary;
-	for (auto& scPair : _shaderCache) {
-		MVKShaderModuleKey smKey = scPair.first;
-		MVKShaderCacheIterator cacheIter(scPair.second);
-		while (cacheIter.next()) {
-			uint64_t startTime = _device->getPerformanceTimestamp();
-			writer(cacheEntryType);
-			writer(smKey);
-			writer(cacheIter.getShaderConversionConfig());
-			writer(cacheIter.getShaderConversionResults());
-			writer(cacheIter.getMSL());
-			_device->addActivityPerformance(activityTracker, startTime);
+	// Write the content header and the table of contents, locating each entry after the table of contents.
+	writer(NSSwapHostIntToLittle(kMVKPipelineCacheContentMagic));
+	writer(NSSwapHostIntToLittle(kMVKPipelineCacheContentVersion));
+	writer(NSSwapHostIntToLittle((uint32_t)_entries.size()));
+	uint32_t flags = 0;
+	for (auto& entry : _entries) {
+		if (entry.rawSize) { flags |= kMVKPipelineCacheFlagCompressedEntries; }
+	}
+	writer(NSSwapHostIntToLittle(flags));
+
+	size_t offset = kMVKPipelineCacheTOCOffset + (_entries.size() * sizeof(MVKPipelineCacheTOCEntry));
+	for (auto& entry : _entries) {
+		writer(NSSwapHostLongLongToLittle(entry.smKey.codeSize));
+		writer(NSSwapHostLongLongToLittle(entry.smKey.codeHash.lo));
+		writer(NSSwapHostLongLongToLittle(entry.smKey.codeHash.hi));
+		writer(NSSwapHostLongLongToLittle(entry.optionsHash));
+		writer(NSSwapHostLongLongToLittle((uint64_t)offset));
+		writer(NSSwapHostLongLongToLittle((uint64_t)entry.size));
+		writer(NSSwapHostLongLongToLittle((uint64_t)entry.rawSize));
+		offset += mvkAlignByteCount(entry.size, kMVKPipelineCacheEntryAlignment);
+	}
+
+	// Write the content of each entry, padded to alignment.
+	static const char padding[kMVKPipelineCacheEntryAlignment] = {};
+	for (auto& entry : _entries) {
+		outstream.write(getEntryContent(entry), entry.size);
+		outstream.write(padding, mvkAlignByteCount(entry.size, kMVKPipelineCacheEntryAlignment) - entry.size);
+	}
+
+	_device->addActivityPerformance(_device->_performanceStatistics.pipelineCache.writePipelineCache, startTime);
+}
+
+// Records that the shader libraries in the shader library cache, from the specified index onwards,
+// have been added to this pipeline cache, and need to be serialized before the cache is next written.
+// Must be called while holding the lock of the stripe for the shader module key.
+void MVKPipelineCache::addNewEntries(MVKShaderModuleKey smKey, MVKShaderLibraryCache* slCache, uint32_t firstSLIndex) {
+	lock_guard<mutex> lock(_newEntriesLock);
+	uint32_t slCnt = (uint32_t)slCache->_shaderLibraries.size();
+	for (uint32_t slIdx = firstSLIndex; slIdx < slCnt; slIdx++) {
+		_newEntries.push_back({smKey, slCache, slIdx});
+	}
+}
+
+// Serializes the content of each shader library that has been added since this function was last called.
+// If configured, the content is compressed, unless compressing it would not reduce its size.
+// Must be called while holding the pipeline cache lock.
+void MVKPipelineCache::serializeNewEntries() {
+	MVKSmallVector<MVKPipelineCacheNewEntry> newEntries;
+	{
+		lock_guard<mutex> lock(_newEntriesLock);
+		newEntries.swap(_newEntries);
+	}
+
+	bool shouldCompress = mvkConfig().compressPipelineCacheData;
+	for (auto& newEntry : newEntries) {
+		uint64_t startTime = _device->getPerformanceTimestamp();
+
+		lock_guard<mutex> stripeLock(getStripe(newEntry.smKey).lock);
+		auto& slPair = newEntry.slCache->_shaderLibraries[newEntry.slIndex];
+		MVKPipelineCacheEntry entry;
+		entry.smKey = newEntry.smKey;
+		entry.optionsHash = slPair.first.options.hash();
+
+		ostringstream entryStream;
+		{
+			cereal::BinaryOutputArchive writer(entryStream);
+			writer(slPair.first);
+			writer(slPair.second->_shaderConversionResults);
+			writer(slPair.second->_msl);
 		}
+		entry.content = entryStream.str();
+		if (shouldCompress) {
+			string compressed = mvkCompressLZ(entry.content.data(), entry.content.size(),
+											  kMVKPipelineCacheDictionary, sizeof(kMVKPipelineCacheDictionary) - 1);
+			if ( !compressed.empty() ) {
+				entry.rawSize = entry.content.size();
+				entry.content = std::move(compressed);
+			}
+		}
+		entry.size = entry.content.size();
+		addEntry(std::move(entry));
+
+		_device->addActivityPerformance(_device->_performanceStatistics.pipelineCache.sizePipelineCache, startTime);
 	}
+}
 
-	// Mark the end of the archive
-	cacheEntryType = MVKPipelineCacheEntryTypeEOF;
-	writer(cacheEntryType);
+// Adds the entry to the content to be written, and updates the size of the data to be written.
+void MVKPipelineCache::addEntry(MVKPipelineCacheEntry&& entry) {
+	_dataSize += sizeof(MVKPipelineCacheTOCEntry) + mvkAlignByteCount(entry.size, kMVKPipelineCacheEntryAlignment);
+	_entries.push_back(std::move(entry));
 }
 
 // Loads any data indicated by the creation info.
+// The data is copied, because it may not be retained beyond the creation of this pipeline cache.
+// Only the header and the table of contents are read here. Each shader library is deserialized from
+// the copied data lazily, when it is first needed to find a shader library for a shader module.
 // This is the compliment of the writeData() function. The two must be kept aligned.
 void MVKPipelineCache::readData(const VkPipelineCacheCreateInfo* pCreateInfo) {
-	try {
+	size_t byteCount = pCreateInfo->initialDataSize;
+	const char* pData = (const char*)pCreateInfo->pInitialData;
 
-		size_t byteCount = pCreateInfo->initialDataSize;
-		uint32_t cacheEntryType;
+	// Must be able to read the header and content header.
+	if ( !pData || byteCount < kMVKPipelineCacheTOCOffset ) { return; }
 
-		// Must be able to read the header and at least one cache entry type.
-		if (byteCount < kDataHeaderSize + sizeof(cacheEntryType)) { return; }
+	uint64_t startTime = _device->getPerformanceTimestamp();
 
-		mvk::membuf mb((char*)pCreateInfo->pInitialData, byteCount);
-		istream inStream(&mb);
-		cereal::BinaryInputArchive reader(inStream);
-
-		// Read the data header...and ensure correct byte-order.
-		uint32_t hdrComponent;
-		uint8_t pcUUID[VK_UUID_SIZE];
-		const VkPhysicalDeviceProperties* pDevProps = _device->_pProperties;
-
-		reader(hdrComponent);	// Header size
-		if (NSSwapLittleIntToHost(hdrComponent) !=  kDataHeaderSize) { return; }
-
-		reader(hdrComponent);	// Header version
-		if (NSSwapLittleIntToHost(hdrComponent) !=  VK_PIPELINE_CACHE_HEADER_VERSION_ONE) { return; }
-
-		reader(hdrComponent);	// Vendor ID
-		if (NSSwapLittleIntToHost(hdrComponent) !=  pDevProps->vendorID) { return; }
+	// Read the data header...and ensure correct byte-order.
+	auto readUInt32 = [pData](size_t offset) { uint32_t val; memcpy(&val, pData + offset, sizeof(val)); return NSSwapLittleIntToHost(val); };
+	const VkPhysicalDeviceProperties* pDevProps = _device->_pProperties;
+	if (readUInt32(0) != kDataHeaderSize) { return; }
+	if (readUInt32(4) != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) { return; }
+	if (readUInt32(8) != pDevProps->vendorID) { return; }
+	if (readUInt32(12) != pDevProps->deviceID) { return; }
+	if ( !mvkAreEqual((const uint8_t*)pData + 16, pDevProps->pipelineCacheUUID, VK_UUID_SIZE) ) { return; }
+
+	// Read the content header.
+	if (readUInt32(kDataHeaderSize) != kMVKPipelineCacheContentMagic) { return; }
+	if (readUInt32(kDataHeaderSize + 4) != kMVKPipelineCacheContentVersion) { return; }
+	size_t entryCount = readUInt32(kDataHeaderSize + 8);
+	uint32_t flags = readUInt32(kDataHeaderSize + 12);
+	if (mvkIsAnyFlagEnabled(flags, ~kMVKPipelineCacheSupportedFlags)) {
+		setConfigurationResult(reportError(VK_SUCCESS, "Error reading pipeline cache data: Unsupported content flags 0x%x.", flags));
+		return;
+	}
+	if (entryCount > (byteCount - kMVKPipelineCacheTOCOffset) / sizeof(MVKPipelineCacheTOCEntry)) {
+		setConfigurationResult(reportError(VK_SUCCESS, "Error reading pipeline cache data: Table of contents is truncated."));
+		return;
+	}
+
+	// Index each entry from the table of contents, ignoring the data if any entry lies outside it.
+	MVKSmallVector<MVKPipelineCacheEntry> entries;
+	entries.reserve(entryCount);
+	for (size_t entryIdx = 0; entryIdx < entryCount; entryIdx++) {
+		MVKPipelineCacheTOCEntry tocEntry;
+		memcpy(&tocEntry, pData + kMVKPipelineCacheTOCOffset + (entryIdx * sizeof(tocEntry)), sizeof(tocEntry));
+
+		MVKPipelineCacheEntry& entry = entries.emplace_back();
+		entry.smKey = MVKShaderModuleKey(NSSwapLittleLongLongToHost(tocEntry.codeSize),
+										 {NSSwapLittleLongLongToHost(tocEntry.codeHashLo), NSSwapLittleLongLongToHost(tocEntry.codeHashHi)});
+		entry.optionsHash = NSSwapLittleLongLongToHost(tocEntry.optionsHash);
+		entry.offset = NSSwapLittleLongLongToHost(tocEntry.offset);
+		entry.size = NSSwapLittleLongLongToHost(tocEntry.size);
+		entry.rawSize = NSSwapLittleLongLongToHost(tocEntry.rawSize);
+		if (entry.offset > byteCount || entry.size > byteCount - entry.offset) {
+			setConfigurationResult(reportError(VK_SUCCESS, "Error reading pipeline cache data: Entry %zu lies outside the data.", entryIdx));
+			return;
+		}
+		if (entry.rawSize && ( !mvkIsAnyFlagEnabled(flags, kMVKPipelineCacheFlagCompressedEntries) || entry.rawSize / 255 > entry.size )) {
+			setConfigurationResult(reportError(VK_SUCCESS, "Error reading pipeline cache data: Entry %zu has invalid compressed content.", entryIdx));
+			return;
+		}
+	}
 
-		reader(hdrComponent);	// Device ID
-		if (NSSwapLittleIntToHost(hdrComponent) !=  pDevProps->deviceID) { return; }
+	_initialData.reset(new char[byteCount]);
+	memcpy(_initialData.get(), pData, byteCount);
+	for (auto& entry : entries) {
+		_pendingEntries[entry.smKey].push_back(entry);
+		addEntry(std::move(entry));
+	}
 
-		reader(pcUUID);			// Pipeline cache UUID
-		if ( !mvkAreEqual(pcUUID, pDevProps->pipelineCacheUUID, VK_UUID_SIZE) ) { return; }
+	_device->addActivityPerformance(_device->_performanceStatistics.pipelineCache.readPipelineCache, startTime);
+}
 
-		bool done = false;
-		while ( !done ) {
-			reader(cacheEntryType);
-			switch (cacheEntryType) {
-				case MVKPipelineCacheEntryTypeShaderLibrary: {
-					uint64_t startTime = _device->getPerformanceTimestamp();
+// Deserializes the pending entries for the shader module key, one at a time, and adds each to the shader library cache.
+// Stops at the first entry that matches the shader conversion configuration, and returns its shader library.
+// Returns null if no entry matches. Entries whose shader conversion options differ from those of the configuration
+// cannot match, and are left pending. If the configuration is null, all pending entries for the key are deserialized.
+// The map of pending entries is only ever indexed by readData(), and is not modified here. The pending entries
+// of the key can therefore be accessed while holding the lock of the stripe for the key. The caller must hold it.
+MVKShaderLibrary* MVKPipelineCache::readPendingEntries(MVKShaderModuleKey smKey,
+													   MVKShaderLibraryCache* slCache,
+													   SPIRVToMSLConversionConfiguration* pContext) {
+	auto peIter = _pendingEntries.find(smKey);
+	if (peIter == _pendingEntries.end()) { return nullptr; }
 
-					MVKShaderModuleKey smKey;
-					reader(smKey);
+	auto& pendingEntries = peIter->second;
+	size_t optsHash = pContext ? pContext->options.hash() : 0;
+	for (size_t peIdx = 0; peIdx < pendingEntries.size(); ) {
+		MVKPipelineCacheEntry entry = pendingEntries[peIdx];
+		if (pContext && entry.optionsHash != optsHash) {
+			peIdx++;
+			continue;
+		}
+		pendingEntries.erase(pendingEntries.begin() + peIdx);
+		if (readEntry(entry, slCache) && pContext) {
+			MVKShaderLibrary* shLib = slCache->findShaderLibrary(pContext);
+			if (shLib) { return shLib; }
+		}
+	}
+	return nullptr;
+}
 
-					SPIRVToMSLConversionConfiguration shaderConversionConfig;
-					reader(shaderConversionConfig);
+// Deserializes the shader library of the entry, and adds it to the shader library cache.
+// Returns whether the shader library was added, reporting the reason if it was not.
+bool MVKPipelineCache::readEntry(MVKPipelineCacheEntry& entry, MVKShaderLibraryCache* slCache) {
+	try {
+		uint64_t startTime = _device->getPerformanceTimestamp();
+
+		// Decompress the content if needed, skipping the entry if it is corrupt.
+		char* pContent = (char*)getEntryContent(entry);
+		size_t contentSize = entry.size;
+		string rawContent;
+		if (entry.rawSize) {
+			rawContent.resize(entry.rawSize);
+			if ( !mvkDecompressLZ(pContent, contentSize, &rawContent[0], entry.rawSize,
+								  kMVKPipelineCacheDictionary, sizeof(kMVKPipelineCacheDictionary) - 1) ) {
+				reportError(VK_SUCCESS, "Error reading pipeline cache data: Could not decompress entry at offset %zu.", entry.offset);
+				return false;
+			}
+			pContent = &rawContent[0];
+			contentSize = entry.rawSize;
+		}
 
-					SPIRVToMSLConversionResults shaderConversionResults;
-					reader(shaderConversionResults);
+		mvk::membuf mb(pContent, contentSize);
+		istream inStream(&mb);
+		cereal::BinaryInputArchive reader(inStream);
 
-					string msl;
-					reader(msl);
+		SPIRVToMSLConversionConfiguration shaderConversionConfig;
+		reader(shaderConversionConfig);
 
-					// Add the shader library to the staging cache.
-					MVKShaderLibraryCache* slCache = getShaderLibraryCache(smKey);
-					_device->addActivityPerformance(_device->_performanceStatistics.pipelineCache.readPipelineCache, startTime);
-					slCache->addShaderLibrary(&shaderConversionConfig, msl, shaderConversionResults);
+		SPIRVToMSLConversionResults shaderConversionResults;
+		reader(shaderConversionResults);
 
-					break;
-				}
+		string msl;
+		reader(msl);
 
-				default: {
-					done = true;
-					break;
-				}
-			}
-		}
+		_device->addActivityPerformance(_device->_performanceStatistics.pipelineCache.readPipelineCache, startTime);
+		slCache->addShaderLibrary(&shaderConversionConfig, msl, shaderConversionResults);
+		return true;
 
 	} catch (cereal::Exception& ex) {
-		setConfigurationResult(reportError(VK_SUCCESS, "Error reading pipeline cache data: %s", ex.what()));
+		reportError(VK_SUCCESS, "Error reading pipeline cache data: %s", ex.what());
+		return false;
 	}
 }
 
-// Mark the cache as dirty, so that existing streaming info is released
-void MVKPipelineCache::markDirty() {
-	_dataSize = 0;
-}
-
+// Any shader libraries from a source pipeline cache that are not already in this pipeline cache,
+// including those not yet deserialized from the initial data of the source pipeline cache, are
+// added to this pipeline cache, and are serialized when this pipeline cache is next written. Any entries for
+// the same key that are pending in this pipeline cache are deserialized first, so that shader libraries
+// that are already in this pipeline cache are recognized, and are not added again. Entries that are
+// pending in the source pipeline cache are deserialized into a temporary cache, and remain pending there.
 VkResult MVKPipelineCache::mergePipelineCaches(uint32_t srcCacheCount, const VkPipelineCache* pSrcCaches) {
 	for (uint32_t srcIdx = 0; srcIdx < srcCacheCount; srcIdx++) {
 		MVKPipelineCache* srcPLC = (MVKPipelineCache*)pSrcCaches[srcIdx];
-		for (auto& srcPair : srcPLC->_shaderCache) {
-			getShaderLibraryCache(srcPair.first)->merge(srcPair.second);
+		if (srcPLC == this) { continue; }
+
+		// Copy the source content while holding only the locks of the source cache, and then merge
+		// it while holding only the locks of this cache. The locks of two caches are never held at
+		// the same time, so merges between the same caches in opposite directions cannot deadlock.
+		std::vector<std::pair<MVKShaderModuleKey, MVKShaderLibraryCache*>> srcSLCaches;
+		{
+			lock_guard<mutex> srcLock(srcPLC->_shaderCacheLock);
+			for (auto& srcPair : srcPLC->_shaderCache) {
+				MVKShaderLibraryCache* srcSLCache = new MVKShaderLibraryCache(srcPLC);
+				lock_guard<mutex> srcStripeLock(srcPLC->getStripe(srcPair.first).lock);
+				srcSLCache->merge(srcPair.second);
+				srcSLCaches.emplace_back(srcPair.first, srcSLCache);
+			}
+			for (auto& srcPair : srcPLC->_pendingEntries) {
+				MVKShaderLibraryCache* srcSLCache = new MVKShaderLibraryCache(srcPLC);
+				lock_guard<mutex> srcStripeLock(srcPLC->getStripe(srcPair.first).lock);
+				for (auto& entry : srcPair.second) { srcPLC->readEntry(entry, srcSLCache); }
+				srcSLCaches.emplace_back(srcPair.first, srcSLCache);
+			}
+		}
+
+		lock_guard<mutex> lock(_shaderCacheLock);
+		for (auto& srcPair : srcSLCaches) {
+			MVKShaderLibraryCache* slCache = getShaderLibraryCache(srcPair.first);
+			lock_guard<mutex> stripeLock(getStripe(srcPair.first).lock);
+			readPendingEntries(srcPair.first, slCache, nullptr);
+			uint32_t slCnt = (uint32_t)slCache->_shaderLibraries.size();
+			slCache->merge(srcPair.second);
+			addNewEntries(srcPair.first, slCache, slCnt);
+			srcPair.second->destroy();
 		}
 	}
-	markDirty();
 
 	return VK_SUCCESS;
 }
 
-
 #pragma mark Cereal archive definitions
 
 namespace SPIRV_CROSS_NAMESPACE {
@@ -2282,13 +2600,15 @@ namespace mvk {
 template<class Archive>
 void serialize(Archive & archive, MVKShaderModuleKey& k) {
 	archive(k.codeSize,
-			k.codeHash);
+			k.codeHash.lo,
+			k.codeHash.hi);
 }
 
 
 #pragma mark Construction
 
 MVKPipelineCache::MVKPipelineCache(MVKDevice* device, const VkPipelineCacheCreateInfo* pCreateInfo) : MVKVulkanAPIDeviceObject(device) {
+	_dataSize = kMVKPipelineCacheTOCOffset;
 	readData(pCreateInfo);
 }
 
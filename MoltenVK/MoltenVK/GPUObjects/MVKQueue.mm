@@ -308,6 +308,9 @@ void MVKQueueCommandBufferSubmission::execute() {
 
 	_queue->_submissionCaptureScope->beginScope();
 
+	// The command buffers may write to resources whose content is tracked in host memory.
+	_queue->getDevice()->advanceGPUWriteEpoch();
+
 	// If using encoded semaphore waiting, do so now.
 	for (auto& ws : _waitSemaphores) { ws.first->encodeWait(getActiveMTLCommandBuffer(), ws.second); }
 
@@ -444,6 +447,9 @@ void MVKQueueCommandBufferSubmission::finish() {
 	// immediately after a waitIdle() is cleared by fence below, taking the capture scope with it.
 	_queue->_submissionCaptureScope->endScope();
 
+	// Advance before signaling, so host memory flushed after waiting on the fence sees the GPU writes.
+	_queue->getDevice()->advanceGPUWriteEpoch();
+
 	// If using inline semaphore signaling, do so now.
 	for (auto& ss : _signalSemaphores) { ss.first->encodeSignal(nil, ss.second); }
 
@@ -24,11 +24,11 @@
 #include <MoltenVKShaderConverter/SPIRVToMSLConverter.h>
 #include <MoltenVKShaderConverter/GLSLToSPIRVConverter.h>
 #include <mutex>
+#include <unordered_map>
 
 #import <Metal/Metal.h>
 
 class MVKPipelineCache;
-class MVKShaderCacheIterator;
 class MVKShaderLibraryCache;
 class MVKShaderModule;
 
@@ -101,7 +101,7 @@ public:
 	~MVKShaderLibrary() override;
 
 protected:
-	friend MVKShaderCacheIterator;
+	friend MVKPipelineCache;
 	friend MVKShaderLibraryCache;
 	friend MVKShaderModule;
 
@@ -119,7 +119,48 @@ protected:
 #pragma mark -
 #pragma mark MVKShaderLibraryCache
 
-/** Represents a cache of shader libraries for one shader module. */
+/** Identifies a resource binding by shader stage, descriptor set, and binding. */
+typedef struct MVKShaderResourceKey {
+	spv::ExecutionModel stage;
+	uint32_t descSet;
+	uint32_t binding;
+
+	bool operator==(const MVKShaderResourceKey& rhs) const {
+		return stage == rhs.stage && descSet == rhs.descSet && binding == rhs.binding;
+	}
+	bool operator<(const MVKShaderResourceKey& rhs) const {
+		if (stage != rhs.stage) { return stage < rhs.stage; }
+		if (descSet != rhs.descSet) { return descSet < rhs.descSet; }
+		return binding < rhs.binding;
+	}
+
+	MVKShaderResourceKey(const SPIRV_CROSS_NAMESPACE::MSLResourceBinding& rb) : stage(rb.stage), descSet(rb.desc_set), binding(rb.binding) {}
+} MVKShaderResourceKey;
+
+/**
+ * Identifies the shader input locations and resource bindings that are used by the shader
+ * libraries in one group within a MVKShaderLibraryCache, and indexes the libraries in that
+ * group by the digest of the used content of their shader conversion configurations.
+ */
+typedef struct MVKShaderLibraryUsage {
+	std::vector<uint32_t> inputLocations;
+	std::vector<MVKShaderResourceKey> resourceKeys;
+	std::unordered_map<std::size_t, MVKSmallVector<uint32_t, 1>> libraryIndicesByDigest;
+
+	/** Returns whether the used content of the shader conversion configuration is identified by this usage. */
+	bool isUsageOf(const SPIRVToMSLConversionConfiguration& shaderConfig) const;
+
+	MVKShaderLibraryUsage(const SPIRVToMSLConversionConfiguration& shaderConfig);
+} MVKShaderLibraryUsage;
+
+/**
+ * Represents a cache of shader libraries for one shader module.
+ *
+ * Shader libraries are grouped by the shader inputs and resource bindings that they use,
+ * which is generally the same for all shader libraries of a shader module stage. Within each
+ * group, shader libraries are indexed by the digest of the content they use, so finding a shader
+ * library requires a digest lookup per group, and a single match verification of the result.
+ */
 class MVKShaderLibraryCache : public MVKBaseObject {
 
 public:
@@ -129,7 +170,8 @@ public:
 
 	/**
 	 * Returns a shader library from the shader conversion configuration sourced from the shader module,
-	 * lazily creating the shader library from source code in the shader module, if needed.
+	 * lazily creating the shader library from source code in the shader module, if needed. If the
+	 * device has a persistent shader conversion cache, it is consulted before converting the source code.
 	 *
 	 * If pWasAdded is not nil, this function will set it to true if a new shader library was created,
 	 * and to false if an existing shader library was found and returned.
@@ -143,7 +185,6 @@ public:
 	~MVKShaderLibraryCache() override;
 
 protected:
-	friend MVKShaderCacheIterator;
 	friend MVKPipelineCache;
 	friend MVKShaderModule;
 
@@ -151,25 +192,33 @@ protected:
 	MVKShaderLibrary* addShaderLibrary(SPIRVToMSLConversionConfiguration* pShaderConfig,
 									   const std::string& mslSourceCode,
 									   const SPIRVToMSLConversionResults& shaderConversionResults);
+	MVKShaderLibrary* addShaderLibrary(SPIRVToMSLConversionConfiguration* pShaderConfig, MVKShaderLibrary* shLib);
+	void indexShaderLibrary(uint32_t slIdx);
 	void merge(MVKShaderLibraryCache* other);
 
 	MVKVulkanAPIDeviceObject* _owner;
 	MVKSmallVector<std::pair<SPIRVToMSLConversionConfiguration, MVKShaderLibrary*>> _shaderLibraries;
+	MVKSmallVector<MVKShaderLibraryUsage, 1> _shaderLibraryUsages;
 };
 
 
 #pragma mark -
 #pragma mark MVKShaderModule
 
+/**
+ * Identifies the content of a shader module. The 128-bit code hash keeps the chance of
+ * different shader code producing the same key negligible, even across very large
+ * numbers of shader modules, such as when used to identify pipeline cache entries.
+ */
 typedef struct MVKShaderModuleKey {
 	std::size_t codeSize;
-	std::size_t codeHash;
+	MVKHash128 codeHash;
 
 	bool operator==(const MVKShaderModuleKey& rhs) const {
 		return ((codeSize == rhs.codeSize) && (codeHash == rhs.codeHash));
 	}
-	MVKShaderModuleKey(std::size_t codeSize, std::size_t codeHash) : codeSize(codeSize), codeHash(codeHash) {}
-	MVKShaderModuleKey() :  MVKShaderModuleKey(0, 0) {}
+	MVKShaderModuleKey(std::size_t codeSize, MVKHash128 codeHash) : codeSize(codeSize), codeHash(codeHash) {}
+	MVKShaderModuleKey() :  MVKShaderModuleKey(0, MVKHash128()) {}
 } MVKShaderModuleKey;
 
 /**
@@ -179,7 +228,7 @@ typedef struct MVKShaderModuleKey {
 namespace std {
 	template <>
 	struct hash<MVKShaderModuleKey> {
-		std::size_t operator()(const MVKShaderModuleKey& k) const { return k.codeHash; }
+		std::size_t operator()(const MVKShaderModuleKey& k) const { return k.codeHash.lo; }
 	};
 }
 
@@ -225,17 +274,18 @@ public:
 	~MVKShaderModule() override;
 
 protected:
-	friend MVKShaderCacheIterator;
-
 	void propagateDebugName() override {}
 	MVKGLSLConversionShaderStage getMVKGLSLConversionShaderStage(SPIRVToMSLConversionConfiguration* pShaderConfig);
+	const MVKHash128& getSPIRVHash();
 
 	MVKShaderLibraryCache _shaderLibraryCache;
 	SPIRVToMSLConverter _spvConverter;
 	GLSLToSPIRVConverter _glslConverter;
 	MVKShaderLibrary* _directMSLLibrary;
 	MVKShaderModuleKey _key;
+	MVKHash128 _spirvHash;
     std::mutex _accessLock;
+	bool _hasSPIRVHash = false;
 };
 
 
@@ -19,6 +19,7 @@
 #include "MVKShaderModule.h"
 #include "MVKPipeline.h"
 #include "MVKFoundation.h"
+#include <algorithm>
 #include <string>
 
 using namespace std;
@@ -215,6 +216,24 @@ MVKShaderLibrary::~MVKShaderLibrary() {
 #pragma mark -
 #pragma mark MVKShaderLibraryCache
 
+// Inputs and resources are kept sorted, including any duplicates, so usages can be compared directly.
+MVKShaderLibraryUsage::MVKShaderLibraryUsage(const SPIRVToMSLConversionConfiguration& shaderConfig) {
+	for (auto& si : shaderConfig.shaderInputs) {
+		if (si.outIsUsedByShader) { inputLocations.push_back(si.shaderInput.location); }
+	}
+	std::sort(inputLocations.begin(), inputLocations.end());
+
+	for (auto& rb : shaderConfig.resourceBindings) {
+		if (shaderConfig.isUsedByStage(rb)) { resourceKeys.emplace_back(rb.resourceBinding); }
+	}
+	std::sort(resourceKeys.begin(), resourceKeys.end());
+}
+
+bool MVKShaderLibraryUsage::isUsageOf(const SPIRVToMSLConversionConfiguration& shaderConfig) const {
+	MVKShaderLibraryUsage otherUsage(shaderConfig);
+	return inputLocations == otherUsage.inputLocations && resourceKeys == otherUsage.resourceKeys;
+}
+
 MVKShaderLibrary* MVKShaderLibraryCache::getShaderLibrary(SPIRVToMSLConversionConfiguration* pShaderConfig,
 														  MVKShaderModule* shaderModule,
 														  bool* pWasAdded) {
@@ -234,25 +253,105 @@ MVKShaderLibrary* MVKShaderLibraryCache::getShaderLibrary(SPIRVToMSLConversionCo
 
 // Finds and returns a shader library matching the shader config, or returns nullptr if it doesn't exist.
 // If a match is found, the shader config is aligned with the shader config of the matching library.
+// For each usage group, sums the hashes of the shader inputs and resource bindings of the shader config
+// that correspond to the used content identified by the usage, and looks up that digest in the usage
+// index, verifying any candidate using matches(). If the shader config contains more than one element
+// corresponding to a used element, the digest is ambiguous, and each library in the group is tested.
+// To retain the behavior of a sequential search, the earliest matching shader library is returned.
 MVKShaderLibrary* MVKShaderLibraryCache::findShaderLibrary(SPIRVToMSLConversionConfiguration* pShaderConfig) {
-	for (auto& slPair : _shaderLibraries) {
-		if (slPair.first.matches(*pShaderConfig)) {
-			pShaderConfig->alignWith(slPair.first);
-			return slPair.second;
+	if (_shaderLibraries.empty()) { return nullptr; }
+
+	// Sort the shader config content by key, to allow binary searching for used content.
+	// Canonical shader configs will already be sorted.
+	auto byKey = [](auto& a, auto& b) { return a.first < b.first; };
+	std::vector<std::pair<uint32_t, const MSLShaderInput*>> inputs;
+	inputs.reserve(pShaderConfig->shaderInputs.size());
+	for (auto& si : pShaderConfig->shaderInputs) { inputs.emplace_back(si.shaderInput.location, &si); }
+	if ( !std::is_sorted(inputs.begin(), inputs.end(), byKey) ) { std::sort(inputs.begin(), inputs.end(), byKey); }
+
+	std::vector<std::pair<MVKShaderResourceKey, const MSLResourceBinding*>> rezBindings;
+	rezBindings.reserve(pShaderConfig->resourceBindings.size());
+	for (auto& rb : pShaderConfig->resourceBindings) { rezBindings.emplace_back(rb.resourceBinding, &rb); }
+	if ( !std::is_sorted(rezBindings.begin(), rezBindings.end(), byKey) ) { std::sort(rezBindings.begin(), rezBindings.end(), byKey); }
+
+	// Adds the hash of the single element with the key to the digest. Returns false if there is no such
+	// element, in which case no library in the group can match, and sets isAmbiguous if there is more than one.
+	auto addHash = [](auto& sortedElems, auto& key, size_t& digest, bool& isAmbiguous) {
+		auto iter = std::lower_bound(sortedElems.begin(), sortedElems.end(), key,
+									 [](auto& elem, auto& k) { return elem.first < k; });
+		if (iter == sortedElems.end() || !(iter->first == key)) { return false; }
+		auto nextIter = iter + 1;
+		if (nextIter != sortedElems.end() && nextIter->first == key) { isAmbiguous = true; }
+		digest += iter->second->hash();
+		return true;
+	};
+
+	size_t optsHash = pShaderConfig->options.hash();
+	uint32_t slCnt = (uint32_t)_shaderLibraries.size();
+	uint32_t foundIdx = slCnt;
+	for (auto& slUsage : _shaderLibraryUsages) {
+		size_t digest = optsHash;
+		bool isAmbiguous = false;
+		bool isFound = true;
+		for (auto& loc : slUsage.inputLocations) {
+			if ( !(isFound = addHash(inputs, loc, digest, isAmbiguous)) ) { break; }
+		}
+		for (auto& rk : slUsage.resourceKeys) {
+			if ( !isFound || !(isFound = addHash(rezBindings, rk, digest, isAmbiguous)) ) { break; }
+		}
+		if ( !isFound ) { continue; }
+
+		if (isAmbiguous) {
+			for (auto& idxPair : slUsage.libraryIndicesByDigest) {
+				for (uint32_t slIdx : idxPair.second) {
+					if (slIdx < foundIdx && _shaderLibraries[slIdx].first.matches(*pShaderConfig)) { foundIdx = slIdx; }
+				}
+			}
+		} else {
+			auto iter = slUsage.libraryIndicesByDigest.find(digest);
+			if (iter == slUsage.libraryIndicesByDigest.end()) { continue; }
+			for (uint32_t slIdx : iter->second) {
+				if (slIdx < foundIdx && _shaderLibraries[slIdx].first.matches(*pShaderConfig)) { foundIdx = slIdx; }
+			}
 		}
 	}
-	return nullptr;
+
+	if (foundIdx == slCnt) { return nullptr; }
+
+	auto& slPair = _shaderLibraries[foundIdx];
+	pShaderConfig->alignWith(slPair.first);
+	return slPair.second;
 }
 
 // Adds and returns a new shader library configured from the specified conversion configuration.
 MVKShaderLibrary* MVKShaderLibraryCache::addShaderLibrary(SPIRVToMSLConversionConfiguration* pShaderConfig,
 														  const string& mslSourceCode,
 														  const SPIRVToMSLConversionResults& shaderConversionResults) {
-	MVKShaderLibrary* shLib = new MVKShaderLibrary(_owner, mslSourceCode, shaderConversionResults);
+	return addShaderLibrary(pShaderConfig, new MVKShaderLibrary(_owner, mslSourceCode, shaderConversionResults));
+}
+
+// Adds a shader library that has already been created for this cache, and takes ownership of it.
+MVKShaderLibrary* MVKShaderLibraryCache::addShaderLibrary(SPIRVToMSLConversionConfiguration* pShaderConfig, MVKShaderLibrary* shLib) {
 	_shaderLibraries.emplace_back(*pShaderConfig, shLib);
+	indexShaderLibrary((uint32_t)_shaderLibraries.size() - 1);
 	return shLib;
 }
 
+// Adds the shader library at the index to the digest index of the usage group
+// that matches its shader conversion configuration, creating the group if needed.
+void MVKShaderLibraryCache::indexShaderLibrary(uint32_t slIdx) {
+	auto& shaderConfig = _shaderLibraries[slIdx].first;
+	MVKShaderLibraryUsage* pSLUsage = nullptr;
+	for (auto& slUsage : _shaderLibraryUsages) {
+		if (slUsage.isUsageOf(shaderConfig)) {
+			pSLUsage = &slUsage;
+			break;
+		}
+	}
+	if ( !pSLUsage ) { pSLUsage = &_shaderLibraryUsages.emplace_back(shaderConfig); }
+	pSLUsage->libraryIndicesByDigest[shaderConfig.getUsedDigest()].push_back(slIdx);
+}
+
 // Merge another shader library cache with this one. Handle null input.
 void MVKShaderLibraryCache::merge(MVKShaderLibraryCache* other) {
 	if ( !other ) { return; }
@@ -260,6 +359,7 @@ void MVKShaderLibraryCache::merge(MVKShaderLibraryCache* other) {
 		if ( !findShaderLibrary(&otherPair.first) ) {
 			_shaderLibraries.emplace_back(otherPair.first, new MVKShaderLibrary(*otherPair.second));
 			_shaderLibraries.back().second->_owner = _owner;
+			indexShaderLibrary((uint32_t)_shaderLibraries.size() - 1);
 		}
 	}
 }
@@ -315,18 +415,42 @@ bool MVKShaderModule::convert(SPIRVToMSLConversionConfiguration* pShaderConfig)
 		shouldLogEstimatedGLSL = false;
 	}
 
+	// If a persistent conversion cache is in use, and the conversion is not being logged, try to retrieve
+	// the conversion from the cache, and if it is not there, add it to the cache once it has been converted.
 	uint64_t startTime = _device->getPerformanceTimestamp();
+	SPIRVToMSLConversionCache* pConvCache = shouldLogCode ? nullptr : _device->getShaderConversionCache();
+	if (pConvCache) {
+		string msl;
+		SPIRVToMSLConversionResults convRslts;
+		if (pConvCache->read(_spvConverter.getSPIRV(), getSPIRVHash(), *pShaderConfig, msl, convRslts)) {
+			_spvConverter.setMSL(msl, &convRslts);
+			_device->addActivityPerformance(_device->_performanceStatistics.shaderCompilation.spirvToMSL, startTime);
+			return true;
+		}
+	}
+
 	bool wasConverted = _spvConverter.convert(*pShaderConfig, shouldLogCode, shouldLogCode, shouldLogEstimatedGLSL);
 	_device->addActivityPerformance(_device->_performanceStatistics.shaderCompilation.spirvToMSL, startTime);
 
 	if (wasConverted) {
 		if (shouldLogCode) { MVKLogInfo("%s", _spvConverter.getResultLog().c_str()); }
+		if (pConvCache) { pConvCache->write(_spvConverter.getSPIRV(), getSPIRVHash(), *pShaderConfig, _spvConverter.getMSL(), _spvConverter.getConversionResults()); }
 	} else {
 		reportError(VK_ERROR_INVALID_SHADER_NV, "Unable to convert SPIR-V to MSL:\n%s", _spvConverter.getResultLog().c_str());
 	}
 	return wasConverted;
 }
 
+// Returns the hash of the SPIR-V code, as used by the shader conversion cache, calculating it the first time it is needed.
+// It is usually the same as the hash in the key of this shader module, unless the SPIR-V was converted from GLSL.
+const MVKHash128& MVKShaderModule::getSPIRVHash() {
+	if ( !_hasSPIRVHash ) {
+		_spirvHash = SPIRVToMSLConversionCache::getSPIRVHash(_spvConverter.getSPIRV());
+		_hasSPIRVHash = true;
+	}
+	return _spirvHash;
+}
+
 // Returns the MVKGLSLConversionShaderStage corresponding to the shader stage in the SPIR-V conversion configuration.
 MVKGLSLConversionShaderStage MVKShaderModule::getMVKGLSLConversionShaderStage(SPIRVToMSLConversionConfiguration* pShaderConfig) {
 	switch (pShaderConfig->options.entryPointStage) {
@@ -365,7 +489,7 @@ MVKShaderModule::MVKShaderModule(MVKDevice* device,
 		return;
 	}
 
-	size_t codeHash = 0;
+	MVKHash128 codeHash;
 
 	// Retrieve the magic number to determine what type of shader code has been loaded.
 	// NOTE: Shader code should be submitted as SPIR-V. Although some simple direct MSL shaders may work,
@@ -377,11 +501,15 @@ MVKShaderModule::MVKShaderModule(MVKDevice* device,
 			size_t spvCount = (codeSize + 3) >> 2;			// Round up if byte length not exactly on uint32_t boundary
 
 			uint64_t startTime = _device->getPerformanceTimestamp();
-			codeHash = mvkHash(pCreateInfo->pCode, spvCount);
+			codeHash = mvkHash128(pCreateInfo->pCode, codeSize);
 			_device->addActivityPerformance(_device->_performanceStatistics.shaderCompilation.hashShaderCode, startTime);
 
 			_spvConverter.setSPIRV(pCreateInfo->pCode, spvCount);
 
+			// The shader conversion cache uses the same hash of the SPIR-V code, so retain it.
+			_hasSPIRVHash = (spvCount * sizeof(uint32_t) == codeSize);
+			if (_hasSPIRVHash) { _spirvHash = codeHash; }
+
 			break;
 		}
 		case kMVKMagicNumberMSLSourceCode: {				// MSL source code
@@ -390,8 +518,7 @@ MVKShaderModule::MVKShaderModule(MVKDevice* device,
 			size_t mslCodeLen = codeSize - hdrSize;
 
 			uint64_t startTime = _device->getPerformanceTimestamp();
-			codeHash = mvkHash(&magicNum);
-			codeHash = mvkHash(pMSLCode, mslCodeLen, codeHash);
+			codeHash = mvkHash128(pMSLCode, mslCodeLen, magicNum);
 			_device->addActivityPerformance(_device->_performanceStatistics.shaderCompilation.hashShaderCode, startTime);
 
 			_spvConverter.setMSL(pMSLCode, nullptr);
@@ -405,8 +532,7 @@ MVKShaderModule::MVKShaderModule(MVKDevice* device,
 			size_t mslCodeLen = codeSize - hdrSize;
 
 			uint64_t startTime = _device->getPerformanceTimestamp();
-			codeHash = mvkHash(&magicNum);
-			codeHash = mvkHash(pMSLCode, mslCodeLen, codeHash);
+			codeHash = mvkHash128(pMSLCode, mslCodeLen, magicNum);
 			_device->addActivityPerformance(_device->_performanceStatistics.shaderCompilation.hashShaderCode, startTime);
 
 			_directMSLLibrary = new MVKShaderLibrary(this, (void*)(pMSLCode), mslCodeLen);
@@ -419,7 +545,7 @@ MVKShaderModule::MVKShaderModule(MVKDevice* device,
 				size_t glslLen = codeSize - 1;
 
 				uint64_t startTime = _device->getPerformanceTimestamp();
-				codeHash = mvkHash(pGLSL, codeSize);
+				codeHash = mvkHash128(pGLSL, codeSize);
 				_device->addActivityPerformance(_device->_performanceStatistics.shaderCompilation.hashShaderCode, startTime);
 
 				_glslConverter.setGLSL(pGLSL, glslLen);
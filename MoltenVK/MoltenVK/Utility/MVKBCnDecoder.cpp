@@ -0,0 +1,867 @@
+/*
+ * MVKBCnDecoder.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKBCnDecoder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#	define MVK_BCN_USE_SSE2		1
+#elif defined(__ARM_NEON)
+#	include <arm_neon.h>
+#	define MVK_BCN_USE_NEON		1
+#endif
+
+
+#pragma mark -
+#pragma mark Texels and palettes
+
+// Packs the channels into a texel, whose bytes are stored in memory in B, G, R, A order.
+static inline uint32_t packBGRA(uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+	return b | (g << 8) | (r << 16) | (a << 24);
+}
+
+// Expands an unsigned value of the specified number of bits to 8 bits, by replicating its high bits into the low bits.
+static inline uint32_t expandToUnorm8(uint32_t val, uint32_t bitCount) {
+	val <<= (8 - bitCount);
+	return val | (val >> bitCount);
+}
+
+// Returns the 6-bit interpolation weights of indexes of the specified number of bits, used by BC6H and BC7.
+static const uint8_t* getInterpolationWeights(uint32_t indexBitCount) {
+	static const uint8_t weights2[] = { 0, 21, 43, 64 };
+	static const uint8_t weights3[] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	static const uint8_t weights4[] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+	switch (indexBitCount) {
+		case 2:		return weights2;
+		case 3:		return weights3;
+		default:	return weights4;
+	}
+}
+
+// Fills the palette with an even number of texels, each interpolated between the two endpoint texels,
+// using the corresponding 6-bit weight. Each channel is interpolated as ((64 - w) * e0 + w * e1 + 32) >> 6.
+// Two palette texels are interpolated together, in the 16-bit lanes of a SIMD register, where available.
+static void interpolatePalette(uint32_t e0, uint32_t e1, const uint8_t* pWeights, uint32_t count, uint32_t* pPalette) {
+#if MVK_BCN_USE_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i sixtyFour = _mm_set1_epi16(64);
+	const __m128i half = _mm_set1_epi16(32);
+	__m128i ep0 = _mm_unpacklo_epi8(_mm_set1_epi32((int32_t)e0), zero);
+	__m128i ep1 = _mm_unpacklo_epi8(_mm_set1_epi32((int32_t)e1), zero);
+	for (uint32_t i = 0; i < count; i += 2) {
+		__m128i w1 = _mm_set_epi16(pWeights[i + 1], pWeights[i + 1], pWeights[i + 1], pWeights[i + 1],
+								   pWeights[i], pWeights[i], pWeights[i], pWeights[i]);
+		__m128i w0 = _mm_sub_epi16(sixtyFour, w1);
+		__m128i val = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(ep0, w0), _mm_mullo_epi16(ep1, w1)), half);
+		val = _mm_srli_epi16(val, 6);
+		_mm_storel_epi64((__m128i*)&pPalette[i], _mm_packus_epi16(val, zero));
+	}
+#elif MVK_BCN_USE_NEON
+	const uint16x8_t sixtyFour = vdupq_n_u16(64);
+	uint16x8_t ep0 = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(e0)));
+	uint16x8_t ep1 = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(e1)));
+	for (uint32_t i = 0; i < count; i += 2) {
+		uint16x8_t w1 = vcombine_u16(vdup_n_u16(pWeights[i]), vdup_n_u16(pWeights[i + 1]));
+		uint16x8_t w0 = vsubq_u16(sixtyFour, w1);
+		uint16x8_t val = vmlaq_u16(vmulq_u16(ep0, w0), ep1, w1);
+		vst1_u8((uint8_t*)&pPalette[i], vmovn_u16(vrshrq_n_u16(val, 6)));
+	}
+#else
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t w1 = pWeights[i];
+		uint32_t w0 = 64 - w1;
+		uint32_t texel = 0;
+		for (uint32_t shift = 0; shift < 32; shift += 8) {
+			uint32_t val = ((((e0 >> shift) & 0xFF) * w0 + ((e1 >> shift) & 0xFF) * w1 + 32) >> 6);
+			texel |= val << shift;
+		}
+		pPalette[i] = texel;
+	}
+#endif
+}
+
+// Returns a table that converts 8-bit sRGB values to 8-bit linear values.
+static const uint8_t* getSRGBToLinearTable() {
+	static const struct SRGBToLinearTable {
+		uint8_t values[256];
+		SRGBToLinearTable() {
+			for (uint32_t i = 0; i < 256; i++) {
+				double srgb = i / 255.0;
+				double linear = (srgb <= 0.04045) ? srgb / 12.92 : pow((srgb + 0.055) / 1.055, 2.4);
+				values[i] = (uint8_t)(linear * 255.0 + 0.5);
+			}
+		}
+	} table;
+	return table.values;
+}
+
+// Converts a signed 8-bit value, in the range [-127, 127], to an unsigned normalized 8-bit value, clamping negative values to zero.
+static inline uint32_t snorm8ToUnorm8(int32_t val) {
+	return (val <= 0) ? 0 : (uint32_t)(val * 255 + 63) / 127;
+}
+
+// Converts the bits of a half-float value to an unsigned normalized 8-bit value, clamping to [0, 1].
+static inline uint32_t halfToUnorm8(uint32_t half) {
+	if (half & 0x8000) { return 0; }
+
+	uint32_t exp = (half >> 10) & 0x1F;
+	uint32_t mant = half & 0x3FF;
+	if (exp == 0x1F) { return mant ? 0 : 255; }		// NaN or infinity
+
+	if (exp >= 15) { return 255; }		// One or more
+
+	// Rebias the exponent of a normal half-float value to form the bits of a float. Subnormal values are scaled by 2^-24.
+	float val;
+	if (exp) {
+		uint32_t floatBits = ((exp + 112) << 23) | (mant << 13);
+		memcpy(&val, &floatBits, sizeof(val));
+	} else {
+		val = mant * (1.0f / 16777216.0f);
+	}
+	return (uint32_t)(val * 255.0f + 0.5f);
+}
+
+static inline uint64_t loadUInt64(const uint8_t* pBytes) {
+	uint64_t val;
+	memcpy(&val, pBytes, sizeof(val));
+	return val;
+}
+
+static inline uint16_t loadUInt16(const uint8_t* pBytes) {
+	return pBytes[0] | (pBytes[1] << 8);
+}
+
+
+#pragma mark -
+#pragma mark MVKBCnBitReader
+
+// Reads consecutive fields of bits, starting at the least significant bit of a 128-bit block.
+class MVKBCnBitReader {
+
+public:
+
+	uint32_t read(uint32_t bitCount) {
+		if ( !bitCount ) { return 0; }
+
+		uint64_t bits;
+		if (_bitPos >= 64) {
+			bits = _hi >> (_bitPos - 64);
+		} else if (_bitPos + bitCount <= 64) {
+			bits = _lo >> _bitPos;
+		} else {
+			bits = (_lo >> _bitPos) | (_hi << (64 - _bitPos));
+		}
+		_bitPos += bitCount;
+		return (uint32_t)bits & ((1u << bitCount) - 1);
+	}
+
+	// Reads the bits in reverse order, so the first bit read becomes the most significant bit of the value.
+	uint32_t readReversed(uint32_t bitCount) {
+		uint32_t val = 0;
+		for (uint32_t i = 0; i < bitCount; i++) { val = (val << 1) | read(1); }
+		return val;
+	}
+
+	MVKBCnBitReader(const uint8_t* pBlock) : _lo(loadUInt64(pBlock)), _hi(loadUInt64(pBlock + 8)) {}
+
+protected:
+	uint64_t _lo;
+	uint64_t _hi;
+	uint32_t _bitPos = 0;
+};
+
+
+#pragma mark -
+#pragma mark Partitions
+
+// The partitions of the 4x4 texels of a block into two subsets, used by BC6H and BC7.
+// Each bit of each entry identifies the subset of the corresponding texel.
+static const uint16_t kBC7Partitions2[64] = {
+	0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+	0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+	0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+	0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+	0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+	0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+	0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+	0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+};
+
+// The partitions of the 4x4 texels of a block into three subsets, used by BC7.
+static const uint8_t kBC7Partitions3[64][16] = {
+	{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2 }, { 0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1 },
+	{ 0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1 }, { 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2 }, { 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2 },
+	{ 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1 }, { 0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2 }, { 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2 },
+	{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2 },
+	{ 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2 }, { 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2 },
+	{ 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2 }, { 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0 },
+	{ 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2 }, { 0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0 },
+	{ 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2 }, { 0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1 },
+	{ 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2 }, { 0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1 },
+	{ 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2 }, { 0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0 },
+	{ 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0 }, { 0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2 },
+	{ 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0 }, { 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1 },
+	{ 0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2 }, { 0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2 },
+	{ 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1 }, { 0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1 },
+	{ 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2 }, { 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1 },
+	{ 0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2 }, { 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0 },
+	{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0 }, { 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 },
+	{ 0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0 }, { 0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1 },
+	{ 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1 }, { 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1 }, { 0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2 },
+	{ 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1 }, { 0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1 },
+	{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1 }, { 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1 },
+	{ 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2 }, { 0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1 },
+	{ 0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2 }, { 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2 },
+	{ 0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2 }, { 0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2 },
+	{ 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2 }, { 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2 },
+	{ 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2 },
+	{ 0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2 }, { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2 },
+	{ 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1 }, { 0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2 },
+	{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0 },
+};
+
+// The anchor texel of the second subset of each two-subset partition.
+static const uint8_t kBC7Anchors2[64] = {
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+	15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+	15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+	 6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+};
+
+// The anchor texels of the second and third subsets of each three-subset partition.
+static const uint8_t kBC7Anchors3[2][64] = {
+	{
+		 3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+		 3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+		 8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+		 3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+	}, {
+		15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+		15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+		15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+		15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+	}
+};
+
+// Returns the subset of the texel, within the partition of a block with the specified number of subsets.
+static inline uint32_t getPartitionSubset(uint32_t subsetCount, uint32_t partition, uint32_t texelIdx) {
+	switch (subsetCount) {
+		case 2:		return (kBC7Partitions2[partition] >> texelIdx) & 1;
+		case 3:		return kBC7Partitions3[partition][texelIdx];
+		default:	return 0;
+	}
+}
+
+// Returns whether the texel is the anchor texel of its subset, whose index omits its most significant bit.
+static inline bool isAnchorTexel(uint32_t subsetCount, uint32_t partition, uint32_t subset, uint32_t texelIdx) {
+	switch (subset) {
+		case 0:		return texelIdx == 0;
+		case 1:		return texelIdx == ((subsetCount == 2) ? kBC7Anchors2[partition] : kBC7Anchors3[0][partition]);
+		default:	return texelIdx == kBC7Anchors3[1][partition];
+	}
+}
+
+
+#pragma mark -
+#pragma mark BC1 - BC5
+
+// Expands the 5:6:5 colour to a texel.
+static inline uint32_t unpackRGB565(uint32_t colour) {
+	return packBGRA(expandToUnorm8((colour >> 11) & 0x1F, 5), expandToUnorm8((colour >> 5) & 0x3F, 6), expandToUnorm8(colour & 0x1F, 5), 255);
+}
+
+// Returns a texel whose channels are the weighted average of the channels of the two texels.
+static inline uint32_t blendTexels(uint32_t t0, uint32_t w0, uint32_t t1, uint32_t w1) {
+	uint32_t texel = 0;
+	uint32_t wSum = w0 + w1;
+	for (uint32_t shift = 0; shift < 32; shift += 8) {
+		uint32_t val = (((t0 >> shift) & 0xFF) * w0 + ((t1 >> shift) & 0xFF) * w1 + wSum / 2) / wSum;
+		texel |= val << shift;
+	}
+	return texel;
+}
+
+// Builds the 8-entry palette of unsigned normalized values of a BC3 alpha block or BC4 channel block.
+static void buildBC4Palette(const uint8_t* pSrcBlock, bool isSigned, uint8_t* pPalette) {
+	int32_t vals[8];
+	if (isSigned) {
+		vals[0] = std::max((int8_t)pSrcBlock[0], (int8_t)-127);
+		vals[1] = std::max((int8_t)pSrcBlock[1], (int8_t)-127);
+	} else {
+		vals[0] = pSrcBlock[0];
+		vals[1] = pSrcBlock[1];
+	}
+
+	if (vals[0] > vals[1]) {
+		for (int32_t i = 0; i < 6; i++) {
+			int32_t sum = (6 - i) * vals[0] + (1 + i) * vals[1];
+			vals[i + 2] = (sum + (sum < 0 ? -3 : 3)) / 7;
+		}
+	} else {
+		for (int32_t i = 0; i < 4; i++) {
+			int32_t sum = (4 - i) * vals[0] + (1 + i) * vals[1];
+			vals[i + 2] = (sum + (sum < 0 ? -2 : 2)) / 5;
+		}
+		vals[6] = isSigned ? -127 : 0;
+		vals[7] = isSigned ? 127 : 255;
+	}
+
+	for (uint32_t i = 0; i < 8; i++) {
+		pPalette[i] = isSigned ? snorm8ToUnorm8(vals[i]) : vals[i];
+	}
+}
+
+// Decodes the 16 unsigned normalized values of a BC3 alpha block or BC4 channel block.
+static void decodeBC4Values(const uint8_t* pSrcBlock, bool isSigned, uint8_t* pVals) {
+	uint8_t palette[8];
+	buildBC4Palette(pSrcBlock, isSigned, palette);
+	uint64_t idxBits = loadUInt64(pSrcBlock) >> 16;
+	for (uint32_t i = 0; i < 16; i++) {
+		pVals[i] = palette[(idxBits >> (i * 3)) & 0x7];
+	}
+}
+
+void MVKBCnDecoder::decodeBC1(const uint8_t* pSrcBlock, uint32_t* pTexels, bool isBC1) const {
+	uint32_t colour0 = loadUInt16(pSrcBlock);
+	uint32_t colour1 = loadUInt16(pSrcBlock + 2);
+	uint32_t palette[4];
+	palette[0] = unpackRGB565(colour0);
+	palette[1] = unpackRGB565(colour1);
+	if (isBC1 && colour0 <= colour1) {
+		palette[2] = blendTexels(palette[0], 1, palette[1], 1);
+		palette[3] = (_format == kMVKBCnFormatBC1RGBA) ? 0 : packBGRA(0, 0, 0, 255);
+	} else {
+		palette[2] = blendTexels(palette[0], 2, palette[1], 1);
+		palette[3] = blendTexels(palette[0], 1, palette[1], 2);
+	}
+
+	uint32_t idxBits = (uint32_t)(loadUInt64(pSrcBlock) >> 32);
+	for (uint32_t i = 0; i < 16; i++) {
+		pTexels[i] = palette[(idxBits >> (i * 2)) & 0x3];
+	}
+}
+
+void MVKBCnDecoder::decodeBC2(const uint8_t* pSrcBlock, uint32_t* pTexels) const {
+	decodeBC1(pSrcBlock + 8, pTexels, false);
+	uint64_t alphaBits = loadUInt64(pSrcBlock);
+	for (uint32_t i = 0; i < 16; i++) {
+		uint32_t alpha = ((alphaBits >> (i * 4)) & 0xF) * 17;
+		pTexels[i] = (pTexels[i] & 0x00FFFFFF) | (alpha << 24);
+	}
+}
+
+void MVKBCnDecoder::decodeBC3(const uint8_t* pSrcBlock, uint32_t* pTexels) const {
+	decodeBC1(pSrcBlock + 8, pTexels, false);
+	uint8_t alphas[16];
+	decodeBC4Values(pSrcBlock, false, alphas);
+	for (uint32_t i = 0; i < 16; i++) {
+		pTexels[i] = (pTexels[i] & 0x00FFFFFF) | ((uint32_t)alphas[i] << 24);
+	}
+}
+
+void MVKBCnDecoder::decodeBC4(const uint8_t* pSrcBlock, uint32_t* pTexels) const {
+	uint8_t reds[16];
+	decodeBC4Values(pSrcBlock, _format == kMVKBCnFormatBC4Snorm, reds);
+	for (uint32_t i = 0; i < 16; i++) {
+		pTexels[i] = packBGRA(reds[i], 0, 0, 255);
+	}
+}
+
+void MVKBCnDecoder::decodeBC5(const uint8_t* pSrcBlock, uint32_t* pTexels) const {
+	bool isSigned = (_format == kMVKBCnFormatBC5Snorm);
+	uint8_t reds[16];
+	uint8_t greens[16];
+	decodeBC4Values(pSrcBlock, isSigned, reds);
+	decodeBC4Values(pSrcBlock + 8, isSigned, greens);
+	for (uint32_t i = 0; i < 16; i++) {
+		pTexels[i] = packBGRA(reds[i], greens[i], 0, 255);
+	}
+}
+
+
+#pragma mark -
+#pragma mark BC6H
+
+// The fields of a BC6H block header. The endpoints of each channel are identified as
+// W and X, for the first subset, and Y and Z, for the second subset, in that order.
+typedef enum : uint8_t {
+	kBC6HRW, kBC6HRX, kBC6HRY, kBC6HRZ,
+	kBC6HGW, kBC6HGX, kBC6HGY, kBC6HGZ,
+	kBC6HBW, kBC6HBX, kBC6HBY, kBC6HBZ,
+	kBC6HPartition,
+	kBC6HFieldCount
+} MVKBC6HField;
+
+// Identifies a run of consecutive bits of a header field, ending with a run whose bit count is zero.
+// If isReversed is true, the bits appear in the block in order from most significant to least significant.
+typedef struct {
+	uint8_t field;
+	uint8_t firstBit;
+	uint8_t bitCount;
+	bool isReversed;
+} MVKBC6HBitRun;
+
+typedef struct {
+	uint8_t subsetCount;
+	bool isTransformed;
+	uint8_t endpointBits;
+	uint8_t deltaBits[3];
+	MVKBC6HBitRun bitRuns[32];
+} MVKBC6HMode;
+
+#define MVK_BC6H_RUN(fld, bit, cnt)		{ kBC6H##fld, bit, cnt, false }
+#define MVK_BC6H_RUN_REV(fld, bit, cnt)	{ kBC6H##fld, bit, cnt, true }
+#define MVK_BC6H_PARTITION				{ kBC6HPartition, 0, 5, false }
+
+// The header layout of each BC6H mode, following its mode bits.
+static const MVKBC6HMode kBC6HModes[14] = {
+	{ 2, true, 10, { 5, 5, 5 }, {
+		MVK_BC6H_RUN(GY, 4, 1), MVK_BC6H_RUN(BY, 4, 1), MVK_BC6H_RUN(BZ, 4, 1), MVK_BC6H_RUN(RW, 0, 10),
+		MVK_BC6H_RUN(GW, 0, 10), MVK_BC6H_RUN(BW, 0, 10), MVK_BC6H_RUN(RX, 0, 5), MVK_BC6H_RUN(GZ, 4, 1),
+		MVK_BC6H_RUN(GY, 0, 4), MVK_BC6H_RUN(GX, 0, 5), MVK_BC6H_RUN(BZ, 0, 1), MVK_BC6H_RUN(GZ, 0, 4),
+		MVK_BC6H_RUN(BX, 0, 5), MVK_BC6H_RUN(BZ, 1, 1), MVK_BC6H_RUN(BY, 0, 4), MVK_BC6H_RUN(RY, 0, 5),
+		MVK_BC6H_RUN(BZ, 2, 1), MVK_BC6H_RUN(RZ, 0, 5), MVK_BC6H_RUN(BZ, 3, 1), MVK_BC6H_PARTITION } },
+	{ 2, true, 7, { 6, 6, 6 }, {
+		MVK_BC6H_RUN(GY, 5, 1), MVK_BC6H_RUN(GZ, 4, 2), MVK_BC6H_RUN(RW, 0, 7), MVK_BC6H_RUN(BZ, 0, 2),
+		MVK_BC6H_RUN(BY, 4, 1), MVK_BC6H_RUN(GW, 0, 7), MVK_BC6H_RUN(BY, 5, 1), MVK_BC6H_RUN(BZ, 2, 1),
+		MVK_BC6H_RUN(GY, 4, 1), MVK_BC6H_RUN(BW, 0, 7), MVK_BC6H_RUN(BZ, 3, 1), MVK_BC6H_RUN(BZ, 5, 1),
+		MVK_BC6H_RUN(BZ, 4, 1), MVK_BC6H_RUN(RX, 0, 6), MVK_BC6H_RUN(GY, 0, 4), MVK_BC6H_RUN(GX, 0, 6),
+		MVK_BC6H_RUN(GZ, 0, 4), MVK_BC6H_RUN(BX, 0, 6), MVK_BC6H_RUN(BY, 0, 4), MVK_BC6H_RUN(RY, 0, 6),
+		MVK_BC6H_RUN(RZ, 0, 6), MVK_BC6H_PARTITION } },
+	{ 2, true, 11, { 5, 4, 4 }, {
+		MVK_BC6H_RUN(RW, 0, 10), MVK_BC6H_RUN(GW, 0, 10), MVK_BC6H_RUN(BW, 0, 10), MVK_BC6H_RUN(RX, 0, 5),
+		MVK_BC6H_RUN(RW, 10, 1), MVK_BC6H_RUN(GY, 0, 4), MVK_BC6H_RUN(GX, 0, 4), MVK_BC6H_RUN(GW, 10, 1),
+		MVK_BC6H_RUN(BZ, 0, 1), MVK_BC6H_RUN(GZ, 0, 4), MVK_BC6H_RUN(BX, 0, 4), MVK_BC6H_RUN(BW, 10, 1),
+		MVK_BC6H_RUN(BZ, 1, 1), MVK_BC6H_RUN(BY, 0, 4), MVK_BC6H_RUN(RY, 0, 5), MVK_BC6H_RUN(BZ, 2, 1),
+		MVK_BC6H_RUN(RZ, 0, 5), MVK_BC6H_RUN(BZ, 3, 1), MVK_BC6H_PARTITION } },
+	{ 2, true, 11, { 4, 5, 4 }, {
+		MVK_BC6H_RUN(RW, 0, 10), MVK_BC6H_RUN(GW, 0, 10), MVK_BC6H_RUN(BW, 0, 10), MVK_BC6H_RUN(RX, 0, 4),
+		MVK_BC6H_RUN(RW, 10, 1), MVK_BC6H_RUN(GZ, 4, 1), MVK_BC6H_RUN(GY, 0, 4), MVK_BC6H_RUN(GX, 0, 5),
+		MVK_BC6H_RUN(GW, 10, 1), MVK_BC6H_RUN(GZ, 0, 4), MVK_BC6H_RUN(BX, 0, 4), MVK_BC6H_RUN(BW, 10, 1),
+		MVK_BC6H_RUN(BZ, 1, 1), MVK_BC6H_RUN(BY, 0, 4), MVK_BC6H_RUN(RY, 0, 4), MVK_BC6H_RUN(BZ, 0, 1),
+		MVK_BC6H_RUN(BZ, 2, 1), MVK_BC6H_RUN(RZ, 0, 4), MVK_BC6H_RUN(GY, 4, 1), MVK_BC6H_RUN(BZ, 3, 1),
+		MVK_BC6H_PARTITION } },
+	{ 2, true, 11, { 4, 4, 5 }, {
+		MVK_BC6H_RUN(RW, 0, 10), MVK_BC6H_RUN(GW, 0, 10), MVK_BC6H_RUN(BW, 0, 10), MVK_BC6H_RUN(RX, 0, 4),
+		MVK_BC6H_RUN(RW, 10, 1), MVK_BC6H_RUN(BY, 4, 1), MVK_BC6H_RUN(GY, 0, 4), MVK_BC6H_RUN(GX, 0, 4),
+		MVK_BC6H_RUN(GW, 10, 1), MVK_BC6H_RUN(BZ, 0, 1), MVK_BC6H_RUN(GZ, 0, 4), MVK_BC6H_RUN(BX, 0, 5),
+		MVK_BC6H_RUN(BW, 10, 1), MVK_BC6H_RUN(BY, 0, 4), MVK_BC6H_RUN(RY, 0, 4), MVK_BC6H_RUN(BZ, 1, 2),
+		MVK_BC6H_RUN(RZ, 0, 4), MVK_BC6H_RUN(BZ, 4, 1), MVK_BC6H_RUN(BZ, 3, 1), MVK_BC6H_PARTITION } },
+	{ 2, true, 9, { 5, 5, 5 }, {
+		MVK_BC6H_RUN(RW, 0, 9), MVK_BC6H_RUN(BY, 4, 1), MVK_BC6H_RUN(GW, 0, 9), MVK_BC6H_RUN(GY, 4, 1),
+		MVK_BC6H_RUN(BW, 0, 9), MVK_BC6H_RUN(BZ, 4, 1), MVK_BC6H_RUN(RX, 0, 5), MVK_BC6H_RUN(GZ, 4, 1),
+		MVK_BC6H_RUN(GY, 0, 4), MVK_BC6H_RUN(GX, 0, 5), MVK_BC6H_RUN(BZ, 0, 1), MVK_BC6H_RUN(GZ, 0, 4),
+		MVK_BC6H_RUN(BX, 0, 5), MVK_BC6H_RUN(BZ, 1, 1), MVK_BC6H_RUN(BY, 0, 4), MVK_BC6H_RUN(RY, 0, 5),
+		MVK_BC6H_RUN(BZ, 2, 1), MVK_BC6H_RUN(RZ, 0, 5), MVK_BC6H_RUN(BZ, 3, 1), MVK_BC6H_PARTITION } },
+	{ 2, true, 8, { 6, 5, 5 }, {
+		MVK_BC6H_RUN(RW, 0, 8), MVK_BC6H_RUN(GZ, 4, 1), MVK_BC6H_RUN(BY, 4, 1), MVK_BC6H_RUN(GW, 0, 8),
+		MVK_BC6H_RUN(BZ, 2, 1), MVK_BC6H_RUN(GY, 4, 1), MVK_BC6H_RUN(BW, 0, 8), MVK_BC6H_RUN(BZ, 3, 2),
+		MVK_BC6H_RUN(RX, 0, 6), MVK_BC6H_RUN(GY, 0, 4), MVK_BC6H_RUN(GX, 0, 5), MVK_BC6H_RUN(BZ, 0, 1),
+		MVK_BC6H_RUN(GZ, 0, 4), MVK_BC6H_RUN(BX, 0, 5), MVK_BC6H_RUN(BZ, 1, 1), MVK_BC6H_RUN(BY, 0, 4),
+		MVK_BC6H_RUN(RY, 0, 6), MVK_BC6H_RUN(RZ, 0, 6), MVK_BC6H_PARTITION } },
+	{ 2, true, 8, { 5, 6, 5 }, {
+		MVK_BC6H_RUN(RW, 0, 8), MVK_BC6H_RUN(BZ, 0, 1), MVK_BC6H_RUN(BY, 4, 1), MVK_BC6H_RUN(GW, 0, 8),
+		MVK_BC6H_RUN(GY, 5, 1), MVK_BC6H_RUN(GY, 4, 1), MVK_BC6H_RUN(BW, 0, 8), MVK_BC6H_RUN(GZ, 5, 1),
+		MVK_BC6H_RUN(BZ, 4, 1), MVK_BC6H_RUN(RX, 0, 5), MVK_BC6H_RUN(GZ, 4, 1), MVK_BC6H_RUN(GY, 0, 4),
+		MVK_BC6H_RUN(GX, 0, 6), MVK_BC6H_RUN(GZ, 0, 4), MVK_BC6H_RUN(BX, 0, 5), MVK_BC6H_RUN(BZ, 1, 1),
+		MVK_BC6H_RUN(BY, 0, 4), MVK_BC6H_RUN(RY, 0, 5), MVK_BC6H_RUN(BZ, 2, 1), MVK_BC6H_RUN(RZ, 0, 5),
+		MVK_BC6H_RUN(BZ, 3, 1), MVK_BC6H_PARTITION } },
+	{ 2, true, 8, { 5, 5, 6 }, {
+		MVK_BC6H_RUN(RW, 0, 8), MVK_BC6H_RUN(BZ, 1, 1), MVK_BC6H_RUN(BY, 4, 1), MVK_BC6H_RUN(GW, 0, 8),
+		MVK_BC6H_RUN(BY, 5, 1), MVK_BC6H_RUN(GY, 4, 1), MVK_BC6H_RUN(BW, 0, 8), MVK_BC6H_RUN(BZ, 5, 1),
+		MVK_BC6H_RUN(BZ, 4, 1), MVK_BC6H_RUN(RX, 0, 5), MVK_BC6H_RUN(GZ, 4, 1), MVK_BC6H_RUN(GY, 0, 4),
+		MVK_BC6H_RUN(GX, 0, 5), MVK_BC6H_RUN(BZ, 0, 1), MVK_BC6H_RUN(GZ, 0, 4), MVK_BC6H_RUN(BX, 0, 6),
+		MVK_BC6H_RUN(BY, 0, 4), MVK_BC6H_RUN(RY, 0, 5), MVK_BC6H_RUN(BZ, 2, 1), MVK_BC6H_RUN(RZ, 0, 5),
+		MVK_BC6H_RUN(BZ, 3, 1), MVK_BC6H_PARTITION } },
+	{ 2, false, 6, { 6, 6, 6 }, {
+		MVK_BC6H_RUN(RW, 0, 6), MVK_BC6H_RUN(GZ, 4, 1), MVK_BC6H_RUN(BZ, 0, 2), MVK_BC6H_RUN(BY, 4, 1),
+		MVK_BC6H_RUN(GW, 0, 6), MVK_BC6H_RUN(GY, 5, 1), MVK_BC6H_RUN(BY, 5, 1), MVK_BC6H_RUN(BZ, 2, 1),
+		MVK_BC6H_RUN(GY, 4, 1), MVK_BC6H_RUN(BW, 0, 6), MVK_BC6H_RUN(GZ, 5, 1), MVK_BC6H_RUN(BZ, 3, 1),
+		MVK_BC6H_RUN(BZ, 5, 1), MVK_BC6H_RUN(BZ, 4, 1), MVK_BC6H_RUN(RX, 0, 6), MVK_BC6H_RUN(GY, 0, 4),
+		MVK_BC6H_RUN(GX, 0, 6), MVK_BC6H_RUN(GZ, 0, 4), MVK_BC6H_RUN(BX, 0, 6), MVK_BC6H_RUN(BY, 0, 4),
+		MVK_BC6H_RUN(RY, 0, 6), MVK_BC6H_RUN(RZ, 0, 6), MVK_BC6H_PARTITION } },
+	{ 1, false, 10, { 10, 10, 10 }, {
+		MVK_BC6H_RUN(RW, 0, 10), MVK_BC6H_RUN(GW, 0, 10), MVK_BC6H_RUN(BW, 0, 10),
+		MVK_BC6H_RUN(RX, 0, 10), MVK_BC6H_RUN(GX, 0, 10), MVK_BC6H_RUN(BX, 0, 10) } },
+	{ 1, true, 11, { 9, 9, 9 }, {
+		MVK_BC6H_RUN(RW, 0, 10), MVK_BC6H_RUN(GW, 0, 10), MVK_BC6H_RUN(BW, 0, 10),
+		MVK_BC6H_RUN(RX, 0, 9), MVK_BC6H_RUN(RW, 10, 1), MVK_BC6H_RUN(GX, 0, 9), MVK_BC6H_RUN(GW, 10, 1),
+		MVK_BC6H_RUN(BX, 0, 9), MVK_BC6H_RUN(BW, 10, 1) } },
+	{ 1, true, 12, { 8, 8, 8 }, {
+		MVK_BC6H_RUN(RW, 0, 10), MVK_BC6H_RUN(GW, 0, 10), MVK_BC6H_RUN(BW, 0, 10),
+		MVK_BC6H_RUN(RX, 0, 8), MVK_BC6H_RUN_REV(RW, 10, 2), MVK_BC6H_RUN(GX, 0, 8), MVK_BC6H_RUN_REV(GW, 10, 2),
+		MVK_BC6H_RUN(BX, 0, 8), MVK_BC6H_RUN_REV(BW, 10, 2) } },
+	{ 1, true, 16, { 4, 4, 4 }, {
+		MVK_BC6H_RUN(RW, 0, 10), MVK_BC6H_RUN(GW, 0, 10), MVK_BC6H_RUN(BW, 0, 10),
+		MVK_BC6H_RUN(RX, 0, 4), MVK_BC6H_RUN_REV(RW, 10, 6), MVK_BC6H_RUN(GX, 0, 4), MVK_BC6H_RUN_REV(GW, 10, 6),
+		MVK_BC6H_RUN(BX, 0, 4), MVK_BC6H_RUN_REV(BW, 10, 6) } },
+};
+
+// Returns the index into kBC6HModes of the mode identified by the mode bits at the start of the block, or -1 if the mode is reserved.
+static int32_t readBC6HMode(MVKBCnBitReader& bits) {
+	uint32_t modeBits = bits.read(2);
+	if (modeBits < 2) { return modeBits; }
+
+	modeBits |= bits.read(3) << 2;
+	switch (modeBits) {
+		case 0x02:	return 2;
+		case 0x06:	return 3;
+		case 0x0A:	return 4;
+		case 0x0E:	return 5;
+		case 0x12:	return 6;
+		case 0x16:	return 7;
+		case 0x1A:	return 8;
+		case 0x1E:	return 9;
+		case 0x03:	return 10;
+		case 0x07:	return 11;
+		case 0x0B:	return 12;
+		case 0x0F:	return 13;
+		default:	return -1;
+	}
+}
+
+static inline int32_t signExtend(int32_t val, uint32_t bitCount) {
+	uint32_t shift = 32 - bitCount;
+	return (int32_t)((uint32_t)val << shift) >> shift;
+}
+
+// Unquantizes an endpoint channel value of the specified number of bits to 16 bits.
+static int32_t unquantizeBC6HEndpoint(int32_t val, uint32_t bitCount, bool isSigned) {
+	if (isSigned) {
+		if (bitCount >= 16) { return val; }
+		bool isNegative = val < 0;
+		if (isNegative) { val = -val; }
+		if (val == 0) {
+			// Remains zero
+		} else if (val >= ((1 << (bitCount - 1)) - 1)) {
+			val = 0x7FFF;
+		} else {
+			val = ((val << 15) + 0x4000) >> (bitCount - 1);
+		}
+		return isNegative ? -val : val;
+	} else {
+		if (bitCount >= 15) { return val; }
+		if (val == 0) { return 0; }
+		if (val == ((1 << bitCount) - 1)) { return 0xFFFF; }
+		return ((val << 16) + 0x8000) >> bitCount;
+	}
+}
+
+// Scales an interpolated channel value to the bits of a half-float value.
+static inline uint32_t finishUnquantizeBC6H(int32_t val, bool isSigned) {
+	if ( !isSigned ) { return (uint32_t)(val * 31) >> 6; }
+	return (val < 0) ? (0x8000 | (uint32_t)(((-val) * 31) >> 5)) : (uint32_t)((val * 31) >> 5);
+}
+
+void MVKBCnDecoder::decodeBC6H(const uint8_t* pSrcBlock, uint32_t* pTexels) const {
+	MVKBCnBitReader bits(pSrcBlock);
+	int32_t modeIdx = readBC6HMode(bits);
+	if (modeIdx < 0) {
+		for (uint32_t i = 0; i < 16; i++) { pTexels[i] = packBGRA(0, 0, 0, 255); }
+		return;
+	}
+
+	const MVKBC6HMode& mode = kBC6HModes[modeIdx];
+	int32_t fields[kBC6HFieldCount] = {};
+	for (const MVKBC6HBitRun* pRun = mode.bitRuns; pRun->bitCount; pRun++) {
+		uint32_t val = pRun->isReversed ? bits.readReversed(pRun->bitCount) : bits.read(pRun->bitCount);
+		fields[pRun->field] |= val << pRun->firstBit;
+	}
+
+	// Recover the endpoints of each channel, which may be encoded as deltas from the first endpoint.
+	bool isSigned = (_format == kMVKBCnFormatBC6HSfloat);
+	uint32_t epCnt = mode.subsetCount * 2;
+	uint32_t epMask = (1u << mode.endpointBits) - 1;
+	int32_t endpoints[4][3];
+	for (uint32_t c = 0; c < 3; c++) {
+		int32_t* pChanFields = &fields[c * 4];
+		if (isSigned) { pChanFields[0] = signExtend(pChanFields[0], mode.endpointBits); }
+		for (uint32_t e = 1; e < epCnt; e++) {
+			if (mode.isTransformed || isSigned) { pChanFields[e] = signExtend(pChanFields[e], mode.deltaBits[c]); }
+			if (mode.isTransformed) {
+				pChanFields[e] = (pChanFields[0] + pChanFields[e]) & epMask;
+				if (isSigned) { pChanFields[e] = signExtend(pChanFields[e], mode.endpointBits); }
+			}
+		}
+		for (uint32_t e = 0; e < epCnt; e++) {
+			endpoints[e][c] = unquantizeBC6HEndpoint(pChanFields[e], mode.endpointBits, isSigned);
+		}
+	}
+
+	// Build a palette for each subset, and select a palette texel for each texel using its index.
+	uint32_t partition = fields[kBC6HPartition];
+	uint32_t idxBitCnt = (mode.subsetCount == 2) ? 3 : 4;
+	uint32_t palSize = 1u << idxBitCnt;
+	const uint8_t* pWeights = getInterpolationWeights(idxBitCnt);
+	uint32_t palettes[2][16];
+	for (uint32_t s = 0; s < mode.subsetCount; s++) {
+		for (uint32_t i = 0; i < palSize; i++) {
+			int32_t w1 = pWeights[i];
+			int32_t w0 = 64 - w1;
+			uint32_t chans[3];
+			for (uint32_t c = 0; c < 3; c++) {
+				int32_t val = (endpoints[s * 2][c] * w0 + endpoints[s * 2 + 1][c] * w1 + 32) >> 6;
+				chans[c] = halfToUnorm8(finishUnquantizeBC6H(val, isSigned));
+			}
+			palettes[s][i] = packBGRA(chans[0], chans[1], chans[2], 255);
+		}
+	}
+
+	for (uint32_t i = 0; i < 16; i++) {
+		uint32_t subset = getPartitionSubset(mode.subsetCount, partition, i);
+		uint32_t idx = bits.read(idxBitCnt - (isAnchorTexel(mode.subsetCount, partition, subset, i) ? 1 : 0));
+		pTexels[i] = palettes[subset][idx];
+	}
+}
+
+
+#pragma mark -
+#pragma mark BC7
+
+typedef struct {
+	uint8_t subsetCount;
+	uint8_t partitionBits;
+	uint8_t rotationBits;
+	uint8_t indexSelectionBits;
+	uint8_t colourBits;
+	uint8_t alphaBits;
+	uint8_t endpointPBits;
+	uint8_t sharedPBits;
+	uint8_t indexBits;
+	uint8_t secondaryIndexBits;
+} MVKBC7Mode;
+
+static const MVKBC7Mode kBC7Modes[8] = {
+	{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+	{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+	{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+	{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+	{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+	{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+	{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+	{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+};
+
+void MVKBCnDecoder::decodeBC7(const uint8_t* pSrcBlock, uint32_t* pTexels) const {
+	// The mode is identified by the position of the lowest set bit in the first byte.
+	uint32_t modeIdx = 0;
+	while (modeIdx < 8 && !(pSrcBlock[0] & (1 << modeIdx))) { modeIdx++; }
+	if (modeIdx == 8) {
+		memset(pTexels, 0, 16 * sizeof(uint32_t));
+		return;
+	}
+
+	const MVKBC7Mode& mode = kBC7Modes[modeIdx];
+	MVKBCnBitReader bits(pSrcBlock);
+	bits.read(modeIdx + 1);
+	uint32_t partition = bits.read(mode.partitionBits);
+	uint32_t rotation = bits.read(mode.rotationBits);
+	uint32_t idxSelection = bits.read(mode.indexSelectionBits);
+
+	// Read the endpoints, in R, G, B, A order, then apply any P-bits and expand each channel to 8 bits.
+	uint32_t epCnt = mode.subsetCount * 2;
+	uint32_t endpoints[6][4];
+	for (uint32_t c = 0; c < 3; c++) {
+		for (uint32_t e = 0; e < epCnt; e++) { endpoints[e][c] = bits.read(mode.colourBits); }
+	}
+	for (uint32_t e = 0; e < epCnt; e++) { endpoints[e][3] = bits.read(mode.alphaBits); }
+
+	uint32_t pBits[6] = {};
+	uint32_t pBitCnt = 0;
+	if (mode.endpointPBits) {
+		for (uint32_t e = 0; e < epCnt; e++) { pBits[e] = bits.read(1); }
+		pBitCnt = 1;
+	} else if (mode.sharedPBits) {
+		for (uint32_t s = 0; s < mode.subsetCount; s++) { pBits[s * 2] = pBits[s * 2 + 1] = bits.read(1); }
+		pBitCnt = 1;
+	}
+
+	uint32_t colourBitCnt = mode.colourBits + pBitCnt;
+	uint32_t alphaBitCnt = mode.alphaBits ? mode.alphaBits + pBitCnt : 0;
+	uint32_t epTexels[6];
+	for (uint32_t e = 0; e < epCnt; e++) {
+		uint32_t* pEP = endpoints[e];
+		for (uint32_t c = 0; c < 3; c++) {
+			pEP[c] = expandToUnorm8((pEP[c] << pBitCnt) | pBits[e], colourBitCnt);
+		}
+		pEP[3] = alphaBitCnt ? expandToUnorm8((pEP[3] << pBitCnt) | pBits[e], alphaBitCnt) : 255;
+		epTexels[e] = packBGRA(pEP[0], pEP[1], pEP[2], pEP[3]);
+	}
+
+	// Read the primary, and any secondary, index of each texel.
+	uint8_t subsets[16];
+	uint8_t indexes[16];
+	uint8_t secondaryIndexes[16];
+	for (uint32_t i = 0; i < 16; i++) {
+		subsets[i] = getPartitionSubset(mode.subsetCount, partition, i);
+		bool isAnchor = isAnchorTexel(mode.subsetCount, partition, subsets[i], i);
+		indexes[i] = bits.read(mode.indexBits - (isAnchor ? 1 : 0));
+	}
+	if (mode.secondaryIndexBits) {
+		for (uint32_t i = 0; i < 16; i++) {
+			secondaryIndexes[i] = bits.read(mode.secondaryIndexBits - (i == 0 ? 1 : 0));
+		}
+	}
+
+	if ( !mode.secondaryIndexBits ) {
+		uint32_t palSize = 1u << mode.indexBits;
+		const uint8_t* pWeights = getInterpolationWeights(mode.indexBits);
+		uint32_t palettes[3][16];
+		for (uint32_t s = 0; s < mode.subsetCount; s++) {
+			interpolatePalette(epTexels[s * 2], epTexels[s * 2 + 1], pWeights, palSize, palettes[s]);
+		}
+		for (uint32_t i = 0; i < 16; i++) { pTexels[i] = palettes[subsets[i]][indexes[i]]; }
+	} else {
+		// Colour and alpha are interpolated separately, using different indexes.
+		uint32_t colourIdxBits = idxSelection ? mode.secondaryIndexBits : mode.indexBits;
+		uint32_t alphaIdxBits = idxSelection ? mode.indexBits : mode.secondaryIndexBits;
+		const uint8_t* pColourIndexes = idxSelection ? secondaryIndexes : indexes;
+		const uint8_t* pAlphaIndexes = idxSelection ? indexes : secondaryIndexes;
+		uint32_t colourPalette[16];
+		uint32_t alphaPalette[16];
+		interpolatePalette(epTexels[0], epTexels[1], getInterpolationWeights(colourIdxBits), 1u << colourIdxBits, colourPalette);
+		interpolatePalette(epTexels[0], epTexels[1], getInterpolationWeights(alphaIdxBits), 1u << alphaIdxBits, alphaPalette);
+		for (uint32_t i = 0; i < 16; i++) {
+			pTexels[i] = (colourPalette[pColourIndexes[i]] & 0x00FFFFFF) | (alphaPalette[pAlphaIndexes[i]] & 0xFF000000);
+		}
+	}
+
+	// Rotation swaps alpha with one of the colour channels.
+	if (rotation) {
+		static const uint32_t colourShifts[] = { 0, 16, 8, 0 };		// Swaps A with R, G, or B
+		uint32_t shift = colourShifts[rotation];
+		for (uint32_t i = 0; i < 16; i++) {
+			uint32_t texel = pTexels[i];
+			uint32_t alpha = texel >> 24;
+			uint32_t colour = (texel >> shift) & 0xFF;
+			pTexels[i] = (texel & ~(0xFFu << shift) & 0x00FFFFFF) | (alpha << shift) | (colour << 24);
+		}
+	}
+}
+
+
+#pragma mark -
+#pragma mark MVKBCnDecoder
+
+size_t MVKBCnDecoder::getBlockByteCount() const {
+	switch (_format) {
+		case kMVKBCnFormatBC1RGB:
+		case kMVKBCnFormatBC1RGBA:
+		case kMVKBCnFormatBC4Unorm:
+		case kMVKBCnFormatBC4Snorm:
+			return 8;
+		default:
+			return 16;
+	}
+}
+
+void MVKBCnDecoder::decodeBlock(const uint8_t* pSrcBlock, uint32_t* pTexels) const {
+	switch (_format) {
+		case kMVKBCnFormatBC1RGB:
+		case kMVKBCnFormatBC1RGBA:		decodeBC1(pSrcBlock, pTexels, true);	break;
+		case kMVKBCnFormatBC2:			decodeBC2(pSrcBlock, pTexels);			break;
+		case kMVKBCnFormatBC3:			decodeBC3(pSrcBlock, pTexels);			break;
+		case kMVKBCnFormatBC4Unorm:
+		case kMVKBCnFormatBC4Snorm:		decodeBC4(pSrcBlock, pTexels);			break;
+		case kMVKBCnFormatBC5Unorm:
+		case kMVKBCnFormatBC5Snorm:		decodeBC5(pSrcBlock, pTexels);			break;
+		case kMVKBCnFormatBC6HUfloat:
+		case kMVKBCnFormatBC6HSfloat:	decodeBC6H(pSrcBlock, pTexels);			break;
+		case kMVKBCnFormatBC7:			decodeBC7(pSrcBlock, pTexels);			break;
+	}
+	if (_isSRGB) { convertFromSRGB(pTexels, 16); }
+}
+
+// Converts the colour channels of the texels from sRGB to linear, leaving alpha unchanged.
+void MVKBCnDecoder::convertFromSRGB(uint32_t* pTexels, uint32_t count) const {
+	const uint8_t* pTable = getSRGBToLinearTable();
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t texel = pTexels[i];
+		pTexels[i] = (pTable[texel & 0xFF] | (pTable[(texel >> 8) & 0xFF] << 8) |
+					  (pTable[(texel >> 16) & 0xFF] << 16) | (texel & 0xFF000000));
+	}
+}
+
+// Decodes one row of blocks, of the specified width in texels, and of up to four rows of texels.
+void MVKBCnDecoder::decodeBlockRow(uint8_t* pDestRow, size_t destRowPitch, const uint8_t* pSrcRow, uint32_t width, uint32_t height) const {
+	size_t blockByteCnt = getBlockByteCount();
+	uint32_t texelRowCnt = std::min(height, 4u);
+	uint32_t texels[16];
+	for (uint32_t x = 0; x < width; x += 4) {
+		decodeBlock(pSrcRow, texels);
+		size_t texelRowByteCnt = std::min(width - x, 4u) * sizeof(uint32_t);
+		uint8_t* pDestBlock = pDestRow + x * sizeof(uint32_t);
+		for (uint32_t y = 0; y < texelRowCnt; y++) {
+			memcpy(pDestBlock + y * destRowPitch, &texels[y * 4], texelRowByteCnt);
+		}
+		pSrcRow += blockByteCnt;
+	}
+}
+
+// The number of rows of blocks claimed by a decoding thread at a time.
+static constexpr size_t kMVKBCnBlockRowsPerClaim = 4;
+
+void MVKBCnDecoder::decode(void* pDest, size_t destRowPitch, size_t destDepthPitch,
+						   const void* pSrc, size_t srcRowPitch, size_t srcDepthPitch,
+						   uint32_t width, uint32_t height, uint32_t depth, uint32_t threadCount) const {
+	size_t blockRowsPerSlice = (height + 3) / 4;
+	size_t blockRowCnt = blockRowsPerSlice * depth;
+
+	std::atomic<size_t> nextBlockRowIdx(0);
+	auto decodeBlockRows = [&]() {
+		size_t firstRowIdx;
+		while ((firstRowIdx = nextBlockRowIdx.fetch_add(kMVKBCnBlockRowsPerClaim)) < blockRowCnt) {
+			size_t endRowIdx = std::min(firstRowIdx + kMVKBCnBlockRowsPerClaim, blockRowCnt);
+			for (size_t rowIdx = firstRowIdx; rowIdx < endRowIdx; rowIdx++) {
+				size_t z = rowIdx / blockRowsPerSlice;
+				uint32_t y = (uint32_t)(rowIdx % blockRowsPerSlice) * 4;
+				decodeBlockRow((uint8_t*)pDest + z * destDepthPitch + y * destRowPitch, destRowPitch,
+							   (const uint8_t*)pSrc + z * srcDepthPitch + (y / 4) * srcRowPitch,
+							   width, height - y);
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	size_t claimCnt = (blockRowCnt + kMVKBCnBlockRowsPerClaim - 1) / kMVKBCnBlockRowsPerClaim;
+	size_t thrdCnt = std::min<size_t>(threadCount, claimCnt);
+	for (size_t thrdIdx = 1; thrdIdx < thrdCnt; thrdIdx++) { workers.emplace_back(decodeBlockRows); }
+	decodeBlockRows();
+	for (auto& worker : workers) { worker.join(); }
+}
+
+// The minimum number of bytes of compressed data that warrants decoding on an additional thread.
+static constexpr size_t kMVKBCnMinBytesPerThread = 256 * 1024;
+
+uint32_t MVKBCnDecoder::getThreadCount(size_t srcByteCount) {
+	uint32_t procCnt = std::max(std::thread::hardware_concurrency(), 1u);
+	size_t thrdCnt = std::max<size_t>(srcByteCount / kMVKBCnMinBytesPerThread, 1);
+	return (uint32_t)std::min<size_t>(thrdCnt, procCnt);
+}
+
+MVKBCnDecoder::MVKBCnDecoder(MVKBCnFormat format, bool isSRGB) : _format(format), _isSRGB(isSRGB) {}
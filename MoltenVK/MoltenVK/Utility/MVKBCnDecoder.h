@@ -0,0 +1,105 @@
+/*
+ * MVKBCnDecoder.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// The contents of this file do not depend on Metal, Vulkan, or on other MoltenVK classes,
+// so that the decoding of block-compressed texture data can be exercised on any platform.
+
+
+#pragma mark -
+#pragma mark MVKBCnFormat
+
+/** Identifies the layout of the 4x4 texel blocks of block-compressed (BCn) texture data. */
+typedef enum : uint8_t {
+	kMVKBCnFormatBC1RGB = 0,	/**< BC1 blocks, without alpha. */
+	kMVKBCnFormatBC1RGBA,		/**< BC1 blocks, with 1-bit alpha. */
+	kMVKBCnFormatBC2,			/**< BC2 blocks, with explicit 4-bit alpha. */
+	kMVKBCnFormatBC3,			/**< BC3 blocks, with interpolated alpha. */
+	kMVKBCnFormatBC4Unorm,		/**< BC4 blocks, with one unsigned normalized channel. */
+	kMVKBCnFormatBC4Snorm,		/**< BC4 blocks, with one signed normalized channel. */
+	kMVKBCnFormatBC5Unorm,		/**< BC5 blocks, with two unsigned normalized channels. */
+	kMVKBCnFormatBC5Snorm,		/**< BC5 blocks, with two signed normalized channels. */
+	kMVKBCnFormatBC6HUfloat,	/**< BC6H blocks, with three unsigned half-float channels. */
+	kMVKBCnFormatBC6HSfloat,	/**< BC6H blocks, with three signed half-float channels. */
+	kMVKBCnFormatBC7,			/**< BC7 blocks. */
+} MVKBCnFormat;
+
+
+#pragma mark -
+#pragma mark MVKBCnDecoder
+
+/**
+ * Decodes block-compressed (BCn) texture data to 8-bit BGRA texels, whose four bytes are
+ * stored in memory in B, G, R, A order, as expected by a MTLPixelFormatBGRA8Unorm texture.
+ *
+ * Texels of sRGB formats are converted to linear values. Channels that are absent from
+ * the format are decoded as zero, and absent alpha is decoded as one. Values of BC6H and
+ * SNORM formats that lie outside the range of an 8-bit unsigned normalized texel are clamped.
+ *
+ * Each row of blocks is decoded independently, and the rows of a large texture are divided
+ * between multiple threads. Instances of this class are immutable, and are thread-safe.
+ */
+class MVKBCnDecoder {
+
+public:
+
+	/** Returns the number of bytes in each 4x4 block of compressed data. */
+	size_t getBlockByteCount() const;
+
+	/** Decodes a single 4x4 block, to 16 BGRA texels, in row-major order. */
+	void decodeBlock(const uint8_t* pSrcBlock, uint32_t* pTexels) const;
+
+	/**
+	 * Decodes a 3D region of compressed data, of the specified texel extent, to BGRA texels.
+	 *
+	 * Each source row holds one row of blocks, and each source slice holds the rows of blocks of
+	 * one depth slice. Each destination row holds one row of texels. Rows of blocks are decoded
+	 * by the calling thread, and by up to (threadCount - 1) additional threads.
+	 */
+	void decode(void* pDest, size_t destRowPitch, size_t destDepthPitch,
+				const void* pSrc, size_t srcRowPitch, size_t srcDepthPitch,
+				uint32_t width, uint32_t height, uint32_t depth, uint32_t threadCount) const;
+
+	/**
+	 * Returns the number of threads that decode() should use to decode the specified number of bytes of
+	 * compressed data. Small amounts of data are decoded on the calling thread, and larger amounts are
+	 * divided between as many threads as the device has processors.
+	 */
+	static uint32_t getThreadCount(size_t srcByteCount);
+
+	/** Constructs an instance that decodes the specified format, converting texels from sRGB if indicated. */
+	MVKBCnDecoder(MVKBCnFormat format, bool isSRGB);
+
+protected:
+	void decodeBlockRow(uint8_t* pDestRow, size_t destRowPitch, const uint8_t* pSrcRow, uint32_t width, uint32_t height) const;
+	void decodeBC1(const uint8_t* pSrcBlock, uint32_t* pTexels, bool isBC1) const;
+	void decodeBC2(const uint8_t* pSrcBlock, uint32_t* pTexels) const;
+	void decodeBC3(const uint8_t* pSrcBlock, uint32_t* pTexels) const;
+	void decodeBC4(const uint8_t* pSrcBlock, uint32_t* pTexels) const;
+	void decodeBC5(const uint8_t* pSrcBlock, uint32_t* pTexels) const;
+	void decodeBC6H(const uint8_t* pSrcBlock, uint32_t* pTexels) const;
+	void decodeBC7(const uint8_t* pSrcBlock, uint32_t* pTexels) const;
+	void convertFromSRGB(uint32_t* pTexels, uint32_t count) const;
+
+	MVKBCnFormat _format;
+	bool _isSRGB;
+};
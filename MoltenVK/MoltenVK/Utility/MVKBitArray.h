@@ -18,7 +18,14 @@
 
 #pragma once
 
-#include "MVKFoundation.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+// The contents of this file do not depend on Metal, or on other MoltenVK classes, so that
+// the bit scanning used to track descriptors can be exercised on any platform.
 
 
 #pragma mark -
@@ -40,7 +47,7 @@ public:
 	 */
 	bool getBit(size_t bitIndex, bool shouldClear = false) {
 		if (bitIndex >= _bitCount) { return false; }
-		bool val = mvkIsAnyFlagEnabled(getSection(getIndexOfSection(bitIndex)), getSectionSetMask(bitIndex));
+		bool val = getSection(getIndexOfSection(bitIndex)) & getSectionSetMask(bitIndex);
 		if (shouldClear && val) { clearBit(bitIndex); }
 		return val;
 	}
@@ -49,10 +56,10 @@ public:
 	void setBit(size_t bitIndex, bool val = true) {
 		size_t secIdx = getIndexOfSection(bitIndex);
 		if (val) {
-			mvkEnableFlags(getSection(secIdx), getSectionSetMask(bitIndex));
+			getSection(secIdx) |= getSectionSetMask(bitIndex);
 			if (secIdx < _minUnclearedSectionIndex) { _minUnclearedSectionIndex = secIdx; }
 		} else {
-			mvkDisableFlags(getSection(secIdx), getSectionSetMask(bitIndex));
+			getSection(secIdx) &= ~getSectionSetMask(bitIndex);
 			if (secIdx == _minUnclearedSectionIndex && !getSection(secIdx)) { _minUnclearedSectionIndex++; }
 		}
 	}
@@ -60,6 +67,28 @@ public:
 	/** Sets the value of the bit to 0. */
 	void clearBit(size_t bitIndex) { setBit(bitIndex, false); }
 
+	/** Sets the value of each bit in the range of the specified start index and count to the val (or to 1 by default). */
+	void setBits(size_t startIndex, size_t count, bool val = true) {
+		size_t endIndex = startIndex + count;
+		for (size_t bitIdx = startIndex; bitIdx < endIndex; ) {
+			size_t secIdx = getIndexOfSection(bitIdx);
+			size_t lclStartBitIdx = getBitIndexInSection(bitIdx);
+			size_t lclBitCnt = std::min(SectionBitCount - lclStartBitIdx, endIndex - bitIdx);
+			uint64_t secMask = getSectionRangeMask(lclStartBitIdx, lclBitCnt);
+			if (val) {
+				getSection(secIdx) |= secMask;
+				if (secIdx < _minUnclearedSectionIndex) { _minUnclearedSectionIndex = secIdx; }
+			} else {
+				getSection(secIdx) &= ~secMask;
+				if (secIdx == _minUnclearedSectionIndex && !getSection(secIdx)) { _minUnclearedSectionIndex++; }
+			}
+			bitIdx += lclBitCnt;
+		}
+	}
+
+	/** Sets the value of each bit in the range of the specified start index and count to 0. */
+	void clearBits(size_t startIndex, size_t count) { setBits(startIndex, count, false); }
+
 	/** Sets all bits in the array to 1. */
 	void setAllBits() { setAllSections(~0); }
 
@@ -75,8 +104,10 @@ public:
 		size_t bitIdx = startSecIdx << SectionMaskSize;
 		size_t secCnt = getSectionCount();
 		for (size_t secIdx = startSecIdx; secIdx < secCnt; secIdx++) {
-			size_t lclBitIdx = getIndexOfFirstSetBitInSection(getSection(secIdx), getBitIndexInSection(startIndex));
+			size_t lclStartBitIdx = (secIdx == getIndexOfSection(startIndex)) ? getBitIndexInSection(startIndex) : 0;
+			size_t lclBitIdx = getIndexOfFirstSetBitInSection(getSection(secIdx), lclStartBitIdx);
 			bitIdx += lclBitIdx;
+			if (bitIdx >= _bitCount) { break; }	// Ignore any bits set in the last section beyond the end of the array
 			if (lclBitIdx < SectionBitCount) {
 				if (startSecIdx == _minUnclearedSectionIndex && !getSection(startSecIdx)) { _minUnclearedSectionIndex = secIdx; }
 				if (shouldClear) { clearBit(bitIdx); }
@@ -110,6 +141,39 @@ public:
 		return getIndexOfFirstSetBit(0, false);
 	}
 
+	/**
+	 * Returns the index of the first bit that is clear, at or after the specified index.
+	 * If no bits are clear, returns the size() of this bit array.
+	 */
+	size_t getIndexOfFirstClearBit(size_t startIndex) {
+		size_t startSecIdx = getIndexOfSection(startIndex);
+		size_t secCnt = getSectionCount();
+		for (size_t secIdx = startSecIdx; secIdx < secCnt; secIdx++) {
+			size_t lclStartBitIdx = (secIdx == startSecIdx) ? getBitIndexInSection(startIndex) : 0;
+			size_t lclBitIdx = getIndexOfFirstSetBitInSection(~getSection(secIdx), lclStartBitIdx);
+			if (lclBitIdx < SectionBitCount) { return std::min((secIdx << SectionMaskSize) + lclBitIdx, _bitCount); }
+		}
+		return _bitCount;
+	}
+
+	/**
+	 * Returns the index of the first run of at least the specified number of consecutive set bits,
+	 * and optionally clears that number of bits at the start of the run. If no run is long enough,
+	 * returns the size() of this bit array, even if enough bits are set in total.
+	 */
+	size_t getIndexOfFirstSetBitRun(size_t count, bool shouldClear = false) {
+		size_t runStartIdx = getIndexOfFirstSetBit();
+		while (runStartIdx + count <= _bitCount) {
+			size_t runEndIdx = getIndexOfFirstClearBit(runStartIdx);
+			if (runEndIdx - runStartIdx >= count) {
+				if (shouldClear) { clearBits(runStartIdx, count); }
+				return runStartIdx;
+			}
+			runStartIdx = getIndexOfFirstSetBit(runEndIdx);
+		}
+		return _bitCount;
+	}
+
 	/**
 	 * Enumerates the bits, executing a custom function on each bit that is enabled.
 	 *
@@ -125,7 +189,7 @@ public:
 	bool enumerateEnabledBits(bool shouldClear, std::function<bool(size_t bitIndex)> func) {
 		for (size_t bitIdx = getIndexOfFirstSetBit(shouldClear);
 			 bitIdx < _bitCount;
-			 getIndexOfFirstSetBit(++bitIdx, shouldClear)) {
+			 bitIdx = getIndexOfFirstSetBit(bitIdx + 1, shouldClear)) {
 
 			if ( !func(bitIdx) ) { return false; }
 		}
@@ -197,12 +261,14 @@ public:
 	MVKBitArray(const MVKBitArray& other) {
 		resize(other._bitCount);
 		memcpy(getData(), other.getData(), getSectionCount() * SectionByteCount);
+		_minUnclearedSectionIndex = other._minUnclearedSectionIndex;
 	}
 
 	MVKBitArray& operator=(const MVKBitArray& other) {
 		resize(0);
 		resize(other._bitCount);
 		memcpy(getData(), other.getData(), getSectionCount() * SectionByteCount);
+		_minUnclearedSectionIndex = other._minUnclearedSectionIndex;
 		return *this;
 	}
 
@@ -242,6 +308,15 @@ protected:
 		return (uint64_t)1U << ((SectionBitCount - 1) - getBitIndexInSection(bitIndex));
 	}
 
+	// Returns a section mask containing 1 values in the bits in the section that correspond to the
+	// range of the specified local start bit index and bit count, and 0 values in all other bits.
+	static uint64_t getSectionRangeMask(size_t lclStartBitIndex, size_t bitCount) {
+		uint64_t rangeMask = ~(uint64_t)0 >> lclStartBitIndex;
+		size_t lclEndBitIndex = lclStartBitIndex + bitCount;
+		if (lclEndBitIndex < SectionBitCount) { rangeMask &= ~(~(uint64_t)0 >> lclEndBitIndex); }
+		return rangeMask;
+	}
+
 	// Returns the local index of the first set bit in the section, starting from the highest order bit.
 	// Clears all bits ahead of the start bit so they will be ignored, then counts the number of zeros
 	// ahead of the set bit. If there are no set bits, returns the number of bits in a section.
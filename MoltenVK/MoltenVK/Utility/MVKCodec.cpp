@@ -18,89 +18,51 @@
 
 
 #include "MVKCodec.h"
+#include "MVKBCnDecoder.h"
 
-#include <algorithm>
-#include <simd/simd.h>
 
-
-using simd::float3;
-using simd::float4;
-using simd::pow;
-using simd::select;
-
-static uint32_t pack_float_to_unorm4x8(float4 x) {
-	return ((((uint8_t)(x.r * 255)) & 0x000000ff) | ((((uint8_t)(x.g * 255)) << 8) & 0x0000ff00) |
-		((((uint8_t)(x.b * 255)) & 0x00ff0000) << 16) | ((((uint8_t)(x.a * 255)) << 24) & 0xff000000));
-}
-
-static float3 unpack_unorm565_to_float(uint16_t x) {
-	return simd::make_float3(((x >> 11) & 0x1f) / 31.0f, ((x >> 5) & 0x3f) / 63.0f, (x & 0x1f) / 31.0f);
-}
-
-
-/** Texture codec for DXTn (i.e. BC[1-3]) compressed data.
- *
- * This implementation is largely derived from Wine, from code originally
- * written by Connor McAdams.
- */
-class MVKDXTnCodec : public MVKCodec {
+/** Texture codec for block-compressed (i.e. BC[1-7]) data, which decodes to BGRA texels. */
+class MVKBCnCodec : public MVKCodec {
 
 public:
 
-	void decompress(void* pDest, const void* pSrc, const VkSubresourceLayout& destLayout, const VkSubresourceLayout& srcLayout, VkExtent3D extent) override {
-		VkDeviceSize blockByteCount;
-		const uint8_t* pSrcRow;
-		const uint8_t* pSrcSlice = (const uint8_t*)pSrc;
-		uint8_t* pDestRow;
-		uint8_t* pDestSlice = (uint8_t*)pDest;
-
-		blockByteCount = isBC1Format(_format) ? 8 : 16;
-
-		for (uint32_t z = 0; z < extent.depth; ++z) {
-			pSrcRow = pSrcSlice;
-			pDestRow = pDestSlice;
-			for (uint32_t y = 0; y < extent.height; y += 4) {
-				for (uint32_t x = 0; x < extent.width; x += 4) {
-					VkExtent2D blockExtent;
-					blockExtent.width = std::min(extent.width - x, 4u);
-					blockExtent.height = std::min(extent.height - y, 4u);
-					decompressDXTnBlock(pSrcRow + x * (blockByteCount / 4),
-						pDestRow + x * 4, blockExtent, destLayout.rowPitch, _format);
-				}
-				pSrcRow += srcLayout.rowPitch;
-				pDestRow += destLayout.rowPitch * 4;
-			}
-			pSrcSlice += srcLayout.depthPitch;
-			pDestSlice += destLayout.depthPitch;
-		}
+	void decompress(void* pDest, const void* pSrc, const VkSubresourceLayout& destLayout, const VkSubresourceLayout& srcLayout, VkOffset3D offset, VkExtent3D extent) override {
+		const uint8_t* pSrcRegion = ((const uint8_t*)pSrc + offset.z * srcLayout.depthPitch +
+									 (offset.y / 4) * srcLayout.rowPitch + (offset.x / 4) * _decoder.getBlockByteCount());
+		VkDeviceSize srcRegionSize = srcLayout.rowPitch * ((extent.height + 3) / 4) * extent.depth;
+		_decoder.decode(pDest, destLayout.rowPitch, destLayout.depthPitch,
+						pSrcRegion, srcLayout.rowPitch, srcLayout.depthPitch,
+						extent.width, extent.height, extent.depth,
+						MVKBCnDecoder::getThreadCount(srcRegionSize));
 	}
 
+	uint32_t getDecompressedBytesPerTexel() override { return 4; }
+
 	/** Constructs an instance. */
-	MVKDXTnCodec(VkFormat format) : _format(format) {}
+	MVKBCnCodec(MVKBCnFormat format, bool isSRGB) : _decoder(format, isSRGB) {}
 
 private:
-
-#define constant const
-#define device
-#define thread
-#define MVK_DECOMPRESS_CODE(...) __VA_ARGS__
-#include "MVKDXTnCodec.def"
-#undef MVK_DECOMPRESS_CODE
-
-	VkFormat _format;
+	MVKBCnDecoder _decoder;
 };
 
 std::unique_ptr<MVKCodec> mvkCreateCodec(VkFormat format) {
 	switch (format) {
-	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
-	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
-	case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
-	case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
-	case VK_FORMAT_BC2_UNORM_BLOCK:
-	case VK_FORMAT_BC2_SRGB_BLOCK:
-	case VK_FORMAT_BC3_UNORM_BLOCK:
-	case VK_FORMAT_BC3_SRGB_BLOCK:
-		return std::unique_ptr<MVKCodec>(new MVKDXTnCodec(format));
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:		return std::unique_ptr<MVKCodec>(new MVKBCnCodec(kMVKBCnFormatBC1RGB, false));
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:		return std::unique_ptr<MVKCodec>(new MVKBCnCodec(kMVKBCnFormatBC1RGB, true));
+	case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:	return std::unique_ptr<MVKCodec>(new MVKBCnCodec(kMVKBCnFormatBC1RGBA, false));
+	case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:		return std::unique_ptr<MVKCodec>(new MVKBCnCodec(kMVKBCnFormatBC1RGBA, true));
+	case VK_FORMAT_BC2_UNORM_BLOCK:			return std::unique_ptr<MVKCodec>(new MVKBCnCodec(kMVKBCnFormatBC2, false));
+	case VK_FORMAT_BC2_SRGB_BLOCK:			return std::unique_ptr<MVKCodec>(new MVKBCnCodec(kMVKBCnFormatBC2, true));
+	case VK_FORMAT_BC3_UNORM_BLOCK:			return std::unique_ptr<MVKCodec>(new MVKBCnCodec(kMVKBCnFormatBC3, false));
+	case VK_FORMAT_BC3_SRGB_BLOCK:			return std::unique_ptr<MVKCodec>(new MVKBCnCodec(kMVKBCnFormatBC3, true));
+	case VK_FORMAT_BC4_UNORM_BLOCK:			return std::unique_ptr<MVKCodec>(new MVKBCnCodec(kMVKBCnFormatBC4Unorm, false));
+	case VK_FORMAT_BC4_SNORM_BLOCK:			return std::unique_ptr<MVKCodec>(new MVKBCnCodec(kMVKBCnFormatBC4Snorm, false));
+	case VK_FORMAT_BC5_UNORM_BLOCK:			return std::unique_ptr<MVKCodec>(new MVKBCnCodec(kMVKBCnFormatBC5Unorm, false));
+	case VK_FORMAT_BC5_SNORM_BLOCK:			return std::unique_ptr<MVKCodec>(new MVKBCnCodec(kMVKBCnFormatBC5Snorm, false));
+	case VK_FORMAT_BC6H_UFLOAT_BLOCK:		return std::unique_ptr<MVKCodec>(new MVKBCnCodec(kMVKBCnFormatBC6HUfloat, false));
+	case VK_FORMAT_BC6H_SFLOAT_BLOCK:		return std::unique_ptr<MVKCodec>(new MVKBCnCodec(kMVKBCnFormatBC6HSfloat, false));
+	case VK_FORMAT_BC7_UNORM_BLOCK:			return std::unique_ptr<MVKCodec>(new MVKBCnCodec(kMVKBCnFormatBC7, false));
+	case VK_FORMAT_BC7_SRGB_BLOCK:			return std::unique_ptr<MVKCodec>(new MVKBCnCodec(kMVKBCnFormatBC7, true));
 
 	default:
 		return nullptr;
@@ -117,6 +79,14 @@ bool mvkCanDecodeFormat(VkFormat format) {
 	case VK_FORMAT_BC2_SRGB_BLOCK:
 	case VK_FORMAT_BC3_UNORM_BLOCK:
 	case VK_FORMAT_BC3_SRGB_BLOCK:
+	case VK_FORMAT_BC4_UNORM_BLOCK:
+	case VK_FORMAT_BC4_SNORM_BLOCK:
+	case VK_FORMAT_BC5_UNORM_BLOCK:
+	case VK_FORMAT_BC5_SNORM_BLOCK:
+	case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+	case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+	case VK_FORMAT_BC7_SRGB_BLOCK:
 		return true;
 
 	default:
@@ -35,8 +35,23 @@ class MVKCodec {
 
 public:
 
+	/**
+	 * Decompresses a region of compressed texture data for upload.
+	 *
+	 * The region is identified by its texel offset and extent within the compressed subresource
+	 * whose data begins at pSrc, and is laid out as described by srcLayout. The offset must be
+	 * aligned to the texel blocks of the compressed format. The decompressed texels of the region
+	 * are written to pDest, laid out as described by destLayout.
+	 */
+	virtual void decompress(void* pDest, const void* pSrc, const VkSubresourceLayout& destLayout, const VkSubresourceLayout& srcLayout, VkOffset3D offset, VkExtent3D extent) = 0;
+
 	/** Decompresses compressed texture data for upload. */
-	virtual void decompress(void* pDest, const void* pSrc, const VkSubresourceLayout& destLayout, const VkSubresourceLayout& srcLayout, VkExtent3D extent) = 0;
+	void decompress(void* pDest, const void* pSrc, const VkSubresourceLayout& destLayout, const VkSubresourceLayout& srcLayout, VkExtent3D extent) {
+		decompress(pDest, pSrc, destLayout, srcLayout, {0, 0, 0}, extent);
+	}
+
+	/** Returns the number of bytes in each decompressed texel. */
+	virtual uint32_t getDecompressedBytesPerTexel() = 0;
 
 	/** Destructor. */
 	virtual ~MVKCodec() = default;
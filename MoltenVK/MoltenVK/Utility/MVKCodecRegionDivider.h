@@ -0,0 +1,110 @@
+/*
+ * MVKCodecRegionDivider.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "mvk_vulkan.h"
+
+#include <algorithm>
+
+// The contents of this file do not depend on Metal, or on other MoltenVK classes, so that
+// the division of texture content into decompression regions can be exercised on any platform.
+
+
+#pragma mark -
+#pragma mark MVKCodecRegionDivider
+
+/**
+ * Divides an area of a subresource of compressed texture content into regions that are each decompressed
+ * into, and uploaded from, a scratch buffer of bounded size, which is reused for each region.
+ *
+ * Each region contains as many whole depth slices of the area as fit within the maximum scratch size.
+ * If a single slice does not fit, each region contains as many rows of texel blocks as fit, and at
+ * least one row of texel blocks. Each region spans the full width of the area, and the regions at the
+ * end of the area may be smaller than the others. If the maximum scratch size is zero, the area is
+ * decompressed as a single region.
+ */
+class MVKCodecRegionDivider {
+
+public:
+
+	/** Returns the extent of each region. */
+	VkExtent3D getRegionExtent() const { return _regionExtent; }
+
+	/** Returns the layout of the scratch buffer, which is large enough to hold the decompressed texels of any region. */
+	const VkSubresourceLayout& getScratchLayout() const { return _scratchLayout; }
+
+	/** Returns the number of bytes of decompressed texels in the area. */
+	VkDeviceSize getContentSize() const { return _scratchLayout.rowPitch * _extent.height * _extent.depth; }
+
+	/**
+	 * Calls the function with the texel offset and extent of each region, within the subresource,
+	 * in order of increasing depth, and then increasing row. Returns the number of regions.
+	 */
+	template <class F>
+	uint32_t forEachRegion(F func) const {
+		uint32_t regionCnt = 0;
+		uint32_t endY = (uint32_t)_origin.y + _extent.height;
+		uint32_t endZ = (uint32_t)_origin.z + _extent.depth;
+		for (uint32_t z = (uint32_t)_origin.z; z < endZ; z += _regionExtent.depth) {
+			for (uint32_t y = (uint32_t)_origin.y; y < endY; y += _regionExtent.height) {
+				VkOffset3D offset = { _origin.x, (int32_t)y, (int32_t)z };
+				VkExtent3D extent = { _extent.width,
+									  std::min(_regionExtent.height, endY - y),
+									  std::min(_regionExtent.depth, endZ - z) };
+				func(offset, extent);
+				regionCnt++;
+			}
+		}
+		return regionCnt;
+	}
+
+	/**
+	 * Constructs an instance that divides the area of texels, at the origin and extent within the subresource,
+	 * whose rows must be aligned to the texel blocks of the specified height. Each decompressed texel occupies
+	 * the specified number of bytes, and the scratch buffer is no larger than the maximum scratch size, unless
+	 * a single row of texel blocks is larger.
+	 */
+	MVKCodecRegionDivider(VkOffset3D origin, VkExtent3D extent, uint32_t blockHeight,
+						  uint32_t bytesPerTexel, VkDeviceSize maxScratchSize) :
+		_origin(origin), _extent(extent), _regionExtent(extent) {
+
+		VkDeviceSize rowPitch = VkDeviceSize(bytesPerTexel) * extent.width;
+		VkDeviceSize depthPitch = rowPitch * extent.height;
+		if ( !maxScratchSize ) { maxScratchSize = depthPitch * extent.depth; }
+
+		if (depthPitch <= maxScratchSize) {
+			_regionExtent.depth = (uint32_t)std::min<VkDeviceSize>(maxScratchSize / std::max<VkDeviceSize>(depthPitch, 1), extent.depth);
+		} else {
+			VkDeviceSize blockRowSize = rowPitch * blockHeight;
+			_regionExtent.height = (uint32_t)std::max<VkDeviceSize>(maxScratchSize / blockRowSize, 1) * blockHeight;
+			_regionExtent.depth = 1;
+		}
+
+		_scratchLayout = {};
+		_scratchLayout.rowPitch = rowPitch;
+		_scratchLayout.depthPitch = rowPitch * _regionExtent.height;
+		_scratchLayout.size = _scratchLayout.depthPitch * _regionExtent.depth;
+	}
+
+protected:
+	VkOffset3D _origin;
+	VkExtent3D _extent;
+	VkExtent3D _regionExtent;
+	VkSubresourceLayout _scratchLayout;
+};
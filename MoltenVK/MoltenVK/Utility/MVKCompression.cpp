@@ -0,0 +1,189 @@
+/*
+ * MVKCompression.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKCompression.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+
+#pragma mark -
+#pragma mark Compression
+
+// Each sequence starts with a token byte, whose high and low nibbles hold the literal length and the
+// match length, less kMVKLZMinMatch. A nibble of 15 is followed by extra length bytes, each added to
+// the length, ending with a byte less than 255. The token is followed by the literals, a two-byte
+// little-endian offset back from the current position to the start of the match, and any extra match
+// length bytes. The final sequence contains only literals. The window spans the dictionary content,
+// if any, as if it immediately preceded the content being compressed.
+static constexpr size_t kMVKLZMinMatch = 4;
+static constexpr size_t kMVKLZMaxOffset = 65535;
+static constexpr size_t kMVKLZLastLiterals = 5;		// Matches must end before the final bytes
+static constexpr uint32_t kMVKLZHashBits = 14;
+
+static inline uint32_t mvkLZRead32(const uint8_t* pBytes) {
+	uint32_t val;
+	memcpy(&val, pBytes, sizeof(val));
+	return val;
+}
+
+static inline uint32_t mvkLZHash(uint32_t val) { return (val * 2654435761U) >> (32 - kMVKLZHashBits); }
+
+static inline void mvkLZWriteLength(std::string& dest, size_t len) {
+	for (; len >= 255; len -= 255) { dest.push_back((char)255); }
+	dest.push_back((char)len);
+}
+
+std::string mvkCompressLZ(const void* pSrc, size_t srcSize, const void* pDict, size_t dictSize) {
+	std::string dest;
+	if (srcSize <= kMVKLZMinMatch + kMVKLZLastLiterals) { return dest; }
+
+	// Only the end of the dictionary content is within reach of the content.
+	if (dictSize > kMVKLZMaxOffset) {
+		pDict = (const uint8_t*)pDict + (dictSize - kMVKLZMaxOffset);
+		dictSize = kMVKLZMaxOffset;
+	}
+
+	// Compress over a window containing the dictionary content followed by the source content.
+	std::unique_ptr<uint8_t[]> window(new uint8_t[dictSize + srcSize]);
+	if (dictSize) { memcpy(window.get(), pDict, dictSize); }
+	memcpy(window.get() + dictSize, pSrc, srcSize);
+	const uint8_t* pBase = window.get();
+	const size_t endPos = dictSize + srcSize;
+	const size_t matchLimit = endPos - kMVKLZLastLiterals;
+
+	// The hash table holds the most recent window position of each hashed four-byte sequence.
+	// Position zero doubles as empty, which only costs the chance of a match at the very start.
+	std::unique_ptr<uint32_t[]> hashTable(new uint32_t[1 << kMVKLZHashBits]());
+	for (size_t pos = 0; pos + kMVKLZMinMatch <= dictSize; pos++) {
+		hashTable[mvkLZHash(mvkLZRead32(pBase + pos))] = (uint32_t)pos;
+	}
+
+	dest.reserve(srcSize / 2);
+	size_t litStart = dictSize;
+	size_t pos = dictSize;
+	while (pos + kMVKLZMinMatch <= matchLimit) {
+		uint32_t seq = mvkLZRead32(pBase + pos);
+		uint32_t& hashEntry = hashTable[mvkLZHash(seq)];
+		size_t candPos = hashEntry;
+		hashEntry = (uint32_t)pos;
+
+		if (candPos >= pos || pos - candPos > kMVKLZMaxOffset || mvkLZRead32(pBase + candPos) != seq) {
+			pos++;
+			continue;
+		}
+
+		// Extend the match forwards, and backwards over any pending literals.
+		size_t matchEnd = pos + kMVKLZMinMatch;
+		size_t candEnd = candPos + kMVKLZMinMatch;
+		while (matchEnd < matchLimit && pBase[matchEnd] == pBase[candEnd]) { matchEnd++; candEnd++; }
+		while (pos > litStart && candPos > 0 && pBase[pos - 1] == pBase[candPos - 1]) { pos--; candPos--; }
+
+		size_t litLen = pos - litStart;
+		size_t matchLen = matchEnd - pos - kMVKLZMinMatch;
+		size_t offset = pos - candPos;
+
+		dest.push_back((char)((std::min<size_t>(litLen, 15) << 4) | std::min<size_t>(matchLen, 15)));
+		if (litLen >= 15) { mvkLZWriteLength(dest, litLen - 15); }
+		dest.append((const char*)pBase + litStart, litLen);
+		dest.push_back((char)(offset & 0xFF));
+		dest.push_back((char)(offset >> 8));
+		if (matchLen >= 15) { mvkLZWriteLength(dest, matchLen - 15); }
+
+		// Index a position within the match, so nearby repetitions can still be found.
+		if (matchEnd - 2 > pos) { hashTable[mvkLZHash(mvkLZRead32(pBase + matchEnd - 2))] = (uint32_t)(matchEnd - 2); }
+
+		pos = litStart = matchEnd;
+		if (dest.size() >= srcSize) { return std::string(); }
+	}
+
+	// Final sequence contains only the remaining literals.
+	size_t litLen = endPos - litStart;
+	dest.push_back((char)(std::min<size_t>(litLen, 15) << 4));
+	if (litLen >= 15) { mvkLZWriteLength(dest, litLen - 15); }
+	dest.append((const char*)pBase + litStart, litLen);
+
+	if (dest.size() >= srcSize) { return std::string(); }
+	return dest;
+}
+
+bool mvkDecompressLZ(const void* pSrc, size_t srcSize, void* pDest, size_t destSize, const void* pDict, size_t dictSize) {
+	const uint8_t* pIn = (const uint8_t*)pSrc;
+	const uint8_t* pInEnd = pIn + srcSize;
+	uint8_t* pOutStart = (uint8_t*)pDest;
+	uint8_t* pOut = pOutStart;
+	uint8_t* pOutEnd = pOut + destSize;
+	const uint8_t* pDictEnd = (const uint8_t*)pDict + dictSize;
+
+	// Reads an extended length, returning false if the input ends or the length overflows.
+	auto readLength = [&](size_t& len) {
+		uint8_t lenByte;
+		do {
+			if (pIn >= pInEnd) { return false; }
+			lenByte = *pIn++;
+			len += lenByte;
+			if (len > destSize) { return false; }
+		} while (lenByte == 255);
+		return true;
+	};
+
+	while (pIn < pInEnd) {
+		uint8_t token = *pIn++;
+
+		size_t litLen = token >> 4;
+		if (litLen == 15 && !readLength(litLen)) { return false; }
+		if (litLen > size_t(pInEnd - pIn) || litLen > size_t(pOutEnd - pOut)) { return false; }
+		memcpy(pOut, pIn, litLen);
+		pIn += litLen;
+		pOut += litLen;
+
+		if (pIn == pInEnd) { break; }		// Final sequence has only literals
+
+		if (pInEnd - pIn < 2) { return false; }
+		size_t offset = pIn[0] | (pIn[1] << 8);
+		pIn += 2;
+
+		size_t matchLen = token & 0xF;
+		if (matchLen == 15 && !readLength(matchLen)) { return false; }
+		matchLen += kMVKLZMinMatch;
+
+		size_t outPos = pOut - pOutStart;
+		if (offset == 0 || offset > outPos + dictSize || matchLen > size_t(pOutEnd - pOut)) { return false; }
+
+		// Copy any part of the match that lies within the dictionary content.
+		if (offset > outPos) {
+			size_t dictLen = std::min(offset - outPos, matchLen);
+			memcpy(pOut, pDictEnd - (offset - outPos), dictLen);
+			pOut += dictLen;
+			matchLen -= dictLen;
+		}
+
+		// The match may overlap the output being written, so copy forwards byte by byte when it does.
+		const uint8_t* pMatch = pOut - offset;
+		if (offset >= matchLen) {
+			memcpy(pOut, pMatch, matchLen);
+			pOut += matchLen;
+		} else {
+			while (matchLen--) { *pOut++ = *pMatch++; }
+		}
+	}
+
+	return pOut == pOutEnd;
+}
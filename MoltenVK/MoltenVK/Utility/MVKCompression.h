@@ -0,0 +1,49 @@
+/*
+ * MVKCompression.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// The contents of this file do not depend on Metal, or on other MoltenVK classes, so that
+// the compression of pipeline cache content can be exercised on any platform.
+
+
+#pragma mark -
+#pragma mark Compression
+
+/**
+ * Compresses the specified memory using a fast LZ77 block compression, based on the LZ4 block
+ * format, and returns the compressed content, or returns an empty string if the content cannot
+ * be compressed to a smaller size. Decompression is considerably faster than compression.
+ *
+ * If dictionary content is provided, the compressed content may reference it, which allows small
+ * content that shares text with the dictionary, such as common source code declarations, to be
+ * compressed further. The same dictionary content must be provided to decompress the content.
+ */
+std::string mvkCompressLZ(const void* pSrc, std::size_t srcSize, const void* pDict = nullptr, std::size_t dictSize = 0);
+
+/**
+ * Decompresses content that was compressed by mvkCompressLZ(), using the same dictionary content,
+ * into the destination memory, whose size must be exactly that of the original content.
+ * Returns whether the content was successfully decompressed. Content that is malformed,
+ * or does not decompress to exactly the destination size, is rejected.
+ */
+bool mvkDecompressLZ(const void* pSrc, std::size_t srcSize, void* pDest, std::size_t destSize,
+					 const void* pDict = nullptr, std::size_t dictSize = 0);
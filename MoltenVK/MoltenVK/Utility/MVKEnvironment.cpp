@@ -26,6 +26,7 @@ static void mvkInitConfigFromEnvVars() {
 
 	MVKConfiguration evCfg;
 	std::string evGPUCapFileStrObj;
+	std::string evShaderConvCachePathStrObj;
 
 	MVK_SET_FROM_ENV_OR_BUILD_BOOL  (evCfg.debugMode,                              MVK_DEBUG);
 	MVK_SET_FROM_ENV_OR_BUILD_BOOL  (evCfg.shaderConversionFlipVertexY,            MVK_CONFIG_SHADER_CONVERSION_FLIP_VERTEX_Y);
@@ -62,12 +63,23 @@ static void mvkInitConfigFromEnvVars() {
 	MVK_SET_FROM_ENV_OR_BUILD_INT32 (evCfg.advertiseExtensions,                    MVK_CONFIG_ADVERTISE_EXTENSIONS);
 	MVK_SET_FROM_ENV_OR_BUILD_BOOL  (evCfg.resumeLostDevice,                       MVK_CONFIG_RESUME_LOST_DEVICE);
 	MVK_SET_FROM_ENV_OR_BUILD_BOOL  (evCfg.useMetalArgumentBuffers,                MVK_CONFIG_USE_METAL_ARGUMENT_BUFFERS);
+	MVK_SET_FROM_ENV_OR_BUILD_STRING(evCfg.shaderConversionCachePath,              MVK_CONFIG_SHADER_CONVERSION_CACHE_PATH, evShaderConvCachePathStrObj);
+	MVK_SET_FROM_ENV_OR_BUILD_BOOL  (evCfg.compressPipelineCacheData,              MVK_CONFIG_COMPRESS_PIPELINE_CACHE_DATA);
+	MVK_SET_FROM_ENV_OR_BUILD_BOOL  (evCfg.useCommandArenas,                       MVK_CONFIG_USE_COMMAND_ARENAS);
+	MVK_SET_FROM_ENV_OR_BUILD_INT32 (evCfg.parallelEncodingSegmentSize,            MVK_CONFIG_PARALLEL_ENCODING_SEGMENT_SIZE);
+	MVK_SET_FROM_ENV_OR_BUILD_BOOL  (evCfg.coalesceStateCommands,                  MVK_CONFIG_COALESCE_STATE_COMMANDS);
+	MVK_SET_FROM_ENV_OR_BUILD_BOOL  (evCfg.replayReusableCommandBuffers,           MVK_CONFIG_REPLAY_REUSABLE_COMMAND_BUFFERS);
+	MVK_SET_FROM_ENV_OR_BUILD_BOOL  (evCfg.useLockFreeBufferAllocation,            MVK_CONFIG_USE_LOCK_FREE_BUFFER_ALLOCATION);
+	MVK_SET_FROM_ENV_OR_BUILD_BOOL  (evCfg.streamOneTimeSubmitCommands,            MVK_CONFIG_STREAM_ONE_TIME_SUBMIT_COMMANDS);
+	MVK_SET_FROM_ENV_OR_BUILD_INT32 (evCfg.textureDecompressionScratchSize,        MVK_CONFIG_TEXTURE_DECOMPRESSION_SCRATCH_SIZE);
+	MVK_SET_FROM_ENV_OR_BUILD_BOOL  (evCfg.trackDirtyHostMemoryPages,              MVK_CONFIG_TRACK_DIRTY_HOST_MEMORY_PAGES);
 
 	mvkSetConfig(evCfg);
 }
 
 static MVKConfiguration _mvkConfig;
 static std::string _autoGPUCaptureOutputFile;
+static std::string _shaderConversionCachePath;
 
 // Returns the MoltenVK config, lazily initializing it if necessary.
 // We initialize lazily instead of in a library constructor function to
@@ -96,4 +108,10 @@ void mvkSetConfig(const MVKConfiguration& mvkConfig) {
 		_autoGPUCaptureOutputFile = _mvkConfig.autoGPUCaptureOutputFilepath;
 	}
 	_mvkConfig.autoGPUCaptureOutputFilepath = (char*)_autoGPUCaptureOutputFile.c_str();
+
+	// Set shader conversion cache path string
+	if (_mvkConfig.shaderConversionCachePath) {
+		_shaderConversionCachePath = _mvkConfig.shaderConversionCachePath;
+	}
+	_mvkConfig.shaderConversionCachePath = (char*)_shaderConversionCachePath.c_str();
 }
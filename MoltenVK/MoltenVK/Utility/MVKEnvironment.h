@@ -282,3 +282,57 @@ void mvkSetConfig(const MVKConfiguration& mvkConfig);
 #ifndef MVK_CONFIG_USE_METAL_ARGUMENT_BUFFERS
 #   define MVK_CONFIG_USE_METAL_ARGUMENT_BUFFERS    0
 #endif
+
+/**
+ * The directory in which to persist SPIR-V to MSL shader conversions, for reuse across runs
+ * and processes. Tilde paths may be used to place the directory in a user's home directory.
+ * If left blank, shader conversions are not persisted.
+ */
+#ifndef MVK_CONFIG_SHADER_CONVERSION_CACHE_PATH
+#	define MVK_CONFIG_SHADER_CONVERSION_CACHE_PATH	""
+#endif
+
+/** Compress the content of each shader library in pipeline cache data. Disabled by default. */
+#ifndef MVK_CONFIG_COMPRESS_PIPELINE_CACHE_DATA
+#   define MVK_CONFIG_COMPRESS_PIPELINE_CACHE_DATA    0
+#endif
+
+/** Allocate the commands in each VkCommandBuffer from an arena held by the command buffer. Disabled by default. */
+#ifndef MVK_CONFIG_USE_COMMAND_ARENAS
+#   define MVK_CONFIG_USE_COMMAND_ARENAS    0
+#endif
+
+/** Minimum number of commands in each segment of a command buffer encoded concurrently. Disabled (zero) by default. */
+#ifndef MVK_CONFIG_PARALLEL_ENCODING_SEGMENT_SIZE
+#   define MVK_CONFIG_PARALLEL_ENCODING_SEGMENT_SIZE    0
+#endif
+
+/** Remove redundant state commands from reusable command buffers. Disabled by default. */
+#ifndef MVK_CONFIG_COALESCE_STATE_COMMANDS
+#   define MVK_CONFIG_COALESCE_STATE_COMMANDS    0
+#endif
+
+/** Encode reusable command buffers from a replay stream recorded when they are first submitted. Disabled by default. */
+#ifndef MVK_CONFIG_REPLAY_REUSABLE_COMMAND_BUFFERS
+#   define MVK_CONFIG_REPLAY_REUSABLE_COMMAND_BUFFERS    0
+#endif
+
+/** Acquire and return transient MTLBuffer regions through lock-free per-thread caches. Disabled by default. */
+#ifndef MVK_CONFIG_USE_LOCK_FREE_BUFFER_ALLOCATION
+#   define MVK_CONFIG_USE_LOCK_FREE_BUFFER_ALLOCATION    0
+#endif
+
+/** Encode the commands of prefilled one-time-submit command buffers without retaining them. Disabled by default. */
+#ifndef MVK_CONFIG_STREAM_ONE_TIME_SUBMIT_COMMANDS
+#   define MVK_CONFIG_STREAM_ONE_TIME_SUBMIT_COMMANDS    0
+#endif
+
+/** Maximum size of the scratch buffer used to decompress compressed 3D texture content for upload. 4 MB by default. */
+#ifndef MVK_CONFIG_TEXTURE_DECOMPRESSION_SCRATCH_SIZE
+#   define MVK_CONFIG_TEXTURE_DECOMPRESSION_SCRATCH_SIZE    (4 * 1024 * 1024)
+#endif
+
+/** Flush only the pages of host-visible memory whose content has changed since last synchronized. Disabled by default. */
+#ifndef MVK_CONFIG_TRACK_DIRTY_HOST_MEMORY_PAGES
+#   define MVK_CONFIG_TRACK_DIRTY_HOST_MEMORY_PAGES    0
+#endif
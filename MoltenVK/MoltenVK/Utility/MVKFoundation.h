@@ -21,6 +21,7 @@
 
 
 #include "MVKCommonEnvironment.h"
+#include "MVKHash.h"
 #include "mvk_vulkan.h"
 #include <algorithm>
 #include <cassert>
@@ -0,0 +1,96 @@
+/*
+ * MVKHostMemoryPageTracker.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKHostMemoryPageTracker.h"
+
+#include <algorithm>
+
+
+#pragma mark -
+#pragma mark MVKHostMemoryPageTracker
+
+// Consecutive changed pages are coalesced into a single range, clipped to the memory range.
+void MVKHostMemoryPageTracker::forEachChangedRange(const void* pMemory, VkDeviceSize offset, VkDeviceSize size,
+												   std::function<void(VkDeviceSize offset, VkDeviceSize size)> func) {
+	VkDeviceSize endOffset = getEndOffset(offset, size);
+	if (offset >= endOffset) { return; }
+
+	VkDeviceSize runOffset = 0;
+	bool isInRun = false;
+	size_t endPageIdx = (endOffset + kPageSize - 1) / kPageSize;
+	for (size_t pageIdx = offset / kPageSize; pageIdx < endPageIdx; pageIdx++) {
+		VkDeviceSize pageOffset = std::max(pageIdx * kPageSize, offset);
+		if (synchronizePage(pMemory, pageIdx, offset, endOffset)) {
+			if ( !isInRun ) {
+				runOffset = pageOffset;
+				isInRun = true;
+			}
+		} else if (isInRun) {
+			func(runOffset, pageOffset - runOffset);
+			isInRun = false;
+		}
+	}
+	if (isInRun) { func(runOffset, endOffset - runOffset); }
+}
+
+void MVKHostMemoryPageTracker::markSynchronized(const void* pMemory, VkDeviceSize offset, VkDeviceSize size) {
+	VkDeviceSize endOffset = getEndOffset(offset, size);
+	if (offset >= endOffset) { return; }
+
+	size_t endPageIdx = (endOffset + kPageSize - 1) / kPageSize;
+	for (size_t pageIdx = offset / kPageSize; pageIdx < endPageIdx; pageIdx++) {
+		synchronizePage(pMemory, pageIdx, offset, endOffset);
+	}
+}
+
+void MVKHostMemoryPageTracker::markChanged(VkDeviceSize offset, VkDeviceSize size) {
+	VkDeviceSize endOffset = getEndOffset(offset, size);
+	if (offset >= endOffset) { return; }
+
+	size_t endPageIdx = (endOffset + kPageSize - 1) / kPageSize;
+	for (size_t pageIdx = offset / kPageSize; pageIdx < endPageIdx; pageIdx++) {
+		_isPageSynchronized[pageIdx] = false;
+	}
+}
+
+// Returns the end of the memory range, clipped to the memory, without overflowing if size is VK_WHOLE_SIZE.
+VkDeviceSize MVKHostMemoryPageTracker::getEndOffset(VkDeviceSize offset, VkDeviceSize size) {
+	return (offset < _memSize && size < _memSize - offset) ? offset + size : _memSize;
+}
+
+// Records the hash of the content of the page if it lies entirely within the memory range,
+// otherwise forgets any hash of the page. Returns whether the content of the page has changed.
+bool MVKHostMemoryPageTracker::synchronizePage(const void* pMemory, size_t pageIdx, VkDeviceSize offset, VkDeviceSize endOffset) {
+	VkDeviceSize pageOffset = pageIdx * kPageSize;
+	VkDeviceSize pageEndOffset = std::min(pageOffset + kPageSize, _memSize);
+	if (pageOffset < offset || pageEndOffset > endOffset) {
+		_isPageSynchronized[pageIdx] = false;
+		return true;
+	}
+
+	MVKHash128 pageHash = mvkHash128((const char*)pMemory + pageOffset, pageEndOffset - pageOffset);
+	bool isChanged = !_isPageSynchronized[pageIdx] || _pageHashes[pageIdx] != pageHash;
+	_pageHashes[pageIdx] = pageHash;
+	_isPageSynchronized[pageIdx] = true;
+	return isChanged;
+}
+
+MVKHostMemoryPageTracker::MVKHostMemoryPageTracker(VkDeviceSize memSize) :
+	_pageHashes((memSize + kPageSize - 1) / kPageSize),
+	_isPageSynchronized((memSize + kPageSize - 1) / kPageSize, false),
+	_memSize(memSize) {}
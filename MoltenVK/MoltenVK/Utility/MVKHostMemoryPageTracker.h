@@ -0,0 +1,79 @@
+/*
+ * MVKHostMemoryPageTracker.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "mvk_vulkan.h"
+#include "MVKHash.h"
+
+#include <functional>
+#include <vector>
+
+// The contents of this file do not depend on Metal, or on other MoltenVK classes, so that
+// the tracking of changed host memory pages can be exercised on any platform.
+
+
+#pragma mark -
+#pragma mark MVKHostMemoryPageTracker
+
+/**
+ * Tracks which pages of the host memory of a device memory allocation have changed content
+ * since they were last synchronized with the images and buffers bound to the memory, by
+ * comparing a hash of the current content of each page with the hash recorded when the page
+ * was last synchronized.
+ *
+ * A hash is only recorded for a page that lies entirely within a synchronized range, because
+ * the app may have changed content in the rest of a partly synchronized page, that it has not
+ * yet flushed. Such a page is considered to have changed until it is next synchronized entirely.
+ */
+class MVKHostMemoryPageTracker {
+
+public:
+
+	/** The number of bytes in each tracked page. */
+	static constexpr VkDeviceSize kPageSize = 4096;
+
+	/**
+	 * Calls the function with the offset and size of each run of consecutive pages, clipped
+	 * to the specified memory range, whose content has changed since it was last synchronized,
+	 * and records the content of the pages within the memory range as synchronized.
+	 */
+	void forEachChangedRange(const void* pMemory, VkDeviceSize offset, VkDeviceSize size,
+							 std::function<void(VkDeviceSize offset, VkDeviceSize size)> func);
+
+	/** Records the content of the pages within the specified memory range as synchronized. */
+	void markSynchronized(const void* pMemory, VkDeviceSize offset, VkDeviceSize size);
+
+	/**
+	 * Records the pages that overlap the specified memory range as changed, such as when the GPU
+	 * may have written to a resource bound to the range. The pages are then reported by the next
+	 * call to forEachChangedRange(), even if their host content has not changed.
+	 */
+	void markChanged(VkDeviceSize offset, VkDeviceSize size);
+
+	/** Constructs an instance tracking memory of the specified size, with all pages considered changed. */
+	MVKHostMemoryPageTracker(VkDeviceSize memSize);
+
+protected:
+	VkDeviceSize getEndOffset(VkDeviceSize offset, VkDeviceSize size);
+	bool synchronizePage(const void* pMemory, size_t pageIdx, VkDeviceSize offset, VkDeviceSize size);
+
+	std::vector<MVKHash128> _pageHashes;
+	std::vector<bool> _isPageSynchronized;
+	VkDeviceSize _memSize;
+};
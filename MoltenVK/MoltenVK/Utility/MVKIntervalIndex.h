@@ -0,0 +1,140 @@
+/*
+ * MVKIntervalIndex.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+// The contents of this file do not depend on Metal, or on other MoltenVK classes,
+// so that they can be exercised with any value type.
+
+
+#pragma mark -
+#pragma mark MVKIntervalIndex
+
+/**
+ * An index of distinct values, each covering a range of offsets, such as resources bound
+ * to ranges of a memory allocation, that can efficiently find the values whose ranges
+ * overlap a range of offsets.
+ *
+ * Values are held in buckets by the power-of-two size class of their ranges, and each bucket
+ * is ordered by the start of the ranges. Because no range in a bucket is more than twice as
+ * large as another, the values in a bucket that overlap a range can be found by starting from
+ * a position found by binary search. Values can be added and removed in logarithmic time,
+ * and finding the values that overlap a range takes logarithmic time per size class in use,
+ * plus time proportional to the number of overlapping values.
+ *
+ * The value type must be hashable, and ordered by std::less, such as a pointer type.
+ * This class is not thread-safe.
+ */
+template <typename T>
+class MVKIntervalIndex {
+
+public:
+
+	/**
+	 * Adds the value, covering the range of the specified offset and size, to this index.
+	 * If the value is already in this index, it is moved to the specified range.
+	 */
+	void add(T value, uint64_t offset, uint64_t size) {
+		remove(value);
+		Entry entry = { offset, offset + size, value };
+		_entries[value] = entry;
+		_buckets[getSizeClass(size)].insert(entry);
+	}
+
+	/** Removes the value from this index, and returns whether the value was in this index. */
+	bool remove(T value) {
+		auto iter = _entries.find(value);
+		if (iter == _entries.end()) { return false; }
+
+		const Entry& entry = iter->second;
+		auto bucketIter = _buckets.find(getSizeClass(entry.end - entry.offset));
+		bucketIter->second.erase(entry);
+		if (bucketIter->second.empty()) { _buckets.erase(bucketIter); }
+		_entries.erase(iter);
+		return true;
+	}
+
+	/** Returns whether the value is in this index. */
+	bool contains(T value) const { return _entries.find(value) != _entries.end(); }
+
+	/**
+	 * Calls the function with each value whose range overlaps the range of the specified
+	 * offset and size. An empty range overlaps no values, and a range whose end lies beyond
+	 * the largest offset, such as one with a size of VK_WHOLE_SIZE, extends to the largest offset.
+	 * The values within each size class are visited in order of offset.
+	 * The function must not add values to, or remove values from, this index.
+	 */
+	void forEachOverlapping(uint64_t offset, uint64_t size, std::function<void(T value)> func) const {
+		if (size == 0) { return; }
+
+		uint64_t endOffset = size < UINT64_MAX - offset ? offset + size : UINT64_MAX;
+		for (auto& bucket : _buckets) {
+			// Ranges in this size class that start this far before the specified range end before it starts.
+			uint64_t maxSize = (uint64_t(1) << bucket.first) * 2 - 1;
+			Entry firstEntry = { offset > maxSize ? offset - maxSize : 0, 0, T() };
+			for (auto iter = bucket.second.lower_bound(firstEntry); iter != bucket.second.end() && iter->offset < endOffset; iter++) {
+				if (iter->end > offset) { func(iter->value); }
+			}
+		}
+	}
+
+	/** Calls the function with each value in this index, in no particular order. */
+	void forEach(std::function<void(T value)> func) const {
+		for (auto& entry : _entries) { func(entry.first); }
+	}
+
+	/** Returns any value in this index. This index must not be empty. */
+	T any() const { return _entries.begin()->first; }
+
+	/** Returns the number of values in this index. */
+	size_t size() const { return _entries.size(); }
+
+	/** Returns whether this index is empty. */
+	bool empty() const { return _entries.empty(); }
+
+protected:
+	typedef struct {
+		uint64_t offset;
+		uint64_t end;
+		T value;
+	} Entry;
+
+	struct EntryLess {
+		bool operator()(const Entry& lhs, const Entry& rhs) const {
+			if (lhs.offset != rhs.offset) { return lhs.offset < rhs.offset; }
+			return std::less<T>()(lhs.value, rhs.value);
+		}
+	};
+
+	// Returns the index of the highest bit of the size. Empty ranges share the class of one-byte ranges.
+	static uint32_t getSizeClass(uint64_t size) {
+		uint32_t sizeClass = 0;
+		while (size >>= 1) { sizeClass++; }
+		return sizeClass;
+	}
+
+	std::unordered_map<T, Entry> _entries;
+	std::map<uint32_t, std::set<Entry, EntryLess>> _buckets;
+};
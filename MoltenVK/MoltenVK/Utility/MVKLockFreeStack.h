@@ -0,0 +1,254 @@
+/*
+ * MVKLockFreeStack.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// The contents of this file do not depend on Metal, or on other MoltenVK classes,
+// so that they can be exercised concurrently with any object type.
+
+
+#pragma mark -
+#pragma mark MVKLockFreeStack
+
+/**
+ * An intrusive, lock-free, last-in-first-out stack of objects, which can be pushed and popped
+ * concurrently by any number of threads.
+ *
+ * The objects in the stack should derive from MVKLinkableMixin, or otherwise support a public
+ * member variable named "_next", of the same object type, which is used by this stack to create
+ * a linked list of objects. While an object is in the stack, its _next member is accessed atomically.
+ *
+ * The head of the stack is a single 64-bit word, holding the address of the top object in its low
+ * bits, and a tag that changes with each update in its high bits, so that an object that is popped
+ * and pushed again, while another thread is popping it, is detected. Because the objects are aligned
+ * to at least 8 bytes, and user-space addresses use no more than 48 bits, the address needs only
+ * 45 bits, leaving 19 bits for the tag. Keeping the head to a single word ensures the head can
+ * always be updated with a single lock-free compare-and-swap, on every platform.
+ *
+ * Because another thread may read the _next member of an object that has just been popped,
+ * objects popped from this stack must not be destroyed while other threads may still be
+ * accessing this stack.
+ */
+template <class T>
+class MVKLockFreeStack {
+
+public:
+
+	/** Pushes the object onto the top of this stack. */
+	void push(T* obj) { pushList(obj, obj); }
+
+	/**
+	 * Pushes a linked list of objects onto the top of this stack, as a single operation.
+	 * The first object will be at the top of the stack. The objects between the first and
+	 * last objects must already be linked together, through their _next members.
+	 */
+	void pushList(T* first, T* last) {
+		uint64_t oldHead = _head.load(std::memory_order_relaxed);
+		uint64_t newHead;
+		do {
+			setNext(last, getObject(oldHead));
+			newHead = makeHead(first, oldHead);
+		} while ( !_head.compare_exchange_weak(oldHead, newHead, std::memory_order_release, std::memory_order_relaxed) );
+	}
+
+	/** Removes and returns the object at the top of this stack, or returns null if this stack is empty. */
+	T* pop() {
+		uint64_t oldHead = _head.load(std::memory_order_acquire);
+		uint64_t newHead;
+		T* obj;
+		do {
+			obj = getObject(oldHead);
+			if ( !obj ) { return nullptr; }
+			newHead = makeHead(getNext(obj), oldHead);
+		} while ( !_head.compare_exchange_weak(oldHead, newHead, std::memory_order_acquire, std::memory_order_acquire) );
+
+		setNext(obj, nullptr);		// Objects in the wild should never think they are still part of this stack
+		return obj;
+	}
+
+	/**
+	 * Removes all objects from this stack, as a single operation, and returns the object that was at
+	 * the top of this stack, which is linked to the remaining objects through their _next members.
+	 */
+	T* popAll() {
+		uint64_t oldHead = _head.load(std::memory_order_relaxed);
+		while ( !_head.compare_exchange_weak(oldHead, makeHead(nullptr, oldHead), std::memory_order_acquire, std::memory_order_relaxed) ) {}
+		return getObject(oldHead);
+	}
+
+	/** Returns whether this stack is currently empty. */
+	bool isEmpty() { return !getObject(_head.load(std::memory_order_relaxed)); }
+
+	/**
+	 * Returns the _next member of the object, using an atomic access. The _next member may be
+	 * declared by a base class of the object type, such as MVKCommand, so it is cast to the object type.
+	 */
+	static T* getNext(T* obj) { return (T*)__atomic_load_n(&obj->_next, __ATOMIC_RELAXED); }
+
+	/** Sets the _next member of the object, using an atomic access. */
+	static void setNext(T* obj, T* next) { __atomic_store_n(&obj->_next, next, __ATOMIC_RELAXED); }
+
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "MVKLockFreeStack requires a lock-free 64-bit atomic.");
+	static_assert(sizeof(uintptr_t) <= sizeof(uint64_t), "MVKLockFreeStack requires addresses of no more than 64 bits.");
+
+protected:
+	static constexpr uint32_t kAlignmentBits = 3;
+	static constexpr uint32_t kAddressBits = sizeof(uintptr_t) == sizeof(uint64_t) ? 48 : 32;
+	static constexpr uint32_t kTagShift = kAddressBits - kAlignmentBits;
+	static constexpr uint64_t kObjectMask = (uint64_t(1) << kTagShift) - 1;
+
+	// Returns a head referencing the object, with a tag one greater than that of the previous head.
+	static uint64_t makeHead(T* obj, uint64_t prevHead) {
+		static_assert(alignof(T) >= (1 << kAlignmentBits), "Objects in a MVKLockFreeStack must be aligned to at least 8 bytes.");
+		uint64_t tag = (prevHead >> kTagShift) + 1;
+		return (tag << kTagShift) | (uint64_t(uintptr_t(obj)) >> kAlignmentBits);
+	}
+
+	// Returns the object referenced by the head.
+	static T* getObject(uint64_t head) { return (T*)uintptr_t((head & kObjectMask) << kAlignmentBits); }
+
+	std::atomic<uint64_t> _head = { 0 };
+};
+
+
+#pragma mark -
+#pragma mark MVKMagazineCache
+
+/**
+ * A lock-free cache of objects, held in small per-thread magazines, in front of a shared
+ * MVKLockFreeStack depot.
+ *
+ * Each thread is assigned one of a fixed number of magazine slots. A thread acquires and
+ * returns objects through the magazine in its slot, without any atomic operations other
+ * than claiming and releasing the slot. A magazine that runs empty is refilled from the
+ * depot, and a magazine that fills up moves half of its objects to the depot, in a single
+ * operation. If another thread currently holds the magazine in the same slot, the object is
+ * acquired from, or returned to, the depot directly, so a thread never waits for another thread.
+ *
+ * Magazines are created when their slots are first used.
+ */
+template <class T, size_t MagazineCapacity = 16, size_t SlotCount = 8>
+class MVKMagazineCache {
+
+public:
+
+	/** Returns an object from the magazine of the calling thread, or from the depot, or returns null if both are empty. */
+	T* acquire() {
+		auto& slot = getSlot();
+		Magazine* mag = claimMagazine(slot);
+		if ( !mag ) { return _depot.pop(); }
+
+		if ( !mag->count ) {
+			while (mag->count < MagazineCapacity / 2) {
+				T* obj = _depot.pop();
+				if ( !obj ) { break; }
+				mag->objects[mag->count++] = obj;
+			}
+		}
+		T* obj = mag->count ? mag->objects[--mag->count] : nullptr;
+
+		slot.store(mag, std::memory_order_release);
+		return obj;
+	}
+
+	/** Returns the object to the magazine of the calling thread, or to the depot. */
+	void release(T* obj) {
+		auto& slot = getSlot();
+		Magazine* mag = claimMagazine(slot);
+		if ( !mag ) {
+			_depot.push(obj);
+			return;
+		}
+
+		if (mag->count == MagazineCapacity) { moveToDepot(mag, MagazineCapacity / 2); }
+		mag->objects[mag->count++] = obj;
+
+		slot.store(mag, std::memory_order_release);
+	}
+
+	/**
+	 * Removes all objects from all magazines and the depot, and returns one of them, which is linked
+	 * to the remaining objects through their _next members. This function must not be called while
+	 * other threads are acquiring or returning objects through this cache.
+	 */
+	T* removeAll() {
+		for (auto& slot : _slots) {
+			Magazine* mag = slot.load(std::memory_order_acquire);
+			if (mag && mag != kMagazineInUse) { moveToDepot(mag, mag->count); }
+		}
+		return _depot.popAll();
+	}
+
+	MVKMagazineCache() { for (auto& slot : _slots) { slot.store(nullptr, std::memory_order_relaxed); } }
+
+	~MVKMagazineCache() {
+		for (auto& slot : _slots) {
+			Magazine* mag = slot.load(std::memory_order_acquire);
+			if (mag != kMagazineInUse) { delete mag; }
+		}
+	}
+
+protected:
+	typedef struct Magazine {
+		T* objects[MagazineCapacity];
+		size_t count = 0;
+	} Magazine;
+
+	// Marks a slot whose magazine is currently held by a thread.
+	static Magazine* const kMagazineInUse;
+
+	// Returns the magazine slot assigned to the calling thread.
+	std::atomic<Magazine*>& getSlot() {
+		static std::atomic<uint32_t> _nextThreadIndex(0);
+		static thread_local uint32_t _threadIndex = _nextThreadIndex++;
+		return _slots[_threadIndex % SlotCount];
+	}
+
+	// Claims the magazine in the slot, creating it if necessary.
+	// Returns null if another thread currently holds the magazine.
+	Magazine* claimMagazine(std::atomic<Magazine*>& slot) {
+		Magazine* mag = slot.exchange(kMagazineInUse, std::memory_order_acquire);
+		if (mag == kMagazineInUse) { return nullptr; }
+		return mag ? mag : new Magazine();
+	}
+
+	// Links the objects at the top of the magazine together, and pushes them onto the depot in one operation.
+	void moveToDepot(Magazine* mag, size_t count) {
+		if ( !count ) { return; }
+		T* first = mag->objects[mag->count - 1];
+		T* last = first;
+		for (size_t i = 1; i < count; i++) {
+			T* obj = mag->objects[mag->count - 1 - i];
+			MVKLockFreeStack<T>::setNext(last, obj);
+			last = obj;
+		}
+		mag->count -= count;
+		_depot.pushList(first, last);
+	}
+
+	MVKLockFreeStack<T> _depot;
+	std::atomic<Magazine*> _slots[SlotCount];
+};
+
+template <class T, size_t MagazineCapacity, size_t SlotCount>
+typename MVKMagazineCache<T, MagazineCapacity, SlotCount>::Magazine* const
+MVKMagazineCache<T, MagazineCapacity, SlotCount>::kMagazineInUse = (typename MVKMagazineCache<T, MagazineCapacity, SlotCount>::Magazine*)alignof(Magazine);
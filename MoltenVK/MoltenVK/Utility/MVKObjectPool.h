@@ -20,6 +20,7 @@
 #pragma once
 
 #include "MVKBaseObject.h"
+#include "MVKLockFreeStack.h"
 #include <mutex>
 
 
@@ -69,6 +70,12 @@ typedef struct MVKObjectPoolCounts {
  * This pool includes member functions for managing resources in either a thread-safe,
  * or somewhat faster, but not-thread-safe manner.
  *
+ * An instance of this pool can be configured to be lock-free, in which case the thread-safe
+ * functions acquire and return objects through per-thread caches, in front of a lock-free
+ * list of available objects, and only take a lock when a new object must be created. The
+ * newObject() function is always called while holding that lock. A lock-free pool must only
+ * be accessed through the thread-safe functions.
+ *
  * An instance of this pool can be configured to either manage a pool of objects,
  * or simply allocate a new object instance on each request and destroy the object
  * when it is released back to the pool.
@@ -127,32 +134,70 @@ public:
 
 	/** A thread-safe version of the acquireObject() function. */
 	T* acquireObjectSafely() {
+		if (_threadCache) {
+			T* obj = _threadCache->acquire();
+			if (obj) { return obj; }
+		}
+
 		std::lock_guard<std::mutex> lock(_lock);
 		return acquireObject();
 	}
 
 	/** A thread-safe version of the returnObject() function. */
 	void returnObjectSafely(T* obj) {
+		if (_threadCache) {
+			if (obj) { _threadCache->release(obj); }
+			return;
+		}
+
 		std::lock_guard<std::mutex> lock(_lock);
 		returnObject(obj);
 	}
 
-	/** Clears all the objects from this pool, destroying each one. This method is thread-safe. */
+	/**
+	 * Clears all the objects from this pool, destroying each one. This method is thread-safe,
+	 * but for a lock-free pool, must not be called while objects are being acquired or returned.
+	 */
 	void clear() {
         std::lock_guard<std::mutex> lock(_lock);
 		while ( T* obj = nextObject() ) { destroyObject(obj); }
+
+		T* obj = _threadCache ? _threadCache->removeAll() : nullptr;
+		while (obj) {
+			T* nextObj = (T*)obj->_next;
+			obj->_next = nullptr;
+			destroyObject(obj);
+			obj = nextObj;
+		}
 	}
 
-	/** Returns the current counts. */
-	MVKObjectPoolCounts getCounts() { return _counts; }
+	/** Returns whether this pool is lock-free. */
+	bool isLockFree() { return _threadCache != nullptr; }
+
+	/**
+	 * Returns the current counts. This method is thread-safe for a lock-free pool, but the
+	 * resident count of a lock-free pool does not include objects held in its per-thread caches.
+	 */
+	MVKObjectPoolCounts getCounts() {
+		if ( !_threadCache ) { return _counts; }
+
+		std::lock_guard<std::mutex> lock(_lock);
+		return _counts;
+	}
 
 	/**
 	 * Configures this instance to either use pooling, or not, depending on the
-	 * value of isPooling, which defaults to true if not indicated explicitly.
+	 * value of isPooling, which defaults to true if not indicated explicitly,
+	 * and to be lock-free, or not, depending on the value of isLockFree.
 	 */
-    MVKObjectPool(bool isPooling = true) : _isPooling(isPooling) {}
+    MVKObjectPool(bool isPooling = true, bool isLockFree = false) :
+		_threadCache(isPooling && isLockFree ? new MVKMagazineCache<T>() : nullptr),
+		_isPooling(isPooling) {}
 
-	~MVKObjectPool() override { clear(); }
+	~MVKObjectPool() override {
+		clear();
+		delete _threadCache;
+	}
 
 protected:
 
@@ -182,6 +227,7 @@ protected:
 	}
 
     std::mutex _lock;
+	MVKMagazineCache<T>* _threadCache;
 	T* _head = nullptr;
 	T* _tail = nullptr;
 	bool _isPooling;
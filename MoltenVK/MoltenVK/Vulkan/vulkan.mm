@@ -90,14 +90,27 @@ static inline void MVKTraceVulkanCallEndImpl(const char* funcName, uint64_t star
 // Create and configure a command of particular type.
 // If the command is configured correctly, add it to the buffer,
 // otherwise indicate the configuration error to the command buffer.
+// If the command buffer is streaming commands, the command is configured
+// on the stack, and encoded immediately, instead of being added to the buffer.
 #define MVKAddCmd(cmdType, vkCmdBuff, ...)  													\
 	MVKCommandBuffer* cmdBuff = MVKCommandBuffer::getMVKCommandBuffer(vkCmdBuff);				\
-	MVKCmd ##cmdType* cmd = cmdBuff->getCommandPool()->_cmd ##cmdType ##Pool.acquireObject();	\
-	VkResult cmdRslt = cmd->setContent(cmdBuff, ##__VA_ARGS__);									\
-	if (cmdRslt == VK_SUCCESS) {																\
-		cmdBuff->addCommand(cmd);																\
+	if (MVKCmd ##cmdType::canStream() && cmdBuff->isStreamingCommands()) {						\
+		MVKCmd ##cmdType cmd;																	\
+		VkResult cmdRslt = cmd.setContent(cmdBuff, ##__VA_ARGS__);								\
+		if (cmdRslt == VK_SUCCESS) {															\
+			cmdBuff->encodeStreamedCommand(&cmd);												\
+		} else {																				\
+			cmdBuff->setConfigurationResult(cmdRslt);											\
+		}																						\
 	} else {																					\
-		cmdBuff->setConfigurationResult(cmdRslt);												\
+		MVKCmd ##cmdType* cmd = cmdBuff->acquireCommand(cmdBuff->getCommandPool()->_cmd ##cmdType ##Pool);	\
+		VkResult cmdRslt = cmd->setContent(cmdBuff, ##__VA_ARGS__);								\
+		if (cmdRslt == VK_SUCCESS) {															\
+			cmdBuff->addCommand(cmd);															\
+		} else {																				\
+			cmdBuff->releaseCommand(cmd);														\
+			cmdBuff->setConfigurationResult(cmdRslt);											\
+		}																						\
 	}
 
 // Add one of two commands, based on comparing a command parameter against a threshold value
@@ -21,7 +21,14 @@
 #include "MVKStrings.h"
 #include "FileSupport.h"
 #include "SPIRVSupport.h"
+#include <spirv_parser.hpp>
+#include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <iterator>
+#include <tuple>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace mvk;
 using namespace std;
@@ -46,6 +53,75 @@ bool containsMatching(const vector<T>& vec, const T& val) {
     return false;
 }
 
+// Canonical sort keys. Elements with the same key may still differ in other content.
+static uint32_t canonicalKey(uint32_t val) { return val; }
+static uint32_t canonicalKey(const mvk::MSLShaderInput& si) { return si.shaderInput.location; }
+static tuple<uint32_t, uint32_t, uint32_t> canonicalKey(const mvk::MSLResourceBinding& rb) {
+	auto& rbb = rb.resourceBinding;
+	return make_tuple(uint32_t(rbb.stage), rbb.desc_set, rbb.binding);
+}
+static tuple<uint32_t, uint32_t, uint32_t, uint32_t> canonicalKey(const DescriptorBinding& db) {
+	return make_tuple(uint32_t(db.stage), db.descriptorSet, db.binding, db.index);
+}
+
+static bool elementsMatch(uint32_t val, uint32_t other) { return val == other; }
+template<class T>
+static bool elementsMatch(const T& val, const T& other) { return val.matches(other); }
+
+// Stable sort, so elements with the same key, such as a builtin shader input sharing a location
+// with another input, remain in the order in which they will be added to the SPIRV-Cross compiler.
+template<class T>
+static void canonicalize(vector<T>& vec) {
+	stable_sort(vec.begin(), vec.end(), [](const T& a, const T& b) { return canonicalKey(a) < canonicalKey(b); });
+}
+
+template<class T>
+static bool isCanonical(const vector<T>& vec) {
+	return is_sorted(vec.begin(), vec.end(), [](const T& a, const T& b) { return canonicalKey(a) < canonicalKey(b); });
+}
+
+// Returns whether each element of the source that passes the filter, matches an element of the
+// container, using a single merge-walk through both. Both vectors must be in canonical order.
+template<class T, class F>
+static bool containsAllCanonical(const vector<T>& container, const vector<T>& src, F filter) {
+	auto cIter = container.begin();
+	auto cEnd = container.end();
+	for (const T& sVal : src) {
+		if ( !filter(sVal) ) { continue; }
+		auto sKey = canonicalKey(sVal);
+		while (cIter != cEnd && canonicalKey(*cIter) < sKey) { cIter++; }
+		bool isFound = false;
+		for (auto runIter = cIter; !isFound && runIter != cEnd && canonicalKey(*runIter) == sKey; runIter++) {
+			isFound = elementsMatch(*runIter, sVal);
+		}
+		if ( !isFound ) { return false; }
+	}
+	return true;
+}
+
+// Accumulates a 64-bit FNV-1a hash of the bytes onto the seed value.
+static size_t hashBytes(const void* pBytes, size_t byteCount, size_t seed = 14695981039346656037ULL) {
+	size_t hash = seed;
+	auto* pByte = (const uint8_t*)pBytes;
+	for (size_t i = 0; i < byteCount; i++) { hash = (hash ^ pByte[i]) * 1099511628211ULL; }
+	return hash;
+}
+
+// Accumulates a hash of the value onto the seed value.
+template<class T>
+static size_t hashValue(const T& val, size_t seed) { return hashBytes(&val, sizeof(val), seed); }
+
+// Avalanches the bits of the hash, so that hashes can be combined by summing them.
+static size_t finalizeHash(size_t hash) {
+	uint64_t h = hash;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return (size_t)h;
+}
+
 MVK_PUBLIC_SYMBOL bool SPIRVToMSLConversionOptions::matches(const SPIRVToMSLConversionOptions& other) const {
 	if (memcmp(&mslOptions, &other.mslOptions, sizeof(mslOptions)) != 0) { return false; }
 	if (entryPointStage != other.entryPointStage) { return false; }
@@ -56,6 +132,16 @@ MVK_PUBLIC_SYMBOL bool SPIRVToMSLConversionOptions::matches(const SPIRVToMSLConv
 	return true;
 }
 
+MVK_PUBLIC_SYMBOL size_t SPIRVToMSLConversionOptions::hash() const {
+	size_t h = hashBytes(&mslOptions, sizeof(mslOptions));
+	h = hashValue(entryPointStage, h);
+	h = hashBytes(entryPointName.data(), entryPointName.size(), h);
+	h = hashValue(tessPatchKind, h);
+	h = hashValue(numTessControlPoints, h);
+	h = hashValue(shouldFlipVertexY, h);
+	return finalizeHash(h);
+}
+
 MVK_PUBLIC_SYMBOL string SPIRVToMSLConversionOptions::printMSLVersion(uint32_t mslVersion, bool includePatch) {
 	string verStr;
 
@@ -100,6 +186,10 @@ MVK_PUBLIC_SYMBOL bool mvk::MSLShaderInput::matches(const mvk::MSLShaderInput& o
 	return true;
 }
 
+MVK_PUBLIC_SYMBOL size_t mvk::MSLShaderInput::hash() const {
+	return finalizeHash(hashValue(binding, hashBytes(&shaderInput, sizeof(shaderInput))));
+}
+
 MVK_PUBLIC_SYMBOL mvk::MSLShaderInput::MSLShaderInput() {
 	// Explicitly set shaderInput to defaults over cleared memory to ensure all instances
 	// have exactly the same memory layout when using memory comparison in matches().
@@ -117,6 +207,13 @@ MVK_PUBLIC_SYMBOL bool mvk::MSLResourceBinding::matches(const MSLResourceBinding
 	return true;
 }
 
+MVK_PUBLIC_SYMBOL size_t mvk::MSLResourceBinding::hash() const {
+	size_t h = hashBytes(&resourceBinding, sizeof(resourceBinding));
+	h = hashValue(requiresConstExprSampler, h);
+	if (requiresConstExprSampler) { h = hashValue(constExprSampler, h); }
+	return finalizeHash(h);
+}
+
 MVK_PUBLIC_SYMBOL mvk::MSLResourceBinding::MSLResourceBinding() {
 	// Explicitly set resourceBinding and constExprSampler to defaults over cleared memory to ensure
 	// all instances have exactly the same memory layout when using memory comparison in matches().
@@ -180,19 +277,28 @@ MVK_PUBLIC_SYMBOL bool SPIRVToMSLConversionConfiguration::matches(const SPIRVToM
 
     if ( !options.matches(other.options) ) { return false; }
 
+	auto isUsedSI = [](const mvk::MSLShaderInput& si) { return si.outIsUsedByShader; };
+	auto isUsedRB = [this](const mvk::MSLResourceBinding& rb) { return isUsedByStage(rb); };
+	auto isStageDB = [this](const DescriptorBinding& db) { return db.stage == options.entryPointStage; };
+	auto isAny = [](uint32_t) { return true; };
+
+	if (isCanonical() && other.isCanonical()) {
+		return (containsAllCanonical(other.shaderInputs, shaderInputs, isUsedSI) &&
+				containsAllCanonical(other.resourceBindings, resourceBindings, isUsedRB) &&
+				containsAllCanonical(other.dynamicBufferDescriptors, dynamicBufferDescriptors, isStageDB) &&
+				containsAllCanonical(other.discreteDescriptorSets, discreteDescriptorSets, isAny));
+	}
+
 	for (const auto& si : shaderInputs) {
-		if (si.outIsUsedByShader && !containsMatching(other.shaderInputs, si)) { return false; }
+		if (isUsedSI(si) && !containsMatching(other.shaderInputs, si)) { return false; }
 	}
 
     for (const auto& rb : resourceBindings) {
-        if (rb.resourceBinding.stage == options.entryPointStage &&
-			rb.outIsUsedByShader &&
-			!containsMatching(other.resourceBindings, rb)) { return false; }
+        if (isUsedRB(rb) && !containsMatching(other.resourceBindings, rb)) { return false; }
     }
 
 	for (const auto& db : dynamicBufferDescriptors) {
-		if (db.stage == options.entryPointStage &&
-			!containsMatching(other.dynamicBufferDescriptors, db)) { return false; }
+		if (isStageDB(db) && !containsMatching(other.dynamicBufferDescriptors, db)) { return false; }
 	}
 
 	for (uint32_t dsIdx : discreteDescriptorSets) {
@@ -202,24 +308,71 @@ MVK_PUBLIC_SYMBOL bool SPIRVToMSLConversionConfiguration::matches(const SPIRVToM
     return true;
 }
 
+MVK_PUBLIC_SYMBOL void SPIRVToMSLConversionConfiguration::canonicalize() {
+	::canonicalize(shaderInputs);
+	::canonicalize(resourceBindings);
+	::canonicalize(discreteDescriptorSets);
+	::canonicalize(dynamicBufferDescriptors);
+}
 
-MVK_PUBLIC_SYMBOL void SPIRVToMSLConversionConfiguration::alignWith(const SPIRVToMSLConversionConfiguration& srcContext) {
+MVK_PUBLIC_SYMBOL bool SPIRVToMSLConversionConfiguration::isCanonical() const {
+	return (::isCanonical(shaderInputs) &&
+			::isCanonical(resourceBindings) &&
+			::isCanonical(discreteDescriptorSets) &&
+			::isCanonical(dynamicBufferDescriptors));
+}
 
-	for (auto& si : shaderInputs) {
-		si.outIsUsedByShader = false;
-		for (auto& srcSI : srcContext.shaderInputs) {
-			if (si.matches(srcSI)) { si.outIsUsedByShader = srcSI.outIsUsedByShader; }
-		}
+// Summing the element hashes makes the digest independent of the order of the elements.
+// Only elements considered by matches() are included, so the digest is consistent with it.
+MVK_PUBLIC_SYMBOL size_t SPIRVToMSLConversionConfiguration::getUsedDigest() const {
+	size_t digest = options.hash();
+	for (const auto& si : shaderInputs) {
+		if (si.outIsUsedByShader) { digest += si.hash(); }
+	}
+	for (const auto& rb : resourceBindings) {
+		if (isUsedByStage(rb)) { digest += rb.hash(); }
 	}
+	return digest;
+}
 
-    for (auto& rb : resourceBindings) {
-        rb.outIsUsedByShader = false;
-        for (auto& srcRB : srcContext.resourceBindings) {
-			if (rb.matches(srcRB)) {
-				rb.outIsUsedByShader = srcRB.outIsUsedByShader;
+MVK_PUBLIC_SYMBOL size_t SPIRVToMSLConversionConfiguration::getDigest() const {
+	size_t digest = options.hash();
+	for (const auto& si : shaderInputs) { digest += si.hash(); }
+	for (const auto& rb : resourceBindings) {
+		if (rb.resourceBinding.stage == options.entryPointStage) { digest += rb.hash(); }
+	}
+	return digest;
+}
+
+
+// Sets the used state of each element of the destination to that of the last matching
+// element in the source, or to false if there is no matching element in the source.
+// If both vectors are in canonical order, does so with a single merge-walk through both.
+template<class T>
+static void alignUsage(vector<T>& dest, const vector<T>& src, bool areCanonical) {
+	auto sIter = src.begin();
+	auto sEnd = src.end();
+	for (auto& dVal : dest) {
+		dVal.outIsUsedByShader = false;
+		if (areCanonical) {
+			auto dKey = canonicalKey(dVal);
+			while (sIter != sEnd && canonicalKey(*sIter) < dKey) { sIter++; }
+			for (auto runIter = sIter; runIter != sEnd && canonicalKey(*runIter) == dKey; runIter++) {
+				if (dVal.matches(*runIter)) { dVal.outIsUsedByShader = runIter->outIsUsedByShader; }
 			}
-        }
-    }
+		} else {
+			for (auto& sVal : src) {
+				if (dVal.matches(sVal)) { dVal.outIsUsedByShader = sVal.outIsUsedByShader; }
+			}
+		}
+	}
+}
+
+MVK_PUBLIC_SYMBOL void SPIRVToMSLConversionConfiguration::alignWith(const SPIRVToMSLConversionConfiguration& srcContext) {
+	alignUsage(shaderInputs, srcContext.shaderInputs,
+			   ::isCanonical(shaderInputs) && ::isCanonical(srcContext.shaderInputs));
+	alignUsage(resourceBindings, srcContext.resourceBindings,
+			   ::isCanonical(resourceBindings) && ::isCanonical(srcContext.resourceBindings));
 }
 
 
@@ -228,6 +381,7 @@ MVK_PUBLIC_SYMBOL void SPIRVToMSLConversionConfiguration::alignWith(const SPIRVT
 
 MVK_PUBLIC_SYMBOL void SPIRVToMSLConverter::setSPIRV(const uint32_t* spirvCode, size_t length) {
 	_spirv.clear();			// Clear for reuse
+	_parsedIR.reset();
 	_spirv.reserve(length);
 	for (size_t i = 0; i < length; i++) {
 		_spirv.push_back(spirvCode[i]);
@@ -256,7 +410,14 @@ MVK_PUBLIC_SYMBOL bool SPIRVToMSLConverter::convert(SPIRVToMSLConversionConfigur
 #ifndef SPIRV_CROSS_EXCEPTIONS_TO_ASSERTIONS
 	try {
 #endif
-		pMSLCompiler = new CompilerMSL(_spirv);
+		// Parse the SPIR-V once, and compile each configuration from a copy of the parsed IR,
+		// because the compiler modifies the IR while compiling.
+		if ( !_parsedIR ) {
+			Parser spvParser(_spirv.data(), _spirv.size());
+			spvParser.parse();
+			_parsedIR = make_shared<const ParsedIR>(std::move(spvParser.get_parsed_ir()));
+		}
+		pMSLCompiler = new CompilerMSL(*_parsedIR);
 
 		if (shaderConfig.options.hasEntryPoint()) {
 			pMSLCompiler->set_entry_point(shaderConfig.options.entryPointName, shaderConfig.options.entryPointStage);
@@ -371,7 +532,7 @@ MVK_PUBLIC_SYMBOL bool SPIRVToMSLConverter::convert(SPIRVToMSLConversionConfigur
 #ifndef SPIRV_CROSS_EXCEPTIONS_TO_ASSERTIONS
 		try {
 #endif
-			pGLSLCompiler = new CompilerGLSL(_spirv);
+			pGLSLCompiler = _parsedIR ? new CompilerGLSL(*_parsedIR) : new CompilerGLSL(_spirv);
 			auto options = pGLSLCompiler->get_common_options();
 			options.vulkan_semantics = true;
 			options.separate_shader_objects = true;
@@ -499,3 +660,251 @@ void SPIRVToMSLConverter::populateEntryPoint(Compiler* pCompiler,
 	populateWorkgroupDimension(wgSize.height, spvEP.workgroup_size.y, heightSC);
 	populateWorkgroupDimension(wgSize.depth, spvEP.workgroup_size.z, depthSC);
 }
+
+
+#pragma mark -
+#pragma mark SPIRVToMSLConversionCache
+
+// Identifies the layout of the cache files. Increment when the layout or key content changes.
+static const uint32_t kSPIRVToMSLConversionCacheMagic = 0x43534D4D;		// "MMSC"
+static const uint32_t kSPIRVToMSLConversionCacheFormatVersion = 2;
+
+// Appends the binary content of values to a string.
+class ConversionCacheWriter {
+public:
+	template<class T>
+	void write(const T& val) { _bytes.append((const char*)&val, sizeof(val)); }
+	void write(const string& str) { write((uint64_t)str.size()); _bytes.append(str); }
+	void write(const SPIRVWorkgroupSizeDimension& wgDim) {
+		write(wgDim.size);
+		write(wgDim.specializationID);
+		write(wgDim.isSpecialized);
+	}
+	string& getBytes() { return _bytes; }
+
+protected:
+	string _bytes;
+};
+
+// Reads values from the binary content of a string, written by a ConversionCacheWriter.
+// If an attempt is made to read beyond the end of the content, the reader is marked as failed.
+class ConversionCacheReader {
+public:
+	template<class T>
+	void read(T& val) {
+		if ( !canRead(sizeof(val)) ) { return; }
+		memcpy(&val, &_bytes[_pos], sizeof(val));
+		_pos += sizeof(val);
+	}
+	void read(string& str) {
+		uint64_t len = 0;
+		read(len);
+		if ( !canRead(len) ) { return; }
+		str.assign(&_bytes[_pos], len);
+		_pos += len;
+	}
+	void read(SPIRVWorkgroupSizeDimension& wgDim) {
+		read(wgDim.size);
+		read(wgDim.specializationID);
+		read(wgDim.isSpecialized);
+	}
+	bool readMatch(const string& expected) {
+		if ( !canRead(expected.size()) || _bytes.compare(_pos, expected.size(), expected) != 0 ) { return fail(); }
+		_pos += expected.size();
+		return true;
+	}
+	bool isAtEnd() { return _isValid && _pos == _bytes.size(); }
+	bool isValid() { return _isValid; }
+
+	ConversionCacheReader(const string& bytes) : _bytes(bytes) {}
+
+protected:
+	bool canRead(uint64_t byteCount) { return (_isValid && byteCount <= _bytes.size() - _pos) || fail(); }
+	bool fail() { _isValid = false; return false; }
+
+	const string& _bytes;
+	size_t _pos = 0;
+	bool _isValid = true;
+};
+
+// Creates the directory, and any missing parent directories. Returns whether the directory exists.
+static bool makeDirectories(const string& dirPath) {
+	struct stat st;
+	if (stat(dirPath.c_str(), &st) == 0) { return S_ISDIR(st.st_mode); }
+
+	size_t sepPos = dirPath.find_last_of('/');
+	if (sepPos != string::npos && sepPos > 0) { makeDirectories(dirPath.substr(0, sepPos)); }
+
+	// Another process may have created the directory concurrently.
+	return mkdir(dirPath.c_str(), 0755) == 0 || (stat(dirPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode));
+}
+
+// The key contains everything that affects the conversion, except the used flags, which are results of it.
+// The SPIR-V code is represented by its size and 128-bit hash, to avoid holding a copy of it in each cache file.
+string SPIRVToMSLConversionCache::getKey(const vector<uint32_t>& spirv,
+										 const MVKHash128& spirvHash,
+										 const SPIRVToMSLConversionConfiguration& shaderConfig) const {
+	ConversionCacheWriter key;
+	key.write(kSPIRVToMSLConversionCacheMagic);
+	key.write(kSPIRVToMSLConversionCacheFormatVersion);
+	key.write(_revision);
+
+	key.write((uint64_t)spirv.size());
+	key.write(spirvHash.lo);
+	key.write(spirvHash.hi);
+
+	auto& opts = shaderConfig.options;
+	key.write(opts.mslOptions);
+	key.write(opts.entryPointName);
+	key.write(opts.entryPointStage);
+	key.write(opts.tessPatchKind);
+	key.write(opts.numTessControlPoints);
+	key.write(opts.shouldFlipVertexY);
+
+	key.write((uint64_t)shaderConfig.shaderInputs.size());
+	for (auto& si : shaderConfig.shaderInputs) {
+		key.write(si.shaderInput);
+		key.write(si.binding);
+	}
+
+	key.write((uint64_t)shaderConfig.resourceBindings.size());
+	for (auto& rb : shaderConfig.resourceBindings) {
+		key.write(rb.resourceBinding);
+		key.write(rb.requiresConstExprSampler);
+		if (rb.requiresConstExprSampler) { key.write(rb.constExprSampler); }
+	}
+
+	key.write((uint64_t)shaderConfig.discreteDescriptorSets.size());
+	for (uint32_t dsIdx : shaderConfig.discreteDescriptorSets) { key.write(dsIdx); }
+
+	key.write((uint64_t)shaderConfig.dynamicBufferDescriptors.size());
+	for (auto& db : shaderConfig.dynamicBufferDescriptors) {
+		key.write(db.stage);
+		key.write(db.descriptorSet);
+		key.write(db.binding);
+		key.write(db.index);
+	}
+
+	return std::move(key.getBytes());
+}
+
+string SPIRVToMSLConversionCache::getFilePath(const string& key) const {
+	char fileName[32];
+	snprintf(fileName, sizeof(fileName), "%016llx.mslcache", (unsigned long long)finalizeHash(hashBytes(key.data(), key.size())));
+	return _dirPath + "/" + fileName;
+}
+
+MVK_PUBLIC_SYMBOL bool SPIRVToMSLConversionCache::read(const vector<uint32_t>& spirv,
+													   const MVKHash128& spirvHash,
+													   SPIRVToMSLConversionConfiguration& shaderConfig,
+													   string& msl,
+													   SPIRVToMSLConversionResults& conversionResults) const {
+	if ( !_isValid ) { return false; }
+
+	string key = getKey(spirv, spirvHash, shaderConfig);
+	ifstream inFile(getFilePath(key), ios::in | ios::binary);
+	if (inFile.fail()) { return false; }
+
+	string bytes((istreambuf_iterator<char>(inFile)), istreambuf_iterator<char>());
+	if (inFile.bad()) { return false; }
+
+	ConversionCacheReader rdr(bytes);
+	if ( !rdr.readMatch(key) ) { return false; }
+
+	// Read into temporaries, and only update the parameters once the entire file has been validated.
+	vector<uint8_t> siUsage(shaderConfig.shaderInputs.size());
+	for (auto& isUsed : siUsage) { rdr.read(isUsed); }
+	vector<uint8_t> rbUsage(shaderConfig.resourceBindings.size());
+	for (auto& isUsed : rbUsage) { rdr.read(isUsed); }
+
+	SPIRVToMSLConversionResults rslts;
+	auto& ep = rslts.entryPoint;
+	rdr.read(ep.mtlFunctionName);
+	rdr.read(ep.workgroupSize.width);
+	rdr.read(ep.workgroupSize.height);
+	rdr.read(ep.workgroupSize.depth);
+	rdr.read(ep.supportsFastMath);
+	rdr.read(rslts.isRasterizationDisabled);
+	rdr.read(rslts.isPositionInvariant);
+	rdr.read(rslts.needsSwizzleBuffer);
+	rdr.read(rslts.needsOutputBuffer);
+	rdr.read(rslts.needsPatchOutputBuffer);
+	rdr.read(rslts.needsBufferSizeBuffer);
+	rdr.read(rslts.needsDynamicOffsetBuffer);
+	rdr.read(rslts.needsInputThreadgroupMem);
+	rdr.read(rslts.needsDispatchBaseBuffer);
+	rdr.read(rslts.needsViewRangeBuffer);
+
+	string mslCode;
+	rdr.read(mslCode);
+	if ( !rdr.isAtEnd() ) { return false; }
+
+	for (size_t siIdx = 0; siIdx < siUsage.size(); siIdx++) {
+		shaderConfig.shaderInputs[siIdx].outIsUsedByShader = siUsage[siIdx];
+	}
+	for (size_t rbIdx = 0; rbIdx < rbUsage.size(); rbIdx++) {
+		shaderConfig.resourceBindings[rbIdx].outIsUsedByShader = rbUsage[rbIdx];
+	}
+	conversionResults = rslts;
+	msl = std::move(mslCode);
+
+	return true;
+}
+
+MVK_PUBLIC_SYMBOL bool SPIRVToMSLConversionCache::write(const vector<uint32_t>& spirv,
+														const MVKHash128& spirvHash,
+														const SPIRVToMSLConversionConfiguration& shaderConfig,
+														const string& msl,
+														const SPIRVToMSLConversionResults& conversionResults) const {
+	if ( !_isValid ) { return false; }
+
+	string key = getKey(spirv, spirvHash, shaderConfig);
+
+	ConversionCacheWriter wtr;
+	wtr.getBytes() = key;
+	for (auto& si : shaderConfig.shaderInputs) { wtr.write((uint8_t)si.outIsUsedByShader); }
+	for (auto& rb : shaderConfig.resourceBindings) { wtr.write((uint8_t)rb.outIsUsedByShader); }
+
+	auto& ep = conversionResults.entryPoint;
+	wtr.write(ep.mtlFunctionName);
+	wtr.write(ep.workgroupSize.width);
+	wtr.write(ep.workgroupSize.height);
+	wtr.write(ep.workgroupSize.depth);
+	wtr.write(ep.supportsFastMath);
+	wtr.write(conversionResults.isRasterizationDisabled);
+	wtr.write(conversionResults.isPositionInvariant);
+	wtr.write(conversionResults.needsSwizzleBuffer);
+	wtr.write(conversionResults.needsOutputBuffer);
+	wtr.write(conversionResults.needsPatchOutputBuffer);
+	wtr.write(conversionResults.needsBufferSizeBuffer);
+	wtr.write(conversionResults.needsDynamicOffsetBuffer);
+	wtr.write(conversionResults.needsInputThreadgroupMem);
+	wtr.write(conversionResults.needsDispatchBaseBuffer);
+	wtr.write(conversionResults.needsViewRangeBuffer);
+	wtr.write(msl);
+
+	// Write to a temporary file that is unique to this process and write, then rename it into place,
+	// which atomically replaces any existing file, so readers never see a partially written file.
+	static atomic<uint32_t> _tmpFileCount(0);
+	string filePath = getFilePath(key);
+	string tmpFilePath = filePath + "." + to_string(getpid()) + "." + to_string(_tmpFileCount++) + ".tmp";
+
+	ofstream outFile(tmpFilePath, ios::out | ios::binary | ios::trunc);
+	if (outFile.fail()) { return false; }
+	const string& bytes = wtr.getBytes();
+	outFile.write(bytes.data(), bytes.size());
+	outFile.close();
+
+	if (outFile.fail() || rename(tmpFilePath.c_str(), filePath.c_str()) != 0) {
+		remove(tmpFilePath.c_str());
+		return false;
+	}
+	return true;
+}
+
+MVK_PUBLIC_SYMBOL SPIRVToMSLConversionCache::SPIRVToMSLConversionCache(const string& dirPath, const string& revision) {
+	_dirPath = dirPath;
+	while (_dirPath.size() > 1 && _dirPath.back() == '/') { _dirPath.pop_back(); }
+	_revision = revision.empty() ? string(__DATE__ " " __TIME__) : revision;
+	_isValid = !_dirPath.empty() && makeDirectories(_dirPath);
+}
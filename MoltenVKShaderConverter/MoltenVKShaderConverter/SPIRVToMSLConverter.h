@@ -19,8 +19,10 @@
 #ifndef __SPIRVToMSLConverter_h_
 #define __SPIRVToMSLConverter_h_ 1
 
+#include "MVKHash.h"
 #include <spirv.hpp>
 #include <spirv_msl.hpp>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -50,6 +52,9 @@ namespace mvk {
 		 */
 		bool matches(const SPIRVToMSLConversionOptions& other) const;
 
+		/** Returns a hash of the elements compared by matches(). Options that match have the same hash. */
+		std::size_t hash() const;
+
 		bool hasEntryPoint() const {
 			return !entryPointName.empty() && entryPointStage != spv::ExecutionModelMax;
 		}
@@ -82,6 +87,9 @@ namespace mvk {
 		 */
 		bool matches(const MSLShaderInput& other) const;
 
+		/** Returns a hash of the elements compared by matches(). Shader inputs that match have the same hash. */
+		std::size_t hash() const;
+
 		MSLShaderInput();
 
 	} MSLShaderInput;
@@ -117,6 +125,9 @@ namespace mvk {
 		 */
 		bool matches(const MSLResourceBinding& other) const;
 
+		/** Returns a hash of the elements compared by matches(). Resource bindings that match have the same hash. */
+		std::size_t hash() const;
+
 		MSLResourceBinding();
 
 	} MSLResourceBinding;
@@ -178,9 +189,49 @@ namespace mvk {
          */
         bool matches(const SPIRVToMSLConversionConfiguration& other) const;
 
+		/**
+		 * Returns an order-independent digest of the options, and of the shader inputs and the
+		 * resource bindings of the entry point stage, that are used by the shader. It is the sum
+		 * of options.hash() and the hash() of each of those used shader inputs and resource bindings.
+		 *
+		 * If this configuration matches() another configuration, summing options.hash() of the other
+		 * configuration with the hash() of the element in the other configuration that matches each
+		 * used element of this configuration will produce this same digest. This allows a cache of
+		 * configurations to be indexed by digest, and verified with a single call to matches().
+		 */
+		std::size_t getUsedDigest() const;
+
+		/**
+		 * Returns an order-independent digest of the options, and of all of the shader inputs and the
+		 * resource bindings of the entry point stage, whether or not they are used by the shader.
+		 * Unlike getUsedDigest(), this digest can be retrieved before the shader has been converted,
+		 * and configurations that will produce the same conversion results have the same digest.
+		 */
+		std::size_t getDigest() const;
+
+		/** Returns whether the resource binding is in the entry point stage and is used by the shader. */
+		bool isUsedByStage(const MSLResourceBinding& rb) const {
+			return rb.outIsUsedByShader && rb.resourceBinding.stage == options.entryPointStage;
+		}
+
         /** Aligns certain aspects of this configuration with the source configuration. */
         void alignWith(const SPIRVToMSLConversionConfiguration& srcContext);
 
+		/**
+		 * Sorts the content of this configuration into canonical order. Shader inputs are sorted
+		 * by location, resource bindings and dynamic buffer descriptors by stage, descriptor set
+		 * and binding, and discrete descriptor sets by index. The sort is stable, so elements that
+		 * share the same key retain their relative order, and conversion results are unaffected.
+		 *
+		 * When both configurations are in canonical order, matches() and alignWith() compare them
+		 * using a single merge-walk through each set of elements, instead of a nested search.
+		 * This should be called after the configuration content is populated or changed.
+		 */
+		void canonicalize();
+
+		/** Returns whether the content of this configuration is in canonical order. */
+		bool isCanonical() const;
+
 	} SPIRVToMSLConversionConfiguration;
 
 
@@ -252,7 +303,7 @@ namespace mvk {
 	public:
 
 		/** Sets the SPIRV code. */
-		void setSPIRV(const std::vector<uint32_t>& spirv) { _spirv = spirv; }
+		void setSPIRV(const std::vector<uint32_t>& spirv) { _spirv = spirv; _parsedIR.reset(); }
 
 		/**
 		 * Sets the SPIRV code from the specified array of values.
@@ -269,6 +320,10 @@ namespace mvk {
 		/**
 		 * Converts SPIR-V code, set using setSPIRV() to MSL code, which can be retrieved using getMSL().
 		 *
+		 * The SPIR-V code is parsed the first time it is converted, and the parsed representation is
+		 * retained until the SPIR-V code is changed, so converting the same SPIR-V code under several
+		 * configurations only needs to parse it once.
+		 *
 		 * The boolean flags indicate whether the original SPIR-V code, the resulting MSL code, 
          * and optionally, the original GLSL (as converted from the SPIR_V), should be logged 
          * to the result log of this converter. This can be useful during shader debugging.
@@ -325,11 +380,110 @@ namespace mvk {
 		void populateEntryPoint(SPIRV_CROSS_NAMESPACE::Compiler* pCompiler, SPIRVToMSLConversionOptions& options);
 
 		std::vector<uint32_t> _spirv;
+		std::shared_ptr<const SPIRV_CROSS_NAMESPACE::ParsedIR> _parsedIR;
 		std::string _msl;
 		std::string _resultLog;
 		SPIRVToMSLConversionResults _shaderConversionResults;
 		bool _wasConverted = false;
 	};
 
+
+#pragma mark -
+#pragma mark SPIRVToMSLConversionCache
+
+	/**
+	 * A persistent cache of SPIR-V to MSL conversions, held in a directory in the file system,
+	 * which allows conversions performed by one process to be reused by subsequent processes.
+	 *
+	 * Each conversion is held in its own file, named by a digest of a key that contains the size and
+	 * 128-bit mvkHash128() of the SPIR-V code, the entire content of the shader conversion configuration,
+	 * and the revision of the converter. The file holds the MSL code, the conversion results, and which
+	 * shader inputs and resource bindings are used by the shader. The key content is also held in the
+	 * file, and is verified on read, so a file whose name collides with that of another conversion is
+	 * treated as a cache miss.
+	 *
+	 * Each file is written to a uniquely-named temporary file, and then renamed into place, so
+	 * multiple processes and threads can safely share the same cache directory. Any file that
+	 * is missing, incomplete, or unreadable is treated as a cache miss.
+	 */
+	class SPIRVToMSLConversionCache {
+
+	public:
+
+		/** Returns the path to the directory holding the cache content. */
+		const std::string& getDirectoryPath() const { return _dirPath; }
+
+		/** Returns whether the cache directory exists and can be used. */
+		bool isValid() const { return _isValid; }
+
+		/**
+		 * If a conversion of the SPIR-V code, using the shader configuration, is held in this cache,
+		 * populates the MSL code and the conversion results, marks the shader inputs and resource
+		 * bindings of the shader configuration that are used by the shader, and returns true.
+		 * Otherwise, leaves the parameters unchanged, and returns false.
+		 *
+		 * The SPIR-V hash must be the mvkHash128() of the SPIR-V code. A caller that converts
+		 * the same SPIR-V code more than once can retain the hash, rather than recalculating it.
+		 */
+		bool read(const std::vector<uint32_t>& spirv,
+				  const MVKHash128& spirvHash,
+				  SPIRVToMSLConversionConfiguration& shaderConfig,
+				  std::string& msl,
+				  SPIRVToMSLConversionResults& conversionResults) const;
+
+		/** Same as the read() function above, but calculates the hash of the SPIR-V code. */
+		bool read(const std::vector<uint32_t>& spirv,
+				  SPIRVToMSLConversionConfiguration& shaderConfig,
+				  std::string& msl,
+				  SPIRVToMSLConversionResults& conversionResults) const {
+			return read(spirv, getSPIRVHash(spirv), shaderConfig, msl, conversionResults);
+		}
+
+		/**
+		 * Adds the conversion of the SPIR-V code, using the shader configuration, to this cache,
+		 * and returns whether it was successfully written. The shader configuration must have
+		 * been used to convert the SPIR-V code, so that it indicates which shader inputs and
+		 * resource bindings are used by the shader. The SPIR-V hash must be the mvkHash128()
+		 * of the SPIR-V code.
+		 */
+		bool write(const std::vector<uint32_t>& spirv,
+				   const MVKHash128& spirvHash,
+				   const SPIRVToMSLConversionConfiguration& shaderConfig,
+				   const std::string& msl,
+				   const SPIRVToMSLConversionResults& conversionResults) const;
+
+		/** Same as the write() function above, but calculates the hash of the SPIR-V code. */
+		bool write(const std::vector<uint32_t>& spirv,
+				   const SPIRVToMSLConversionConfiguration& shaderConfig,
+				   const std::string& msl,
+				   const SPIRVToMSLConversionResults& conversionResults) const {
+			return write(spirv, getSPIRVHash(spirv), shaderConfig, msl, conversionResults);
+		}
+
+		/** Returns the hash of the SPIR-V code, as used by the read() and write() functions. */
+		static MVKHash128 getSPIRVHash(const std::vector<uint32_t>& spirv) {
+			return mvkHash128(spirv.data(), spirv.size() * sizeof(uint32_t));
+		}
+
+		/**
+		 * Constructs an instance that holds conversions in the specified directory,
+		 * which is created if it does not already exist.
+		 *
+		 * The revision should identify the build of the converter and SPIRV-Cross, such as a
+		 * Git revision, so that conversions made by a different build are not reused. If it
+		 * is empty, the build time of this library is used instead.
+		 */
+		SPIRVToMSLConversionCache(const std::string& dirPath, const std::string& revision = "");
+
+	protected:
+		std::string getKey(const std::vector<uint32_t>& spirv, const MVKHash128& spirvHash,
+						   const SPIRVToMSLConversionConfiguration& shaderConfig) const;
+		std::string getFilePath(const std::string& key) const;
+
+		std::string _dirPath;
+		std::string _revision;
+		bool _isValid;
+	};
+
 }
 #endif
@@ -23,6 +23,8 @@
 #include "SPIRVToMSLConverter.h"
 #include "SPIRVSupport.h"
 #include "MVKOSExtensions.h"
+#include <atomic>
+#include <thread>
 
 using namespace std;
 using namespace mvk;
@@ -46,6 +48,9 @@ static const char* _defaultCompShaderExtns = "cs csh cp cmp comp compute kn kl k
 // The default list of SPIR-V file extensions.
 static const char* _defaultSPIRVShaderExtns = "spv spirv";
 
+// When converting a batch of files in parallel, the log of the file being converted by this thread.
+static thread_local string* _pFileLog = nullptr;
+
 
 uint64_t MVKPerformanceTracker::getTimestamp() { return mvkGetTimestamp(); }
 
@@ -68,8 +73,11 @@ int MoltenVKShaderConverterTool::run() {
 	bool success = false;
 	if ( !_directoryPath.empty() ) {
 		string errMsg;
+		_isCollectingBatch = (_jobCount > 1);
 		success = iterateDirectory(_directoryPath, *this, _shouldUseDirectoryRecursion, errMsg);
+		_isCollectingBatch = false;
 		if ( !success ) { log(errMsg.data()); }
+		if (success && !_batchFilePaths.empty()) { success = processBatch(); }
 	} else {
 		if (_shouldReadGLSL) {
 			success = convertGLSL(_glslInFilePath, _spvOutFilePath, _mslOutFilePath, _shaderStage);
@@ -85,6 +93,11 @@ int MoltenVKShaderConverterTool::run() {
 }
 
 bool MoltenVKShaderConverterTool::processFile(string filePath) {
+	if (_isCollectingBatch) {
+		_batchFilePaths.push_back(filePath);
+		return true;
+	}
+
 	string absPath = absolutePath(filePath);
 	string emptyPath;
 
@@ -98,6 +111,45 @@ bool MoltenVKShaderConverterTool::processFile(string filePath) {
 	return true;
 }
 
+// Converts the files collected from the directory using a pool of worker threads, including
+// this thread. The log of each file is captured separately while it is being converted,
+// and all file logs are then output in the order in which the files were found.
+bool MoltenVKShaderConverterTool::processBatch() {
+	size_t fileCnt = _batchFilePaths.size();
+	vector<string> fileLogs(fileCnt);
+	vector<uint8_t> fileResults(fileCnt, true);		// Not vector<bool>, so threads can write elements safely
+	atomic<size_t> nextFileIdx(0);
+
+	auto convertFiles = [&]() {
+		size_t fileIdx;
+		while ((fileIdx = nextFileIdx++) < fileCnt) {
+			_pFileLog = &fileLogs[fileIdx];
+			fileResults[fileIdx] = processFile(_batchFilePaths[fileIdx]);
+			_pFileLog = nullptr;
+		}
+	};
+
+	uint64_t startTime = _batchConversionPerformance.getTimestamp();
+
+	size_t threadCnt = min<size_t>(_jobCount, fileCnt);
+	_batchThreadCount = max<uint32_t>(_batchThreadCount, (uint32_t)threadCnt);
+	vector<thread> workers;
+	for (size_t thrdIdx = 1; thrdIdx < threadCnt; thrdIdx++) { workers.emplace_back(convertFiles); }
+	convertFiles();
+	for (auto& wkr : workers) { wkr.join(); }
+
+	_batchConversionPerformance.accumulate(startTime);
+
+	bool success = true;
+	for (size_t fileIdx = 0; fileIdx < fileCnt; fileIdx++) {
+		if ( !fileLogs[fileIdx].empty() ) { printf("%s", fileLogs[fileIdx].c_str()); }
+		if ( !fileResults[fileIdx] ) { success = false; }
+	}
+	_batchFilePaths.clear();
+
+	return success;
+}
+
 // Read GLSL code from a GLSL file, convert to SPIR-V, and optionally MSL,
 // and write the SPIR-V and/or MSL code to files.
 bool MoltenVKShaderConverterTool::convertGLSL(string& glslInFile,
@@ -142,7 +194,7 @@ bool MoltenVKShaderConverterTool::convertGLSL(string& glslInFile,
 
 	uint64_t startTime = _glslConversionPerformance.getTimestamp();
 	bool wasConverted = glslConverter.convert(shaderStage, _shouldLogConversions, _shouldLogConversions);
-	_glslConversionPerformance.accumulate(startTime);
+	accumulatePerformance(_glslConversionPerformance, startTime);
 
 	if (wasConverted) {
 		if (_shouldLogConversions) { log(glslConverter.getResultLog().data()); }
@@ -223,12 +275,27 @@ bool MoltenVKShaderConverterTool::convertSPIRV(const vector<uint32_t>& spv,
 	SPIRVToMSLConverter spvConverter;
 	spvConverter.setSPIRV(spv);
 
+	// If a conversion cache is in use, and the conversion is not being logged, try to retrieve the conversion from it.
 	uint64_t startTime = _spvConversionPerformance.getTimestamp();
-	bool wasConverted = spvConverter.convert(mslContext, shouldLogSPV, _shouldLogConversions, (_shouldLogConversions && shouldLogSPV));
-	_spvConversionPerformance.accumulate(startTime);
+	bool shouldUseCache = _conversionCache && !_shouldLogConversions;
+	string cachedMSL;
+	SPIRVToMSLConversionResults cachedConvRslts;
+	bool wasCached = shouldUseCache && _conversionCache->read(spv, mslContext, cachedMSL, cachedConvRslts);
+	bool wasConverted = wasCached;
+	if (wasCached) {
+		spvConverter.setMSL(cachedMSL, &cachedConvRslts);
+	} else {
+		wasConverted = spvConverter.convert(mslContext, shouldLogSPV, _shouldLogConversions, (_shouldLogConversions && shouldLogSPV));
+	}
+	accumulatePerformance(_spvConversionPerformance, startTime);
 
 	if (wasConverted) {
 		if (_shouldLogConversions) { log(spvConverter.getResultLog().data()); }
+		if (wasCached) {
+			log("Retrieved MSL from conversion cache.");
+		} else if (shouldUseCache) {
+			_conversionCache->write(spv, mslContext, spvConverter.getMSL(), spvConverter.getConversionResults());
+		}
 	} else {
 		string errMsg = "Could not convert SPIR-V in file: " + absolutePath(inFile);
 		log(errMsg.data());
@@ -236,6 +303,8 @@ bool MoltenVKShaderConverterTool::convertSPIRV(const vector<uint32_t>& spv,
 		return false;
 	}
 
+	if (_benchmarkVariantCount) { benchmarkVariants(spv, mslContext); }
+
 	// Write the MSL to file
 	string path = mslOutFile;
 	if (mslOutFile.empty()) { path = pathWithExtension(inFile, "metal", _shouldIncludeOrigPathExtn, _origPathExtnSep); }
@@ -265,6 +334,38 @@ bool MoltenVKShaderConverterTool::convertSPIRV(const vector<uint32_t>& spv,
 	}
 }
 
+// Converts the SPIR-V code under a number of different configurations, derived from the specified
+// configuration, as a pipeline would when creating variants of the same shader module. Each variant
+// is converted once by a separate converter, which must parse the SPIR-V code for each variant, and
+// once by a single converter, which parses the SPIR-V code only for the first variant, and reuses it.
+void MoltenVKShaderConverterTool::benchmarkVariants(const vector<uint32_t>& spv, const SPIRVToMSLConversionConfiguration& mslContext) {
+	// Vary the auxiliary buffer indexes, which changes the configuration without changing the resources the shader uses.
+	vector<SPIRVToMSLConversionConfiguration> variants(_benchmarkVariantCount, mslContext);
+	for (uint32_t varIdx = 0; varIdx < _benchmarkVariantCount; varIdx++) {
+		auto& mslOpts = variants[varIdx].options.mslOptions;
+		mslOpts.swizzle_buffer_index = 30 - (varIdx % 8);
+		mslOpts.buffer_size_buffer_index = 22 - ((varIdx / 8) % 8);
+	}
+
+	for (auto& variant : variants) {
+		SPIRVToMSLConversionConfiguration shaderConfig = variant;
+		uint64_t startTime = _variantReparsePerformance.getTimestamp();
+		SPIRVToMSLConverter spvConverter;
+		spvConverter.setSPIRV(spv);
+		spvConverter.convert(shaderConfig);
+		accumulatePerformance(_variantReparsePerformance, startTime);
+	}
+
+	SPIRVToMSLConverter spvConverter;
+	spvConverter.setSPIRV(spv);
+	for (auto& variant : variants) {
+		SPIRVToMSLConversionConfiguration shaderConfig = variant;
+		uint64_t startTime = _variantReusePerformance.getTimestamp();
+		spvConverter.convert(shaderConfig);
+		accumulatePerformance(_variantReusePerformance, startTime);
+	}
+}
+
 MVKGLSLConversionShaderStage MoltenVKShaderConverterTool::shaderStageFromFileExtension(string& pathExtension) {
     for (auto& fx : _glslVtxFileExtns) { if (fx == pathExtension) { return kMVKGLSLConversionShaderStageVertex; } }
 	for (auto& fx : _glslTescFileExtns) { if (fx == pathExtension) { return kMVKGLSLConversionShaderStageTessControl; } }
@@ -288,9 +389,17 @@ bool MoltenVKShaderConverterTool::isSPIRVFileExtension(string& pathExtension) {
 	return false;
 }
 
-// Log the specified message to the console.
+// Log the specified message to the console, or if converting a batch of files in parallel,
+// to the log of the file being converted by this thread, to be output when the batch is done.
 void MoltenVKShaderConverterTool::log(const char* logMsg) {
-	if ( !_quietMode ) { printf("%s\n", logMsg); }
+	if (_quietMode) { return; }
+
+	if (_pFileLog) {
+		*_pFileLog += logMsg;
+		*_pFileLog += "\n";
+	} else {
+		printf("%s\n", logMsg);
+	}
 }
 
 // Display usage information about this application on the console.
@@ -364,6 +473,16 @@ void MoltenVKShaderConverterTool::showUsage() {
     log("                       May be omitted for defaults (\"cp cmp comp compute kn kl krn kern kernel\").");
 	log("  -sx \"fileExtns\"    - List of SPIR-V shader file extensions.");
 	log("                       May be omitted for defaults (\"spv spirv\").");
+	log("  -mc \"cacheDirPath\" - Path to a directory in which to cache SPIR-V to MSL conversions,");
+	log("                       so they can be reused by later runs. The directory is created if");
+	log("                       needed, and may be shared by several concurrent runs.");
+	log("  -bv variantCount   - Benchmark converting each SPIR-V file under the specified number");
+	log("                       of different configurations, both parsing the SPIR-V code for each");
+	log("                       configuration, and reusing the parsed SPIR-V code across them.");
+	log("                       Implies the -p option.");
+	log("  -j [jobCount]      - (when using -d) Convert files in parallel, using the specified");
+	log("                       number of threads. The jobCount may be omitted to use one thread");
+	log("                       per CPU core. Log output is still reported in file order.");
 	log("  -l                 - Log the conversion results to the console (to aid debugging).");
 	log("  -p                 - Log the performance of the shader conversions.");
 	log("  -q                 - Quiet mode. Stops logging of informational messages.");
@@ -377,6 +496,25 @@ void MoltenVKShaderConverterTool::reportPerformance() {
 
 	if (_shouldReadGLSL) { reportPerformance(_glslConversionPerformance, "GLSL to SPIR-V"); }
 	reportPerformance(_spvConversionPerformance, "SPIR-V to MSL");
+	if (_batchConversionPerformance.count) {
+		reportPerformance(_batchConversionPerformance, "all files using " + to_string(_batchThreadCount) + " threads");
+	}
+	if (_variantReparsePerformance.count) {
+		reportPerformance(_variantReparsePerformance, "SPIR-V to MSL variants, parsing each variant");
+		reportPerformance(_variantReusePerformance, "SPIR-V to MSL variants, reusing parsed SPIR-V");
+		if (_variantReusePerformance.averageDuration > 0.0) {
+			string logMsg = "Reusing parsed SPIR-V converts variants " + to_string(_variantReparsePerformance.averageDuration / _variantReusePerformance.averageDuration) + " times as fast.\n";
+			log(logMsg.c_str());
+		}
+	}
+}
+
+// Conversions may occur on several threads, so accumulate performance under a lock,
+// but take the end time before acquiring the lock, so waiting for it is not measured.
+void MoltenVKShaderConverterTool::accumulatePerformance(MVKPerformanceTracker& perfTracker, uint64_t startTime) {
+	uint64_t endTime = perfTracker.getTimestamp();
+	lock_guard<mutex> lock(_performanceLock);
+	perfTracker.accumulate(startTime, endTime);
 }
 
 void MoltenVKShaderConverterTool::reportPerformance(MVKPerformanceTracker& shaderCompilationEvent, string eventDescription) {
@@ -408,6 +546,10 @@ MoltenVKShaderConverterTool::MoltenVKShaderConverterTool(int argc, const char* a
 	_origPathExtnSep = "_";
 	_shaderStage = kMVKGLSLConversionShaderStageAuto;
 	_shouldUseDirectoryRecursion = false;
+	_isCollectingBatch = false;
+	_jobCount = 1;
+	_batchThreadCount = 0;
+	_benchmarkVariantCount = 0;
 	_shouldReadGLSL = false;
 	_shouldReadSPIRV = false;
 	_shouldWriteSPIRV = false;
@@ -633,6 +775,39 @@ bool MoltenVKShaderConverterTool::parseArgs(int argc, const char* argv[]) {
 			continue;
 		}
 
+		if (equal(arg, "-mc", true)) {
+			int optIdx = argIdx;
+			string cacheDirPath;
+			argIdx = optionalParam(cacheDirPath, argIdx, argc, argv);
+			if (argIdx == optIdx || cacheDirPath.length() == 0) { return false; }
+			_conversionCache.reset(new SPIRVToMSLConversionCache(absolutePath(cacheDirPath)));
+			if ( !_conversionCache->isValid() ) {
+				string errMsg = "Could not create conversion cache directory: " + _conversionCache->getDirectoryPath();
+				log(errMsg.c_str());
+				return false;
+			}
+			continue;
+		}
+
+		if (equal(arg, "-bv", true)) {
+			int optIdx = argIdx;
+			string varCntStr;
+			argIdx = optionalParam(varCntStr, argIdx, argc, argv);
+			if (argIdx == optIdx) { return false; }
+			_benchmarkVariantCount = (uint32_t)strtol(varCntStr.c_str(), nullptr, 0);
+			_shouldReportPerformance = true;
+			continue;
+		}
+
+		if (equal(arg, "-j", true)) {
+			int optIdx = argIdx;
+			string jobCntStr;
+			argIdx = optionalParam(jobCntStr, argIdx, argc, argv);
+			_jobCount = (argIdx == optIdx) ? thread::hardware_concurrency() : (uint32_t)strtol(jobCntStr.c_str(), nullptr, 0);
+			if (_jobCount == 0) { _jobCount = 1; }
+			continue;
+		}
+
 		if(equal(arg, "-l", true)) {
 			_shouldLogConversions = true;
 			continue;
@@ -21,6 +21,8 @@
 
 #include "GLSLConversion.h"
 #include "SPIRVToMSLConverter.h"
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -77,6 +79,7 @@ namespace mvk {
 						  std::string& inFile,
 						  std::string& mslOutFile,
 						  bool shouldLogSPV);
+		void benchmarkVariants(const std::vector<uint32_t>& spv, const SPIRVToMSLConversionConfiguration& mslContext);
 		bool parseArgs(int argc, const char* argv[]);
 		void log(const char* logMsg);
 		void showUsage();
@@ -85,6 +88,8 @@ namespace mvk {
 						  int optionArgIndex,
 						  int argc,
 						  const char* argv[]);
+		bool processBatch();
+		void accumulatePerformance(MVKPerformanceTracker& perfTracker, uint64_t startTime);
 		void reportPerformance();
 		void reportPerformance(MVKPerformanceTracker& shaderCompilationEvent,
 							   std::string eventDescription);
@@ -103,15 +108,25 @@ namespace mvk {
 		std::vector<std::string> _glslFragFileExtns;
         std::vector<std::string> _glslCompFileExtns;
 		std::vector<std::string> _spvFileExtns;
+		std::vector<std::string> _batchFilePaths;
+		std::unique_ptr<SPIRVToMSLConversionCache> _conversionCache;
+		std::mutex _performanceLock;
 		MVKGLSLConversionShaderStage _shaderStage;
 		MVKPerformanceTracker _glslConversionPerformance;
 		MVKPerformanceTracker _spvConversionPerformance;
+		MVKPerformanceTracker _batchConversionPerformance;
+		MVKPerformanceTracker _variantReparsePerformance;
+		MVKPerformanceTracker _variantReusePerformance;
+		uint32_t _jobCount;
+		uint32_t _batchThreadCount;
+		uint32_t _benchmarkVariantCount;
 		uint32_t _mslVersionMajor;
 		uint32_t _mslVersionMinor;
 		uint32_t _mslVersionPatch;
 		SPIRV_CROSS_NAMESPACE::CompilerMSL::Options::Platform _mslPlatform;
 		bool _isActive;
 		bool _shouldUseDirectoryRecursion;
+		bool _isCollectingBatch;
 		bool _shouldReadGLSL;
 		bool _shouldReadSPIRV;
 		bool _shouldWriteSPIRV;
@@ -0,0 +1,79 @@
+/*
+ * MVKBCnDecoderBenchmark.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the throughput of MVKBCnDecoder for each BCn format, in megabytes of compressed data
+// decoded per second, when decoding on the calling thread, and when dividing the texture between
+// the number of threads returned by MVKBCnDecoder::getThreadCount().
+//
+// Usage: MVKBCnDecoderBenchmark [number of times each texture is decoded]
+
+#include "MVKTest.h"
+#include "MVKBCnDecoder.h"
+
+typedef struct {
+	MVKBCnFormat format;
+	const char* name;
+} TestFormat;
+
+static const TestFormat kTestFormats[] = {
+	{ kMVKBCnFormatBC1RGBA, "BC1" },
+	{ kMVKBCnFormatBC2, "BC2" },
+	{ kMVKBCnFormatBC3, "BC3" },
+	{ kMVKBCnFormatBC4Unorm, "BC4" },
+	{ kMVKBCnFormatBC5Unorm, "BC5" },
+	{ kMVKBCnFormatBC6HUfloat, "BC6H" },
+	{ kMVKBCnFormatBC7, "BC7" },
+};
+
+// Returns the throughput, in MB/s of compressed data, of decoding the texture the specified number of times.
+static double measure(const MVKBCnDecoder& decoder, const std::vector<uint8_t>& src, std::vector<uint32_t>& dest,
+					  uint32_t extent, uint64_t repCnt, uint32_t threadCnt) {
+	size_t srcRowPitch = src.size() / (extent / 4);
+	double secs = mvkTestTime([&]() {
+		for (uint64_t rep = 0; rep < repCnt; rep++) {
+			decoder.decode(dest.data(), extent * sizeof(uint32_t), dest.size() * sizeof(uint32_t),
+						   src.data(), srcRowPitch, src.size(), extent, extent, 1, threadCnt);
+		}
+	});
+	return double(src.size()) * repCnt / secs / 1e6;
+}
+
+int main(int argc, const char* argv[]) {
+	uint64_t repCnt = mvkTestIterationCount(argc, argv, 4);
+	const uint32_t extent = 1024;
+
+	printf("BCn decoding of %ux%u textures, %llu times each, MB of compressed data per second:\n",
+		   extent, extent, (unsigned long long)repCnt);
+	printf("%8s %12s %12s %10s\n", "Format", "1 thread", "Threaded", "Threads");
+	std::vector<uint32_t> dest(extent * extent);
+	for (auto& testFmt : kTestFormats) {
+		MVKBCnDecoder decoder(testFmt.format, false);
+		std::vector<uint8_t> src((extent / 4) * (extent / 4) * decoder.getBlockByteCount());
+		uint32_t state = 1;
+		for (auto& byte : src) {
+			state = state * 1664525u + 1013904223u;
+			byte = uint8_t(state >> 24);
+		}
+		uint32_t threadCnt = MVKBCnDecoder::getThreadCount(src.size());
+		printf("%8s %12.1f %12.1f %10u\n", testFmt.name,
+			   measure(decoder, src, dest, extent, repCnt, 1),
+			   measure(decoder, src, dest, extent, repCnt, threadCnt),
+			   threadCnt);
+	}
+	return mvkTestExitCode();
+}
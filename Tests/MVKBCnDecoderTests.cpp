@@ -0,0 +1,266 @@
+/*
+ * MVKBCnDecoderTests.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKTest.h"
+#include "MVKBCnDecoder.h"
+#include "MVKHash.h"
+#include <cstring>
+
+// Packs the channels into a texel, whose bytes are stored in memory in B, G, R, A order.
+static uint32_t bgra(uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+	return b | (g << 8) | (r << 16) | (a << 24);
+}
+
+// Writes consecutive fields of bits into a 128-bit block, starting at its least significant bit.
+struct TestBlockWriter {
+	uint8_t bytes[16] = {};
+	uint32_t bitPos = 0;
+
+	TestBlockWriter& write(uint32_t val, uint32_t bitCount) {
+		for (uint32_t i = 0; i < bitCount; i++, bitPos++) {
+			if ((val >> i) & 1) { bytes[bitPos / 8] |= uint8_t(1 << (bitPos % 8)); }
+		}
+		return *this;
+	}
+};
+
+// Writes the indexes of a BC6H or BC7 single-subset block, in which the anchor texel 0 has one bit fewer.
+static void writeIndexes(TestBlockWriter& writer, const uint32_t (&indexes)[16], uint32_t indexBitCount) {
+	for (uint32_t i = 0; i < 16; i++) { writer.write(indexes[i], i ? indexBitCount : indexBitCount - 1); }
+}
+
+static void expectBlock(MVKBCnFormat format, bool isSRGB, const uint8_t* pBlock, const uint32_t (&expected)[16]) {
+	uint32_t texels[16];
+	MVKBCnDecoder(format, isSRGB).decodeBlock(pBlock, texels);
+	MVKTestExpect(memcmp(texels, expected, sizeof(texels)) == 0);
+}
+
+// Each texel row of a BC1 block selects a different palette entry. The endpoints are chosen so that the
+// interpolated entries are exact, and do not depend on rounding. Index 3 of the three-colour mode is
+// transparent black when the format has alpha, and opaque black when it does not.
+static void testBC1() {
+	const uint32_t red = bgra(255, 0, 0, 255), blue = bgra(0, 0, 255, 255);
+	const uint8_t fourColour[] = { 0x00, 0xF8, 0x1F, 0x00, 0x00, 0x55, 0xAA, 0xFF };
+	uint32_t expected[16];
+	const uint32_t palette[] = { red, blue, bgra(170, 0, 85, 255), bgra(85, 0, 170, 255) };
+	for (uint32_t i = 0; i < 16; i++) { expected[i] = palette[i / 4]; }
+	expectBlock(kMVKBCnFormatBC1RGB, false, fourColour, expected);
+	expectBlock(kMVKBCnFormatBC1RGBA, false, fourColour, expected);
+
+	const uint8_t threeColour[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x55, 0xAA, 0xFF };
+	const uint32_t white = bgra(255, 255, 255, 255);
+	for (uint32_t i = 0; i < 16; i++) { expected[i] = (i < 12) ? white : 0; }
+	expectBlock(kMVKBCnFormatBC1RGBA, false, threeColour, expected);
+	for (uint32_t i = 12; i < 16; i++) { expected[i] = bgra(0, 0, 0, 255); }
+	expectBlock(kMVKBCnFormatBC1RGB, false, threeColour, expected);
+
+	// sRGB conversion leaves black, white, and alpha unchanged.
+	expectBlock(kMVKBCnFormatBC1RGB, true, threeColour, expected);
+}
+
+// A BC2 block has explicit 4-bit alpha, and its colour block always uses the four-colour mode.
+static void testBC2() {
+	const uint8_t block[] = {
+		0x0F, 0x80, 0x0F, 0x80, 0x0F, 0x80, 0x0F, 0x80,		// Alpha 0xF, 0x0, 0x0, 0x8 in each row
+		0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00,		// White, in four-colour mode
+	};
+	uint32_t expected[16];
+	const uint32_t alphas[] = { 255, 0, 0, 136 };
+	for (uint32_t i = 0; i < 16; i++) { expected[i] = bgra(255, 255, 255, alphas[i % 4]); }
+	expectBlock(kMVKBCnFormatBC2, false, block, expected);
+}
+
+// Interpolated values of the six-value mode of BC3 alpha and BC4 are exact when the endpoints are 0 and 255.
+// Each texel row selects indexes { 0, 1, 2, 3 }, { 4, 5, 6, 7 }, and then { 0, 1, 6, 7 } twice.
+static const uint8_t kBC4Unorm[] = { 0x00, 0xFF, 0x88, 0xC6, 0xFA, 0x88, 0x8F, 0xF8 };
+static const uint8_t kBC4UnormValues[] = { 0, 255, 51, 102, 153, 204, 0, 255, 0, 255, 0, 255, 0, 255, 0, 255 };
+
+static void testBC3AndBC4() {
+	uint8_t bc3Block[16];
+	memcpy(bc3Block, kBC4Unorm, 8);
+	const uint8_t colour[] = { 0x00, 0xF8, 0x00, 0xF8, 0x00, 0x00, 0x00, 0x00 };
+	memcpy(bc3Block + 8, colour, 8);
+	uint32_t expected[16];
+	for (uint32_t i = 0; i < 16; i++) { expected[i] = bgra(255, 0, 0, kBC4UnormValues[i]); }
+	expectBlock(kMVKBCnFormatBC3, false, bc3Block, expected);
+
+	for (uint32_t i = 0; i < 16; i++) { expected[i] = bgra(kBC4UnormValues[i], 0, 0, 255); }
+	expectBlock(kMVKBCnFormatBC4Unorm, false, kBC4Unorm, expected);
+
+	// Signed endpoints of -127 and 127, using only the endpoint indexes, clamp to 0 and 255.
+	uint8_t snorm[8];
+	memcpy(snorm, kBC4Unorm, 8);
+	snorm[0] = 0x81;
+	snorm[1] = 0x7F;
+	const uint32_t snormReds[] = { 0, 255, 0, 255 };
+	for (uint32_t i = 8; i < 16; i++) { expected[i] = bgra(snormReds[i % 4], 0, 0, 255); }
+	uint32_t texels[16];
+	MVKBCnDecoder(kMVKBCnFormatBC4Snorm, false).decodeBlock(snorm, texels);
+	MVKTestExpect(memcmp(texels + 8, expected + 8, 8 * sizeof(uint32_t)) == 0);
+
+	// BC5 decodes the second block to green.
+	uint8_t bc5Block[16];
+	memcpy(bc5Block, kBC4Unorm, 8);
+	memset(bc5Block + 8, 0, 8);
+	bc5Block[8] = 0xFF;		// Both green endpoints are 255.
+	bc5Block[9] = 0xFF;
+	for (uint32_t i = 0; i < 16; i++) { expected[i] = bgra(kBC4UnormValues[i], 255, 0, 255); }
+	expectBlock(kMVKBCnFormatBC5Unorm, false, bc5Block, expected);
+}
+
+// A BC6H mode 11 block has a single subset with untransformed 10-bit endpoints. An endpoint of 1023 is the
+// largest half-float value, which clamps to 255, and 448 unquantizes to the half-float 0x364F (0.394).
+static void testBC6H() {
+	TestBlockWriter writer;
+	writer.write(0x03, 5);
+	writer.write(1023, 10).write(448, 10).write(0, 10);		// Endpoint W (R, G, B)
+	writer.write(0, 10).write(0, 10).write(0, 10);			// Endpoint X (R, G, B)
+	uint32_t indexes[16] = {};
+	indexes[15] = 15;
+	writeIndexes(writer, indexes, 4);
+	MVKTestExpect(writer.bitPos == 128);
+
+	uint32_t expected[16];
+	for (uint32_t i = 0; i < 16; i++) { expected[i] = bgra(255, 101, 0, 255); }
+	expected[15] = bgra(0, 0, 0, 255);
+	expectBlock(kMVKBCnFormatBC6HUfloat, false, writer.bytes, expected);
+}
+
+// A BC7 mode 6 block has a single subset with 7-bit RGBA endpoints, each with a shared P-bit.
+// Index weights of 0 and 64 select the endpoints exactly.
+static void testBC7() {
+	TestBlockWriter writer;
+	writer.write(1 << 6, 7);
+	writer.write(127, 7).write(0, 7);		// R0, R1
+	writer.write(0, 7).write(127, 7);		// G0, G1
+	writer.write(0, 7).write(0, 7);			// B0, B1
+	writer.write(127, 7).write(127, 7);		// A0, A1
+	writer.write(1, 1).write(0, 1);			// P0, P1
+	uint32_t indexes[16] = {};
+	indexes[15] = 15;
+	writeIndexes(writer, indexes, 4);
+	MVKTestExpect(writer.bitPos == 128);
+
+	uint32_t expected[16];
+	for (uint32_t i = 0; i < 16; i++) { expected[i] = bgra(255, 1, 1, 255); }
+	expected[15] = bgra(0, 254, 0, 254);
+	expectBlock(kMVKBCnFormatBC7, false, writer.bytes, expected);
+}
+
+// Fills the blocks with reproducible pseudo-random content.
+static void fillBlocks(std::vector<uint8_t>& blocks, uint32_t seed) {
+	uint32_t state = seed * 2654435761u + 1;
+	for (auto& byte : blocks) {
+		state = state * 1664525u + 1013904223u;
+		byte = uint8_t(state >> 24);
+	}
+}
+
+typedef struct {
+	MVKBCnFormat format;
+	bool isSRGB;
+	uint64_t goldenLo;
+	uint64_t goldenHi;
+} TestGoldenImage;
+
+// The hashes of 64x64 texel images, decoded from pseudo-random blocks, which exercise every mode,
+// partition, and endpoint transform, including those that are not covered by the tests above.
+// If a change to the decoder alters any decoded texel, these will not match.
+static const TestGoldenImage kGoldenImages[] = {
+	{ kMVKBCnFormatBC1RGB, false, 0x871E57842781F3DBULL, 0x8ABFD6DB5B675DBAULL },
+	{ kMVKBCnFormatBC1RGB, true, 0x96569785CCA2FB50ULL, 0x0C99A920E7EC0D3EULL },
+	{ kMVKBCnFormatBC1RGBA, false, 0x9F54A3513ED521C7ULL, 0x0D89FBB8D69C320FULL },
+	{ kMVKBCnFormatBC2, false, 0xBB97712EABFDA76BULL, 0x00381C3BEBC717CEULL },
+	{ kMVKBCnFormatBC3, false, 0x5B01AD0B10F0C2ABULL, 0x6CC717A59391D6A1ULL },
+	{ kMVKBCnFormatBC3, true, 0x53F43DFDA4759B14ULL, 0x0EC8218AD74BC0E0ULL },
+	{ kMVKBCnFormatBC4Unorm, false, 0x4CA4A15211EED9C0ULL, 0xF7DBC4FF67B9D328ULL },
+	{ kMVKBCnFormatBC4Snorm, false, 0x4EB4C5813274129AULL, 0xE8461619C78F49DEULL },
+	{ kMVKBCnFormatBC5Unorm, false, 0xD90D776694FC3F91ULL, 0x2A1C16F00ABDF66DULL },
+	{ kMVKBCnFormatBC5Snorm, false, 0xAD0E8A2EA0EAEEEFULL, 0x7449D6CDFFAB9777ULL },
+	{ kMVKBCnFormatBC6HUfloat, false, 0x3D1DCA8AFF1C27E1ULL, 0x9EBBF654D25BE8CBULL },
+	{ kMVKBCnFormatBC6HSfloat, false, 0xAC9B5CE33AAC8A84ULL, 0x07F54FD80FA10A76ULL },
+	{ kMVKBCnFormatBC7, false, 0x550EB14A0649F0A5ULL, 0xD6DE6435F4D8720CULL },
+	{ kMVKBCnFormatBC7, true, 0x50415BB26BFD51C1ULL, 0x66B2F930E9D48E52ULL },
+};
+
+static void testGoldenImages() {
+	const uint32_t extent = 64;
+	for (auto& golden : kGoldenImages) {
+		MVKBCnDecoder decoder(golden.format, golden.isSRGB);
+		size_t srcRowPitch = (extent / 4) * decoder.getBlockByteCount();
+		std::vector<uint8_t> src(srcRowPitch * (extent / 4));
+		fillBlocks(src, golden.format);
+		std::vector<uint32_t> texels(extent * extent);
+		decoder.decode(texels.data(), extent * sizeof(uint32_t), texels.size() * sizeof(uint32_t),
+					   src.data(), srcRowPitch, src.size(), extent, extent, 1, 1);
+		MVKHash128 hash = mvkHash128(texels.data(), texels.size() * sizeof(uint32_t));
+		MVKTestExpect(hash.lo == golden.goldenLo && hash.hi == golden.goldenHi);
+	}
+}
+
+// Decoding a 3D region, with a partial block at its edges, on several threads, places
+// each texel of each block at the same location as decoding each block individually.
+static void testRegionDecoding() {
+	const uint32_t width = 37, height = 21, depth = 3;
+	const uint32_t blocksWide = (width + 3) / 4, blocksHigh = (height + 3) / 4;
+	MVKBCnDecoder decoder(kMVKBCnFormatBC7, false);
+	size_t blockByteCnt = decoder.getBlockByteCount();
+	size_t srcRowPitch = blocksWide * blockByteCnt + 16;		// Padded rows and slices
+	size_t srcDepthPitch = srcRowPitch * blocksHigh + 64;
+	std::vector<uint8_t> src(srcDepthPitch * depth);
+	fillBlocks(src, 7);
+
+	size_t destRowPitch = (width + 3) * sizeof(uint32_t);
+	size_t destDepthPitch = destRowPitch * (height + 1);
+	for (uint32_t threadCnt : { 1, 4 }) {
+		std::vector<uint8_t> dest(destDepthPitch * depth, 0xCD);
+		decoder.decode(dest.data(), destRowPitch, destDepthPitch, src.data(), srcRowPitch, srcDepthPitch,
+					   width, height, depth, threadCnt);
+		for (uint32_t z = 0; z < depth; z++) {
+			for (uint32_t by = 0; by < blocksHigh; by++) {
+				for (uint32_t bx = 0; bx < blocksWide; bx++) {
+					uint32_t texels[16];
+					decoder.decodeBlock(&src[z * srcDepthPitch + by * srcRowPitch + bx * blockByteCnt], texels);
+					for (uint32_t i = 0; i < 16; i++) {
+						uint32_t x = bx * 4 + i % 4, y = by * 4 + i / 4;
+						if (x >= width || y >= height) { continue; }
+						uint32_t texel;
+						memcpy(&texel, &dest[z * destDepthPitch + y * destRowPitch + x * sizeof(uint32_t)], sizeof(texel));
+						MVKTestExpect(texel == texels[i]);
+					}
+				}
+			}
+		}
+
+		// Texels outside the region are untouched.
+		uint32_t padTexel;
+		memcpy(&padTexel, &dest[width * sizeof(uint32_t)], sizeof(padTexel));
+		MVKTestExpect(padTexel == 0xCDCDCDCD);
+	}
+}
+
+int main(int argc, const char* argv[]) {
+	MVKTestRun(testBC1);
+	MVKTestRun(testBC2);
+	MVKTestRun(testBC3AndBC4);
+	MVKTestRun(testBC6H);
+	MVKTestRun(testBC7);
+	MVKTestRun(testGoldenImages);
+	MVKTestRun(testRegionDecoding);
+	return mvkTestExitCode();
+}
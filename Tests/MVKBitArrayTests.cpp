@@ -0,0 +1,206 @@
+/*
+ * MVKBitArrayTests.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKTest.h"
+#include "MVKBitArray.h"
+#include <random>
+
+typedef std::vector<bool> TestModel;
+
+static size_t modelFirst(const TestModel& model, size_t startIdx, bool val) {
+	for (size_t bitIdx = startIdx; bitIdx < model.size(); bitIdx++) {
+		if (model[bitIdx] == val) { return bitIdx; }
+	}
+	return model.size();
+}
+
+static size_t modelFirstRun(const TestModel& model, size_t count) {
+	size_t runLen = 0;
+	for (size_t bitIdx = 0; bitIdx < model.size(); bitIdx++) {
+		runLen = model[bitIdx] ? runLen + 1 : 0;
+		if (runLen == count) { return bitIdx + 1 - count; }
+	}
+	return model.size();
+}
+
+static bool matchesModel(MVKBitArray& bits, const TestModel& model) {
+	if (bits.size() != model.size()) { return false; }
+	for (size_t bitIdx = 0; bitIdx < model.size(); bitIdx++) {
+		if (bits.getBit(bitIdx) != model[bitIdx]) { return false; }
+	}
+	return true;
+}
+
+// Random single-bit and range changes, and searches from random indexes, match a bool vector,
+// both for an array that fits in one section, and for arrays whose ranges cross sections.
+static void testMatchesModel() {
+	std::mt19937 rng(25);
+	for (size_t bitCnt : { 1, 10, 64, 65, 200, 1000 }) {
+		MVKBitArray bits(bitCnt);
+		TestModel model(bitCnt, false);
+		for (uint32_t opIdx = 0; opIdx < 4000; opIdx++) {
+			size_t bitIdx = rng() % bitCnt;
+			size_t count = rng() % (std::min<size_t>(bitCnt - bitIdx, 150) + 1);
+			bool val = rng() % 2;
+			switch (rng() % 8) {
+				case 0:
+					bits.setBit(bitIdx, val);
+					model[bitIdx] = val;
+					break;
+				case 1:
+				case 2:
+					bits.setBits(bitIdx, count);
+					std::fill(model.begin() + bitIdx, model.begin() + bitIdx + count, true);
+					break;
+				case 3:
+				case 4:
+					bits.clearBits(bitIdx, count);
+					std::fill(model.begin() + bitIdx, model.begin() + bitIdx + count, false);
+					break;
+				case 5: {
+					size_t setIdx = bits.getIndexOfFirstSetBit(bitIdx, val);
+					MVKTestExpect(setIdx == modelFirst(model, bitIdx, true));
+					if (val && setIdx < bitCnt) { model[setIdx] = false; }
+					break;
+				}
+				case 6:
+					MVKTestExpect(bits.getIndexOfFirstClearBit(bitIdx) == modelFirst(model, bitIdx, false));
+					break;
+				case 7:
+					if (rng() % 50 == 0) {
+						if (val) { bits.setAllBits(); } else { bits.clearAllBits(); }
+						std::fill(model.begin(), model.end(), val);
+					}
+					MVKTestExpect(bits.getIndexOfFirstSetBit() == modelFirst(model, 0, true));
+					break;
+			}
+		}
+		MVKTestExpect(matchesModel(bits, model));
+	}
+}
+
+// Enumeration visits each set bit in order, and can stop early, or clear the bits as it goes.
+static void testEnumerateEnabledBits() {
+	MVKBitArray bits(300);
+	std::vector<size_t> setIdxs = { 0, 63, 64, 65, 130, 299 };
+	for (size_t bitIdx : setIdxs) { bits.setBit(bitIdx); }
+
+	std::vector<size_t> visited;
+	MVKTestExpect(bits.enumerateEnabledBits(false, [&](size_t bitIdx) { visited.push_back(bitIdx); return true; }));
+	MVKTestExpect(visited == setIdxs);
+
+	visited.clear();
+	MVKTestExpect( !bits.enumerateEnabledBits(false, [&](size_t bitIdx) { visited.push_back(bitIdx); return bitIdx < 64; }));
+	MVKTestExpect((visited == std::vector<size_t>{ 0, 63, 64 }));
+
+	visited.clear();
+	MVKTestExpect(bits.enumerateEnabledBits(true, [&](size_t bitIdx) { visited.push_back(bitIdx); return true; }));
+	MVKTestExpect(visited == setIdxs);
+	MVKTestExpect(bits.getIndexOfFirstSetBit() == bits.size());
+}
+
+// Growing keeps the existing bits, including when growing out of the single inline section,
+// and sets the new bits to the specified value. Copies are independent of the original.
+static void testResizeAndCopy() {
+	MVKBitArray bits(10);
+	bits.setBits(3, 4);
+	bits.resize(40, true);
+	MVKTestExpect(bits.getIndexOfFirstSetBit() == 3 && bits.getIndexOfFirstClearBit(3) == 7);
+	MVKTestExpect(bits.getIndexOfFirstClearBit(10) == 40);
+
+	bits.resize(150, false);
+	MVKTestExpect(bits.getIndexOfFirstClearBit(7) == 7 && bits.getIndexOfFirstSetBit(7, false) == 10);
+	MVKTestExpect(bits.getIndexOfFirstClearBit(10) == 40 && bits.getIndexOfFirstSetBit(40, false) == 150);
+
+	MVKBitArray copy(bits);
+	MVKTestExpect(copy.getIndexOfFirstSetBit() == 3 && copy.getIndexOfFirstSetBit(7, false) == 10);
+	copy.clearAllBits();
+	MVKTestExpect(copy.size() == 150 && copy.getIndexOfFirstSetBit() == 150);
+	MVKTestExpect(bits.getIndexOfFirstSetBit() == 3);
+	copy = bits;
+	MVKTestExpect(copy.getIndexOfFirstSetBit(7, false) == 10);
+
+	bits.resize(0);
+	MVKTestExpect(bits.empty() && bits.getIndexOfFirstSetBit() == 0);
+}
+
+// Random reservations and releases of runs match the first long-enough run in a bool vector.
+static void testSetBitRunMatchesModel() {
+	std::mt19937 rng(7);
+	for (size_t bitCnt : { 50, 64, 500 }) {
+		MVKBitArray bits(bitCnt, true);
+		TestModel model(bitCnt, true);
+		std::vector<std::pair<size_t, size_t>> runs;
+		for (uint32_t opIdx = 0; opIdx < 2000; opIdx++) {
+			if (runs.empty() || rng() % 2) {
+				size_t count = rng() % 20 + 1;
+				size_t runIdx = bits.getIndexOfFirstSetBitRun(count, true);
+				MVKTestExpect(runIdx == modelFirstRun(model, count));
+				if (runIdx < bitCnt) {
+					std::fill(model.begin() + runIdx, model.begin() + runIdx + count, false);
+					runs.emplace_back(runIdx, count);
+				}
+			} else {
+				size_t runPos = rng() % runs.size();
+				bits.setBits(runs[runPos].first, runs[runPos].second);
+				std::fill(model.begin() + runs[runPos].first, model.begin() + runs[runPos].first + runs[runPos].second, true);
+				runs.erase(runs.begin() + runPos);
+			}
+		}
+		MVKTestExpect(matchesModel(bits, model));
+	}
+}
+
+// MVKDescriptorTypePool reserves each binding as a run of available descriptors. When freeing sets
+// has left enough descriptors available, but no run long enough, the search reports that there is no
+// run, so the pool creates the descriptors on the fly instead. A pool with a single free run, such as
+// one that has just been reset, always finds it.
+static void testFragmentedSetBitRun() {
+	MVKBitArray avail(128, true);
+	for (uint32_t setIdx = 0; setIdx < 8; setIdx++) {
+		MVKTestExpect(avail.getIndexOfFirstSetBitRun(16, true) == setIdx * 16);
+	}
+	MVKTestExpect(avail.getIndexOfFirstSetBitRun(1) == avail.size());
+
+	// Free every second set, leaving half of the descriptors available, in runs of 16.
+	for (uint32_t setIdx = 0; setIdx < 8; setIdx += 2) { avail.setBits(setIdx * 16, 16); }
+	MVKTestExpect(avail.getIndexOfFirstSetBitRun(17) == avail.size());
+	MVKTestExpect(avail.getIndexOfFirstSetBitRun(64) == avail.size());
+	MVKTestExpect(avail.getIndexOfFirstSetBitRun(16) == 0);
+
+	// Freeing a neighbouring set joins runs, across the sections of the bit array.
+	avail.setBits(48, 16);
+	MVKTestExpect(avail.getIndexOfFirstSetBitRun(48, true) == 32);
+	MVKTestExpect(avail.getIndexOfFirstSetBitRun(17) == avail.size());
+	MVKTestExpect(avail.getIndexOfFirstSetBitRun(16, true) == 0);
+	MVKTestExpect(avail.getIndexOfFirstSetBitRun(16, true) == 96);
+	MVKTestExpect(avail.getIndexOfFirstSetBitRun(1) == avail.size());
+
+	avail.setAllBits();
+	MVKTestExpect(avail.getIndexOfFirstSetBitRun(128) == 0);
+	MVKTestExpect(avail.getIndexOfFirstSetBitRun(129) == avail.size());
+}
+
+int main(int argc, const char* argv[]) {
+	MVKTestRun(testMatchesModel);
+	MVKTestRun(testEnumerateEnabledBits);
+	MVKTestRun(testResizeAndCopy);
+	MVKTestRun(testSetBitRunMatchesModel);
+	MVKTestRun(testFragmentedSetBitRun);
+	return mvkTestExitCode();
+}
@@ -0,0 +1,233 @@
+/*
+ * MVKBufferUploadRingTests.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKTest.h"
+#include "MVKBufferUploadRing.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+
+// Stands in for a MTLBuffer.
+struct TestMTLBuffer {
+	std::vector<uint8_t> contents;
+	TestMTLBuffer(size_t length) : contents(length) {}
+};
+
+class TestBlockAllocator;
+
+// Stands in for a MVKMTLBufferAllocation, a region of a larger MTLBuffer that is returned to its pool.
+struct TestBlock {
+	TestMTLBuffer* _mtlBuffer;
+	size_t _offset;
+	size_t _length;
+	TestBlockAllocator* _allocator;
+	void returnToPool();
+};
+
+// Stands in for a MVKMTLBufferAllocator, which reuses returned blocks of the same length,
+// and places each block at an offset within its MTLBuffer, as the allocator's regions are.
+class TestBlockAllocator {
+public:
+	TestBlock* acquireMTLBufferRegion(size_t length) {
+		acquiredCount++;
+		for (auto iter = _freeBlocks.begin(); iter != _freeBlocks.end(); iter++) {
+			if ((*iter)->_length == length) {
+				TestBlock* block = *iter;
+				_freeBlocks.erase(iter);
+				return block;
+			}
+		}
+		_mtlBuffers.emplace_back(new TestMTLBuffer(length + kTestBlockOffset));
+		_blocks.emplace_back(new TestBlock{_mtlBuffers.back().get(), kTestBlockOffset, length, this});
+		return _blocks.back().get();
+	}
+
+	void returnAllocation(TestBlock* block) { _freeBlocks.push_back(block); }
+
+	size_t getCreatedBlockCount() { return _blocks.size(); }
+	size_t getFreeBlockCount() { return _freeBlocks.size(); }
+
+	uint32_t acquiredCount = 0;
+
+protected:
+	static constexpr size_t kTestBlockOffset = 256;
+
+	std::vector<std::unique_ptr<TestMTLBuffer>> _mtlBuffers;
+	std::vector<std::unique_ptr<TestBlock>> _blocks;
+	std::vector<TestBlock*> _freeBlocks;
+};
+
+void TestBlock::returnToPool() { _allocator->returnAllocation(this); }
+
+// Stands in for a MTLCommandBuffer, whose completed handlers run once it completes.
+struct TestMTLCommandBuffer {
+	std::vector<std::function<void()>> completedHandlers;
+	void complete() {
+		for (auto& handler : completedHandlers) { handler(); }
+		completedHandlers.clear();
+	}
+};
+
+typedef MVKBufferUploadRing<TestBlock> TestRing;
+
+static TestRing newTestRing(TestBlockAllocator& allocator, size_t alignment, size_t blockLength) {
+	return TestRing([&allocator](size_t length) { return allocator.acquireMTLBufferRegion(length); }, alignment, blockLength);
+}
+
+// Recycles the blocks of the ring once the command buffer completes, as MVKMTLBufferUploadRing::recycleOnCompletion() does.
+static uint32_t recycleOnCompletion(TestRing& ring, TestMTLCommandBuffer& mtlCmdBuff) {
+	std::vector<TestBlock*> blocks;
+	uint32_t regionCnt = ring.recycle(blocks);
+	if ( !blocks.empty() ) {
+		mtlCmdBuff.completedHandlers.push_back([blocks]() {
+			for (auto* block : blocks) { block->returnToPool(); }
+		});
+	}
+	return regionCnt;
+}
+
+// Regions are aligned, and are sub-allocated from the current block until the next region would
+// cross the end of the block, including a region that exactly fills the rest of the block.
+static void testBlockBoundary() {
+	TestBlockAllocator allocator;
+	TestRing ring = newTestRing(allocator, 16, 1024);
+
+	auto rgn1 = ring.acquireRegion(1000);
+	auto rgn2 = ring.acquireRegion(16);
+	MVKTestExpect(rgn1.block == rgn2.block && rgn1.offset == 0 && rgn2.offset == 1008);
+	MVKTestExpect(ring.getBlockCount() == 1);
+
+	auto rgn3 = ring.acquireRegion(1);
+	MVKTestExpect(rgn3.block != rgn1.block && rgn3.offset == 0);
+
+	auto rgn4 = ring.acquireRegion(5);
+	MVKTestExpect(rgn4.block == rgn3.block && rgn4.offset == 16);
+
+	// A region of exactly the block length is not oversized, but does not fit in the rest of the block.
+	auto rgn5 = ring.acquireRegion(1024);
+	MVKTestExpect(rgn5.block != rgn3.block && rgn5.offset == 0 && rgn5.block->_length == 1024);
+	MVKTestExpect(ring.getBlockCount() == 3);
+}
+
+// A region larger than a block is given its own block of the region's length,
+// and regions that follow it are still sub-allocated from the current block.
+static void testOversizedRegion() {
+	TestBlockAllocator allocator;
+	TestRing ring = newTestRing(allocator, 16, 1024);
+
+	auto rgn1 = ring.acquireRegion(10);
+	auto bigRgn = ring.acquireRegion(4096);
+	auto rgn2 = ring.acquireRegion(10);
+	MVKTestExpect(bigRgn.block != rgn1.block && bigRgn.offset == 0 && bigRgn.block->_length == 4096);
+	MVKTestExpect(rgn2.block == rgn1.block && rgn2.offset == 16);
+	MVKTestExpect(ring.getBlockCount() == 2);
+
+	// An oversized region as the first region does not become the current block.
+	TestRing ring2 = newTestRing(allocator, 16, 1024);
+	auto bigRgn2 = ring2.acquireRegion(2048);
+	auto rgn3 = ring2.acquireRegion(8);
+	MVKTestExpect(rgn3.block != bigRgn2.block && rgn3.block->_length == 1024 && rgn3.offset == 0);
+
+	// The same applies at the 256 KB block length used by the command encoder.
+	const size_t blockLength = 256 * 1024;
+	TestRing ring3 = newTestRing(allocator, 256, blockLength);
+	auto rgn4 = ring3.acquireRegion(100);
+	auto bigRgn3 = ring3.acquireRegion(blockLength + 1);
+	auto rgn5 = ring3.acquireRegion(blockLength - 256);
+	MVKTestExpect(bigRgn3.block->_length == blockLength + 1 && bigRgn3.block != rgn4.block);
+	MVKTestExpect(rgn5.block == rgn4.block && rgn5.offset == 256);
+}
+
+// Recycled blocks are returned to the allocator only once the command buffer completes, and
+// regions acquired in the meantime come from new blocks. Once returned, the blocks are reused.
+static void testRecycleOnCompletion() {
+	TestBlockAllocator allocator;
+	TestRing ring = newTestRing(allocator, 16, 1024);
+	TestMTLCommandBuffer mtlCmdBuff1;
+	TestMTLCommandBuffer mtlCmdBuff2;
+
+	auto rgn1 = ring.acquireRegion(600);
+	ring.acquireRegion(600);
+	ring.acquireRegion(3000);
+	MVKTestExpect(recycleOnCompletion(ring, mtlCmdBuff1) == 3);
+	MVKTestExpect(ring.getBlockCount() == 0 && allocator.getFreeBlockCount() == 0);
+
+	// The blocks are still in use by the GPU, so new blocks are created.
+	auto rgn2 = ring.acquireRegion(600);
+	MVKTestExpect(rgn2.block != rgn1.block && rgn2.offset == 0);
+	MVKTestExpect(recycleOnCompletion(ring, mtlCmdBuff2) == 1);
+	MVKTestExpect(allocator.getCreatedBlockCount() == 4);
+
+	mtlCmdBuff1.complete();
+	MVKTestExpect(allocator.getFreeBlockCount() == 3);
+	mtlCmdBuff2.complete();
+	MVKTestExpect(allocator.getFreeBlockCount() == 4);
+
+	// Returned blocks are reused, without creating more.
+	for (uint32_t cycle = 0; cycle < 10; cycle++) {
+		TestMTLCommandBuffer mtlCmdBuff;
+		ring.acquireRegion(600);
+		ring.acquireRegion(600);
+		ring.acquireRegion(3000);
+		MVKTestExpect(recycleOnCompletion(ring, mtlCmdBuff) == 3);
+		mtlCmdBuff.complete();
+	}
+	MVKTestExpect(allocator.getCreatedBlockCount() == 4);
+
+	// Recycling a ring that has no blocks hands over nothing.
+	TestMTLCommandBuffer emptyCmdBuff;
+	MVKTestExpect(recycleOnCompletion(ring, emptyCmdBuff) == 0);
+	MVKTestExpect(emptyCmdBuff.completedHandlers.empty());
+}
+
+// Regions of random lengths are aligned, lie within their blocks, and never overlap, so their contents
+// can be written independently, at the offset of the region's block within its MTLBuffer.
+static void testRegionsDoNotOverlap() {
+	TestBlockAllocator allocator;
+	const size_t alignment = 256;
+	TestRing ring = newTestRing(allocator, alignment, 4096);
+	std::mt19937 rng(3);
+	std::vector<std::pair<TestRing::Region, uint8_t>> regions;
+	for (uint32_t idx = 0; idx < 500; idx++) {
+		size_t length = 1 + rng() % ((idx % 50) ? 700 : 6000);
+		auto rgn = ring.acquireRegion(length);
+		MVKTestExpect(rgn.offset % alignment == 0);
+		MVKTestExpect(rgn.offset + rgn.length <= rgn.block->_length);
+
+		uint8_t fill = uint8_t(idx);
+		std::fill_n(rgn.block->_mtlBuffer->contents.begin() + rgn.block->_offset + rgn.offset, rgn.length, fill);
+		regions.emplace_back(rgn, fill);
+	}
+	for (auto& rgnPair : regions) {
+		auto& rgn = rgnPair.first;
+		auto pStart = rgn.block->_mtlBuffer->contents.begin() + rgn.block->_offset + rgn.offset;
+		MVKTestExpect(std::all_of(pStart, pStart + rgn.length, [&](uint8_t val) { return val == rgnPair.second; }));
+	}
+
+	std::vector<TestBlock*> blocks;
+	MVKTestExpect(ring.recycle(blocks) == 500);
+	MVKTestExpect(blocks.size() == allocator.acquiredCount);
+}
+
+int main(int argc, const char* argv[]) {
+	MVKTestRun(testBlockBoundary);
+	MVKTestRun(testOversizedRegion);
+	MVKTestRun(testRecycleOnCompletion);
+	MVKTestRun(testRegionsDoNotOverlap);
+	return mvkTestExitCode();
+}
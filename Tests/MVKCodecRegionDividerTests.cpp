@@ -0,0 +1,168 @@
+/*
+ * MVKCodecRegionDividerTests.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKTest.h"
+#include "MVKCodecRegionDivider.h"
+#include "MVKBCnDecoder.h"
+#include <cstring>
+
+static const uint32_t kBytesPerTexel = 4;
+static const uint32_t kBlockHeight = 4;
+
+// Returns the regions of the divider, and checks that they tile the area exactly, in order,
+// that each fits in the scratch buffer, and that each begins on a row of texel blocks.
+static std::vector<std::pair<VkOffset3D, VkExtent3D>> getRegions(const MVKCodecRegionDivider& divider,
+																 VkOffset3D origin, VkExtent3D extent) {
+	std::vector<std::pair<VkOffset3D, VkExtent3D>> regions;
+	uint32_t regionCnt = divider.forEachRegion([&](VkOffset3D offset, VkExtent3D regionExtent) {
+		regions.push_back({offset, regionExtent});
+	});
+	MVKTestExpect(regionCnt == regions.size());
+
+	const VkSubresourceLayout& scratchLayout = divider.getScratchLayout();
+	std::vector<uint32_t> coverage(extent.width * extent.height * extent.depth, 0);
+	for (auto& region : regions) {
+		const VkOffset3D& offset = region.first;
+		const VkExtent3D& rgnExt = region.second;
+		MVKTestExpect(offset.x == origin.x && rgnExt.width == extent.width);
+		MVKTestExpect((offset.y - origin.y) % kBlockHeight == 0);
+		MVKTestExpect(scratchLayout.rowPitch * rgnExt.height <= scratchLayout.depthPitch);
+		MVKTestExpect(scratchLayout.depthPitch * rgnExt.depth <= scratchLayout.size);
+		for (uint32_t z = 0; z < rgnExt.depth; z++) {
+			for (uint32_t y = 0; y < rgnExt.height; y++) {
+				uint32_t areaY = offset.y - origin.y + y;
+				uint32_t areaZ = offset.z - origin.z + z;
+				MVKTestExpect(areaY < extent.height && areaZ < extent.depth);
+				if (areaY < extent.height && areaZ < extent.depth) { coverage[areaZ * extent.height + areaY]++; }
+			}
+		}
+	}
+	for (uint32_t z = 0; z < extent.depth; z++) {
+		for (uint32_t y = 0; y < extent.height; y++) { MVKTestExpect(coverage[z * extent.height + y] == 1); }
+	}
+	return regions;
+}
+
+// Each region holds as many whole slices as fit, and the last region holds the remaining slices.
+static void testSliceRegions() {
+	VkOffset3D origin = { 0, 0, 0 };
+	VkExtent3D extent = { 64, 64, 10 };
+	VkDeviceSize slice = 64 * 64 * kBytesPerTexel;
+	MVKCodecRegionDivider divider(origin, extent, kBlockHeight, kBytesPerTexel, slice * 3 + 100);
+	MVKTestExpect(divider.getRegionExtent().depth == 3 && divider.getRegionExtent().height == 64);
+	MVKTestExpect(divider.getScratchLayout().size == slice * 3);
+	MVKTestExpect(divider.getContentSize() == slice * 10);
+	auto regions = getRegions(divider, origin, extent);
+	MVKTestExpect(regions.size() == 4);
+	MVKTestExpect(regions.back().first.z == 9 && regions.back().second.depth == 1);
+}
+
+// If a slice does not fit, each region holds as many rows of texel blocks as fit, in one slice.
+static void testBlockRowRegions() {
+	VkOffset3D origin = { 0, 0, 0 };
+	VkExtent3D extent = { 64, 30, 2 };
+	VkDeviceSize blockRow = 64 * kBlockHeight * kBytesPerTexel;
+	MVKCodecRegionDivider divider(origin, extent, kBlockHeight, kBytesPerTexel, blockRow * 3 + 1);
+	MVKTestExpect(divider.getRegionExtent().height == 12 && divider.getRegionExtent().depth == 1);
+	MVKTestExpect(divider.getScratchLayout().size == blockRow * 3);
+	auto regions = getRegions(divider, origin, extent);
+	MVKTestExpect(regions.size() == 6);
+	MVKTestExpect(regions[2].first.y == 24 && regions[2].second.height == 6);
+}
+
+// A scratch buffer smaller than a row of texel blocks still holds one row of texel blocks.
+static void testScratchSmallerThanBlockRow() {
+	VkOffset3D origin = { 0, 0, 0 };
+	VkExtent3D extent = { 256, 8, 1 };
+	MVKCodecRegionDivider divider(origin, extent, kBlockHeight, kBytesPerTexel, 64);
+	MVKTestExpect(divider.getRegionExtent().height == kBlockHeight);
+	MVKTestExpect(divider.getScratchLayout().size == 256 * kBlockHeight * kBytesPerTexel);
+	MVKTestExpect(getRegions(divider, origin, extent).size() == 2);
+}
+
+// A zero maximum scratch size decompresses the whole area as one region.
+static void testUnboundedScratch() {
+	VkOffset3D origin = { 0, 0, 0 };
+	VkExtent3D extent = { 512, 512, 512 };
+	MVKCodecRegionDivider divider(origin, extent, kBlockHeight, kBytesPerTexel, 0);
+	MVKTestExpect(divider.getScratchLayout().size == divider.getContentSize());
+	MVKTestExpect(divider.forEachRegion([](VkOffset3D, VkExtent3D) {}) == 1);
+}
+
+// An area that begins within the subresource is divided from its origin.
+static void testAreaWithinSubresource() {
+	VkOffset3D origin = { 0, 8, 3 };
+	VkExtent3D extent = { 32, 20, 3 };
+	VkDeviceSize blockRow = 32 * kBlockHeight * kBytesPerTexel;
+	MVKCodecRegionDivider divider(origin, extent, kBlockHeight, kBytesPerTexel, blockRow * 2);
+	auto regions = getRegions(divider, origin, extent);
+	MVKTestExpect(regions.size() == 9);
+	MVKTestExpect(regions.front().first.y == 8 && regions.front().first.z == 3);
+	MVKTestExpect(regions.back().first.y == 24 && regions.back().second.height == 4 && regions.back().first.z == 5);
+}
+
+// Decompressing a BC1 volume region by region, through a small scratch buffer, produces the same
+// texels as decompressing the whole volume at once. The source of each region is located in the
+// same way as by the BCn codec of MoltenVK.
+static void testRegionDecompressionMatchesWhole() {
+	const uint32_t width = 36, height = 22, depth = 5;
+	MVKBCnDecoder decoder(kMVKBCnFormatBC1RGBA, false);
+	size_t blockByteCnt = decoder.getBlockByteCount();
+	size_t srcRowPitch = ((width + 3) / 4) * blockByteCnt;
+	size_t srcDepthPitch = srcRowPitch * ((height + 3) / 4);
+	std::vector<uint8_t> src(srcDepthPitch * depth);
+	uint32_t state = 1;
+	for (auto& byte : src) {
+		state = state * 1664525u + 1013904223u;
+		byte = uint8_t(state >> 24);
+	}
+
+	size_t destRowPitch = width * kBytesPerTexel;
+	size_t destDepthPitch = destRowPitch * height;
+	std::vector<uint8_t> whole(destDepthPitch * depth);
+	decoder.decode(whole.data(), destRowPitch, destDepthPitch, src.data(), srcRowPitch, srcDepthPitch, width, height, depth, 1);
+
+	for (VkDeviceSize maxScratchSize : { VkDeviceSize(0), VkDeviceSize(destDepthPitch * 2), VkDeviceSize(destRowPitch * 9) }) {
+		MVKCodecRegionDivider divider({ 0, 0, 0 }, { width, height, depth }, kBlockHeight, kBytesPerTexel, maxScratchSize);
+		const VkSubresourceLayout& scratchLayout = divider.getScratchLayout();
+		std::vector<uint8_t> scratch(scratchLayout.size);
+		std::vector<uint8_t> regional(whole.size(), 0);
+		divider.forEachRegion([&](VkOffset3D offset, VkExtent3D extent) {
+			const uint8_t* pSrcRegion = src.data() + offset.z * srcDepthPitch + (offset.y / 4) * srcRowPitch;
+			decoder.decode(scratch.data(), scratchLayout.rowPitch, scratchLayout.depthPitch,
+						   pSrcRegion, srcRowPitch, srcDepthPitch, extent.width, extent.height, extent.depth, 2);
+			for (uint32_t z = 0; z < extent.depth; z++) {
+				for (uint32_t y = 0; y < extent.height; y++) {
+					memcpy(&regional[(offset.z + z) * destDepthPitch + (offset.y + y) * destRowPitch],
+						   &scratch[z * scratchLayout.depthPitch + y * scratchLayout.rowPitch], destRowPitch);
+				}
+			}
+		});
+		MVKTestExpect(regional == whole);
+	}
+}
+
+int main(int argc, const char* argv[]) {
+	MVKTestRun(testSliceRegions);
+	MVKTestRun(testBlockRowRegions);
+	MVKTestRun(testScratchSmallerThanBlockRow);
+	MVKTestRun(testUnboundedScratch);
+	MVKTestRun(testAreaWithinSubresource);
+	MVKTestRun(testRegionDecompressionMatchesWhole);
+	return mvkTestExitCode();
+}
@@ -0,0 +1,179 @@
+/*
+ * MVKCommandArenaBenchmark.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the throughput of the two ways a command buffer allocates its commands: acquiring each
+// command from the pool of its command type, and returning it once the command buffer is reset; and
+// constructing each command in memory allocated from a MVKCommandArena, destroying it in place once the
+// command buffer is reset, and resetting the arena. Commands of several types and sizes are interleaved,
+// as they are in a typical command buffer, and are encoded by traversing the list of commands.
+//
+// Usage: MVKCommandArenaBenchmark [commands per command buffer]
+
+#include "MVKTest.h"
+#include "MVKObjectPool.h"
+#include "MVKCommandArena.h"
+
+// A stand-in for the Metal command encoder, which consumes the content of each command.
+struct TestEncoder {
+	uint64_t encodedContent = 0;
+};
+
+// A stand-in for a MVKCommand.
+class TestCommand : public MVKBaseObject, public MVKLinkableMixin<TestCommand> {
+public:
+	MVKVulkanAPIObject* getVulkanAPIObject() override { return nullptr; }
+	virtual void setContent(uint32_t first) = 0;
+	virtual void encode(TestEncoder* encoder) = 0;
+};
+
+// A command type with content of N words, such as a draw command, or a dynamic state command.
+template<uint32_t N>
+class TestCommandType : public TestCommand {
+public:
+	void setContent(uint32_t first) override {
+		for (uint32_t idx = 0; idx < N; idx++) { _content[idx] = first + idx; }
+	}
+
+	void encode(TestEncoder* encoder) override {
+		for (auto val : _content) { encoder->encodedContent += val; }
+	}
+
+protected:
+	uint32_t _content[N];
+};
+
+template<class T>
+class TestCommandTypePool : public MVKObjectPool<T> {
+public:
+	MVKVulkanAPIObject* getVulkanAPIObject() override { return nullptr; }
+	TestCommandTypePool() : MVKObjectPool<T>(true) {}
+
+protected:
+	T* newObject() override { return new T(); }
+};
+
+typedef TestCommandType<2> TestSmallCommand;
+typedef TestCommandType<6> TestMediumCommand;
+typedef TestCommandType<16> TestLargeCommand;
+
+// Holds a pool of each command type.
+struct TestCommandPools {
+	TestCommandTypePool<TestSmallCommand> smallPool;
+	TestCommandTypePool<TestMediumCommand> mediumPool;
+	TestCommandTypePool<TestLargeCommand> largePool;
+};
+
+// A stand-in for a command buffer, which allocates each command from either its
+// command pool or its command arena, and encodes the linked list of commands.
+class TestCommandBuffer {
+public:
+	void record(uint64_t cmdCnt) {
+		for (uint64_t idx = 0; idx < cmdCnt; idx++) {
+			TestCommand* cmd;
+			switch (idx % 4) {
+				case 0:  cmd = newCommand<TestLargeCommand>(_pools->largePool); break;
+				case 2:  cmd = newCommand<TestSmallCommand>(_pools->smallPool); break;
+				default: cmd = newCommand<TestMediumCommand>(_pools->mediumPool); break;
+			}
+			cmd->setContent(uint32_t(idx));
+			cmd->_next = nullptr;
+			if (_tail) { _tail->_next = cmd; } else { _head = cmd; }
+			_tail = cmd;
+		}
+	}
+
+	uint64_t encode() {
+		TestEncoder encoder;
+		for (TestCommand* cmd = _head; cmd; cmd = cmd->_next) { cmd->encode(&encoder); }
+		return encoder.encodedContent;
+	}
+
+	void reset() {
+		uint64_t idx = 0;
+		while (_head) {
+			TestCommand* next = _head->_next;
+			if (_pools) {
+				switch (idx % 4) {
+					case 0:  _pools->largePool.returnObject((TestLargeCommand*)_head); break;
+					case 2:  _pools->smallPool.returnObject((TestSmallCommand*)_head); break;
+					default: _pools->mediumPool.returnObject((TestMediumCommand*)_head); break;
+				}
+			} else {
+				_head->~TestCommand();
+			}
+			_head = next;
+			idx++;
+		}
+		_tail = nullptr;
+		_arena.reset();
+	}
+
+	TestCommandBuffer(TestCommandPools* pools) : _pools(pools) {}
+
+	~TestCommandBuffer() { reset(); }
+
+protected:
+	template<class T>
+	T* newCommand(TestCommandTypePool<T>& pool) {
+		return _pools ? pool.acquireObject() : _arena.newCommand<T>();
+	}
+
+	TestCommandPools* _pools;
+	MVKCommandArena _arena;
+	TestCommand* _head = nullptr;
+	TestCommand* _tail = nullptr;
+};
+
+// Records, encodes, and resets the command buffer repeatedly, and returns the seconds taken to do each.
+static void run(TestCommandBuffer& cmdBuff, uint64_t cmdCnt, uint32_t cmdBuffCnt, double& recordSecs, double& encodeSecs, double& resetSecs) {
+	volatile uint64_t sink = 0;
+	recordSecs = encodeSecs = resetSecs = 0;
+	for (uint32_t cbIdx = 0; cbIdx < cmdBuffCnt; cbIdx++) {
+		recordSecs += mvkTestTime([&]() { cmdBuff.record(cmdCnt); });
+		encodeSecs += mvkTestTime([&]() { sink = sink + cmdBuff.encode(); });
+		resetSecs += mvkTestTime([&]() { cmdBuff.reset(); });
+	}
+}
+
+int main(int argc, const char* argv[]) {
+	uint64_t cmdCnt = mvkTestIterationCount(argc, argv, 100000);
+	const uint32_t cmdBuffCnt = 20;
+
+	// Both ways of allocating must encode the same content.
+	TestCommandPools pools;
+	TestCommandBuffer pooledCmdBuff(&pools);
+	TestCommandBuffer arenaCmdBuff(nullptr);
+	pooledCmdBuff.record(1000);
+	arenaCmdBuff.record(1000);
+	MVKTestExpect(pooledCmdBuff.encode() == arenaCmdBuff.encode());
+	pooledCmdBuff.reset();
+	arenaCmdBuff.reset();
+
+	double poolRecSecs, poolEncSecs, poolRstSecs;
+	double arenaRecSecs, arenaEncSecs, arenaRstSecs;
+	run(pooledCmdBuff, cmdCnt, cmdBuffCnt, poolRecSecs, poolEncSecs, poolRstSecs);
+	run(arenaCmdBuff, cmdCnt, cmdBuffCnt, arenaRecSecs, arenaEncSecs, arenaRstSecs);
+
+	double totalCmdCnt = double(cmdBuffCnt) * cmdCnt;
+	printf("Command allocation, %u command buffers of %llu commands, millions of commands per second:\n",
+		   cmdBuffCnt, (unsigned long long)cmdCnt);
+	printf("%12s %12s %12s %12s\n", "", "Record", "Encode", "Reset");
+	printf("%12s %12.2f %12.2f %12.2f\n", "Type pools", totalCmdCnt / poolRecSecs / 1e6, totalCmdCnt / poolEncSecs / 1e6, totalCmdCnt / poolRstSecs / 1e6);
+	printf("%12s %12.2f %12.2f %12.2f\n", "Arena", totalCmdCnt / arenaRecSecs / 1e6, totalCmdCnt / arenaEncSecs / 1e6, totalCmdCnt / arenaRstSecs / 1e6);
+	return mvkTestExitCode();
+}
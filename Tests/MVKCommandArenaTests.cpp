@@ -0,0 +1,122 @@
+/*
+ * MVKCommandArenaTests.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKTest.h"
+#include "MVKCommandArena.h"
+#include <cstdint>
+
+struct TestSmallCommand {
+	uint32_t value = 7;
+};
+
+struct TestCommand {
+	uint64_t values[5] = {};
+	uint8_t flag = 1;
+};
+
+static bool isAligned(const void* ptr, size_t alignment) { return ((uintptr_t)ptr & (alignment - 1)) == 0; }
+
+// Consecutive allocations are adjacent in memory, aligned, and constructed, regardless of type.
+static void testAllocate() {
+	MVKCommandArena arena;
+	MVKTestExpect(arena.getChunkCount() == 0);
+
+	auto* pSmall = arena.newCommand<TestSmallCommand>();
+	auto* pCmd = arena.newCommand<TestCommand>();
+	auto* pSmall2 = arena.newCommand<TestSmallCommand>();
+	MVKTestExpect(arena.getChunkCount() == 1);
+	MVKTestExpect(pSmall->value == 7 && pCmd->flag == 1 && pSmall2->value == 7);
+	MVKTestExpect(isAligned(pCmd, alignof(TestCommand)));
+	MVKTestExpect((char*)pCmd == (char*)pSmall + alignof(TestCommand));
+	MVKTestExpect((char*)pSmall2 == (char*)pCmd + sizeof(TestCommand));
+
+	for (size_t alignment = 1; alignment <= alignof(std::max_align_t); alignment *= 2) {
+		arena.allocate(1, 1);
+		MVKTestExpect(isAligned(arena.allocate(3, alignment), alignment));
+	}
+}
+
+// Allocations that do not fit in the current chunk move on to a new chunk, and objects
+// larger than the standard chunk size are given a chunk of their own.
+static void testChunks() {
+	MVKCommandArena arena;
+	char* pFirst = (char*)arena.allocate(kMVKCommandArenaChunkSize - 8, 8);
+	char* pNext = (char*)arena.allocate(16, 8);
+	MVKTestExpect(arena.getChunkCount() == 2);
+	MVKTestExpect(pNext < pFirst || pNext >= pFirst + kMVKCommandArenaChunkSize);
+
+	char* pLarge = (char*)arena.allocate(kMVKCommandArenaChunkSize * 3, 8);
+	MVKTestExpect(arena.getChunkCount() == 3);
+	pLarge[kMVKCommandArenaChunkSize * 3 - 1] = 1;
+	MVKTestExpect(arena.allocate(16, 8) != nullptr);
+	MVKTestExpect(arena.getChunkCount() == 4);
+}
+
+// Once reset, the arena reuses the same memory, in the same order, without allocating more chunks.
+static void testReset() {
+	MVKCommandArena arena;
+	std::vector<void*> ptrs;
+	for (uint32_t idx = 0; idx < 5000; idx++) { ptrs.push_back(arena.newCommand<TestCommand>()); }
+	size_t chunkCnt = arena.getChunkCount();
+	MVKTestExpect(chunkCnt > 1);
+
+	arena.reset();
+	MVKTestExpect(arena.getChunkCount() == chunkCnt);
+	bool isReused = true;
+	for (uint32_t idx = 0; idx < 5000; idx++) { isReused = isReused && arena.newCommand<TestCommand>() == ptrs[idx]; }
+	MVKTestExpect(isReused);
+	MVKTestExpect(arena.getChunkCount() == chunkCnt);
+}
+
+// Trimming releases all chunks. Trimming the unused chunks keeps those holding objects still in use,
+// and releases all chunks once the arena has been reset.
+static void testTrim() {
+	MVKCommandArena arena;
+	for (uint32_t idx = 0; idx < 5000; idx++) { arena.newCommand<TestCommand>(); }
+	arena.trim();
+	MVKTestExpect(arena.getChunkCount() == 0);
+	MVKTestExpect(arena.newCommand<TestCommand>() != nullptr);
+	MVKTestExpect(arena.getChunkCount() == 1);
+
+	arena.reset();
+	for (uint32_t idx = 0; idx < 5000; idx++) { arena.newCommand<TestCommand>(); }
+	size_t chunkCnt = arena.getChunkCount();
+	arena.reset();
+	auto* pCmd = arena.newCommand<TestCommand>();
+	pCmd->values[4] = 42;
+	arena.trimUnused();
+	MVKTestExpect(chunkCnt > 1 && arena.getChunkCount() == 1);
+	MVKTestExpect(pCmd->values[4] == 42);
+
+	// A chunk is kept once the offset has moved on to it.
+	arena.allocate(kMVKCommandArenaChunkSize - 8, 8);
+	arena.trimUnused();
+	MVKTestExpect(arena.getChunkCount() == 2);
+
+	arena.reset();
+	arena.trimUnused();
+	MVKTestExpect(arena.getChunkCount() == 0);
+}
+
+int main(int argc, const char* argv[]) {
+	MVKTestRun(testAllocate);
+	MVKTestRun(testChunks);
+	MVKTestRun(testReset);
+	MVKTestRun(testTrim);
+	return mvkTestExitCode();
+}
@@ -0,0 +1,220 @@
+/*
+ * MVKCommandEncodingPlanTests.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKTest.h"
+#include "MVKCommandEncodingPlan.h"
+#include <algorithm>
+#include <string>
+
+// A recording stand-in for a MVKCommandEncoder, which records the commands encoded into it.
+struct TestEncoder {
+	std::vector<uint32_t> encodedCommands;
+	size_t primingCount = 0;
+};
+
+// A stand-in for a MVKCommand, which records whether it is being encoded by more than one thread at once.
+struct TestCommand {
+	TestCommand* _next = nullptr;
+	uint32_t id = 0;
+	MVKCommandEncodingScope scope = kMVKCommandEncodingScopeSegment;
+	std::atomic<uint32_t> encodingCount = { 0 };
+
+	MVKCommandEncodingScope getEncodingScope() { return scope; }
+
+	void encode(TestEncoder* encoder) {
+		MVKTestExpect(encodingCount.fetch_add(1) == 0);
+		encoder->encodedCommands.push_back(id);
+		std::this_thread::yield();
+		encodingCount.fetch_sub(1);
+	}
+};
+
+// Builds a linked list of commands, from a string of scope codes: S=state, B=boundary, C=command buffer, other=segment.
+class TestCommandList {
+public:
+	TestCommand* getHead() { return _commands.empty() ? nullptr : &_commands[0]; }
+	size_t size() { return _commands.size(); }
+	TestCommand& operator[](size_t idx) { return _commands[idx]; }
+
+	TestCommandList(const std::string& scopes) : _commands(scopes.size()) {
+		for (size_t idx = 0; idx < scopes.size(); idx++) {
+			auto& cmd = _commands[idx];
+			cmd.id = uint32_t(idx);
+			cmd._next = idx + 1 < scopes.size() ? &_commands[idx + 1] : nullptr;
+			switch (scopes[idx]) {
+				case 'S': cmd.scope = kMVKCommandEncodingScopeState; break;
+				case 'B': cmd.scope = kMVKCommandEncodingScopeBoundary; break;
+				case 'C': cmd.scope = kMVKCommandEncodingScopeCommandBuffer; break;
+				default:  cmd.scope = kMVKCommandEncodingScopeSegment; break;
+			}
+		}
+	}
+
+protected:
+	std::vector<TestCommand> _commands;
+};
+
+static std::string repeat(const std::string& str, size_t count) {
+	std::string result;
+	for (size_t i = 0; i < count; i++) { result += str; }
+	return result;
+}
+
+// Encodes the plan in the same way as MVKCommandBuffer::encodeConcurrently(), into recording encoders.
+static std::vector<TestEncoder> encodePlan(MVKCommandEncodingPlan<TestCommand>& plan, size_t threadCount, std::vector<size_t>& commitOrder) {
+	std::vector<TestEncoder> encoders(plan.getSegmentCount());
+	plan.encode(threadCount,
+				[&](size_t segIdx) {
+					auto& seg = plan.getSegment(segIdx);
+					for (size_t cmdIdx = 0; cmdIdx < seg.primingCommandCount; cmdIdx++) {
+						plan.getPrimingCommand(cmdIdx)->encode(&encoders[segIdx]);
+					}
+					encoders[segIdx].primingCount = encoders[segIdx].encodedCommands.size();
+				},
+				[&](size_t segIdx) {
+					auto& seg = plan.getSegment(segIdx);
+					for (TestCommand* cmd = seg.firstCommand; cmd != seg.endCommand; cmd = cmd->_next) {
+						cmd->encode(&encoders[segIdx]);
+					}
+				},
+				[&](size_t segIdx) { commitOrder.push_back(segIdx); });
+	return encoders;
+}
+
+static void testDivision() {
+	// Four render passes of 10 commands, each beginning with a boundary, and a state command.
+	TestCommandList cmds(repeat("BS" + repeat("x", 8), 4));
+	MVKCommandEncodingPlan<TestCommand> plan;
+
+	MVKTestExpect(plan.divide(cmds.getHead(), cmds.size(), 10, 4));
+	MVKTestExpect(plan.getSegmentCount() == 4);
+	size_t cmdCnt = 0;
+	for (size_t segIdx = 0; segIdx < plan.getSegmentCount(); segIdx++) {
+		auto& seg = plan.getSegment(segIdx);
+		MVKTestExpect(seg.firstCommand == &cmds[segIdx * 10]);
+		MVKTestExpect(seg.commandCount == 10);
+		MVKTestExpect(seg.primingCommandCount == segIdx);		// One state command per earlier segment
+		cmdCnt += seg.commandCount;
+	}
+	MVKTestExpect(plan.getSegment(3).endCommand == nullptr);
+	MVKTestExpect(cmdCnt == cmds.size());
+
+	// No more segments than the maximum.
+	TestCommandList moreCmds(repeat("BS" + repeat("x", 8), 6));
+	MVKTestExpect(plan.divide(moreCmds.getHead(), moreCmds.size(), 10, 3));
+	MVKTestExpect(plan.getSegmentCount() == 3);
+	MVKTestExpect(plan.getSegment(0).commandCount == 20 && plan.getSegment(1).commandCount == 20 && plan.getSegment(2).commandCount == 20);
+
+	// Too short to divide, or too few threads, to encode at least the minimum number of segments concurrently.
+	MVKTestExpect( !plan.divide(cmds.getHead(), cmds.size(), 20, 4) );
+	MVKTestExpect(plan.getSegmentCount() == 0);
+	MVKTestExpect( !plan.divide(cmds.getHead(), cmds.size(), 10, 2) );
+	MVKTestExpect( !plan.divide(cmds.getHead(), cmds.size(), 10, 1) );
+}
+
+static void testShortLastSegmentIsFolded() {
+	TestCommandList cmds(repeat("B" + repeat("x", 9), 3) + "Bxx");
+	MVKCommandEncodingPlan<TestCommand> plan;
+	MVKTestExpect(plan.divide(cmds.getHead(), cmds.size(), 10, 8));
+	MVKTestExpect(plan.getSegmentCount() == 3);
+	MVKTestExpect(plan.getSegment(2).commandCount == 13);
+	MVKTestExpect(plan.getSegment(2).endCommand == nullptr);
+
+	// Folding the short segment may leave too few segments to be worth encoding concurrently.
+	TestCommandList fewerCmds(repeat("B" + repeat("x", 9), 2) + "Bxx");
+	MVKTestExpect( !plan.divide(fewerCmds.getHead(), fewerCmds.size(), 10, 8));
+}
+
+static void testCommandBufferScopePreventsDivision() {
+	TestCommandList cmds(repeat("B" + repeat("x", 9), 3) + "C" + repeat("B" + repeat("x", 9), 3));
+	MVKCommandEncodingPlan<TestCommand> plan;
+	MVKTestExpect( !plan.divide(cmds.getHead(), cmds.size(), 10, 4) );
+	MVKTestExpect(plan.getSegmentCount() == 0);
+}
+
+// Encodes many segments on many threads, and checks that each encoder was primed with every state
+// command before its segment, that every command was encoded once in its own segment, that segments
+// were committed in order, and that no command was encoded by two threads at once.
+static void testConcurrentEncoding() {
+	const size_t segCnt = 16;
+	TestCommandList cmds(repeat("BSxSxSxxxx", segCnt * 4));
+	MVKCommandEncodingPlan<TestCommand> plan;
+	MVKTestExpect(plan.divide(cmds.getHead(), cmds.size(), 10, segCnt));
+	MVKTestExpect(plan.getSegmentCount() == segCnt);
+
+	std::vector<size_t> commitOrder;
+	auto encoders = encodePlan(plan, 8, commitOrder);
+
+	std::vector<uint32_t> encodedCmds;
+	for (size_t segIdx = 0; segIdx < segCnt; segIdx++) {
+		auto& seg = plan.getSegment(segIdx);
+		auto& encoder = encoders[segIdx];
+		MVKTestExpect(commitOrder[segIdx] == segIdx);
+
+		std::vector<uint32_t> expectedPriming;
+		for (TestCommand* cmd = cmds.getHead(); cmd != seg.firstCommand; cmd = cmd->_next) {
+			if (cmd->scope == kMVKCommandEncodingScopeState) { expectedPriming.push_back(cmd->id); }
+		}
+		MVKTestExpect(encoder.primingCount == expectedPriming.size());
+		MVKTestExpect(std::equal(expectedPriming.begin(), expectedPriming.end(), encoder.encodedCommands.begin()));
+
+		encodedCmds.insert(encodedCmds.end(), encoder.encodedCommands.begin() + encoder.primingCount, encoder.encodedCommands.end());
+	}
+	MVKTestExpect(encodedCmds.size() == cmds.size());
+	for (size_t idx = 0; idx < encodedCmds.size(); idx++) { MVKTestExpect(encodedCmds[idx] == idx); }
+}
+
+// The worker pool runs the task on the requested number of threads, including the calling thread, reusing
+// its worker threads across runs. A run made while the pool is busy runs only on its calling thread.
+static void testWorkerPool() {
+	MVKCommandEncodingWorkerPool pool;
+	std::atomic<size_t> runCnt(0);
+	for (size_t thrdCnt = 1; thrdCnt <= 4; thrdCnt++) {
+		runCnt = 0;
+		pool.run(thrdCnt, [&]() { runCnt++; });
+		MVKTestExpect(runCnt == thrdCnt);
+	}
+	for (uint32_t iter = 0; iter < 1000; iter++) { pool.run(1 + iter % 4, [&]() { runCnt++; }); }
+	MVKTestExpect(pool.getWorkerCount() == 3);
+
+	// Each concurrent run is either shared with the workers, or runs on its calling thread alone.
+	const uint32_t callerCnt = 4;
+	const uint32_t runsPerCaller = 200;
+	std::atomic<size_t> sharedRunCnt(0);
+	std::atomic<size_t> soloRunCnt(0);
+	mvkTestRunThreads(callerCnt, [&](uint32_t) {
+		for (uint32_t runIdx = 0; runIdx < runsPerCaller; runIdx++) {
+			std::atomic<size_t> taskCnt(0);
+			pool.run(4, [&]() { taskCnt++; });
+			if (taskCnt == 4) { sharedRunCnt++; }
+			if (taskCnt == 1) { soloRunCnt++; }
+		}
+	});
+	MVKTestExpect(sharedRunCnt + soloRunCnt == callerCnt * runsPerCaller);
+	MVKTestExpect(sharedRunCnt > 0);
+	MVKTestExpect(pool.getWorkerCount() == 3);
+}
+
+int main(int argc, const char* argv[]) {
+	MVKTestRun(testDivision);
+	MVKTestRun(testShortLastSegmentIsFolded);
+	MVKTestRun(testCommandBufferScopePreventsDivision);
+	MVKTestRun(testConcurrentEncoding);
+	MVKTestRun(testWorkerPool);
+	return mvkTestExitCode();
+}
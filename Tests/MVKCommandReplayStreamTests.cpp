@@ -0,0 +1,269 @@
+/*
+ * MVKCommandReplayStreamTests.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKTest.h"
+#include "MVKCommandReplayStream.h"
+#include <map>
+
+struct TestCommand;
+typedef MVKCommandReplayStream<TestCommand> TestReplayStream;
+
+// A stand-in for a texture resolved by a descriptor. A volatile texture, like the drawable
+// texture of a swapchain image, can be different each time its descriptor is resolved.
+struct TestTexture {
+	bool isVolatile = false;
+};
+
+// A stand-in for a descriptor set, whose content version changes each time it is written.
+struct TestDescriptorSet {
+	std::vector<TestTexture*> textures;
+	uint64_t contentVersion = mvkNewCommandReplayVersion();
+
+	void write(std::vector<TestTexture*> texs) {
+		textures = std::move(texs);
+		contentVersion = mvkNewCommandReplayVersion();
+	}
+};
+
+static const uint32_t kTestDependencyDescriptorSet = 1;
+
+// A stand-in for a MVKCommandEncoder, which records the commands and bindings encoded into it, and
+// records a replay stream in the same way as MVKCommandEncoder::encodeCommand().
+struct TestEncoder {
+	std::vector<const void*> encoded;
+	TestReplayStream* replayStream = nullptr;
+	bool isRecordingReplayBindings = false;
+	bool areReplayBindingsVolatile = false;
+
+	void encodeCommand(TestCommand* cmd);
+
+	void bindTexture(uint16_t index, TestTexture* tex) {
+		encoded.push_back(tex);
+		if (isRecordingReplayBindings) {
+			replayStream->recordBinding(kMVKCommandReplayOpBindTexture, 0, index, tex);
+			if (tex->isVolatile) { areReplayBindingsVolatile = true; }
+		}
+	}
+
+	void replay(TestReplayStream& stream);
+};
+
+// A stand-in for a MVKCommand. A command with a descriptor set binds the textures in the set.
+struct TestCommand {
+	TestDescriptorSet* descSet = nullptr;
+
+	MVKCommandReplayMode getReplayMode() { return descSet ? kMVKCommandReplayBindings : kMVKCommandReplayEncode; }
+
+	void encode(TestEncoder* encoder) {
+		if ( !descSet ) {
+			encoder->encoded.push_back(this);
+			return;
+		}
+		if (encoder->isRecordingReplayBindings) {
+			encoder->replayStream->addDependency(descSet, descSet->contentVersion, kTestDependencyDescriptorSet);
+		}
+		for (size_t idx = 0; idx < descSet->textures.size(); idx++) {
+			encoder->bindTexture(uint16_t(idx), descSet->textures[idx]);
+		}
+	}
+};
+
+void TestEncoder::encodeCommand(TestCommand* cmd) {
+	if ( !replayStream ) {
+		cmd->encode(this);
+		return;
+	}
+	if (cmd->getReplayMode() == kMVKCommandReplayBindings) {
+		size_t opIdx = replayStream->getOpCount();
+		isRecordingReplayBindings = true;
+		areReplayBindingsVolatile = false;
+		cmd->encode(this);
+		isRecordingReplayBindings = false;
+		if (areReplayBindingsVolatile) { replayStream->replaceOpsWithCommand(opIdx, cmd); }
+	} else {
+		replayStream->recordCommand(cmd);
+		cmd->encode(this);
+	}
+}
+
+void TestEncoder::replay(TestReplayStream& stream) {
+	stream.replay([&](const TestReplayStream::Op& op) {
+		switch (op.type) {
+			case kMVKCommandReplayOpEncodeCommand:
+				op.command->encode(this);
+				break;
+			case kMVKCommandReplayOpBindTexture:
+				encoded.push_back(op.resource);
+				break;
+			default:
+				MVKTestExpect(false);
+				break;
+		}
+	});
+}
+
+static std::vector<const void*> record(TestReplayStream& stream, std::vector<TestCommand>& cmds) {
+	TestEncoder encoder;
+	encoder.replayStream = &stream;
+	stream.beginRecording();
+	for (auto& cmd : cmds) { encoder.encodeCommand(&cmd); }
+	stream.endRecording();
+	return encoder.encoded;
+}
+
+static std::vector<const void*> replay(TestReplayStream& stream) {
+	TestEncoder encoder;
+	encoder.replay(stream);
+	return encoder.encoded;
+}
+
+static bool isCurrent(TestReplayStream& stream) {
+	return stream.isCurrent([](const MVKCommandReplayDependency& dep) -> uint64_t {
+		return dep.kind == kTestDependencyDescriptorSet ? ((TestDescriptorSet*)dep.object)->contentVersion : 0;
+	});
+}
+
+// Replaying the stream encodes the same commands and bindings as recording it, with each
+// descriptor set bind replaced by the textures it resolved.
+static void testRecordAndReplay() {
+	TestTexture tex0, tex1;
+	TestDescriptorSet descSet;
+	descSet.write({&tex0, &tex1});
+	std::vector<TestCommand> cmds(3);
+	cmds[1].descSet = &descSet;
+
+	TestReplayStream stream;
+	auto recorded = record(stream, cmds);
+	MVKTestExpect(stream.isRecorded() && !stream.isRecording());
+	MVKTestExpect(isCurrent(stream));
+	MVKTestExpect((recorded == std::vector<const void*>{&cmds[0], &tex0, &tex1, &cmds[2]}));
+
+	auto& ops = stream.getOps();
+	MVKTestExpect(ops.size() == 4);
+	MVKTestExpect(ops[0].type == kMVKCommandReplayOpEncodeCommand && ops[0].command == &cmds[0]);
+	MVKTestExpect(ops[1].type == kMVKCommandReplayOpBindTexture && ops[1].resource == &tex0 && ops[1].index == 0);
+	MVKTestExpect(ops[2].type == kMVKCommandReplayOpBindTexture && ops[2].resource == &tex1 && ops[2].index == 1);
+	MVKTestExpect(ops[3].type == kMVKCommandReplayOpEncodeCommand && ops[3].command == &cmds[2]);
+	MVKTestExpect(stream.getDependencies().size() == 1);
+
+	MVKTestExpect(replay(stream) == recorded);
+}
+
+// A stream cannot be replayed after a descriptor set it depends on is written.
+static void testDependencyChangeInvalidates() {
+	TestTexture tex0, tex1;
+	TestDescriptorSet descSet;
+	descSet.write({&tex0});
+	std::vector<TestCommand> cmds(1);
+	cmds[0].descSet = &descSet;
+
+	TestReplayStream stream;
+	record(stream, cmds);
+	MVKTestExpect(isCurrent(stream));
+	descSet.write({&tex1});
+	MVKTestExpect( !isCurrent(stream) );
+
+	// Rerecording picks up the new content.
+	MVKTestExpect((record(stream, cmds) == std::vector<const void*>{&tex1}));
+	MVKTestExpect(isCurrent(stream));
+	MVKTestExpect((replay(stream) == std::vector<const void*>{&tex1}));
+}
+
+// A stream that binds the same descriptor set at two different versions cannot be replayed.
+static void testInconsistentDependency() {
+	TestDescriptorSet descSet;
+	TestReplayStream stream;
+	stream.beginRecording();
+	stream.addDependency(&descSet, 1, kTestDependencyDescriptorSet);
+	stream.addDependency(&descSet, 1, kTestDependencyDescriptorSet);
+	MVKTestExpect(stream.getDependencies().size() == 1);
+	stream.addDependency(&descSet, 2, kTestDependencyDescriptorSet);
+	stream.endRecording();
+	MVKTestExpect( !stream.isCurrent([](const MVKCommandReplayDependency& dep) { return dep.version; }) );
+}
+
+// A descriptor set bind that resolves a volatile texture is recorded as the command itself, and not
+// as the textures it resolved, so replaying it resolves the texture again. Other binds are unaffected.
+static void testVolatileBindingIsEncodedAgain() {
+	TestTexture tex0, drawableTex;
+	drawableTex.isVolatile = true;
+	TestDescriptorSet stableSet, volatileSet;
+	stableSet.write({&tex0});
+	volatileSet.write({&tex0, &drawableTex});
+	std::vector<TestCommand> cmds(3);
+	cmds[0].descSet = &stableSet;
+	cmds[1].descSet = &volatileSet;
+
+	TestReplayStream stream;
+	record(stream, cmds);
+	auto& ops = stream.getOps();
+	MVKTestExpect(ops.size() == 3);
+	MVKTestExpect(ops[0].type == kMVKCommandReplayOpBindTexture && ops[0].resource == &tex0);
+	MVKTestExpect(ops[1].type == kMVKCommandReplayOpEncodeCommand && ops[1].command == &cmds[1]);
+	MVKTestExpect(ops[2].type == kMVKCommandReplayOpEncodeCommand && ops[2].command == &cmds[2]);
+
+	// Replaying encodes the command, which resolves whatever texture the descriptor set now holds.
+	TestTexture nextDrawableTex;
+	volatileSet.textures[1] = &nextDrawableTex;
+	MVKTestExpect((replay(stream) == std::vector<const void*>{&tex0, &tex0, &nextDrawableTex, &cmds[2]}));
+}
+
+// An unsuccessful recording leaves nothing to replay, and trimming empties the stream.
+static void testFailedRecordingAndTrim() {
+	TestCommand cmd;
+	TestReplayStream stream;
+	stream.beginRecording();
+	MVKTestExpect(stream.isRecording());
+	stream.recordCommand(&cmd);
+	stream.endRecording(false);
+	MVKTestExpect( !stream.isRecorded() );
+	MVKTestExpect(stream.getOpCount() == 0);
+	MVKTestExpect( !stream.isCurrent([](const MVKCommandReplayDependency& dep) { return dep.version; }) );
+
+	stream.beginRecording();
+	stream.recordCommand(&cmd);
+	stream.endRecording();
+	MVKTestExpect(stream.getOpCount() == 1);
+	stream.trim();
+	MVKTestExpect( !stream.isRecorded() && stream.getOpCount() == 0 && stream.getDependencies().empty() );
+}
+
+// Content versions are never repeated, even when requested from many threads at once.
+static void testVersionsAreUnique() {
+	const uint32_t threadCnt = 4;
+	const uint32_t versionCnt = 10000;
+	std::vector<std::vector<uint64_t>> versions(threadCnt);
+	mvkTestRunThreads(threadCnt, [&](uint32_t tIdx) {
+		for (uint32_t i = 0; i < versionCnt; i++) { versions[tIdx].push_back(mvkNewCommandReplayVersion()); }
+	});
+	std::map<uint64_t, uint32_t> counts;
+	for (auto& tVersions : versions) {
+		for (auto v : tVersions) { counts[v]++; }
+	}
+	MVKTestExpect(counts.size() == threadCnt * versionCnt);
+}
+
+int main(int argc, const char* argv[]) {
+	MVKTestRun(testRecordAndReplay);
+	MVKTestRun(testDependencyChangeInvalidates);
+	MVKTestRun(testInconsistentDependency);
+	MVKTestRun(testVolatileBindingIsEncodedAgain);
+	MVKTestRun(testFailedRecordingAndTrim);
+	MVKTestRun(testVersionsAreUnique);
+	return mvkTestExitCode();
+}
@@ -0,0 +1,218 @@
+/*
+ * MVKCommandStateContentTests.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKTest.h"
+#include "MVKCommandStateContent.h"
+#include <set>
+
+// A stand-in for a MVKCommand. A state command sets a range of elements of one type of state,
+// like a MVKCmdSetViewport command. Other commands either use state, like a draw command, set
+// state that cannot be coalesced, like binding a pipeline, or might set any state at all.
+struct TestCommand {
+	MVKCommandStateType stateType = kMVKCommandStateNone;
+	MVKCommandEncodingScope scope = kMVKCommandEncodingScopeSegment;
+	uint32_t selector = 0;
+	uint32_t firstElement = 0;
+	std::vector<uint32_t> elements;
+
+	MVKCommandEncodingScope getEncodingScope() { return scope; }
+
+	MVKCommandStateContent getStateContent() {
+		MVKCommandStateContent content;
+		content.stateType = stateType;
+		content.selector = selector;
+		content.firstElement = firstElement;
+		content.elementCount = (uint32_t)elements.size();
+		content.elementSize = sizeof(uint32_t);
+		content.elements = elements.data();
+		return content;
+	}
+
+	bool mergeStateContent(const MVKCommandStateContent& prevContent) {
+		mvkMergeCommandStateContent(elements, firstElement, prevContent);
+		return true;
+	}
+};
+
+static TestCommand setViewports(uint32_t first, std::vector<uint32_t> elems) {
+	TestCommand cmd;
+	cmd.stateType = kMVKCommandStateViewports;
+	cmd.scope = kMVKCommandEncodingScopeState;
+	cmd.firstElement = first;
+	cmd.elements = std::move(elems);
+	return cmd;
+}
+
+static TestCommand setScissors(uint32_t first, std::vector<uint32_t> elems) {
+	TestCommand cmd = setViewports(first, std::move(elems));
+	cmd.stateType = kMVKCommandStateScissors;
+	return cmd;
+}
+
+static TestCommand pushConstants(uint32_t stages, uint32_t first, std::vector<uint32_t> elems) {
+	TestCommand cmd = setViewports(first, std::move(elems));
+	cmd.stateType = kMVKCommandStatePushConstants;
+	cmd.selector = stages;
+	return cmd;
+}
+
+static TestCommand draw() { return TestCommand(); }
+
+static TestCommand bindPipeline() {
+	TestCommand cmd;
+	cmd.scope = kMVKCommandEncodingScopeState;
+	return cmd;
+}
+
+static TestCommand executeCommands() {
+	TestCommand cmd;
+	cmd.stateType = kMVKCommandStateAll;
+	return cmd;
+}
+
+// Coalesces the commands, and returns the indexes of the commands that remain.
+static std::vector<size_t> coalesce(std::vector<TestCommand>& cmds, MVKCommandCoalescingCounts& counts) {
+	std::vector<TestCommand*> cmdPtrs;
+	for (auto& cmd : cmds) { cmdPtrs.push_back(&cmd); }
+	std::set<TestCommand*> released;
+	counts = mvkCoalesceStateCommands(cmdPtrs, [&](TestCommand* cmd) { MVKTestExpect(released.insert(cmd).second); });
+
+	std::vector<size_t> remaining;
+	for (size_t idx = 0; idx < cmds.size(); idx++) {
+		MVKTestExpect((cmdPtrs[idx] == nullptr) == (released.count(&cmds[idx]) == 1));
+		if (cmdPtrs[idx]) { remaining.push_back(idx); }
+	}
+	MVKTestExpect(released.size() == counts.removedCount + counts.mergedCount);
+	return remaining;
+}
+
+static void testMergeContent() {
+	// The earlier content overlaps the start of the later content, which overwrites it.
+	std::vector<uint32_t> elems = { 20, 30 };
+	uint32_t first = 2;
+	TestCommand prev = setViewports(0, { 1, 2, 3 });
+	mvkMergeCommandStateContent(elems, first, prev.getStateContent());
+	MVKTestExpect(first == 0 && (elems == std::vector<uint32_t>{ 1, 2, 20, 30 }));
+
+	// The earlier content abuts the end of the later content.
+	elems = { 10, 11 };
+	first = 1;
+	prev = setViewports(3, { 4, 5 });
+	mvkMergeCommandStateContent(elems, first, prev.getStateContent());
+	MVKTestExpect(first == 1 && (elems == std::vector<uint32_t>{ 10, 11, 4, 5 }));
+
+	// The later content lies within the earlier content.
+	elems = { 99 };
+	first = 1;
+	prev = setViewports(0, { 1, 2, 3 });
+	mvkMergeCommandStateContent(elems, first, prev.getStateContent());
+	MVKTestExpect(first == 0 && (elems == std::vector<uint32_t>{ 1, 99, 3 }));
+}
+
+static void testContentComparisons() {
+	TestCommand cmd = setViewports(1, { 2, 3 });
+	TestCommand wider = setViewports(0, { 1, 2, 3 });
+	MVKTestExpect(cmd.getStateContent().isRedundantWith(wider.getStateContent()));
+	MVKTestExpect( !wider.getStateContent().isRedundantWith(cmd.getStateContent()) );
+	MVKTestExpect(wider.getStateContent().contains(cmd.getStateContent()));
+	MVKTestExpect( !cmd.getStateContent().contains(wider.getStateContent()) );
+
+	wider.elements[2] = 7;
+	MVKTestExpect( !cmd.getStateContent().isRedundantWith(wider.getStateContent()) );
+
+	TestCommand apart = setViewports(4, { 5 });
+	MVKTestExpect( !cmd.getStateContent().canMergeWith(apart.getStateContent()) );
+	TestCommand abutting = setViewports(3, { 5 });
+	MVKTestExpect(cmd.getStateContent().canMergeWith(abutting.getStateContent()));
+
+	// Content of different types, selectors, or layouts, or without elements, cannot be compared.
+	MVKTestExpect( !cmd.getStateContent().isComparableWith(setScissors(1, { 2, 3 }).getStateContent()) );
+	MVKTestExpect( !pushConstants(1, 0, { 1 }).getStateContent().isComparableWith(pushConstants(2, 0, { 1 }).getStateContent()) );
+	MVKTestExpect( !pushConstants(1, 0, {}).getStateContent().isComparableWith(pushConstants(1, 0, {}).getStateContent()) );
+	auto laidOut = cmd.getStateContent();
+	laidOut.layout = &cmd;
+	MVKTestExpect( !laidOut.isComparableWith(cmd.getStateContent()) );
+}
+
+// A command that sets state already set to the same content is removed, even if a draw lies between them.
+static void testRedundantCommandIsRemoved() {
+	std::vector<TestCommand> cmds = { setViewports(0, { 1, 2 }), draw(), setViewports(1, { 2 }) };
+	MVKCommandCoalescingCounts counts;
+	MVKTestExpect((coalesce(cmds, counts) == std::vector<size_t>{ 0, 1 }));
+	MVKTestExpect(counts.removedCount == 1 && counts.mergedCount == 0);
+}
+
+// An unused earlier command whose state is completely overwritten is removed. Commands that set other
+// types of state, or that set state that cannot be coalesced, do not use the state of the earlier command.
+static void testOverwrittenCommandIsRemoved() {
+	std::vector<TestCommand> cmds = { setViewports(1, { 5 }), setScissors(0, { 1 }), bindPipeline(), setViewports(0, { 1, 2, 3 }) };
+	MVKCommandCoalescingCounts counts;
+	MVKTestExpect((coalesce(cmds, counts) == std::vector<size_t>{ 1, 2, 3 }));
+	MVKTestExpect(counts.removedCount == 1 && counts.mergedCount == 0);
+}
+
+// An unused earlier command whose state overlaps is merged into the later command.
+static void testOverlappingCommandIsMerged() {
+	std::vector<TestCommand> cmds = { setViewports(0, { 1, 2 }), bindPipeline(), setViewports(1, { 7, 8 }) };
+	MVKCommandCoalescingCounts counts;
+	MVKTestExpect((coalesce(cmds, counts) == std::vector<size_t>{ 1, 2 }));
+	MVKTestExpect(counts.removedCount == 0 && counts.mergedCount == 1);
+	MVKTestExpect(cmds[2].firstElement == 0 && (cmds[2].elements == std::vector<uint32_t>{ 1, 7, 8 }));
+
+	// The merged command is then compared with the commands that follow it.
+	cmds = { setViewports(0, { 1, 2 }), setViewports(1, { 7, 8 }), setViewports(0, { 1 }) };
+	MVKTestExpect((coalesce(cmds, counts) == std::vector<size_t>{ 1 }));
+	MVKTestExpect(counts.removedCount == 1 && counts.mergedCount == 1);
+}
+
+// State that has been used by a draw is neither overwritten nor merged.
+static void testUsedStateIsKept() {
+	std::vector<TestCommand> cmds = { setViewports(0, { 1, 2 }), draw(), setViewports(1, { 7, 8 }), draw(), setViewports(0, { 3, 4, 5 }) };
+	MVKCommandCoalescingCounts counts;
+	MVKTestExpect((coalesce(cmds, counts) == std::vector<size_t>{ 0, 1, 2, 3, 4 }));
+	MVKTestExpect(counts.removedCount == 0 && counts.mergedCount == 0);
+	MVKTestExpect(cmds[2].firstElement == 1 && (cmds[2].elements == std::vector<uint32_t>{ 7, 8 }));
+}
+
+// Push constants for different shader stages are coalesced separately from each other.
+static void testDifferentSelectorsAreKept() {
+	std::vector<TestCommand> cmds = { pushConstants(1, 0, { 1 }), pushConstants(2, 0, { 1 }), pushConstants(2, 0, { 1 }) };
+	MVKCommandCoalescingCounts counts;
+	MVKTestExpect((coalesce(cmds, counts) == std::vector<size_t>{ 0, 1 }));
+	MVKTestExpect(counts.removedCount == 1);
+}
+
+// A command that might set any state ends all comparisons with the commands before it.
+static void testCommandSettingAnyStateIsBarrier() {
+	std::vector<TestCommand> cmds = { setViewports(0, { 1 }), executeCommands(), setViewports(0, { 1 }), setViewports(0, { 1 }) };
+	MVKCommandCoalescingCounts counts;
+	MVKTestExpect((coalesce(cmds, counts) == std::vector<size_t>{ 0, 1, 2 }));
+	MVKTestExpect(counts.removedCount == 1);
+}
+
+int main(int argc, const char* argv[]) {
+	MVKTestRun(testMergeContent);
+	MVKTestRun(testContentComparisons);
+	MVKTestRun(testRedundantCommandIsRemoved);
+	MVKTestRun(testOverwrittenCommandIsRemoved);
+	MVKTestRun(testOverlappingCommandIsMerged);
+	MVKTestRun(testUsedStateIsKept);
+	MVKTestRun(testDifferentSelectorsAreKept);
+	MVKTestRun(testCommandSettingAnyStateIsBarrier);
+	return mvkTestExitCode();
+}
@@ -0,0 +1,116 @@
+/*
+ * MVKCommandStreamingBenchmark.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the throughput of the two ways a command buffer records commands: acquiring each command
+// from its command type pool, linking it into the command buffer, and encoding and returning the
+// commands when the command buffer is submitted, as a reusable command buffer does; and constructing
+// each command temporarily and encoding it immediately, as a streaming one-time-submit command buffer does.
+//
+// Usage: MVKCommandStreamingBenchmark [commands per command buffer]
+
+#include "MVKTest.h"
+#include "MVKObjectPool.h"
+
+// A stand-in for the Metal command encoder, which consumes the content of each command.
+struct TestEncoder {
+	uint64_t encodedContent = 0;
+};
+
+// A stand-in for a MVKCommand, with content similar in size to that of a typical dynamic state command.
+class TestCommand : public MVKBaseObject, public MVKLinkableMixin<TestCommand> {
+public:
+	MVKVulkanAPIObject* getVulkanAPIObject() override { return nullptr; }
+
+	void setContent(uint32_t first, uint32_t count) {
+		for (uint32_t idx = 0; idx < 6; idx++) { _content[idx] = first + idx * count; }
+	}
+
+	void encode(TestEncoder* encoder) {
+		for (auto val : _content) { encoder->encodedContent += val; }
+	}
+
+protected:
+	uint32_t _content[6];
+};
+
+class TestCommandPool : public MVKObjectPool<TestCommand> {
+public:
+	MVKVulkanAPIObject* getVulkanAPIObject() override { return nullptr; }
+	TestCommandPool() : MVKObjectPool<TestCommand>(true) {}
+
+protected:
+	TestCommand* newObject() override { return new TestCommand(); }
+};
+
+// Records, encodes, and releases the commands, in the same way as a reusable command buffer.
+static uint64_t recordPooled(TestCommandPool& pool, uint64_t cmdCnt) {
+	TestCommand* head = nullptr;
+	TestCommand* tail = nullptr;
+	for (uint64_t idx = 0; idx < cmdCnt; idx++) {
+		TestCommand* cmd = pool.acquireObject();
+		cmd->setContent(uint32_t(idx), 1);
+		cmd->_next = nullptr;
+		if (tail) { tail->_next = cmd; } else { head = cmd; }
+		tail = cmd;
+	}
+
+	TestEncoder encoder;
+	for (TestCommand* cmd = head; cmd; cmd = cmd->_next) { cmd->encode(&encoder); }
+
+	while (head) {
+		TestCommand* next = head->_next;
+		pool.returnObject(head);
+		head = next;
+	}
+	return encoder.encodedContent;
+}
+
+// Records and encodes the commands, in the same way as a streaming command buffer.
+static uint64_t recordStreamed(uint64_t cmdCnt) {
+	TestEncoder encoder;
+	for (uint64_t idx = 0; idx < cmdCnt; idx++) {
+		TestCommand cmd;
+		cmd.setContent(uint32_t(idx), 1);
+		cmd.encode(&encoder);
+	}
+	return encoder.encodedContent;
+}
+
+int main(int argc, const char* argv[]) {
+	uint64_t cmdCnt = mvkTestIterationCount(argc, argv, 100000);
+	const uint32_t cmdBuffCnt = 20;
+
+	// Both ways of recording must encode the same content.
+	TestCommandPool pool;
+	MVKTestExpect(recordPooled(pool, 1000) == recordStreamed(1000));
+
+	volatile uint64_t sink = 0;
+	double pooledSecs = mvkTestTime([&]() {
+		for (uint32_t cbIdx = 0; cbIdx < cmdBuffCnt; cbIdx++) { sink = sink + recordPooled(pool, cmdCnt); }
+	});
+	double streamedSecs = mvkTestTime([&]() {
+		for (uint32_t cbIdx = 0; cbIdx < cmdBuffCnt; cbIdx++) { sink = sink + recordStreamed(cmdCnt); }
+	});
+
+	double totalCmdCnt = double(cmdBuffCnt) * cmdCnt;
+	printf("Command recording and encoding, %u command buffers of %llu commands, millions of commands per second:\n",
+		   cmdBuffCnt, (unsigned long long)cmdCnt);
+	printf("%12s %12s\n", "Pooled", "Streamed");
+	printf("%12.2f %12.2f\n", totalCmdCnt / pooledSecs / 1e6, totalCmdCnt / streamedSecs / 1e6);
+	return mvkTestExitCode();
+}
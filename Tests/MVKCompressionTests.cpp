@@ -0,0 +1,203 @@
+/*
+ * MVKCompressionTests.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKTest.h"
+#include "MVKCompression.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+
+// Boilerplate shared by the MSL that SPIRV-Cross generates for each shader,
+// standing in for the dictionary used to compress pipeline cache entries.
+static const char kTestDictionary[] =
+	"#pragma clang diagnostic ignored \"-Wmissing-prototypes\"\n"
+	"#include <metal_stdlib>\n#include <simd/simd.h>\n\nusing namespace metal;\n\n"
+	"template<typename T, size_t Num>\nstruct spvUnsafeArray\n{\n    T elements[Num ? Num : 1];\n    \n"
+	"    thread T& operator [] (size_t pos) thread\n    {\n        return elements[pos];\n    }\n};\n\n"
+	"struct main0_out\n{\n    float4 gl_Position [[position]];\n};\n\n"
+	"struct main0_in\n{\n    float4 in_var_POSITION [[attribute(0)]];\n};\n\n"
+	"vertex main0_out main0(main0_in in [[stage_in]], constant type_Globals& _Globals [[buffer(0)]])\n{\n"
+	"    main0_out out = {};\n    out.gl_Position = ";
+
+// Returns MSL source code resembling that generated by SPIRV-Cross for a vertex shader
+// with the specified number of inputs and uniform matrices.
+static std::string testShaderSource(uint32_t inputCount, uint32_t uniformCount) {
+	std::string msl = "#pragma clang diagnostic ignored \"-Wmissing-prototypes\"\n"
+					  "#include <metal_stdlib>\n#include <simd/simd.h>\n\nusing namespace metal;\n\n"
+					  "struct type_Globals\n{\n";
+	for (uint32_t uIdx = 0; uIdx < uniformCount; uIdx++) {
+		msl += "    float4x4 uMatrix" + std::to_string(uIdx) + ";\n";
+	}
+	msl += "};\n\nstruct main0_out\n{\n    float4 gl_Position [[position]];\n";
+	for (uint32_t iIdx = 0; iIdx < inputCount; iIdx++) {
+		msl += "    float4 out_var_TEXCOORD" + std::to_string(iIdx) + " [[user(locn" + std::to_string(iIdx) + ")]];\n";
+	}
+	msl += "};\n\nstruct main0_in\n{\n    float4 in_var_POSITION [[attribute(0)]];\n";
+	for (uint32_t iIdx = 0; iIdx < inputCount; iIdx++) {
+		msl += "    float4 in_var_TEXCOORD" + std::to_string(iIdx) + " [[attribute(" + std::to_string(iIdx + 1) + ")]];\n";
+	}
+	msl += "};\n\nvertex main0_out main0(main0_in in [[stage_in]], constant type_Globals& _Globals [[buffer(0)]])\n{\n"
+		   "    main0_out out = {};\n    float4 _pos = in.in_var_POSITION;\n";
+	for (uint32_t uIdx = 0; uIdx < uniformCount; uIdx++) {
+		msl += "    _pos = _Globals.uMatrix" + std::to_string(uIdx) + " * _pos;\n";
+	}
+	for (uint32_t iIdx = 0; iIdx < inputCount; iIdx++) {
+		msl += "    out.out_var_TEXCOORD" + std::to_string(iIdx) + " = in.in_var_TEXCOORD" + std::to_string(iIdx) + ";\n";
+	}
+	msl += "    out.gl_Position = _pos;\n    return out;\n}\n\n";
+	return msl;
+}
+
+// Returns whether the content compresses, and decompresses back to the original content.
+static bool roundTrips(const std::string& content, const char* pDict = nullptr, size_t dictSize = 0) {
+	std::string compressed = mvkCompressLZ(content.data(), content.size(), pDict, dictSize);
+	if (compressed.empty() || compressed.size() >= content.size()) { return false; }
+
+	std::string decompressed(content.size(), '\0');
+	return (mvkDecompressLZ(compressed.data(), compressed.size(), &decompressed[0], decompressed.size(), pDict, dictSize) &&
+			decompressed == content);
+}
+
+// Content with repetition round-trips, including literal and match lengths that need extra length bytes,
+// and matches that overlap the output being written. Content too small, or too random, to be compressed
+// to a smaller size is not compressed.
+static void testRoundTrip() {
+	MVKTestExpect(roundTrips(testShaderSource(4, 2)));
+	MVKTestExpect(roundTrips(std::string(100000, 'a')));
+	MVKTestExpect(roundTrips(std::string(3, 'a') + std::string(1000, 'b')));
+
+	std::mt19937 rng(17);
+	std::string literals;
+	for (uint32_t idx = 0; idx < 1000; idx++) { literals.push_back((char)rng()); }
+	MVKTestExpect(roundTrips(literals + literals + literals));
+	MVKTestExpect(mvkCompressLZ(literals.data(), literals.size()).empty());
+
+	MVKTestExpect(mvkCompressLZ("", 0).empty());
+	MVKTestExpect(mvkCompressLZ("aaaaaaaaa", 9).empty());
+	MVKTestExpect(roundTrips(std::string(20, 'a')));
+}
+
+// Content that shares text with the dictionary compresses further using it, and only decompresses using
+// the same dictionary. Only the end of dictionary content larger than the compression window is used.
+static void testDictionaryReuse() {
+	std::string msl = testShaderSource(1, 1);
+	size_t dictSize = sizeof(kTestDictionary) - 1;
+	std::string compressed = mvkCompressLZ(msl.data(), msl.size());
+	std::string dictCompressed = mvkCompressLZ(msl.data(), msl.size(), kTestDictionary, dictSize);
+	MVKTestExpect( !compressed.empty() && !dictCompressed.empty() && dictCompressed.size() < compressed.size());
+	MVKTestExpect(roundTrips(msl, kTestDictionary, dictSize));
+
+	std::string decompressed(msl.size(), '\0');
+	MVKTestExpect( !mvkDecompressLZ(dictCompressed.data(), dictCompressed.size(), &decompressed[0], decompressed.size()));
+
+	std::string otherDict(kTestDictionary, dictSize);
+	std::reverse(otherDict.begin(), otherDict.end());
+	MVKTestExpect( !(mvkDecompressLZ(dictCompressed.data(), dictCompressed.size(), &decompressed[0], decompressed.size(),
+									 otherDict.data(), otherDict.size()) && decompressed == msl));
+
+	// The same dictionary is reused across many entries.
+	for (uint32_t iIdx = 0; iIdx < 8; iIdx++) {
+		MVKTestExpect(roundTrips(testShaderSource(iIdx, 8 - iIdx), kTestDictionary, dictSize));
+	}
+
+	std::string largeDict = std::string(100000, 'x') + kTestDictionary;
+	MVKTestExpect(roundTrips(msl, largeDict.data(), largeDict.size()));
+	MVKTestExpect(mvkCompressLZ(msl.data(), msl.size(), largeDict.data(), largeDict.size()) == dictCompressed);
+}
+
+// Decompression rejects every truncation of compressed content, and a destination of the wrong size.
+static void testTruncatedInput() {
+	std::string msl = testShaderSource(3, 3);
+	std::string compressed = mvkCompressLZ(msl.data(), msl.size());
+	std::string decompressed(msl.size() + 1, '\0');
+	for (size_t size = 0; size < compressed.size(); size++) {
+		MVKTestExpect( !mvkDecompressLZ(compressed.data(), size, &decompressed[0], msl.size()));
+	}
+	MVKTestExpect(mvkDecompressLZ(compressed.data(), compressed.size(), &decompressed[0], msl.size()));
+	MVKTestExpect( !mvkDecompressLZ(compressed.data(), compressed.size(), &decompressed[0], msl.size() - 1));
+	MVKTestExpect( !mvkDecompressLZ(compressed.data(), compressed.size(), &decompressed[0], msl.size() + 1));
+}
+
+// Decompression rejects malformed sequences, and never writes beyond the destination, or reads beyond
+// the source or dictionary, when any byte of compressed content is corrupted.
+static void testCorruptInput() {
+	uint8_t dest[64] = {};
+	const uint8_t zeroOffset[] = { 0x10, 'a', 0x00, 0x00, 0x00 };
+	const uint8_t offsetBeyondOutput[] = { 0x10, 'a', 0x02, 0x00, 0x00 };
+	const uint8_t endlessLength[] = { 0xF0, 0xFF, 0xFF, 0xFF };
+	const uint8_t hugeLength[] = { 0xF0, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 'a' };
+	MVKTestExpect( !mvkDecompressLZ(zeroOffset, sizeof(zeroOffset), dest, 5));
+	MVKTestExpect( !mvkDecompressLZ(offsetBeyondOutput, sizeof(offsetBeyondOutput), dest, 5));
+	MVKTestExpect( !mvkDecompressLZ(offsetBeyondOutput, sizeof(offsetBeyondOutput), dest, 5, "b", 0));
+	MVKTestExpect( !mvkDecompressLZ(endlessLength, sizeof(endlessLength), dest, sizeof(dest)));
+	MVKTestExpect( !mvkDecompressLZ(hugeLength, sizeof(hugeLength), dest, sizeof(dest)));
+
+	// A match beginning in the dictionary is accepted only within the dictionary content.
+	const uint8_t dictMatch[] = { 0x10, 'a', 0x02, 0x00, 0x00 };
+	MVKTestExpect(mvkDecompressLZ(dictMatch, sizeof(dictMatch), dest, 5, "b", 1) && memcmp(dest, "aba", 3) == 0);
+
+	std::string msl = testShaderSource(2, 2);
+	size_t dictSize = sizeof(kTestDictionary) - 1;
+	std::string compressed = mvkCompressLZ(msl.data(), msl.size(), kTestDictionary, dictSize);
+	const size_t guardSize = 256;
+	std::mt19937 rng(5);
+	for (uint32_t trial = 0; trial < 2000; trial++) {
+		std::string corrupt = compressed;
+		uint32_t flipCnt = 1 + (rng() % 4);
+		for (uint32_t flip = 0; flip < flipCnt; flip++) { corrupt[rng() % corrupt.size()] ^= (char)(1 + rng() % 255); }
+
+		// Copy the source to its own allocation, so that reads beyond it can be caught by memory checkers.
+		std::unique_ptr<char[]> src(new char[corrupt.size()]);
+		memcpy(src.get(), corrupt.data(), corrupt.size());
+		std::vector<uint8_t> out(msl.size() + guardSize, 0xA5);
+		mvkDecompressLZ(src.get(), corrupt.size(), out.data(), msl.size(), kTestDictionary, dictSize);
+		bool isGuardIntact = true;
+		for (size_t idx = msl.size(); idx < out.size(); idx++) { isGuardIntact = isGuardIntact && out[idx] == 0xA5; }
+		MVKTestExpect(isGuardIntact);
+	}
+}
+
+// Measures the ratio of the size of shader source code to its compressed size, using the dictionary,
+// for shaders of sizes typical of pipeline cache entries, and for the shaders concatenated together.
+static void testSizeRatio() {
+	size_t dictSize = sizeof(kTestDictionary) - 1;
+	size_t rawSize = 0;
+	size_t compressedSize = 0;
+	std::string allMSL;
+	for (uint32_t iIdx = 0; iIdx < 16; iIdx++) {
+		std::string msl = testShaderSource(iIdx, 16 - iIdx);
+		rawSize += msl.size();
+		compressedSize += mvkCompressLZ(msl.data(), msl.size(), kTestDictionary, dictSize).size();
+		allMSL += msl;
+	}
+	double entryRatio = double(rawSize) / compressedSize;
+	double allRatio = double(allMSL.size()) / mvkCompressLZ(allMSL.data(), allMSL.size(), kTestDictionary, dictSize).size();
+	printf("Compression ratio: %.1fx per shader, %.1fx for all %zu bytes of shaders\n", entryRatio, allRatio, allMSL.size());
+	MVKTestExpect(entryRatio >= 3.0);
+	MVKTestExpect(allRatio >= 5.0);
+}
+
+int main(int argc, const char* argv[]) {
+	MVKTestRun(testRoundTrip);
+	MVKTestRun(testDictionaryReuse);
+	MVKTestRun(testTruncatedInput);
+	MVKTestRun(testCorruptInput);
+	MVKTestRun(testSizeRatio);
+	return mvkTestExitCode();
+}
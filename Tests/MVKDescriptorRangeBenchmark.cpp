@@ -0,0 +1,144 @@
+/*
+ * MVKDescriptorRangeBenchmark.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the throughput of allocating, updating and binding the descriptors of one descriptor set
+// binding, when each element is a separately reserved descriptor referenced through a pointer, as
+// MVKDescriptorSet once held them, and when the binding is one contiguous range of descriptors, as
+// MVKDescriptorSet now holds them. Both reserve their descriptors from a pool tracked by MVKBitArray,
+// as MVKDescriptorTypePool does. The descriptors stand in for MVKDescriptor subclasses, which depend
+// on Metal, so the updates and binds record only what the real descriptors would encode. As in
+// MVKDescriptorSet, each element is updated and bound through a virtual call in both cases.
+//
+// Usage: MVKDescriptorRangeBenchmark [iterations]
+
+#include "MVKTest.h"
+#include "MVKBitArray.h"
+
+enum TestDescriptorType { TestSampledImage, TestSampler };
+
+// Stands in for MVKDescriptor, with the virtual type, write and bind used by descriptor sets.
+class TestDescriptor {
+public:
+	virtual TestDescriptorType getDescriptorType() = 0;
+	virtual void write(const void* pResource) = 0;
+	virtual void bind(uintptr_t& boundCount) = 0;
+	virtual ~TestDescriptor() {}
+};
+
+// Stands in for MVKSampledImageDescriptor.
+class TestImageDescriptor : public TestDescriptor {
+public:
+	TestDescriptorType getDescriptorType() override { return TestSampledImage; }
+	void write(const void* pResource) override { _pImage = pResource; }
+	void bind(uintptr_t& boundCount) override { if (_pImage) { boundCount++; } }
+	const void* _pImage = nullptr;
+};
+
+// Stands in for MVKDescriptorRange.
+struct TestDescriptorRange {
+	TestDescriptor* pFirstDescriptor = nullptr;
+	uint32_t descriptorStride = 0;
+
+	TestDescriptor* getDescriptor(uint32_t elementIndex) {
+		return (TestDescriptor*)((uint8_t*)pFirstDescriptor + (size_t)descriptorStride * elementIndex);
+	}
+};
+
+// Stands in for MVKDescriptorTypePool, which preallocates descriptors and tracks those available.
+struct TestDescriptorPool {
+	std::vector<TestImageDescriptor> descriptors;
+	MVKBitArray availability;
+
+	TestDescriptorPool(size_t size) : descriptors(size), availability(size, true) {}
+};
+
+// Each element is reserved from the pool separately, and updated and bound through its pointer,
+// checking the type of each element.
+static void runPerElement(TestDescriptorPool& pool, uint32_t descCnt, uint64_t iterCnt,
+						  double& allocTime, double& updateTime, double& bindTime) {
+	std::vector<TestDescriptor*> descs(descCnt);
+	uintptr_t boundCnt = 0;
+	for (uint64_t iter = 0; iter < iterCnt; iter++) {
+		allocTime += mvkTestTime([&]() {
+			for (auto& pDesc : descs) { pDesc = &pool.descriptors[pool.availability.getIndexOfFirstSetBit(true)]; }
+		});
+		updateTime += mvkTestTime([&]() {
+			for (uint32_t elemIdx = 0; elemIdx < descCnt; elemIdx++) {
+				if (descs[elemIdx]->getDescriptorType() == TestSampledImage) { descs[elemIdx]->write(&descs[elemIdx]); }
+			}
+		});
+		bindTime += mvkTestTime([&]() {
+			for (auto* pDesc : descs) {
+				if (pDesc->getDescriptorType() == TestSampledImage) { pDesc->bind(boundCnt); }
+			}
+		});
+		for (auto* pDesc : descs) { pool.availability.setBit((TestImageDescriptor*)pDesc - pool.descriptors.data()); }
+	}
+	MVKTestExpect(boundCnt == iterCnt * descCnt);
+}
+
+// The binding is reserved from the pool as a single run, and updated and bound by its offset
+// within the run, checking the type of the binding once.
+static void runRange(TestDescriptorPool& pool, uint32_t descCnt, uint64_t iterCnt,
+					 double& allocTime, double& updateTime, double& bindTime) {
+	TestDescriptorRange descRange;
+	descRange.descriptorStride = sizeof(TestImageDescriptor);
+	uintptr_t boundCnt = 0;
+	for (uint64_t iter = 0; iter < iterCnt; iter++) {
+		allocTime += mvkTestTime([&]() {
+			descRange.pFirstDescriptor = &pool.descriptors[pool.availability.getIndexOfFirstSetBitRun(descCnt, true)];
+		});
+		updateTime += mvkTestTime([&]() {
+			if (descRange.getDescriptor(0)->getDescriptorType() == TestSampledImage) {
+				for (uint32_t elemIdx = 0; elemIdx < descCnt; elemIdx++) {
+					descRange.getDescriptor(elemIdx)->write(descRange.getDescriptor(elemIdx));
+				}
+			}
+		});
+		bindTime += mvkTestTime([&]() {
+			for (uint32_t elemIdx = 0; elemIdx < descCnt; elemIdx++) { descRange.getDescriptor(elemIdx)->bind(boundCnt); }
+		});
+		pool.availability.setBits((TestImageDescriptor*)descRange.pFirstDescriptor - pool.descriptors.data(), descCnt);
+	}
+	MVKTestExpect(boundCnt == iterCnt * descCnt);
+}
+
+int main(int argc, const char* argv[]) {
+	uint64_t iterCnt = mvkTestIterationCount(argc, argv, 20);
+
+	printf("Descriptor set binding, %llu iterations, millions of descriptors per second:\n", (unsigned long long)iterCnt);
+	printf("%8s %12s %12s %12s %12s %12s %12s\n", "Elements",
+		   "Alloc elem", "Alloc range", "Update elem", "Update range", "Bind elem", "Bind range");
+	for (uint32_t descCnt : { 16, 1024, 16384 }) {
+		TestDescriptorPool pool(descCnt * 2);
+		pool.availability.clearBits(0, descCnt / 2);	// Start each binding part-way into the pool.
+
+		double elemTimes[3] = {};
+		double rangeTimes[3] = {};
+		runPerElement(pool, descCnt, iterCnt, elemTimes[0], elemTimes[1], elemTimes[2]);
+		runRange(pool, descCnt, iterCnt, rangeTimes[0], rangeTimes[1], rangeTimes[2]);
+
+		double descCntTotal = double(descCnt) * iterCnt;
+		printf("%8u", descCnt);
+		for (uint32_t timeIdx = 0; timeIdx < 3; timeIdx++) {
+			printf(" %12.2f %12.2f", descCntTotal / elemTimes[timeIdx] / 1e6, descCntTotal / rangeTimes[timeIdx] / 1e6);
+		}
+		printf("\n");
+	}
+	return mvkTestExitCode();
+}
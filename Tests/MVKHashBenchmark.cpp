@@ -0,0 +1,76 @@
+/*
+ * MVKHashBenchmark.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the throughput of mvkHash128() against the per-element hash of mvkHash(),
+// over content of the sizes typical of SPIR-V shader modules, and checks that
+// mvkHash128() distinguishes content that differs only in its length or final bytes.
+//
+// Usage: MVKHashBenchmark [bytes hashed per size]
+
+#include "MVKTest.h"
+#include "MVKHash.h"
+#include <algorithm>
+
+// The same calculation as mvkHash() in MVKFoundation.h, which cannot be included here
+// because it depends on the Apple SIMD headers. SPIR-V is hashed as 32-bit words.
+static std::size_t testHashPerElement(const uint32_t* pVals, std::size_t count, std::size_t seed = 5381) {
+	std::size_t hash = seed;
+	for (std::size_t i = 0; i < count; i++) { hash = ((hash << 5) + hash) ^ pVals[i]; }
+	return hash;
+}
+
+static void checkHashDistinguishesContent() {
+	std::vector<uint8_t> data(100, 0);
+	MVKHash128 hash = mvkHash128(data.data(), data.size());
+	MVKTestExpect(hash == mvkHash128(data.data(), data.size()));
+	MVKTestExpect(hash != mvkHash128(data.data(), data.size() - 1));
+	MVKTestExpect(hash != mvkHash128(data.data(), data.size(), 1));
+	data.back() = 1;
+	MVKTestExpect(hash != mvkHash128(data.data(), data.size()));
+}
+
+// Returns the throughput, in MB/s, of hashing the content repeatedly until byteCnt bytes have been hashed.
+template<typename F>
+static double measure(std::vector<uint32_t>& content, uint64_t byteCnt, F hashFunc) {
+	uint64_t reps = std::max<uint64_t>(byteCnt / (content.size() * sizeof(uint32_t)), 1);
+	volatile uint64_t sink = 0;
+	double secs = mvkTestTime([&]() {
+		for (uint64_t rep = 0; rep < reps; rep++) {
+			content[0] = uint32_t(rep);		// Prevent the compiler from hoisting the hash out of the loop.
+			sink = sink + hashFunc(content);
+		}
+	});
+	return double(reps) * content.size() * sizeof(uint32_t) / secs / 1e6;
+}
+
+int main(int argc, const char* argv[]) {
+	uint64_t byteCnt = mvkTestIterationCount(argc, argv, 64 * 1024 * 1024);
+
+	checkHashDistinguishesContent();
+
+	printf("Hash throughput, %llu bytes per size, MB per second:\n", (unsigned long long)byteCnt);
+	printf("%10s %14s %14s\n", "Bytes", "mvkHash", "mvkHash128");
+	for (uint32_t size : { 256, 4 * 1024, 64 * 1024, 1024 * 1024 }) {
+		std::vector<uint32_t> content(size / sizeof(uint32_t));
+		for (size_t idx = 0; idx < content.size(); idx++) { content[idx] = uint32_t(idx * 2654435761u); }
+		printf("%10u %14.0f %14.0f\n", size,
+			   measure(content, byteCnt, [](std::vector<uint32_t>& c) { return (uint64_t)testHashPerElement(c.data(), c.size()); }),
+			   measure(content, byteCnt, [](std::vector<uint32_t>& c) { return mvkHash128(c.data(), c.size() * sizeof(uint32_t)).lo; }));
+	}
+	return mvkTestExitCode();
+}
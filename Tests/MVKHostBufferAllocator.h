@@ -0,0 +1,157 @@
+/*
+ * MVKHostBufferAllocator.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "MVKLockFreeStack.h"
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+// A stand-in for MVKMTLBufferAllocator, which dispenses power-of-two regions of host memory
+// blocks, instead of MTLBuffers, so that the lock-free acquisition of buffer regions can be
+// exercised on any platform. As with a lock-free MVKMTLBufferAllocationPool, each size class
+// acquires and returns regions through a MVKMagazineCache, and a lock is only taken when a
+// new region must be carved from a block, which may add a new block.
+
+
+#pragma mark -
+#pragma mark MVKHostBufferAllocation
+
+class MVKHostBufferAllocationPool;
+
+/** Defines a contiguous region of bytes within a host memory block. */
+class MVKHostBufferAllocation {
+
+public:
+	MVKHostBufferAllocation* _next = nullptr;
+	MVKHostBufferAllocationPool* _pool;
+	char* _contents;
+	size_t _length;
+
+	/** Identifies the thread holding this allocation, or zero if it is not held. Used to detect sharing. */
+	std::atomic<uint32_t> _holder = { 0 };
+
+	void returnToPool();
+
+	MVKHostBufferAllocation(MVKHostBufferAllocationPool* pool, char* contents, size_t length) :
+		_pool(pool), _contents(contents), _length(length) {}
+};
+
+
+#pragma mark -
+#pragma mark MVKHostBufferAllocationPool
+
+/** A lock-free pool of MVKHostBufferAllocation instances of a single size. */
+class MVKHostBufferAllocationPool {
+
+public:
+
+	/** Returns an allocation cached by this thread, or freed by any thread, or creates a new allocation. */
+	MVKHostBufferAllocation* acquireAllocation() {
+		MVKHostBufferAllocation* ba = _threadCache.acquire();
+		if (ba) { return ba; }
+
+		std::lock_guard<std::mutex> lock(_lock);
+		if (_nextOffset >= _blockLength) {
+			_blocks.push_back((char*)malloc(_blockLength));
+			_nextOffset = 0;
+		}
+		ba = new MVKHostBufferAllocation(this, _blocks.back() + _nextOffset, _allocationLength);
+		_nextOffset += _allocationLength;
+		_allocationCount++;
+		return ba;
+	}
+
+	void returnAllocation(MVKHostBufferAllocation* ba) { _threadCache.release(ba); }
+
+	/** Returns the number of allocations created by this pool. */
+	size_t getAllocationCount() {
+		std::lock_guard<std::mutex> lock(_lock);
+		return _allocationCount;
+	}
+
+	/**
+	 * Destroys the allocations available in this pool, and returns how many were destroyed.
+	 * Must not be called while allocations are being acquired or returned.
+	 */
+	size_t destroyAvailableAllocations() {
+		size_t count = 0;
+		MVKHostBufferAllocation* ba = _threadCache.removeAll();
+		while (ba) {
+			MVKHostBufferAllocation* nextBA = ba->_next;
+			delete ba;
+			ba = nextBA;
+			count++;
+		}
+		return count;
+	}
+
+	MVKHostBufferAllocationPool(size_t allocationLength) :
+		_allocationLength(allocationLength),
+		_blockLength(allocationLength * (allocationLength <= 256 ? 256 : 16)),
+		_nextOffset(_blockLength) {}
+
+	~MVKHostBufferAllocationPool() {
+		destroyAvailableAllocations();
+		for (char* block : _blocks) { free(block); }
+	}
+
+protected:
+	MVKMagazineCache<MVKHostBufferAllocation> _threadCache;
+	std::mutex _lock;
+	std::vector<char*> _blocks;
+	size_t _allocationLength;
+	size_t _blockLength;
+	size_t _nextOffset;
+	size_t _allocationCount = 0;
+};
+
+inline void MVKHostBufferAllocation::returnToPool() { _pool->returnAllocation(this); }
+
+
+#pragma mark -
+#pragma mark MVKHostBufferAllocator
+
+/** A stand-in for MVKMTLBufferAllocator, which dispenses regions with a power-of-two size. */
+class MVKHostBufferAllocator {
+
+public:
+
+	/** Returns a region at least as large as the length, with a size that is a power of two. */
+	MVKHostBufferAllocation* acquireRegion(size_t length) {
+		size_t p2Exp = 0;
+		while ((size_t(1) << p2Exp) < length) { p2Exp++; }
+		return _regionPools[p2Exp]->acquireAllocation();
+	}
+
+	/** Returns the pools of each size class. */
+	const std::vector<MVKHostBufferAllocationPool*>& getRegionPools() { return _regionPools; }
+
+	MVKHostBufferAllocator(size_t maxRegionLength) {
+		for (size_t allocLen = 1; allocLen < maxRegionLength * 2; allocLen <<= 1) {
+			_regionPools.push_back(new MVKHostBufferAllocationPool(allocLen));
+		}
+	}
+
+	~MVKHostBufferAllocator() { for (auto* pool : _regionPools) { delete pool; } }
+
+protected:
+	std::vector<MVKHostBufferAllocationPool*> _regionPools;
+};
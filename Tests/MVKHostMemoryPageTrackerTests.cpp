@@ -0,0 +1,174 @@
+/*
+ * MVKHostMemoryPageTrackerTests.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKTest.h"
+#include "MVKHostMemoryPageTracker.h"
+#include <random>
+#include <utility>
+
+typedef std::vector<std::pair<VkDeviceSize, VkDeviceSize>> TestRanges;
+
+static const VkDeviceSize kPageSize = MVKHostMemoryPageTracker::kPageSize;
+
+static TestRanges changedRanges(MVKHostMemoryPageTracker& tracker, const std::vector<uint8_t>& mem,
+								VkDeviceSize offset, VkDeviceSize size) {
+	TestRanges ranges;
+	tracker.forEachChangedRange(mem.data(), offset, size, [&](VkDeviceSize rngOffset, VkDeviceSize rngSize) {
+		ranges.emplace_back(rngOffset, rngSize);
+	});
+	return ranges;
+}
+
+// Before anything is synchronized, every page within the range has changed, and is reported as
+// a single range. Once synchronized, unchanged content is not reported again.
+static void testInitialAndUnchangedContent() {
+	std::vector<uint8_t> mem(kPageSize * 4, 7);
+	MVKHostMemoryPageTracker tracker(mem.size());
+	MVKTestExpect((changedRanges(tracker, mem, 0, mem.size()) == TestRanges{{0, kPageSize * 4}}));
+	MVKTestExpect(changedRanges(tracker, mem, 0, mem.size()).empty());
+	MVKTestExpect(changedRanges(tracker, mem, 0, VK_WHOLE_SIZE).empty());
+}
+
+// Only the runs of pages containing written content are reported, clipped to the range.
+static void testChangedPagesAreReported() {
+	std::vector<uint8_t> mem(kPageSize * 8, 0);
+	MVKHostMemoryPageTracker tracker(mem.size());
+	changedRanges(tracker, mem, 0, mem.size());
+
+	mem[kPageSize * 2 + 10] = 1;
+	mem[kPageSize * 3 + 20] = 1;
+	mem[kPageSize * 6] = 1;
+	MVKTestExpect((changedRanges(tracker, mem, 0, mem.size()) == TestRanges{{kPageSize * 2, kPageSize * 2}, {kPageSize * 6, kPageSize}}));
+	MVKTestExpect(changedRanges(tracker, mem, 0, mem.size()).empty());
+
+	// A write outside the range is neither reported nor forgotten.
+	mem[kPageSize * 5] = 2;
+	MVKTestExpect(changedRanges(tracker, mem, 0, kPageSize * 5).empty());
+	MVKTestExpect((changedRanges(tracker, mem, 0, mem.size()) == TestRanges{{kPageSize * 5, kPageSize}}));
+}
+
+// A page only partly within the range is always reported, clipped to the range, and is
+// considered changed until it is next synchronized entirely.
+static void testPartialPages() {
+	std::vector<uint8_t> mem(kPageSize * 4, 0);
+	MVKHostMemoryPageTracker tracker(mem.size());
+	changedRanges(tracker, mem, 0, mem.size());
+
+	MVKTestExpect((changedRanges(tracker, mem, 100, kPageSize * 2) == TestRanges{{100, kPageSize - 100}, {kPageSize * 2, 100}}));
+	MVKTestExpect((changedRanges(tracker, mem, 100, kPageSize * 2) == TestRanges{{100, kPageSize - 100}, {kPageSize * 2, 100}}));
+	MVKTestExpect((changedRanges(tracker, mem, kPageSize + 1, 10) == TestRanges{{kPageSize + 1, 10}}));
+
+	// The partial pages, and the middle page that was last partly synchronized, are reported once more.
+	MVKTestExpect((changedRanges(tracker, mem, 0, mem.size()) == TestRanges{{0, kPageSize * 3}}));
+	MVKTestExpect(changedRanges(tracker, mem, 0, mem.size()).empty());
+}
+
+// Content marked as synchronized, such as content pulled from the GPU, is not reported as changed.
+static void testMarkSynchronized() {
+	std::vector<uint8_t> mem(kPageSize * 4, 0);
+	MVKHostMemoryPageTracker tracker(mem.size());
+	changedRanges(tracker, mem, 0, mem.size());
+
+	std::fill(mem.begin(), mem.end(), 3);
+	tracker.markSynchronized(mem.data(), 0, kPageSize * 2 + 1);
+	MVKTestExpect((changedRanges(tracker, mem, 0, mem.size()) == TestRanges{{kPageSize * 2, kPageSize * 2}}));
+}
+
+// Pages marked as changed, such as those of an image the GPU may have written to, are reported
+// once more even though their host content is unchanged, including any page only partly marked.
+static void testMarkChanged() {
+	std::vector<uint8_t> mem(kPageSize * 4, 0);
+	MVKHostMemoryPageTracker tracker(mem.size());
+	changedRanges(tracker, mem, 0, mem.size());
+
+	tracker.markChanged(kPageSize + 10, kPageSize);
+	MVKTestExpect((changedRanges(tracker, mem, 0, mem.size()) == TestRanges{{kPageSize, kPageSize * 2}}));
+	MVKTestExpect(changedRanges(tracker, mem, 0, mem.size()).empty());
+
+	tracker.markChanged(kPageSize * 3, VK_WHOLE_SIZE);
+	tracker.markChanged(mem.size(), 10);
+	MVKTestExpect((changedRanges(tracker, mem, 0, mem.size()) == TestRanges{{kPageSize * 3, kPageSize}}));
+}
+
+// The last page of memory whose size is not a multiple of the page size is tracked like any other.
+static void testLastPartialPageOfMemory() {
+	std::vector<uint8_t> mem(kPageSize * 2 + 500, 0);
+	MVKHostMemoryPageTracker tracker(mem.size());
+	MVKTestExpect((changedRanges(tracker, mem, 0, VK_WHOLE_SIZE) == TestRanges{{0, mem.size()}}));
+	MVKTestExpect(changedRanges(tracker, mem, kPageSize * 2, VK_WHOLE_SIZE).empty());
+
+	mem.back() = 1;
+	MVKTestExpect((changedRanges(tracker, mem, kPageSize, VK_WHOLE_SIZE) == TestRanges{{kPageSize * 2, 500}}));
+	MVKTestExpect(changedRanges(tracker, mem, mem.size(), 10).empty());
+}
+
+// The reported ranges match those of a model that keeps a copy of each synchronized page.
+static void testMatchesModel() {
+	const uint32_t pageCnt = 16;
+	const VkDeviceSize memSize = kPageSize * pageCnt - 300;
+	std::vector<uint8_t> mem(memSize, 0);
+	MVKHostMemoryPageTracker tracker(memSize);
+
+	std::vector<std::vector<uint8_t>> syncedPages(pageCnt);		// Empty if not synchronized
+	std::mt19937 rng(1234);
+	for (uint32_t iter = 0; iter < 2000; iter++) {
+		uint32_t writeCnt = rng() % 4;
+		for (uint32_t wIdx = 0; wIdx < writeCnt; wIdx++) { mem[rng() % memSize] = uint8_t(rng()); }
+
+		VkDeviceSize offset = (rng() % 2) ? (rng() % pageCnt) * kPageSize : rng() % memSize;
+		VkDeviceSize size = (rng() % 4) ? rng() % (memSize - offset) + 1 : VK_WHOLE_SIZE;
+		VkDeviceSize endOffset = size == VK_WHOLE_SIZE ? memSize : offset + size;
+		bool isPull = (rng() % 4) == 0;
+
+		TestRanges expected;
+		for (uint32_t pIdx = uint32_t(offset / kPageSize); pIdx * kPageSize < endOffset; pIdx++) {
+			VkDeviceSize pgOffset = pIdx * kPageSize;
+			VkDeviceSize pgEndOffset = std::min(pgOffset + kPageSize, memSize);
+			std::vector<uint8_t> content(mem.begin() + pgOffset, mem.begin() + pgEndOffset);
+			bool isEntire = pgOffset >= offset && pgEndOffset <= endOffset;
+			bool isChanged = !isEntire || syncedPages[pIdx] != content;
+			syncedPages[pIdx] = isEntire ? content : std::vector<uint8_t>();
+			if ( !isChanged ) { continue; }
+
+			VkDeviceSize rngOffset = std::max(pgOffset, offset);
+			VkDeviceSize rngEndOffset = std::min(pgEndOffset, endOffset);
+			if ( !expected.empty() && expected.back().first + expected.back().second == rngOffset ) {
+				expected.back().second += rngEndOffset - rngOffset;
+			} else {
+				expected.emplace_back(rngOffset, rngEndOffset - rngOffset);
+			}
+		}
+
+		if (isPull) {
+			tracker.markSynchronized(mem.data(), offset, size);
+		} else {
+			MVKTestExpect(changedRanges(tracker, mem, offset, size) == expected);
+		}
+	}
+}
+
+int main(int argc, const char* argv[]) {
+	MVKTestRun(testInitialAndUnchangedContent);
+	MVKTestRun(testChangedPagesAreReported);
+	MVKTestRun(testPartialPages);
+	MVKTestRun(testMarkSynchronized);
+	MVKTestRun(testMarkChanged);
+	MVKTestRun(testLastPartialPageOfMemory);
+	MVKTestRun(testMatchesModel);
+	return mvkTestExitCode();
+}
@@ -0,0 +1,114 @@
+/*
+ * MVKIntervalIndexTests.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKTest.h"
+#include "MVKIntervalIndex.h"
+#include <algorithm>
+#include <random>
+
+typedef MVKIntervalIndex<uint32_t> TestIndex;
+
+static std::vector<uint32_t> overlapping(const TestIndex& index, uint64_t offset, uint64_t size) {
+	std::vector<uint32_t> values;
+	index.forEachOverlapping(offset, size, [&](uint32_t value) { values.push_back(value); });
+	std::sort(values.begin(), values.end());
+	return values;
+}
+
+// Only ranges that share at least one offset with the specified range overlap it.
+static void testOverlapBoundaries() {
+	TestIndex index;
+	index.add(1, 100, 50);
+	index.add(2, 150, 10);
+	index.add(3, 0, 1000);
+	MVKTestExpect((overlapping(index, 149, 1) == std::vector<uint32_t>{1, 3}));
+	MVKTestExpect((overlapping(index, 150, 1) == std::vector<uint32_t>{2, 3}));
+	MVKTestExpect((overlapping(index, 90, 10) == std::vector<uint32_t>{3}));
+	MVKTestExpect((overlapping(index, 90, 11) == std::vector<uint32_t>{1, 3}));
+	MVKTestExpect((overlapping(index, 1000, 10).empty()));
+	MVKTestExpect((overlapping(index, 120, 0).empty()));
+}
+
+// A range far larger than the ranges of a size class still finds them, including from an offset
+// beyond the start of the memory, and a size of the whole memory does not overflow.
+static void testLargeAndWholeRanges() {
+	TestIndex index;
+	index.add(1, 5000, 16);
+	index.add(2, 1 << 20, 1 << 20);
+	MVKTestExpect((overlapping(index, 0, 1 << 22) == std::vector<uint32_t>{1, 2}));
+	MVKTestExpect((overlapping(index, 5010, UINT64_MAX) == std::vector<uint32_t>{1, 2}));
+	MVKTestExpect((overlapping(index, (1 << 21) - 1, UINT64_MAX) == std::vector<uint32_t>{2}));
+}
+
+// Adding a value that is already in the index moves it, and removing a value forgets it.
+static void testAddMoveAndRemove() {
+	TestIndex index;
+	MVKTestExpect(index.empty() && !index.remove(1));
+	index.add(1, 0, 100);
+	index.add(1, 1000, 4000);
+	MVKTestExpect(index.size() == 1 && index.contains(1) && index.any() == 1);
+	MVKTestExpect(overlapping(index, 0, 100).empty());
+	MVKTestExpect((overlapping(index, 4999, 1) == std::vector<uint32_t>{1}));
+
+	index.add(2, 1000, 4000);
+	MVKTestExpect(index.remove(1) && !index.contains(1));
+	MVKTestExpect((overlapping(index, 1000, 1) == std::vector<uint32_t>{2}));
+	MVKTestExpect(index.remove(2) && index.empty());
+	MVKTestExpect(overlapping(index, 0, UINT64_MAX).empty());
+}
+
+// The overlapping values match those found by checking every range, across many size classes.
+static void testMatchesModel() {
+	struct Range { uint64_t offset; uint64_t size; bool isIn; };
+	const uint32_t valueCnt = 200;
+	const uint64_t memSize = 1 << 24;
+	std::vector<Range> model(valueCnt, Range{0, 0, false});
+	TestIndex index;
+	std::mt19937_64 rng(1234);
+	for (uint32_t iter = 0; iter < 5000; iter++) {
+		uint32_t value = uint32_t(rng() % valueCnt);
+		if (rng() % 4) {
+			uint64_t size = rng() % (uint64_t(1) << (rng() % 24));
+			uint64_t offset = rng() % (memSize - size);
+			index.add(value, offset, size);
+			model[value] = Range{offset, size, true};
+		} else {
+			MVKTestExpect(index.remove(value) == model[value].isIn);
+			model[value].isIn = false;
+		}
+
+		uint64_t size = rng() % (uint64_t(1) << (rng() % 24)) + 1;
+		uint64_t offset = rng() % memSize;
+		std::vector<uint32_t> expected;
+		for (uint32_t val = 0; val < valueCnt; val++) {
+			auto& rng = model[val];
+			if (rng.isIn && rng.offset < offset + size && rng.offset + rng.size > offset) { expected.push_back(val); }
+		}
+		MVKTestExpect(overlapping(index, offset, size) == expected);
+	}
+	size_t inCnt = std::count_if(model.begin(), model.end(), [](const Range& rng) { return rng.isIn; });
+	MVKTestExpect(index.size() == inCnt);
+}
+
+int main(int argc, const char* argv[]) {
+	MVKTestRun(testOverlapBoundaries);
+	MVKTestRun(testLargeAndWholeRanges);
+	MVKTestRun(testAddMoveAndRemove);
+	MVKTestRun(testMatchesModel);
+	return mvkTestExitCode();
+}
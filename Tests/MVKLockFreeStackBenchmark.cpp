@@ -0,0 +1,95 @@
+/*
+ * MVKLockFreeStackBenchmark.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the throughput of acquiring and returning buffer regions through the lock-free
+// MVKHostBufferAllocator, against the same size classes guarded by a mutex, as used by a
+// thread-safe MVKMTLBufferAllocator when lock-free buffer allocation is disabled.
+//
+// Usage: MVKLockFreeStackBenchmark [iterations per thread]
+
+#include "MVKTest.h"
+#include "MVKHostBufferAllocator.h"
+
+// A size class guarded by a mutex, holding available regions in a list.
+// The length of each region records its size class.
+class MutexRegionPool {
+public:
+	MVKHostBufferAllocation* acquire(uint32_t sizeClass) {
+		std::lock_guard<std::mutex> lock(_lock);
+		MVKHostBufferAllocation* ba = _head;
+		if (ba) {
+			_head = ba->_next;
+			return ba;
+		}
+		_allocations.push_back(new MVKHostBufferAllocation(nullptr, nullptr, sizeClass));
+		return _allocations.back();
+	}
+	void release(MVKHostBufferAllocation* ba) {
+		std::lock_guard<std::mutex> lock(_lock);
+		ba->_next = _head;
+		_head = ba;
+	}
+	~MutexRegionPool() { for (auto* ba : _allocations) { delete ba; } }
+
+protected:
+	std::mutex _lock;
+	MVKHostBufferAllocation* _head = nullptr;
+	std::vector<MVKHostBufferAllocation*> _allocations;
+};
+
+static const uint32_t kSizeClassCount = 8;
+
+// Each thread cycles through the size classes, holding a few regions at once.
+template <class AcquireFunc, class ReleaseFunc>
+static double runThreads(uint32_t threadCnt, uint64_t iterCnt, AcquireFunc acquire, ReleaseFunc release) {
+	return mvkTestTime([&]() {
+		mvkTestRunThreads(threadCnt, [&](uint32_t tIdx) {
+			MVKHostBufferAllocation* held[4] = {};
+			for (uint64_t i = 0; i < iterCnt; i++) {
+				uint32_t sizeClass = (i + tIdx) % kSizeClassCount;
+				auto& slot = held[i % 4];
+				if (slot) { release(slot); }
+				slot = acquire(sizeClass);
+			}
+			for (auto* ba : held) { if (ba) { release(ba); } }
+		});
+	});
+}
+
+int main(int argc, const char* argv[]) {
+	uint64_t iterCnt = mvkTestIterationCount(argc, argv, 200000);
+
+	printf("Acquire and return buffer regions, %llu per thread, millions of operations per second:\n", (unsigned long long)iterCnt);
+	printf("%8s %12s %12s\n", "Threads", "Mutex", "Lock-free");
+	for (uint32_t threadCnt : { 1, 2, 4, 8, 16 }) {
+		double opCnt = double(threadCnt) * iterCnt;
+
+		MutexRegionPool mutexPools[kSizeClassCount];
+		double mutexTime = runThreads(threadCnt, iterCnt,
+									  [&](uint32_t sc) { return mutexPools[sc].acquire(sc); },
+									  [&](MVKHostBufferAllocation* ba) { mutexPools[ba->_length].release(ba); });
+
+		MVKHostBufferAllocator allocator(size_t(1) << (kSizeClassCount - 1));
+		double lockFreeTime = runThreads(threadCnt, iterCnt,
+										 [&](uint32_t sc) { return allocator.acquireRegion(size_t(1) << sc); },
+										 [&](MVKHostBufferAllocation* ba) { ba->returnToPool(); });
+
+		printf("%8u %12.2f %12.2f\n", threadCnt, opCnt / mutexTime / 1e6, opCnt / lockFreeTime / 1e6);
+	}
+	return mvkTestExitCode();
+}
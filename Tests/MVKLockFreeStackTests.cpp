@@ -0,0 +1,151 @@
+/*
+ * MVKLockFreeStackTests.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKTest.h"
+#include "MVKHostBufferAllocator.h"
+#include "MVKLockFreeStack.h"
+#include <cstring>
+#include <random>
+
+struct Node {
+	Node* _next = nullptr;
+	uint32_t value = 0;
+};
+
+// Exposes the packed head of the stack.
+class TestStack : public MVKLockFreeStack<Node> {
+public:
+	uint64_t getHead() { return _head.load(); }
+};
+
+static void testStackOrder() {
+	Node nodes[4];
+	TestStack stack;
+	MVKTestExpect(stack.isEmpty());
+	MVKTestExpect(stack.pop() == nullptr);
+
+	for (auto& node : nodes) { stack.push(&node); }
+	MVKTestExpect( !stack.isEmpty() );
+	for (int i = 3; i >= 0; i--) { MVKTestExpect(stack.pop() == &nodes[i]); }
+	MVKTestExpect(stack.isEmpty());
+
+	// A pushed list keeps its order, with the first object on top.
+	nodes[0]._next = &nodes[1];
+	nodes[1]._next = &nodes[2];
+	stack.push(&nodes[3]);
+	stack.pushList(&nodes[0], &nodes[2]);
+	MVKTestExpect(stack.pop() == &nodes[0]);
+	MVKTestExpect(stack.pop()->_next == nullptr);	// Popped objects are unlinked
+	Node* list = stack.popAll();
+	MVKTestExpect(list == &nodes[2] && list->_next == &nodes[3] && !nodes[3]._next);
+	MVKTestExpect(stack.isEmpty());
+}
+
+// Popping and pushing the same object must produce a different head, so a stale compare-and-swap fails.
+static void testStackTag() {
+	Node node;
+	TestStack stack;
+	stack.push(&node);
+	uint64_t head = stack.getHead();
+	stack.pop();
+	stack.push(&node);
+	MVKTestExpect(stack.getHead() != head);
+	MVKTestExpect(stack.pop() == &node);
+
+	// The address survives many tag increments, including the tag wrapping around.
+	for (uint32_t i = 0; i < (1 << 20); i++) { stack.push(&node); stack.pop(); }
+	stack.push(&node);
+	MVKTestExpect(stack.pop() == &node);
+}
+
+static void testMagazineCache() {
+	const uint32_t objCnt = 100;
+	std::vector<Node> nodes(objCnt);
+	MVKMagazineCache<Node> cache;
+	MVKTestExpect(cache.acquire() == nullptr);
+
+	for (auto& node : nodes) { cache.release(&node); }
+
+	std::vector<bool> acquired(objCnt, false);
+	for (uint32_t i = 0; i < objCnt; i++) {
+		Node* node = cache.acquire();
+		MVKTestExpect(node);
+		if ( !node ) { return; }
+		size_t idx = node - nodes.data();
+		MVKTestExpect( !acquired[idx] );
+		acquired[idx] = true;
+	}
+	MVKTestExpect(cache.acquire() == nullptr);
+
+	for (auto& node : nodes) { cache.release(&node); }
+	uint32_t removedCnt = 0;
+	for (Node* node = cache.removeAll(); node; node = node->_next) { removedCnt++; }
+	MVKTestExpect(removedCnt == objCnt);
+	MVKTestExpect(cache.acquire() == nullptr);
+}
+
+// Many threads acquire regions of random sizes, hold a few at once, and fill and verify their
+// contents, while checking that no region is ever held by two threads at the same time.
+static void testConcurrentRegions() {
+	const uint32_t threadCnt = 16;
+	const uint32_t iterCnt = 20000;
+	const size_t maxLength = 4096;
+	MVKHostBufferAllocator allocator(maxLength);
+
+	mvkTestRunThreads(threadCnt, [&](uint32_t tIdx) {
+		std::minstd_rand rng(tIdx + 1);
+		std::vector<MVKHostBufferAllocation*> held;
+		uint8_t fill = uint8_t(tIdx + 1);
+		for (uint32_t i = 0; i < iterCnt; i++) {
+			size_t length = 1 + rng() % maxLength;
+			MVKHostBufferAllocation* ba = allocator.acquireRegion(length);
+			MVKTestExpect(ba->_length >= length);
+			uint32_t prevHolder = ba->_holder.exchange(tIdx + 1);
+			MVKTestExpect(prevHolder == 0);
+			memset(ba->_contents, fill, ba->_length);
+			held.push_back(ba);
+
+			if (held.size() > 4 || (rng() & 1)) {
+				size_t heldIdx = rng() % held.size();
+				MVKHostBufferAllocation* retBA = held[heldIdx];
+				held.erase(held.begin() + heldIdx);
+				MVKTestExpect(retBA->_contents[0] == (char)fill && retBA->_contents[retBA->_length - 1] == (char)fill);
+				MVKTestExpect(retBA->_holder.exchange(0) == tIdx + 1);
+				retBA->returnToPool();
+			}
+		}
+		for (auto* ba : held) {
+			MVKTestExpect(ba->_holder.exchange(0) == tIdx + 1);
+			ba->returnToPool();
+		}
+	});
+
+	// Every region created was returned, and can be found in the magazines or the depot.
+	for (auto* pool : allocator.getRegionPools()) {
+		size_t createdCnt = pool->getAllocationCount();
+		MVKTestExpect(pool->destroyAvailableAllocations() == createdCnt);
+	}
+}
+
+int main(int argc, const char* argv[]) {
+	MVKTestRun(testStackOrder);
+	MVKTestRun(testStackTag);
+	MVKTestRun(testMagazineCache);
+	MVKTestRun(testConcurrentRegions);
+	return mvkTestExitCode();
+}
@@ -0,0 +1,83 @@
+/*
+ * MVKObjectPoolBenchmark.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the throughput of the thread-safe functions of a lock-free MVKObjectPool against
+// those of a mutex-guarded MVKObjectPool, when each thread returns the objects it acquired,
+// and when objects are returned by a different thread than the one that acquired them.
+//
+// Usage: MVKObjectPoolBenchmark [iterations per thread]
+
+#include "MVKTest.h"
+#include "MVKObjectPool.h"
+
+class TestObject : public MVKBaseObject, public MVKLinkableMixin<TestObject> {
+public:
+	MVKVulkanAPIObject* getVulkanAPIObject() override { return nullptr; }
+};
+
+class TestObjectPool : public MVKObjectPool<TestObject> {
+public:
+	MVKVulkanAPIObject* getVulkanAPIObject() override { return nullptr; }
+	TestObjectPool(bool isLockFree) : MVKObjectPool<TestObject>(true, isLockFree) {}
+
+protected:
+	TestObject* newObject() override { return new TestObject(); }
+};
+
+// Each thread holds a few objects at once. If crossThreads is true, each thread returns
+// objects acquired by the previous thread, through a ring of per-thread exchange slots.
+static double runThreads(bool isLockFree, uint32_t threadCnt, uint64_t iterCnt, bool crossThreads) {
+	TestObjectPool pool(isLockFree);
+	std::vector<std::atomic<TestObject*>> exchange(threadCnt);
+	for (auto& slot : exchange) { slot.store(nullptr); }
+
+	return mvkTestTime([&]() {
+		mvkTestRunThreads(threadCnt, [&](uint32_t tIdx) {
+			TestObject* held[4] = {};
+			auto& inSlot = exchange[tIdx];
+			auto& outSlot = exchange[(tIdx + 1) % threadCnt];
+			for (uint64_t i = 0; i < iterCnt; i++) {
+				auto& obj = held[i % 4];
+				if (obj) {
+					if (crossThreads) { obj = outSlot.exchange(obj); }
+					if (obj) { pool.returnObjectSafely(obj); }
+				}
+				obj = pool.acquireObjectSafely();
+			}
+			for (auto* obj : held) { if (obj) { pool.returnObjectSafely(obj); } }
+			if (TestObject* obj = inSlot.exchange(nullptr)) { pool.returnObjectSafely(obj); }
+		});
+		for (auto& slot : exchange) { if (TestObject* obj = slot.exchange(nullptr)) { pool.returnObjectSafely(obj); } }
+	});
+}
+
+int main(int argc, const char* argv[]) {
+	uint64_t iterCnt = mvkTestIterationCount(argc, argv, 200000);
+
+	printf("MVKObjectPool acquire and return, %llu per thread, millions of operations per second:\n", (unsigned long long)iterCnt);
+	printf("%8s %12s %12s %14s %14s\n", "Threads", "Mutex", "Lock-free", "Mutex xthr", "Lock-free xthr");
+	for (uint32_t threadCnt : { 1, 2, 4, 8, 16 }) {
+		double opCnt = double(threadCnt) * iterCnt;
+		printf("%8u %12.2f %12.2f %14.2f %14.2f\n", threadCnt,
+			   opCnt / runThreads(false, threadCnt, iterCnt, false) / 1e6,
+			   opCnt / runThreads(true, threadCnt, iterCnt, false) / 1e6,
+			   opCnt / runThreads(false, threadCnt, iterCnt, true) / 1e6,
+			   opCnt / runThreads(true, threadCnt, iterCnt, true) / 1e6);
+	}
+	return mvkTestExitCode();
+}
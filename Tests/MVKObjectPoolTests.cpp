@@ -0,0 +1,175 @@
+/*
+ * MVKObjectPoolTests.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKTest.h"
+#include "MVKObjectPool.h"
+#include <deque>
+#include <random>
+
+static std::atomic<uint32_t> _destroyedCount(0);
+
+class TestObject : public MVKBaseObject, public MVKLinkableMixin<TestObject> {
+public:
+	MVKVulkanAPIObject* getVulkanAPIObject() override { return nullptr; }
+	void destroy() override { _destroyedCount++; MVKBaseObject::destroy(); }
+
+	/** Identifies the thread holding this object, or zero if it is not held. Used to detect sharing. */
+	std::atomic<uint32_t> _holder = { 0 };
+};
+
+class TestObjectPool : public MVKObjectPool<TestObject> {
+public:
+	MVKVulkanAPIObject* getVulkanAPIObject() override { return nullptr; }
+	TestObjectPool(bool isPooling, bool isLockFree) : MVKObjectPool<TestObject>(isPooling, isLockFree) {}
+
+protected:
+	// Called concurrently with acquisitions and returns in a lock-free pool, but always while holding
+	// the pool lock, so an unsynchronized count exposes any race to ThreadSanitizer.
+	TestObject* newObject() override {
+		_newObjectCount++;
+		return new TestObject();
+	}
+
+public:
+	uint64_t _newObjectCount = 0;
+};
+
+static void testPooling() {
+	for (bool isLockFree : { false, true }) {
+		TestObjectPool pool(true, isLockFree);
+		MVKTestExpect(pool.isLockFree() == isLockFree);
+
+		TestObject* obj1 = pool.acquireObjectSafely();
+		TestObject* obj2 = pool.acquireObjectSafely();
+		MVKTestExpect(obj1 && obj2 && obj1 != obj2);
+		pool.returnObjectSafely(obj1);
+		MVKTestExpect(pool.acquireObjectSafely() == obj1);		// Reused rather than created
+		pool.returnObjectSafely(obj1);
+		pool.returnObjectSafely(obj2);
+		pool.returnObjectSafely(nullptr);
+
+		auto counts = pool.getCounts();
+		MVKTestExpect(counts.created == 2 && counts.alive == 2);
+		MVKTestExpect(counts.resident == (isLockFree ? 0 : 2));
+
+		_destroyedCount = 0;
+		pool.clear();
+		MVKTestExpect(_destroyedCount == 2);
+		MVKTestExpect(pool.getCounts().alive == 0);
+	}
+
+	// A non-pooling pool is never lock-free, and destroys returned objects.
+	TestObjectPool pool(false, true);
+	MVKTestExpect( !pool.isLockFree() );
+	_destroyedCount = 0;
+	pool.returnObjectSafely(pool.acquireObjectSafely());
+	MVKTestExpect(_destroyedCount == 1);
+}
+
+// Objects are acquired on producer threads and returned on consumer threads, as with buffer regions
+// returned from MTLCommandBuffer completion handlers, while every thread also acquires and returns
+// objects of its own. Checks that no object is ever held by two threads at the same time.
+static void testConcurrentPool(bool isLockFree) {
+	const uint32_t threadCnt = 16;
+	const uint32_t iterCnt = 20000;
+	auto* pool = new TestObjectPool(true, isLockFree);
+	std::mutex handoffLock;
+	std::deque<TestObject*> handoff;
+
+	mvkTestRunThreads(threadCnt, [&](uint32_t tIdx) {
+		std::minstd_rand rng(tIdx + 1);
+		bool isProducer = tIdx % 2;
+		for (uint32_t i = 0; i < iterCnt; i++) {
+			TestObject* obj = pool->acquireObjectSafely();
+			MVKTestExpect(obj->_holder.exchange(tIdx + 1) == 0);
+			if (isProducer && (rng() & 1)) {
+				MVKTestExpect(obj->_holder.exchange(0) == tIdx + 1);
+				std::lock_guard<std::mutex> lock(handoffLock);
+				handoff.push_back(obj);
+				continue;
+			}
+			MVKTestExpect(obj->_holder.exchange(0) == tIdx + 1);
+			pool->returnObjectSafely(obj);
+
+			if ( !isProducer ) {
+				TestObject* handedObj = nullptr;
+				{
+					std::lock_guard<std::mutex> lock(handoffLock);
+					if ( !handoff.empty() ) {
+						handedObj = handoff.front();
+						handoff.pop_front();
+					}
+				}
+				if (handedObj) { pool->returnObjectSafely(handedObj); }
+			}
+		}
+	});
+	for (auto* obj : handoff) { pool->returnObjectSafely(obj); }
+
+	auto counts = pool->getCounts();
+	MVKTestExpect(counts.created == pool->_newObjectCount);
+	MVKTestExpect(counts.alive == counts.created);
+
+	_destroyedCount = 0;
+	pool->destroy();
+	MVKTestExpect(_destroyedCount == counts.created);
+}
+
+// A subclass of a linkable class, such as a MVKCommand subclass held in a MVKCommandTypePool,
+// inherits a _next member of its base class type, which both kinds of pool must accept.
+class TestDerivedObject : public TestObject {
+public:
+	uint32_t _value = 0;
+};
+
+class TestDerivedObjectPool : public MVKObjectPool<TestDerivedObject> {
+public:
+	MVKVulkanAPIObject* getVulkanAPIObject() override { return nullptr; }
+	TestDerivedObjectPool(bool isLockFree) : MVKObjectPool<TestDerivedObject>(true, isLockFree) {}
+
+protected:
+	TestDerivedObject* newObject() override { return new TestDerivedObject(); }
+};
+
+static void testDerivedObjectPool() {
+	for (bool isLockFree : { false, true }) {
+		TestDerivedObjectPool pool(isLockFree);
+		std::vector<TestDerivedObject*> objs;
+		for (uint32_t idx = 0; idx < 100; idx++) { objs.push_back(pool.acquireObjectSafely()); }
+		for (auto* obj : objs) { pool.returnObjectSafely(obj); }
+		TestDerivedObject* obj = pool.acquireObjectSafely();
+		MVKTestExpect(obj != nullptr);
+		pool.returnObjectSafely(obj);
+
+		_destroyedCount = 0;
+		pool.clear();
+		MVKTestExpect(_destroyedCount == 100);
+	}
+}
+
+static void testConcurrentLockedPool() { testConcurrentPool(false); }
+
+static void testConcurrentLockFreePool() { testConcurrentPool(true); }
+
+int main(int argc, const char* argv[]) {
+	MVKTestRun(testPooling);
+	MVKTestRun(testDerivedObjectPool);
+	MVKTestRun(testConcurrentLockedPool);
+	MVKTestRun(testConcurrentLockFreePool);
+	return mvkTestExitCode();
+}
@@ -0,0 +1,164 @@
+/*
+ * MVKPipelineBarrierTests.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKTest.h"
+#include "MVKPipelineBarrier.h"
+
+// Stand-ins for Vulkan buffer and image handles. Barriers only compare them, and never dereference them.
+static VkBuffer const kBuffer0 = (VkBuffer)0x1000;
+static VkBuffer const kBuffer1 = (VkBuffer)0x2000;
+static VkImage const kImage0 = (VkImage)0x3000;
+static VkImage const kImage1 = (VkImage)0x4000;
+
+static VkBufferMemoryBarrier bufferBarrier(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+										   VkAccessFlags srcAccess = VK_ACCESS_TRANSFER_WRITE_BIT,
+										   VkAccessFlags dstAccess = VK_ACCESS_SHADER_READ_BIT) {
+	VkBufferMemoryBarrier vkBarrier = {};
+	vkBarrier.buffer = buffer;
+	vkBarrier.offset = offset;
+	vkBarrier.size = size;
+	vkBarrier.srcAccessMask = srcAccess;
+	vkBarrier.dstAccessMask = dstAccess;
+	return vkBarrier;
+}
+
+static VkImageMemoryBarrier imageBarrier(VkImage image, uint32_t baseLevel, uint32_t levelCnt,
+										 uint32_t baseLayer, uint32_t layerCnt) {
+	VkImageMemoryBarrier vkBarrier = {};
+	vkBarrier.image = image;
+	vkBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	vkBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	vkBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, baseLevel, levelCnt, baseLayer, layerCnt };
+	return vkBarrier;
+}
+
+static bool hasImageRange(const MVKPipelineBarrier& b, uint32_t baseLevel, uint32_t levelCnt, uint32_t baseLayer, uint32_t layerCnt) {
+	return (b.baseMipLevel == (uint8_t)baseLevel && b.levelCount == (uint8_t)levelCnt &&
+			b.baseArrayLayer == (uint16_t)baseLayer && b.layerCount == (uint16_t)layerCnt);
+}
+
+// Memory barriers are merged into one global barrier, with the access of each.
+static void testMemoryBarriersMerge() {
+	MVKPipelineBarrier b;
+	VkMemoryBarrier vkBarrier = {};
+	vkBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	vkBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	b.mergeMemoryBarrier(vkBarrier);
+	vkBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	b.mergeMemoryBarrier(vkBarrier);
+	MVKTestExpect(b.mvkResource == nullptr);
+	MVKTestExpect(b.srcAccessMask == (VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT));
+	MVKTestExpect(b.dstAccessMask == VK_ACCESS_SHADER_READ_BIT);
+}
+
+// Overlapping and adjacent ranges of the same buffer merge into their union, with the access of both.
+static void testBufferBarriersMerge() {
+	MVKPipelineBarrier b(bufferBarrier(kBuffer0, 256, 256));
+	MVKTestExpect(b.mergeBufferBarrier(bufferBarrier(kBuffer0, 512, 128, VK_ACCESS_SHADER_WRITE_BIT)));		// Adjacent after
+	MVKTestExpect(b.offset == 256 && b.size == 384);
+	MVKTestExpect(b.srcAccessMask == (VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT));
+	MVKTestExpect(b.mergeBufferBarrier(bufferBarrier(kBuffer0, 0, 300)));		// Overlapping before
+	MVKTestExpect(b.offset == 0 && b.size == 640);
+	MVKTestExpect(b.mergeBufferBarrier(bufferBarrier(kBuffer0, 64, 64)));		// Enclosed
+	MVKTestExpect(b.offset == 0 && b.size == 640);
+
+	// A whole-size barrier covers the rest of the buffer.
+	MVKTestExpect(b.mergeBufferBarrier(bufferBarrier(kBuffer0, 600, VK_WHOLE_SIZE)));
+	MVKTestExpect(b.offset == 0 && b.size == VK_WHOLE_SIZE);
+	MVKTestExpect(b.mergeBufferBarrier(bufferBarrier(kBuffer0, 4096, 16)));
+	MVKTestExpect(b.offset == 0 && b.size == VK_WHOLE_SIZE);
+}
+
+// Barriers on different buffers, or on separated ranges, are not merged, and are left unchanged.
+static void testBufferBarriersRemainSeparate() {
+	MVKPipelineBarrier b(bufferBarrier(kBuffer0, 256, 256));
+	MVKTestExpect( !b.mergeBufferBarrier(bufferBarrier(kBuffer1, 256, 256)) );
+	MVKTestExpect( !b.mergeBufferBarrier(bufferBarrier(kBuffer0, 513, 16)) );
+	MVKTestExpect( !b.mergeBufferBarrier(bufferBarrier(kBuffer0, 0, 255)) );
+	MVKTestExpect(b.offset == 256 && b.size == 256 && b.srcAccessMask == VK_ACCESS_TRANSFER_WRITE_BIT);
+
+	MVKPipelineBarrier wholeBarrier(bufferBarrier(kBuffer0, 1024, VK_WHOLE_SIZE));
+	MVKTestExpect( !wholeBarrier.mergeBufferBarrier(bufferBarrier(kBuffer0, 0, 512)) );
+	MVKTestExpect(wholeBarrier.mergeBufferBarrier(bufferBarrier(kBuffer0, 0, 1024)));
+	MVKTestExpect(wholeBarrier.offset == 0 && wholeBarrier.size == VK_WHOLE_SIZE);
+}
+
+// Image barriers on adjacent array layers of the same mip levels, or adjacent mip levels
+// of the same array layers, merge into their union. Identical ranges merge trivially.
+static void testImageBarriersMerge() {
+	MVKPipelineBarrier b(imageBarrier(kImage0, 0, 1, 0, 2));
+	MVKTestExpect(b.mergeImageBarrier(imageBarrier(kImage0, 0, 1, 2, 3)));
+	MVKTestExpect(hasImageRange(b, 0, 1, 0, 5));
+	MVKTestExpect(b.mergeImageBarrier(imageBarrier(kImage0, 1, 2, 0, 5)));
+	MVKTestExpect(hasImageRange(b, 0, 3, 0, 5));
+	MVKTestExpect(b.mergeImageBarrier(imageBarrier(kImage0, 0, 3, 0, 5)));
+	MVKTestExpect(hasImageRange(b, 0, 3, 0, 5));
+}
+
+// Image barriers are only merged if the union of their ranges is exactly a single subresource range.
+static void testImageBarriersRemainSeparate() {
+	MVKPipelineBarrier b(imageBarrier(kImage0, 0, 1, 0, 2));
+
+	// Different image, layout, aspect, or access.
+	MVKTestExpect( !b.mergeImageBarrier(imageBarrier(kImage1, 0, 1, 2, 2)) );
+	auto vkBarrier = imageBarrier(kImage0, 0, 1, 2, 2);
+	vkBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	MVKTestExpect( !b.mergeImageBarrier(vkBarrier) );
+	vkBarrier = imageBarrier(kImage0, 0, 1, 2, 2);
+	vkBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	MVKTestExpect( !b.mergeImageBarrier(vkBarrier) );
+	vkBarrier = imageBarrier(kImage0, 0, 1, 2, 2);
+	vkBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	MVKTestExpect( !b.mergeImageBarrier(vkBarrier) );
+
+	// Separated layers, layers of different levels, and levels of different layers.
+	MVKTestExpect( !b.mergeImageBarrier(imageBarrier(kImage0, 0, 1, 3, 1)) );
+	MVKTestExpect( !b.mergeImageBarrier(imageBarrier(kImage0, 1, 1, 2, 1)) );
+	MVKTestExpect( !b.mergeImageBarrier(imageBarrier(kImage0, 1, 1, 0, 1)) );
+
+	MVKTestExpect(hasImageRange(b, 0, 1, 0, 2));
+}
+
+// Ranges that extend to the remaining levels or layers are never extended, nor extend another range.
+static void testRemainingRangesRemainSeparate() {
+	MVKPipelineBarrier b(imageBarrier(kImage0, 0, 1, 0, 2));
+	MVKTestExpect( !b.mergeImageBarrier(imageBarrier(kImage0, 0, 1, 2, VK_REMAINING_ARRAY_LAYERS)) );
+	MVKTestExpect( !b.mergeImageBarrier(imageBarrier(kImage0, 1, VK_REMAINING_MIP_LEVELS, 0, 2)) );
+	MVKTestExpect(hasImageRange(b, 0, 1, 0, 2));
+
+	MVKPipelineBarrier remaining(imageBarrier(kImage0, 0, 1, 2, VK_REMAINING_ARRAY_LAYERS));
+	MVKTestExpect( !remaining.mergeImageBarrier(imageBarrier(kImage0, 0, 1, 0, 2)) );
+
+	// A merged count that would equal the truncated remaining count is not merged.
+	MVKPipelineBarrier large(imageBarrier(kImage0, 0, 1, 0, 0xFFF0));
+	MVKTestExpect( !large.mergeImageBarrier(imageBarrier(kImage0, 0, 1, 0xFFF0, 0x0F)) );
+	MVKTestExpect(large.mergeImageBarrier(imageBarrier(kImage0, 0, 1, 0xFFF0, 0x0E)));
+	MVKTestExpect(large.layerCount == 0xFFFE);
+}
+
+int main(int argc, const char* argv[]) {
+	MVKTestRun(testMemoryBarriersMerge);
+	MVKTestRun(testBufferBarriersMerge);
+	MVKTestRun(testBufferBarriersRemainSeparate);
+	MVKTestRun(testImageBarriersMerge);
+	MVKTestRun(testImageBarriersRemainSeparate);
+	MVKTestRun(testRemainingRangesRemainSeparate);
+	return mvkTestExitCode();
+}
@@ -0,0 +1,150 @@
+/*
+ * MVKResourceBindingTableTests.cpp
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MVKTest.h"
+#include "MVKResourceBindingTable.h"
+
+// Stands in for a Metal resource binding, such as MVKMTLTextureBinding.
+struct TestBinding {
+	const void* mtlResource = nullptr;
+	uint32_t swizzle = 0;
+	uint16_t index = 0;
+
+	bool isRedundantWith(const TestBinding& other) const {
+		return mtlResource == other.mtlResource && swizzle == other.swizzle;
+	}
+};
+
+typedef MVKResourceBindingTable<TestBinding, 128> TestBindingTable;
+
+static int kTestResources[4];
+
+static TestBinding testBinding(uint16_t index, uint32_t resIdx, uint32_t swizzle = 0) {
+	TestBinding b;
+	b.mtlResource = &kTestResources[resIdx];
+	b.swizzle = swizzle;
+	b.index = index;
+	return b;
+}
+
+// Returns the indexes of the bindings that need to be encoded, and marks them all as encoded.
+template<size_t N>
+static std::vector<uint16_t> encodeDirty(MVKResourceBindingTable<TestBinding, N>& table) {
+	std::vector<uint16_t> indexes;
+	table.encodeDirtyBindings([&](TestBinding& b) { indexes.push_back(b.index); });
+	return indexes;
+}
+
+// Bindings are dirty until encoded, and are visited in index order, across the words of the bitmasks.
+static void testDirtyTracking() {
+	TestBindingTable table;
+	MVKTestExpect( !table.isDirty());
+	MVKTestExpect(table.getBinding(0) == nullptr);
+
+	MVKTestExpect(table.bind(testBinding(127, 0)));
+	MVKTestExpect(table.bind(testBinding(64, 1)));
+	MVKTestExpect(table.bind(testBinding(0, 2)));
+	MVKTestExpect(table.bind(testBinding(63, 3)));
+	MVKTestExpect(table.isDirty());
+	MVKTestExpect((encodeDirty(table) == std::vector<uint16_t>{0, 63, 64, 127}));
+	MVKTestExpect( !table.isDirty());
+	MVKTestExpect(encodeDirty(table).empty());
+
+	MVKTestExpect(table.getBinding(64) && table.getBinding(64)->mtlResource == &kTestResources[1]);
+	MVKTestExpect(table.getBinding(65) == nullptr);
+
+	// Rebinding changed content at one index dirties only that index.
+	MVKTestExpect(table.bind(testBinding(64, 0)));
+	MVKTestExpect((encodeDirty(table) == std::vector<uint16_t>{64}));
+	MVKTestExpect(table.getBinding(64)->mtlResource == &kTestResources[0]);
+
+	uint32_t boundCnt = 0;
+	table.forEachBinding([&](TestBinding&) { boundCnt++; });
+	MVKTestExpect(boundCnt == 4);
+}
+
+// Binding content identical to that already bound is elided, and does not dirty the binding.
+static void testRedundantBindingsAreElided() {
+	TestBindingTable table;
+	MVKTestExpect(table.bind(testBinding(5, 0)));
+	encodeDirty(table);
+
+	MVKTestExpect( !table.bind(testBinding(5, 0)));
+	MVKTestExpect( !table.isDirty());
+	MVKTestExpect(table.bind(testBinding(5, 0, 1)));
+	MVKTestExpect((encodeDirty(table) == std::vector<uint16_t>{5}));
+
+	// Content matching the default binding content is still bound at an index where nothing is bound.
+	MVKTestExpect(table.bind(TestBinding()));
+	MVKTestExpect(table.getBinding(0) != nullptr);
+}
+
+// Marking the table dirty dirties only the bound bindings, and an unbound index cannot be marked dirty.
+static void testMarkDirty() {
+	TestBindingTable table;
+	table.markDirty();
+	table.markDirty(3);
+	MVKTestExpect( !table.isDirty());
+
+	table.bind(testBinding(3, 0));
+	table.bind(testBinding(100, 1));
+	encodeDirty(table);
+
+	table.markDirty(100);
+	table.markDirty(101);
+	MVKTestExpect((encodeDirty(table) == std::vector<uint16_t>{100}));
+
+	table.markDirty();
+	std::vector<uint16_t> dirtyIndexes;
+	table.forEachDirtyBinding([&](TestBinding& b) { dirtyIndexes.push_back(b.index); });
+	MVKTestExpect((dirtyIndexes == std::vector<uint16_t>{3, 100}));
+	MVKTestExpect(table.isDirty());
+	MVKTestExpect((encodeDirty(table) == std::vector<uint16_t>{3, 100}));
+}
+
+// A binding at an index beyond the capacity of the table is rejected without changing the table,
+// and is left for the caller to report.
+static void testOverflow() {
+	MVKResourceBindingTable<TestBinding, 16> table;
+	MVKTestExpect( !table.bind(testBinding(16, 0)));
+	MVKTestExpect( !table.bind(testBinding(UINT16_MAX, 0)));
+	MVKTestExpect( !table.isDirty());
+	MVKTestExpect(table.getBinding(16) == nullptr);
+	table.markDirty(16);
+	MVKTestExpect( !table.isDirty());
+
+	MVKTestExpect(table.bind(testBinding(15, 0)));
+	MVKTestExpect( !table.bind(testBinding(16, 1)));
+	MVKTestExpect(table.getBinding(15)->mtlResource == &kTestResources[0]);
+	MVKTestExpect(encodeDirty(table).size() == 1);
+}
+
+// The bindings are held on the heap, so a table embedded in a command encoder remains small.
+static void testTableSize() {
+	MVKTestExpect(sizeof(TestBindingTable) <= 64);
+	MVKTestExpect((sizeof(MVKResourceBindingTable<TestBinding, 16>) <= 64));
+}
+
+int main(int argc, const char* argv[]) {
+	MVKTestRun(testDirtyTracking);
+	MVKTestRun(testRedundantBindingsAreElided);
+	MVKTestRun(testMarkDirty);
+	MVKTestRun(testOverflow);
+	MVKTestRun(testTableSize);
+	return mvkTestExitCode();
+}
@@ -0,0 +1,82 @@
+/*
+ * MVKTest.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <vector>
+
+
+#pragma mark -
+#pragma mark Expectations
+
+/** Returns the number of expectations that have failed. */
+inline std::atomic<uint32_t>& mvkTestFailureCount() {
+	static std::atomic<uint32_t> failureCount(0);
+	return failureCount;
+}
+
+/** Reports a failed expectation. */
+inline void mvkTestReportFailure(const char* expression, const char* file, int line) {
+	fprintf(stderr, "%s:%d: Expectation failed: %s\n", file, line, expression);
+	mvkTestFailureCount()++;
+}
+
+/** Reports a failure if the condition is false. May be used from any thread. */
+#define MVKTestExpect(cond)		do { if ( !(cond) ) { mvkTestReportFailure(#cond, __FILE__, __LINE__); } } while (false)
+
+/** Runs the named test function, and reports whether it succeeded. */
+#define MVKTestRun(testFunc)	mvkTestRun(#testFunc, testFunc)
+
+inline void mvkTestRun(const char* name, const std::function<void()>& testFunc) {
+	uint32_t prevFailureCount = mvkTestFailureCount();
+	testFunc();
+	printf("%s %s\n", mvkTestFailureCount() == prevFailureCount ? "Passed:" : "FAILED:", name);
+}
+
+/** Returns the process exit code, reflecting whether any expectation failed. */
+inline int mvkTestExitCode() { return mvkTestFailureCount() ? EXIT_FAILURE : EXIT_SUCCESS; }
+
+
+#pragma mark -
+#pragma mark Threads and timing
+
+/** Runs the function on the specified number of threads, passing each its thread index, and waits for them all to finish. */
+inline void mvkTestRunThreads(uint32_t threadCount, const std::function<void(uint32_t)>& threadFunc) {
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount);
+	for (uint32_t tIdx = 0; tIdx < threadCount; tIdx++) { threads.emplace_back(threadFunc, tIdx); }
+	for (auto& thread : threads) { thread.join(); }
+}
+
+/** Returns the number of seconds taken to run the function. */
+inline double mvkTestTime(const std::function<void()>& func) {
+	auto startTime = std::chrono::steady_clock::now();
+	func();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+/** Returns the iteration count passed as the first command line argument, or the default count. */
+inline uint64_t mvkTestIterationCount(int argc, const char* argv[], uint64_t defaultCount) {
+	return argc > 1 ? strtoull(argv[1], nullptr, 0) : defaultCount;
+}
@@ -0,0 +1,118 @@
+/*
+ * mvk_vulkan.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// A minimal stand-in for the Vulkan headers, declaring only the types needed by the Metal-free
+// MoltenVK headers that are tested, such as MVKPipelineBarrier.h and MVKCodecRegionDivider.h.
+// Structures have the same members as their Vulkan counterparts, but values are only declared
+// as needed by the tests.
+
+#include <cstdint>
+
+typedef uint64_t VkDeviceSize;
+typedef uint32_t VkFlags;
+typedef VkFlags VkAccessFlags;
+typedef VkFlags VkImageAspectFlags;
+
+typedef struct VkBuffer_T* VkBuffer;
+typedef struct VkImage_T* VkImage;
+
+#define VK_WHOLE_SIZE					(~0ULL)
+#define VK_REMAINING_MIP_LEVELS			(~0U)
+#define VK_REMAINING_ARRAY_LAYERS		(~0U)
+
+typedef struct VkOffset3D {
+	int32_t x;
+	int32_t y;
+	int32_t z;
+} VkOffset3D;
+
+typedef struct VkExtent3D {
+	uint32_t width;
+	uint32_t height;
+	uint32_t depth;
+} VkExtent3D;
+
+typedef struct VkSubresourceLayout {
+	VkDeviceSize offset;
+	VkDeviceSize size;
+	VkDeviceSize rowPitch;
+	VkDeviceSize arrayPitch;
+	VkDeviceSize depthPitch;
+} VkSubresourceLayout;
+
+typedef enum VkStructureType { VK_STRUCTURE_TYPE_APPLICATION_INFO = 0 } VkStructureType;
+
+typedef enum VkImageLayout {
+	VK_IMAGE_LAYOUT_UNDEFINED = 0,
+	VK_IMAGE_LAYOUT_GENERAL = 1,
+	VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL = 2,
+	VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL = 5,
+} VkImageLayout;
+
+typedef enum VkImageAspectFlagBits {
+	VK_IMAGE_ASPECT_COLOR_BIT = 0x00000001,
+	VK_IMAGE_ASPECT_DEPTH_BIT = 0x00000002,
+} VkImageAspectFlagBits;
+
+typedef enum VkAccessFlagBits {
+	VK_ACCESS_SHADER_READ_BIT = 0x00000020,
+	VK_ACCESS_SHADER_WRITE_BIT = 0x00000040,
+	VK_ACCESS_TRANSFER_WRITE_BIT = 0x00001000,
+} VkAccessFlagBits;
+
+typedef struct VkImageSubresourceRange {
+	VkImageAspectFlags aspectMask;
+	uint32_t baseMipLevel;
+	uint32_t levelCount;
+	uint32_t baseArrayLayer;
+	uint32_t layerCount;
+} VkImageSubresourceRange;
+
+typedef struct VkMemoryBarrier {
+	VkStructureType sType;
+	const void* pNext;
+	VkAccessFlags srcAccessMask;
+	VkAccessFlags dstAccessMask;
+} VkMemoryBarrier;
+
+typedef struct VkBufferMemoryBarrier {
+	VkStructureType sType;
+	const void* pNext;
+	VkAccessFlags srcAccessMask;
+	VkAccessFlags dstAccessMask;
+	uint32_t srcQueueFamilyIndex;
+	uint32_t dstQueueFamilyIndex;
+	VkBuffer buffer;
+	VkDeviceSize offset;
+	VkDeviceSize size;
+} VkBufferMemoryBarrier;
+
+typedef struct VkImageMemoryBarrier {
+	VkStructureType sType;
+	const void* pNext;
+	VkAccessFlags srcAccessMask;
+	VkAccessFlags dstAccessMask;
+	VkImageLayout oldLayout;
+	VkImageLayout newLayout;
+	uint32_t srcQueueFamilyIndex;
+	uint32_t dstQueueFamilyIndex;
+	VkImage image;
+	VkImageSubresourceRange subresourceRange;
+} VkImageMemoryBarrier;
@@ -0,0 +1,34 @@
+/*
+ * vk_mvk_moltenvk.h
+ *
+ * Copyright (c) 2015-2022 The Brenwill Workshop Ltd. (http://www.brenwill.com)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// A minimal stand-in for the MoltenVK API header, declaring only the types needed to include
+// MVKBaseObject.h, so that its templated Metal-free subclasses, such as MVKObjectPool, can be
+// tested without the Vulkan headers. The functions of MVKBaseObject that use these types are
+// declared, but not defined, and must not be called by the tests.
+
+#include <cstdint>
+
+typedef enum VkResult { VK_SUCCESS = 0 } VkResult;
+
+typedef enum MVKConfigLogLevel { MVK_CONFIG_LOG_LEVEL_NONE = 0 } MVKConfigLogLevel;
+
+#ifndef __printflike
+#	define __printflike(fmtarg, firstvararg)	__attribute__((__format__ (__printf__, fmtarg, firstvararg)))
+#endif